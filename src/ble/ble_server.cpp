@@ -4,42 +4,155 @@
 const char* BLEServer::SERVICE_UUID = "DD3F0AD1-6239-4E1F-81F1-91F6C9F01D86";
 const char* BLEServer::CHARACTERISTIC_UUID = "5D0360B2-2D3B-4BDC-B688-E1EC92394B8C";
 
+// Compact binary protocol v2 (see nav_protocol_v2.h)
+const char* BLEServer::CHARACTERISTIC_V2_UUID = "8F4A2C31-6B1E-4C7D-9A53-2E7D0B9C4F12";
+
+// Current speed from a secondary device
+const char* BLEServer::CHARACTERISTIC_SPEED_UUID = "8F4A2C32-6B1E-4C7D-9A53-2E7D0B9C4F12";
+
+// --- Built-in decoders ---
+
+static bool parseSygicPacket(void* context, const uint8_t* data, size_t length, NavigationData& nav) {
+    if (length < 7) {
+        Serial.println("Invalid navigation data length");
+        return false;
+    }
+    
+    // Parse based on original project format
+    // Example data: 0x01320A3335306D
+    // [0] = basic data flag
+    // [1][2] = speed limit (hex to decimal)
+    // [3] = turn direction
+    // [4][5][6][7] = distance in meters
+    
+    nav.isValid = true;
+    
+    // Speed limit (km/h)
+    nav.speedLimit = (data[1] << 8) | data[2];
+    
+    // Turn direction
+    nav.turnDirection = data[3];
+    
+    // Distance (meters) - convert from hex string
+    String distStr = "";
+    for (int i = 4; i < min((int)length, 7); i++) {
+        distStr += String(data[i], HEX);
+    }
+    nav.distance = distStr.toInt();
+    
+    // Set instruction based on turn direction
+    switch (nav.turnDirection) {
+        case 0x01: nav.instruction = "Turn Left"; break;
+        case 0x02: nav.instruction = "Turn Right"; break;
+        case 0x03: nav.instruction = "Go Straight"; break;
+        case 0x04: nav.instruction = "U-Turn"; break;
+        default: nav.instruction = "Continue"; break;
+    }
+    
+    Serial.printf("Navigation Update: %s, %dm, %dkm/h\n", 
+                  nav.instruction.c_str(),
+                  nav.distance,
+                  nav.speedLimit);
+    return true;
+}
+
+static bool parseV2Packet(void* context, const uint8_t* data, size_t length, NavigationData& nav) {
+    return static_cast<NavV2Decoder*>(context)->decode(data, length, nav);
+}
+
+static void resetV2Decoder(void* context) {
+    static_cast<NavV2Decoder*>(context)->reset();
+}
+
+static bool parseSpeedPacket(void* context, const uint8_t* data, size_t length, NavigationData& nav) {
+    if (length < 2) return false;
+    
+    nav.currentSpeed = (data[0] | (data[1] << 8)) / 10;
+    
+    // Speed alone is not worth a redraw until there is navigation to show
+    return nav.isValid;
+}
+
 class BLEServer::ServerCallbacks: public NimBLEServerCallbacks {
     BLEServer* server;
 public:
     ServerCallbacks(BLEServer* srv) : server(srv) {}
     
-    void onConnect(NimBLEServer* pServer) {
-        server->deviceConnected = true;
+    void onConnect(NimBLEServer* pServer, ble_gap_conn_desc* desc) {
+        NimBLEAddress peer(desc->peer_id_addr);
+        server->handleConnect(desc->conn_handle, &peer, millis());
         Serial.println("BLE Client connected");
+        
+        // Larger LL packets so a full v2 packet fits in one air frame
+        pServer->setDataLen(desc->conn_handle, CONN_PREFERRED_DATA_LEN);
+        
+        // Ask the phone to bond so the next reconnect can be directed
+        if (server->autoConnect) {
+            NimBLEDevice::startSecurity(desc->conn_handle);
+        }
     }
     
-    void onDisconnect(NimBLEServer* pServer) {
-        server->deviceConnected = false;
+    void onDisconnect(NimBLEServer* pServer, ble_gap_conn_desc* desc) {
         Serial.println("BLE Client disconnected");
-        server->startAdvertising();
+        server->handleDisconnect(desc->conn_handle, millis());
+    }
+    
+    void onMTUChange(uint16_t MTU, ble_gap_conn_desc* desc) {
+        server->handleMtuChange(desc->conn_handle, MTU);
+        Serial.printf("BLE MTU negotiated: %u\n", MTU);
     }
 };
 
+// Shared by every decoder characteristic; the ATT handle selects the decoder
 class BLEServer::CharacteristicCallbacks: public NimBLECharacteristicCallbacks {
     BLEServer* server;
 public:
     CharacteristicCallbacks(BLEServer* srv) : server(srv) {}
     
-    void onWrite(NimBLECharacteristic* pCharacteristic) {
+    void onWrite(NimBLECharacteristic* pCharacteristic, ble_gap_conn_desc* desc) {
         std::string value = pCharacteristic->getValue();
-        if (value.length() > 0) {
-            server->parseNavigationData((uint8_t*)value.data(), value.length());
+        if (!server->enqueueWrite(desc->conn_handle, pCharacteristic->getHandle(),
+                                  (const uint8_t*)value.data(), value.length(), millis())) {
+            server->packetsDropped++;
         }
     }
 };
 
 BLEServer::BLEServer() : pServer(nullptr), pService(nullptr), 
                          pCharacteristic(nullptr), pAdvertising(nullptr),
-                         deviceConnected(false), hasNewNavData(false) {
+                         hasNewNavData(false), connectionCount(0),
+                         packetLog(nullptr), broadcastEnabled(false), broadcastLength(0),
+                         autoConnect(true), reconnectDelay(5000),
+                         hasLastPeer(false), advPhase(ADV_OFF), advPhaseStartMs(0),
+                         lastStatsRefreshMs(0), packetsReceived(0), packetsDropped(0),
+                         disconnectMs(0), connectMs(0),
+                         awaitingFirstFrame(false), everConnected(false), task(nullptr) {
+    navLock = xSemaphoreCreateMutexStatic(&navLockBuffer);
+    linkLock = xSemaphoreCreateMutexStatic(&linkLockBuffer);
+    memset(decoderCharacteristics, 0, sizeof(decoderCharacteristics));
+    memset(slotDecoders, 0, sizeof(slotDecoders));
+    memset(slotPeerKnown, 0, sizeof(slotPeerKnown));
+    
+    // Built-in protocols, in NAV_SOURCE_* order
+    decoders.add({"Sygic", SERVICE_UUID, CHARACTERISTIC_UUID,
+                  NIMBLE_PROPERTY::READ | NIMBLE_PROPERTY::WRITE | NIMBLE_PROPERTY::NOTIFY,
+                  parseSygicPacket, nullptr, nullptr, NAV_PRIORITY_NAVIGATION});
+    
+    // Optional v2 characteristic; write-without-response keeps airtime low
+    decoders.add({"HUD v2", SERVICE_UUID, CHARACTERISTIC_V2_UUID,
+                  NIMBLE_PROPERTY::WRITE | NIMBLE_PROPERTY::WRITE_NR,
+                  parseV2Packet, resetV2Decoder, &v2Decoder, NAV_PRIORITY_NAVIGATION});
+    
+    // Current speed from a second connection (OBD adapter, GPS puck)
+    decoders.add({"Speed", SERVICE_UUID, CHARACTERISTIC_SPEED_UUID,
+                  NIMBLE_PROPERTY::WRITE | NIMBLE_PROPERTY::WRITE_NR,
+                  parseSpeedPacket, nullptr, nullptr, NAV_PRIORITY_SENSOR});
 }
 
 BLEServer::~BLEServer() {
+    if (task) {
+        vTaskDelete(task);
+    }
     if (pServer) {
         NimBLEDevice::deinit(true);
     }
@@ -52,97 +165,537 @@ bool BLEServer::init() {
     NimBLEDevice::init("ESP32-S3-HUD");
     NimBLEDevice::setPower(ESP_PWR_LVL_P9);
     
-    // Create BLE Server
-    pServer = NimBLEDevice::createServer();
-    pServer->setCallbacks(new ServerCallbacks(this));
+    // Offer a large ATT MTU; the central initiates the exchange
+    NimBLEDevice::setMTU(CONN_PREFERRED_MTU);
     
-    // Create BLE Service
-    pService = pServer->createService(SERVICE_UUID);
+    // Bond (Just Works, secure connections) so the phone can be recognised
+    NimBLEDevice::setSecurityAuth(true, false, true);
+    NimBLEDevice::setSecurityIOCap(BLE_HS_IO_NO_INPUT_OUTPUT);
     
-    // Create BLE Characteristic
-    pCharacteristic = pService->createCharacteristic(
-        CHARACTERISTIC_UUID,
-        NIMBLE_PROPERTY::READ | NIMBLE_PROPERTY::WRITE | NIMBLE_PROPERTY::NOTIFY
-    );
+    // Most recent bond is the reconnect target
+    int bonds = NimBLEDevice::getNumBonds();
+    if (bonds > 0) {
+        lastPeer = NimBLEDevice::getBondedAddress(bonds - 1);
+        hasLastPeer = true;
+    }
     
-    pCharacteristic->setCallbacks(new CharacteristicCallbacks(this));
+    // Create BLE Server
+    pServer = NimBLEDevice::createServer();
+    pServer->setCallbacks(new ServerCallbacks(this));
     
-    // Start the service
-    pService->start();
+    // One characteristic per registered decoder, grouped into services
+    if (!createDecoderCharacteristics()) {
+        Serial.println("Failed to create navigation characteristics");
+        return false;
+    }
+    pCharacteristic = decoderCharacteristics[NAV_SOURCE_SYGIC];
     
     // Start advertising
     pAdvertising = NimBLEDevice::getAdvertising();
     pAdvertising->addServiceUUID(SERVICE_UUID);
     pAdvertising->setScanResponse(true);
-    pAdvertising->setMinPreferred(0x06);
-    pAdvertising->setMinPreferred(0x12);
+    
+    // Peripheral preferred connection parameters: start in the active profile
+    pAdvertising->setMinPreferred(CONN_PROFILE_ACTIVE_PARAMS.minInterval);
+    pAdvertising->setMaxPreferred(CONN_PROFILE_ACTIVE_PARAMS.maxInterval);
     
     Serial.println("BLE server initialized successfully");
     return true;
 }
 
+bool BLEServer::createDecoderCharacteristics() {
+    NimBLEService* services[NAV_MAX_DECODERS];
+    const char* serviceUuids[NAV_MAX_DECODERS];
+    uint8_t serviceCount = 0;
+    CharacteristicCallbacks* callbacks = new CharacteristicCallbacks(this);
+    
+    for (uint8_t id = 0; id < decoders.size(); id++) {
+        const NavDecoder* decoder = decoders.get(id);
+        
+        // UUID compares only happen here, once, never per packet
+        NimBLEService* service = nullptr;
+        for (uint8_t i = 0; i < serviceCount; i++) {
+            if (strcasecmp(serviceUuids[i], decoder->serviceUuid) == 0) {
+                service = services[i];
+                break;
+            }
+        }
+        if (!service) {
+            service = pServer->createService(decoder->serviceUuid);
+            services[serviceCount] = service;
+            serviceUuids[serviceCount++] = decoder->serviceUuid;
+        }
+        
+        decoderCharacteristics[id] = service->createCharacteristic(
+            decoder->characteristicUuid, decoder->properties);
+        decoderCharacteristics[id]->setCallbacks(callbacks);
+    }
+    
+    for (uint8_t i = 0; i < serviceCount; i++) {
+        services[i]->start();
+    }
+    pService = services[0];
+    
+    // Handles are only assigned once the GATT server is started
+    pServer->start();
+    decoders.clearHandles();
+    for (uint8_t id = 0; id < decoders.size(); id++) {
+        if (!decoders.bindHandle(decoderCharacteristics[id]->getHandle(), id)) {
+            return false;
+        }
+        Serial.printf("Decoder %s on handle %u\n", decoders.get(id)->name,
+                      decoderCharacteristics[id]->getHandle());
+    }
+    return true;
+}
+
 void BLEServer::startAdvertising() {
-    if (pAdvertising && !deviceConnected) {
-        pAdvertising->start();
-        Serial.println("BLE advertising started");
+    xSemaphoreTake(linkLock, portMAX_DELAY);
+    if (connectionCount == 0) {
+        beginAdvertisingSequence(millis());
+    }
+    xSemaphoreGive(linkLock);
+    wakeTask();
+}
+
+void BLEServer::beginAdvertisingSequence(uint32_t nowMs) {
+    // Directed advertising only makes sense towards a phone we bonded with
+    if (autoConnect && hasLastPeer) {
+        enterAdvertisingPhase(ADV_DIRECTED, nowMs);
+    } else {
+        enterAdvertisingPhase(ADV_FAST, nowMs);
     }
 }
 
 void BLEServer::stopAdvertising() {
+    xSemaphoreTake(linkLock, portMAX_DELAY);
     if (pAdvertising) {
         pAdvertising->stop();
         Serial.println("BLE advertising stopped");
     }
+    advPhase = ADV_OFF;
+    xSemaphoreGive(linkLock);
 }
 
-void BLEServer::parseNavigationData(uint8_t* data, size_t length) {
-    if (length < 7) {
-        Serial.println("Invalid navigation data length");
+void BLEServer::enterAdvertisingPhase(AdvertisingPhase phase, uint32_t nowMs) {
+    advPhase = phase;
+    advPhaseStartMs = nowMs;
+    if (!pAdvertising) return;
+    
+    pAdvertising->stop();
+    switch (phase) {
+        case ADV_DIRECTED:
+            pAdvertising->setAdvertisementType(BLE_GAP_CONN_MODE_DIR);
+            pAdvertising->start(0, nullptr, &lastPeer);
+            Serial.printf("BLE directed advertising to %s\n", lastPeer.toString().c_str());
+            break;
+        case ADV_FAST:
+            pAdvertising->setAdvertisementType(BLE_GAP_CONN_MODE_UND);
+            pAdvertising->setMinInterval(ADV_FAST_INTERVAL_MIN);
+            pAdvertising->setMaxInterval(ADV_FAST_INTERVAL_MAX);
+            pAdvertising->start();
+            Serial.println("BLE fast advertising started");
+            break;
+        case ADV_SLOW:
+            pAdvertising->setAdvertisementType(BLE_GAP_CONN_MODE_UND);
+            // Receivers need the broadcast refreshed often
+            pAdvertising->setMinInterval(broadcastEnabled ? NAV_BCAST_ADV_INTERVAL : ADV_SLOW_INTERVAL_MIN);
+            pAdvertising->setMaxInterval(broadcastEnabled ? NAV_BCAST_ADV_INTERVAL : ADV_SLOW_INTERVAL_MAX);
+            pAdvertising->start();
+            Serial.println("BLE slow advertising started");
+            break;
+        case ADV_BROADCAST:
+            pAdvertising->setAdvertisementType(BLE_GAP_CONN_MODE_NON);
+            pAdvertising->setMinInterval(NAV_BCAST_ADV_INTERVAL);
+            pAdvertising->setMaxInterval(NAV_BCAST_ADV_INTERVAL);
+            pAdvertising->start();
+            Serial.println("BLE broadcast-only advertising started");
+            break;
+        case ADV_OFF:
+            break;
+    }
+}
+
+void BLEServer::processIngest(uint32_t nowMs) {
+    IngestPacket packet;
+    for (uint8_t n = 0; n < INGEST_BUDGET; n++) {
+        // Recorded with the pop so a disconnect resets what this slot fed
+        xSemaphoreTake(linkLock, portMAX_DELAY);
+        int slot = ingest.pop(nowMs, packet);
+        uint16_t connHandle = 0xFFFF;
+        if (slot >= 0) {
+            connHandle = ingest.connHandleAt(slot);
+            uint8_t id = decoders.lookup(packet.attHandle);
+            if (id != NAV_DECODER_NONE && !(slotDecoders[slot] & (1u << id))) {
+                slotDecoders[slot] |= 1u << id;
+                
+                // The link carrying navigation is the phone; a speed
+                // sensor on another slot must not become the reconnect target
+                if (decoders.get(id)->priority == NAV_PRIORITY_NAVIGATION && slotPeerKnown[slot]) {
+                    lastPeer = slotPeers[slot];
+                    hasLastPeer = true;
+                }
+            }
+        }
+        xSemaphoreGive(linkLock);
+        if (slot < 0) break;
+        
+        dispatchWrite(connHandle, packet.attHandle, packet.data, packet.length, nowMs);
+    }
+}
+
+void BLEServer::update(uint32_t nowMs) {
+    processIngest(nowMs);
+    
+    xSemaphoreTake(linkLock, portMAX_DELAY);
+    if (connectionCount > 0) {
+        ConnProfileId profile;
+        if (connPolicy.update(nowMs, profile)) {
+            applyConnectionProfile(profile);
+        }
+        
+        // Read back what the central actually granted
+        if (pServer && nowMs - lastStatsRefreshMs >= 1000) {
+            lastStatsRefreshMs = nowMs;
+            NimBLEConnInfo info = pServer->getPeerIDInfo(connPolicy.getStats().connHandle);
+            connPolicy.recordNegotiated(info.getConnInterval(), info.getConnLatency(),
+                                        info.getConnTimeout());
+        }
+    }
+    
+    uint32_t elapsed = nowMs - advPhaseStartMs;
+    switch (advPhase) {
+        case ADV_DIRECTED:
+            if (elapsed >= ADV_DIRECTED_WINDOW_MS) enterAdvertisingPhase(ADV_FAST, nowMs);
+            break;
+        case ADV_FAST:
+            if (elapsed >= reconnectDelay) enterAdvertisingPhase(ADV_SLOW, nowMs);
+            break;
+        default:
+            break;
+    }
+    xSemaphoreGive(linkLock);
+}
+
+uint32_t BLEServer::msUntilNextUpdate(uint32_t nowMs) const {
+    if (ingest.hasPending()) return 0;
+    
+    uint32_t wait = BLE_TASK_NO_DEADLINE;
+    xSemaphoreTake(linkLock, portMAX_DELAY);
+    uint32_t elapsed = nowMs - advPhaseStartMs;
+    if (advPhase == ADV_DIRECTED) {
+        wait = elapsed < ADV_DIRECTED_WINDOW_MS ? ADV_DIRECTED_WINDOW_MS - elapsed : 0;
+    } else if (advPhase == ADV_FAST) {
+        wait = elapsed < reconnectDelay ? reconnectDelay - elapsed : 0;
+    }
+    if (connectionCount > 0) {
+        wait = min(wait, (uint32_t)BLE_TASK_CONNECTED_MS);
+    }
+    xSemaphoreGive(linkLock);
+    return wait;
+}
+
+bool BLEServer::startTask(uint8_t core, uint8_t priority) {
+    if (task) return false;
+    
+    BaseType_t result = xTaskCreatePinnedToCore(taskEntry, "ble", BLE_TASK_STACK, this,
+                                                priority, &task, core);
+    if (result != pdPASS) {
+        task = nullptr;
+        return false;
+    }
+    return true;
+}
+
+void BLEServer::taskEntry(void* param) {
+    static_cast<BLEServer*>(param)->runTask();
+}
+
+void BLEServer::runTask() {
+    for (;;) {
+        uint32_t waitMs = msUntilNextUpdate(millis());
+        if (waitMs > 0) {
+            ulTaskNotifyTake(pdTRUE, waitMs == BLE_TASK_NO_DEADLINE ? portMAX_DELAY : pdMS_TO_TICKS(waitMs));
+        }
+        uint32_t wakeUs = micros();
+        update(millis());
+        taskLoad.add(micros() - wakeUs);
+    }
+}
+
+// Timers changed outside the task: let it recompute its deadline
+void BLEServer::wakeTask() {
+    if (task) {
+        xTaskNotifyGive(task);
+    }
+}
+
+void BLEServer::applyConnectionProfile(ConnProfileId profile) {
+    if (!pServer) return;
+    
+    const ConnectionProfile& p = ConnectionPolicy::params(profile);
+    pServer->updateConnParams(connPolicy.getStats().connHandle, p.minInterval,
+                              p.maxInterval, p.latency, p.supervisionTimeout);
+    Serial.printf("BLE requesting %s connection profile\n",
+                  profile == CONN_PROFILE_IDLE ? "idle" : "active");
+}
+
+void BLEServer::setReconnectPolicy(bool autoConnectEnabled, uint16_t fastAdvertisingMs) {
+    xSemaphoreTake(linkLock, portMAX_DELAY);
+    autoConnect = autoConnectEnabled;
+    reconnectDelay = fastAdvertisingMs;
+    xSemaphoreGive(linkLock);
+    wakeTask();
+}
+
+void BLEServer::handleMtuChange(uint16_t connHandle, uint16_t mtu) {
+    xSemaphoreTake(linkLock, portMAX_DELAY);
+    if (connPolicy.isConnected() && connHandle == connPolicy.getStats().connHandle) {
+        connPolicy.recordMtu(mtu);
+    }
+    xSemaphoreGive(linkLock);
+}
+
+bool BLEServer::getReconnectPeer(NimBLEAddress& peer) const {
+    xSemaphoreTake(linkLock, portMAX_DELAY);
+    bool known = hasLastPeer;
+    if (known) {
+        peer = lastPeer;
+    }
+    xSemaphoreGive(linkLock);
+    return known;
+}
+
+void BLEServer::handleConnect(uint16_t connHandle, const NimBLEAddress* peer, uint32_t nowMs) {
+    xSemaphoreTake(linkLock, portMAX_DELAY);
+    int slot = ingest.open(connHandle);
+    if (slot < 0) {
+        xSemaphoreGive(linkLock);
+        Serial.println("BLE connection rejected: no free ingestion slot");
         return;
     }
+    slotDecoders[slot] = 0;
+    slotPeerKnown[slot] = peer != nullptr;
+    if (peer) {
+        slotPeers[slot] = *peer;
+    }
+    connectionCount++;
     
-    // Parse based on original project format
-    // Example data: 0x01320A3335306D
-    // [0] = basic data flag
-    // [1][2] = speed limit (hex to decimal)
-    // [3] = turn direction
-    // [4][5][6][7] = distance in meters
+    // The controller stops advertising on connection; keep a slow beacon
+    // up while another device could still join
+    if (connectionCount < BLE_MAX_CONNECTIONS) {
+        enterAdvertisingPhase(ADV_SLOW, nowMs);
+    } else if (broadcastEnabled) {
+        enterAdvertisingPhase(ADV_BROADCAST, nowMs);
+    } else {
+        advPhase = ADV_OFF;
+    }
     
-    currentNavData.isValid = true;
+    if (!connPolicy.isConnected()) {
+        connPolicy.onConnect(connHandle, nowMs);
+    }
     
-    // Speed limit (km/h)
-    currentNavData.speedLimit = (data[1] << 8) | data[2];
+    // Reconnect bookkeeping only tracks going from no link to a link
+    if (connectionCount > 1) {
+        xSemaphoreGive(linkLock);
+        wakeTask();
+        return;
+    }
+    connectMs = nowMs;
     
-    // Turn direction
-    currentNavData.turnDirection = data[3];
+    if (everConnected) {
+        reconnectStats.reconnects++;
+        reconnectStats.lastDisconnectToConnectMs = nowMs - disconnectMs;
+    }
+    everConnected = true;
     
-    // Distance (meters) - convert from hex string
-    if (length >= 7) {
-        String distStr = "";
-        for (int i = 4; i < min((int)length, 7); i++) {
-            distStr += String(data[i], HEX);
+    // Re-render the last known navigation immediately instead of waiting
+    // for the phone's next update
+    xSemaphoreTake(navLock, portMAX_DELAY);
+    if (currentNavData.isValid) {
+        hasNewNavData = true;
+        publishNavUpdate(NAV_DECODER_NONE, nowMs);
+    }
+    xSemaphoreGive(navLock);
+    awaitingFirstFrame = true;
+    xSemaphoreGive(linkLock);
+    wakeTask();
+}
+
+void BLEServer::handleDisconnect(uint16_t connHandle, uint32_t nowMs) {
+    xSemaphoreTake(linkLock, portMAX_DELAY);
+    int slot = ingest.close(connHandle);
+    if (slot < 0) {
+        xSemaphoreGive(linkLock);
+        return;
+    }
+    connectionCount--;
+    
+    // Reset only the decoders this connection fed, e.g. the next v2
+    // session starts with a keyframe while a speed sensor stays linked.
+    // navLock keeps the reset out of a decode running on the ingest task.
+    xSemaphoreTake(navLock, portMAX_DELAY);
+    for (uint8_t id = 0; id < decoders.size(); id++) {
+        if (slotDecoders[slot] & (1u << id)) {
+            decoders.reset(id);
         }
-        currentNavData.distance = distStr.toInt();
     }
+    xSemaphoreGive(navLock);
+    slotDecoders[slot] = 0;
+    slotPeerKnown[slot] = false;
     
-    // Set instruction based on turn direction
-    switch (currentNavData.turnDirection) {
-        case 0x01: currentNavData.instruction = "Turn Left"; break;
-        case 0x02: currentNavData.instruction = "Turn Right"; break;
-        case 0x03: currentNavData.instruction = "Go Straight"; break;
-        case 0x04: currentNavData.instruction = "U-Turn"; break;
-        default: currentNavData.instruction = "Continue"; break;
+    // Connection parameters follow the oldest remaining link
+    if (connPolicy.getStats().connHandle == connHandle) {
+        connPolicy.onDisconnect();
+        for (uint8_t i = 0; i < BLE_MAX_CONNECTIONS; i++) {
+            uint16_t handle = ingest.connHandleAt(i);
+            if (handle != 0xFFFF) {
+                connPolicy.onConnect(handle, nowMs);
+                break;
+            }
+        }
+    }
+    
+    if (connectionCount > 0) {
+        enterAdvertisingPhase(ADV_FAST, nowMs);
+    } else {
+        disconnectMs = nowMs;
+        awaitingFirstFrame = false;
+        beginAdvertisingSequence(nowMs);
+    }
+    xSemaphoreGive(linkLock);
+    wakeTask();
+}
+
+void BLEServer::markFrameRendered(uint32_t nowMs) {
+    xSemaphoreTake(linkLock, portMAX_DELAY);
+    if (awaitingFirstFrame) {
+        awaitingFirstFrame = false;
+        reconnectStats.lastConnectToFrameMs = nowMs - connectMs;
+        if (reconnectStats.reconnects > 0) {
+            reconnectStats.lastDisconnectToFrameMs = nowMs - disconnectMs;
+            Serial.printf("Reconnect: %ums to connect, %ums to first frame\n",
+                          reconnectStats.lastDisconnectToConnectMs,
+                          reconnectStats.lastDisconnectToFrameMs);
+        }
+    }
+    xSemaphoreGive(linkLock);
+}
+
+bool BLEServer::enqueueWrite(uint16_t connHandle, uint16_t attHandle,
+                             const uint8_t* data, size_t length, uint32_t nowMs) {
+    const NavDecoder* decoder = decoders.get(decoders.lookup(attHandle));
+    if (!decoder) return false;
+    
+    if (!ingest.push(connHandle, attHandle, decoder->priority, data, length, nowMs)) {
+        return false;
     }
+    wakeTask();
+    return true;
+}
+
+void BLEServer::dispatchWrite(uint16_t connHandle, uint16_t handle, const uint8_t* data,
+                              size_t length, uint32_t nowMs) {
+    uint8_t id = decoders.lookup(handle);
+    if (id == NAV_DECODER_NONE || length == 0) return;
     
-    hasNewNavData = true;
+    // Only traffic on the managed link keeps it in the active profile; a
+    // streaming sensor on another connection must not hold it there
+    xSemaphoreTake(linkLock, portMAX_DELAY);
+    if (connPolicy.isConnected() && connHandle == connPolicy.getStats().connHandle) {
+        connPolicy.onPacket(nowMs);
+    }
+    xSemaphoreGive(linkLock);
     
-    Serial.printf("Navigation Update: %s, %dm, %dkm/h\n", 
-                  currentNavData.instruction.c_str(),
-                  currentNavData.distance,
-                  currentNavData.speedLimit);
+    if (packetLog) {
+        packetLog->record(id, data, length);
+    }
+    injectPacket(data, length, id);
+}
+
+void BLEServer::injectPacket(const uint8_t* data, size_t length, uint8_t source) {
+    const NavDecoder* decoder = decoders.get(source);
+    if (length == 0 || !decoder) return;
+    
+    packetsReceived++;
+    
+    // Broadcasting rewrites the advertising data, which the host task
+    // starts and stops under linkLock; hold it only when needed
+    xSemaphoreTake(linkLock, portMAX_DELAY);
+    bool broadcast = broadcastEnabled;
+    if (!broadcast) {
+        xSemaphoreGive(linkLock);
+    }
+    
+    xSemaphoreTake(navLock, portMAX_DELAY);
+    if (hasNewNavData) {
+        packetsDropped++;
+    }
+    if (decoder->parse(decoder->context, data, length, currentNavData)) {
+        hasNewNavData = true;
+        publishNavUpdate(source, millis());
+        if (broadcast && currentNavData.isValid) {
+            publishBroadcast();
+        }
+    }
+    xSemaphoreGive(navLock);
+    if (broadcast) {
+        xSemaphoreGive(linkLock);
+    }
+}
+
+void BLEServer::setBroadcastEnabled(bool enabled) {
+    xSemaphoreTake(linkLock, portMAX_DELAY);
+    broadcastEnabled = enabled;
+    xSemaphoreTake(navLock, portMAX_DELAY);
+    if (enabled && currentNavData.isValid) {
+        publishBroadcast();
+    }
+    xSemaphoreGive(navLock);
+    xSemaphoreGive(linkLock);
+}
+
+// Called with linkLock and navLock held: it reads the navigation and
+// touches the advertising object enterAdvertisingPhase() also drives
+void BLEServer::publishBroadcast() {
+    broadcastLength = broadcastEncoder.encode(currentNavData, broadcastFrame, sizeof(broadcastFrame));
+    if (!pAdvertising || broadcastLength == 0) return;
+    
+    // Custom advertising data replaces the service UUID list, so the UUID
+    // moves to the scan response for phones looking for the HUD
+    NimBLEAdvertisementData advData;
+    advData.setFlags(BLE_HS_ADV_F_DISC_GEN | BLE_HS_ADV_F_BREDR_UNSUP);
+    advData.setManufacturerData(std::string((const char*)broadcastFrame, broadcastLength));
+    pAdvertising->setAdvertisementData(advData);
+    
+    NimBLEAdvertisementData scanData;
+    scanData.setCompleteServices(NimBLEUUID(SERVICE_UUID));
+    pAdvertising->setScanResponseData(scanData);
+}
+
+bool BLEServer::notify(const uint8_t* data, size_t length) {
+    if (connectionCount == 0 || !pCharacteristic || pCharacteristic->getSubscribedCount() == 0) {
+        return false;
+    }
+    
+    pCharacteristic->setValue(data, length);
+    pCharacteristic->notify();
+    return true;
+}
+
+void BLEServer::publishNavUpdate(uint8_t source, uint32_t nowMs) {
+    NavUpdateEvent event;
+    event.timeMs = nowMs;
+    event.source = source;
+    event.valid = currentNavData.isValid;
+    event.distance = currentNavData.distance;
+    EventBus<NavUpdateEvent>::publish(event);
 }
 
 NavigationData BLEServer::getNavigationData() {
+    xSemaphoreTake(navLock, portMAX_DELAY);
     hasNewNavData = false;
-    return currentNavData;
+    NavigationData copy = currentNavData;
+    xSemaphoreGive(navLock);
+    return copy;
 }
\ No newline at end of file
@@ -3,6 +3,22 @@
 
 #include <Arduino.h>
 #include <NimBLEDevice.h>
+#include <atomic>
+#include "packet_log.h"
+#include "nav_protocol_v2.h"
+#include "conn_policy.h"
+#include "nav_decoder.h"
+#include "ingest_scheduler.h"
+#include "nav_broadcast.h"
+#include "../core/event_bus.h"
+#include "../core/events.h"
+#include "../core/task_monitor.h"
+
+// Decoder ids of the built-in protocols (registration order). Also stored
+// as the source of packet captures.
+#define NAV_SOURCE_SYGIC 0
+#define NAV_SOURCE_V2    1
+#define NAV_SOURCE_SPEED 2   // Speed sensor: [u16 LE km/h * 10]
 
 struct NavigationData {
     String instruction;
@@ -11,25 +27,132 @@ struct NavigationData {
     int turnDirection;
     bool isValid;
     
-    NavigationData() : distance(0), speedLimit(0), turnDirection(0), isValid(false) {}
+    // Protocol v2 only fields
+    int currentSpeed;        // km/h
+    uint32_t etaSeconds;     // Time to arrival
+    uint8_t laneCount;
+    uint16_t laneMask;       // Bit n set = lane n (from the left) recommended
+    String streetName;
+    
+    NavigationData() : distance(0), speedLimit(0), turnDirection(0), isValid(false),
+                       currentSpeed(0), etaSeconds(0), laneCount(0), laneMask(0) {}
+};
+
+// Advertising intervals in 0.625 ms units
+#define ADV_DIRECTED_WINDOW_MS  1280    // Spec limit for high duty cycle directed advertising
+#define ADV_FAST_INTERVAL_MIN   0x20    // 20 ms
+#define ADV_FAST_INTERVAL_MAX   0x30    // 30 ms
+#define ADV_SLOW_INTERVAL_MIN   0x0666  // 1022.5 ms (Apple recommended value)
+#define ADV_SLOW_INTERVAL_MAX   0x0666
+
+// Reconnect sequence: directed burst to the bonded phone, then fast
+// undirected advertising for reconnectDelay ms, then slow advertising.
+// While connected with free connection slots, advertising continues slowly
+// so a second device (e.g. a speed sensor) can join.
+enum AdvertisingPhase {
+    ADV_OFF,
+    ADV_DIRECTED,
+    ADV_FAST,
+    ADV_SLOW,
+    ADV_BROADCAST   // Non-connectable, only carries the navigation broadcast
+};
+
+// Ingest task: decodes writes as soon as onWrite queued them, and runs the
+// advertising and connection timers. On the NimBLE host's core, below the
+// IMU; it sleeps until a write or the next timer deadline.
+#define BLE_TASK_CORE           0
+#define BLE_TASK_PRIORITY       4
+#define BLE_TASK_STACK          4096
+#define BLE_TASK_CONNECTED_MS   1000    // Timer step while connected (profile, negotiated parameters)
+#define BLE_TASK_NO_DEADLINE    UINT32_MAX
+
+struct ReconnectStats {
+    uint32_t reconnects;
+    uint32_t lastDisconnectToConnectMs;
+    uint32_t lastDisconnectToFrameMs;  // Disconnect until the HUD showed navigation again
+    uint32_t lastConnectToFrameMs;
+    
+    ReconnectStats() : reconnects(0), lastDisconnectToConnectMs(0),
+                       lastDisconnectToFrameMs(0), lastConnectToFrameMs(0) {}
 };
 
 class BLEServer {
 private:
     NimBLEServer* pServer;
     NimBLEService* pService;
-    NimBLECharacteristic* pCharacteristic;
+    NimBLECharacteristic* pCharacteristic;   // Sygic, also carries notifications
+    NimBLECharacteristic* decoderCharacteristics[NAV_MAX_DECODERS];
     NimBLEAdvertising* pAdvertising;
     
+    // Decoded by the ingest task, copied out by the render task
     NavigationData currentNavData;
-    bool deviceConnected;
     bool hasNewNavData;
+    StaticSemaphore_t navLockBuffer;
+    SemaphoreHandle_t navLock;
+    uint8_t connectionCount;
+    PacketLog* packetLog;
+    NavDecoderRegistry decoders;
+    NavV2Decoder v2Decoder;
+    
+    // Connection state shared by the NimBLE host task (connect, disconnect,
+    // MTU callbacks) and the ingest task (timers, decoding): slots,
+    // advertising phase, connection policy and reconnect bookkeeping.
+    // Taken before navLock when both are needed.
+    StaticSemaphore_t linkLockBuffer;
+    SemaphoreHandle_t linkLock;
+    
+    // Writes are queued per connection and merged in update()
+    IngestScheduler ingest;
+    uint32_t slotDecoders[BLE_MAX_CONNECTIONS];  // Decoder ids seen per connection
+    NimBLEAddress slotPeers[BLE_MAX_CONNECTIONS];
+    bool slotPeerKnown[BLE_MAX_CONNECTIONS];
+    
+    // Republishes navigation in advertising packets (see nav_broadcast.h)
+    bool broadcastEnabled;
+    NavBroadcastEncoder broadcastEncoder;
+    uint8_t broadcastFrame[NAV_BCAST_MAX_FRAME];
+    size_t broadcastLength;
+    
+    // Reconnect policy (from Settings::autoConnect / reconnectDelay)
+    bool autoConnect;
+    uint16_t reconnectDelay;
+    NimBLEAddress lastPeer;      // The phone: last peer that sent navigation
+    bool hasLastPeer;
+    AdvertisingPhase advPhase;
+    uint32_t advPhaseStartMs;
+    
+    // Connection interval / MTU / data length negotiation
+    ConnectionPolicy connPolicy;
+    uint32_t lastStatsRefreshMs;
+    
+    std::atomic<uint32_t> packetsReceived;
+    std::atomic<uint32_t> packetsDropped;  // Overwritten before the UI consumed them, or not queued
+    
+    ReconnectStats reconnectStats;
+    uint32_t disconnectMs;
+    uint32_t connectMs;
+    bool awaitingFirstFrame;
+    bool everConnected;
+    
+    TaskHandle_t task;
+    TaskLoad taskLoad;
     
     // Sygic BLE Service UUID (from original project)
     static const char* SERVICE_UUID;
     static const char* CHARACTERISTIC_UUID;
+    static const char* CHARACTERISTIC_V2_UUID;
+    static const char* CHARACTERISTIC_SPEED_UUID;
     
-    void parseNavigationData(uint8_t* data, size_t length);
+    bool createDecoderCharacteristics();
+    void processIngest(uint32_t nowMs);
+    void publishBroadcast();
+    void publishNavUpdate(uint8_t source, uint32_t nowMs);
+    void beginAdvertisingSequence(uint32_t nowMs);
+    void enterAdvertisingPhase(AdvertisingPhase phase, uint32_t nowMs);
+    void applyConnectionProfile(ConnProfileId profile);
+    void wakeTask();
+    static void taskEntry(void* param);
+    void runTask();
     
 public:
     BLEServer();
@@ -39,9 +162,83 @@ public:
     void startAdvertising();
     void stopAdvertising();
     
-    bool isConnected() const { return deviceConnected; }
+    // Drains the ingestion queues and advances advertising phases and the
+    // connection profile. Called by the ingest task, or directly without one.
+    void update(uint32_t nowMs);
+    // How long update() may sleep: 0 while packets are queued,
+    // BLE_TASK_NO_DEADLINE when only a new write can change anything
+    uint32_t msUntilNextUpdate(uint32_t nowMs) const;
+    
+    // Runs update() in its own task, woken by every queued write
+    bool startTask(uint8_t core = BLE_TASK_CORE, uint8_t priority = BLE_TASK_PRIORITY);
+    bool isTaskRunning() const { return task != nullptr; }
+    TaskHandle_t getTaskHandle() const { return task; }
+    const TaskLoad& getTaskLoad() const { return taskLoad; }
+    void setReconnectPolicy(bool autoConnectEnabled, uint16_t fastAdvertisingMs);
+    AdvertisingPhase getAdvertisingPhase() const { return advPhase; }
+    // Target of the directed reconnect burst; false until one is known
+    bool getReconnectPeer(NimBLEAddress& peer) const;
+    
+    // Connection events. Called by the NimBLE callbacks, and by scripted
+    // stand-in centrals in tests. peer may be nullptr if unknown.
+    void handleConnect(uint16_t connHandle, const NimBLEAddress* peer, uint32_t nowMs);
+    void handleDisconnect(uint16_t connHandle, uint32_t nowMs);
+    // Only the link the connection policy manages updates the reported MTU
+    void handleMtuChange(uint16_t connHandle, uint16_t mtu);
+    
+    // The UI reports when it rendered navigation so reconnect latency can be measured
+    void markFrameRendered(uint32_t nowMs);
+    const ReconnectStats& getReconnectStats() const { return reconnectStats; }
+    
+    // Broadcast mode: every navigation update is also advertised so other
+    // HUDs can follow without connecting. Advertising stays at 100 ms.
+    void setBroadcastEnabled(bool enabled);
+    bool isBroadcastEnabled() const { return broadcastEnabled; }
+    // Manufacturer data currently advertised (empty until the first update)
+    const uint8_t* getBroadcastFrame(size_t& length) const {
+        length = broadcastLength;
+        return broadcastFrame;
+    }
+    
+    uint8_t getConnectionCount() const { return connectionCount; }
+    const IngestStats* getIngestStats(uint16_t connHandle) const { return ingest.getStats(connHandle); }
+    
+    uint32_t getPacketsReceived() const { return packetsReceived; }
+    uint32_t getPacketsDropped() const { return packetsDropped; }
+    
+    // Sends a notification on the NOTIFY characteristic if a client subscribed.
+    // Non-blocking: NimBLE queues the notification for the next connection event.
+    bool notify(const uint8_t* data, size_t length);
+    
+    // Negotiated connection interval, latency, timeout and MTU
+    const ConnectionStats& getConnectionStats() const { return connPolicy.getStats(); }
+    
+    bool isConnected() const { return connectionCount > 0; }
     bool hasNewData() const { return hasNewNavData; }
+    // Copy of the decoded state; safe against the ingest task
     NavigationData getNavigationData();
+    // NavUpdateEvent is published whenever hasNewData() becomes true
+    
+    // Raw write capture (see packet_log.h); nullptr disables recording
+    void setPacketLog(PacketLog* log) { packetLog = log; }
+    
+    // Adds a navigation app protocol. Must be called before init() so its
+    // characteristic is created. Returns the decoder id or -1.
+    int registerDecoder(const NavDecoder& decoder) { return decoders.add(decoder); }
+    NavDecoderRegistry& getDecoders() { return decoders; }
+    
+    // Queues a characteristic write from a connection, as onWrite does.
+    // Returns false if the handle is unknown or the queue is full.
+    bool enqueueWrite(uint16_t connHandle, uint16_t attHandle,
+                      const uint8_t* data, size_t length, uint32_t nowMs);
+    
+    // Decodes a write by ATT handle immediately, bypassing the queues.
+    // Writes from the policy's connection count as link activity.
+    void dispatchWrite(uint16_t connHandle, uint16_t attHandle, const uint8_t* data,
+                       size_t length, uint32_t nowMs);
+    
+    // Feeds a raw payload straight to a decoder id. Used by PacketReplay and tests.
+    void injectPacket(const uint8_t* data, size_t length, uint8_t source = NAV_SOURCE_SYGIC);
     
     // Callback classes
     class ServerCallbacks;
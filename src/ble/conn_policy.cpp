@@ -0,0 +1,59 @@
+#include "conn_policy.h"
+
+// 15-30 ms interval, no latency, 2 s timeout
+const ConnectionProfile CONN_PROFILE_ACTIVE_PARAMS = {12, 24, 0, 200};
+
+// 120-150 ms interval, skip up to 4 events (~750 ms), 5 s timeout
+const ConnectionProfile CONN_PROFILE_IDLE_PARAMS = {96, 120, 4, 500};
+
+ConnectionPolicy::ConnectionPolicy() : connected(false), lastPacketMs(0), lastSwitchMs(0) {
+}
+
+void ConnectionPolicy::onConnect(uint16_t connHandle, uint32_t nowMs) {
+    stats = ConnectionStats();
+    stats.connHandle = connHandle;
+    connected = true;
+
+    // Treat the connection itself as activity: the phone usually starts
+    // sending navigation right after service discovery
+    lastPacketMs = nowMs;
+    lastSwitchMs = nowMs - CONN_MIN_HOLD_MS;
+}
+
+void ConnectionPolicy::onDisconnect() {
+    connected = false;
+    stats.connHandle = 0xFFFF;
+    stats.profile = CONN_PROFILE_NONE;
+}
+
+bool ConnectionPolicy::update(uint32_t nowMs, ConnProfileId& requested) {
+    if (!connected) return false;
+
+    ConnProfileId desired = (nowMs - lastPacketMs < CONN_IDLE_AFTER_MS)
+                            ? CONN_PROFILE_ACTIVE : CONN_PROFILE_IDLE;
+    if (desired == stats.profile) return false;
+
+    // Going active is never delayed; going idle waits out the hold time so
+    // a short gap between packets does not bounce the link
+    if (desired == CONN_PROFILE_IDLE && nowMs - lastSwitchMs < CONN_MIN_HOLD_MS) {
+        return false;
+    }
+
+    if (stats.profile != CONN_PROFILE_NONE) {
+        stats.profileSwitches++;
+    }
+    stats.profile = desired;
+    lastSwitchMs = nowMs;
+    requested = desired;
+    return true;
+}
+
+void ConnectionPolicy::recordNegotiated(uint16_t interval, uint16_t latency, uint16_t timeout) {
+    stats.intervalUnits = interval;
+    stats.latency = latency;
+    stats.supervisionTimeout = timeout;
+}
+
+const ConnectionProfile& ConnectionPolicy::params(ConnProfileId profile) {
+    return profile == CONN_PROFILE_IDLE ? CONN_PROFILE_IDLE_PARAMS : CONN_PROFILE_ACTIVE_PARAMS;
+}
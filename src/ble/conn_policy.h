@@ -0,0 +1,77 @@
+#ifndef CONN_POLICY_H
+#define CONN_POLICY_H
+
+#include <Arduino.h>
+
+// Connection parameter profiles. Intervals are in 1.25 ms units and the
+// supervision timeout in 10 ms units, as on the air. Values respect the
+// Apple accessory guidelines: min interval >= 15 ms, interval * (latency + 1)
+// <= 2 s, and timeout > 3 * interval * (latency + 1).
+#define CONN_PREFERRED_MTU      247   // Fits a full 251-byte LL packet
+#define CONN_PREFERRED_DATA_LEN 251   // LE Data Length Extension TX octets
+
+#define CONN_IDLE_AFTER_MS      5000  // No nav packets for this long -> idle
+#define CONN_MIN_HOLD_MS        2000  // Minimum time between profile switches
+
+enum ConnProfileId {
+    CONN_PROFILE_NONE,
+    CONN_PROFILE_ACTIVE,  // Navigation packets flowing: low latency
+    CONN_PROFILE_IDLE     // Connected but quiet: save airtime and power
+};
+
+struct ConnectionProfile {
+    uint16_t minInterval;
+    uint16_t maxInterval;
+    uint16_t latency;
+    uint16_t supervisionTimeout;
+};
+
+extern const ConnectionProfile CONN_PROFILE_ACTIVE_PARAMS;
+extern const ConnectionProfile CONN_PROFILE_IDLE_PARAMS;
+
+// Values actually negotiated with the central, for runtime inspection
+struct ConnectionStats {
+    uint16_t connHandle;
+    uint16_t intervalUnits;       // 1.25 ms units
+    uint16_t latency;
+    uint16_t supervisionTimeout;  // 10 ms units
+    uint16_t mtu;
+    ConnProfileId profile;        // Last profile requested
+    uint32_t profileSwitches;
+
+    ConnectionStats() : connHandle(0xFFFF), intervalUnits(0), latency(0),
+                        supervisionTimeout(0), mtu(23), profile(CONN_PROFILE_NONE),
+                        profileSwitches(0) {}
+
+    float intervalMs() const { return intervalUnits * 1.25f; }
+};
+
+// Chooses between the active and idle profiles from packet flow. Pure
+// logic: BLEServer applies the requested profile to the link.
+class ConnectionPolicy {
+private:
+    ConnectionStats stats;
+    bool connected;
+    uint32_t lastPacketMs;
+    uint32_t lastSwitchMs;
+
+public:
+    ConnectionPolicy();
+
+    void onConnect(uint16_t connHandle, uint32_t nowMs);
+    void onDisconnect();
+    void onPacket(uint32_t nowMs) { lastPacketMs = nowMs; }
+
+    // Returns true when the link should switch to the profile in 'requested'
+    bool update(uint32_t nowMs, ConnProfileId& requested);
+
+    void recordNegotiated(uint16_t interval, uint16_t latency, uint16_t timeout);
+    void recordMtu(uint16_t mtu) { stats.mtu = mtu; }
+
+    static const ConnectionProfile& params(ConnProfileId profile);
+
+    bool isConnected() const { return connected; }
+    const ConnectionStats& getStats() const { return stats; }
+};
+
+#endif // CONN_POLICY_H
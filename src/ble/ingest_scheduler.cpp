@@ -0,0 +1,150 @@
+#include "ingest_scheduler.h"
+
+#define INGEST_FREE_SLOT 0xFFFF
+
+static_assert((INGEST_QUEUE_SIZE & (INGEST_QUEUE_SIZE - 1)) == 0,
+              "Ingest queue size must be a power of 2");
+
+IngestScheduler::IngestScheduler() : turn(0) {
+    slotLock = xSemaphoreCreateMutexStatic(&slotLockBuffer);
+    for (uint8_t i = 0; i < BLE_MAX_CONNECTIONS; i++) {
+        queues[i].connHandle = INGEST_FREE_SLOT;
+        queues[i].head.store(0);
+        queues[i].tail.store(0);
+        queues[i].deficit = 0;
+        queues[i].stats = IngestStats();
+    }
+}
+
+int IngestScheduler::find(uint16_t connHandle) const {
+    for (uint8_t i = 0; i < BLE_MAX_CONNECTIONS; i++) {
+        if (queues[i].connHandle == connHandle) return i;
+    }
+    return -1;
+}
+
+int IngestScheduler::open(uint16_t connHandle) {
+    int slot = find(connHandle);
+    if (slot >= 0) return slot;
+
+    xSemaphoreTake(slotLock, portMAX_DELAY);
+    slot = find(INGEST_FREE_SLOT);
+    if (slot >= 0) {
+        Queue& q = queues[slot];
+        q.head.store(0, std::memory_order_relaxed);
+        q.tail.store(0, std::memory_order_relaxed);
+        q.deficit = 0;
+        q.stats = IngestStats();
+        q.connHandle = connHandle;
+    }
+    xSemaphoreGive(slotLock);
+    return slot;
+}
+
+int IngestScheduler::close(uint16_t connHandle) {
+    int slot = find(connHandle);
+    if (slot < 0) return -1;
+
+    xSemaphoreTake(slotLock, portMAX_DELAY);
+    queues[slot].connHandle = INGEST_FREE_SLOT;
+    queues[slot].tail.store(queues[slot].head.load(std::memory_order_acquire),
+                            std::memory_order_release);
+    xSemaphoreGive(slotLock);
+    return slot;
+}
+
+bool IngestScheduler::push(uint16_t connHandle, uint16_t attHandle, uint8_t priority,
+                           const uint8_t* data, size_t length, uint32_t nowMs) {
+    int slot = find(connHandle);
+    if (slot < 0 || length == 0 || length > INGEST_MAX_PAYLOAD) return false;
+
+    Queue& q = queues[slot];
+    uint32_t head = q.head.load(std::memory_order_relaxed);
+    uint32_t tail = q.tail.load(std::memory_order_acquire);
+    if (head - tail >= INGEST_QUEUE_SIZE) {
+        q.stats.overflowed++;
+        return false;
+    }
+
+    IngestPacket& packet = q.packets[head & (INGEST_QUEUE_SIZE - 1)];
+    packet.attHandle = attHandle;
+    packet.priority = priority;
+    packet.length = length;
+    packet.arrivalMs = nowMs;
+    memcpy(packet.data, data, length);
+
+    q.head.store(head + 1, std::memory_order_release);
+    q.stats.enqueued++;
+    return true;
+}
+
+int IngestScheduler::pop(uint32_t nowMs, IngestPacket& packet) {
+    // Held until the packet is copied out, so a slot cannot be closed and
+    // reopened for another connection halfway through
+    xSemaphoreTake(slotLock, portMAX_DELAY);
+    for (uint8_t visits = 0; visits < BLE_MAX_CONNECTIONS; visits++) {
+        uint8_t slot = turn;
+        Queue& q = queues[slot];
+        uint32_t tail = q.tail.load(std::memory_order_relaxed);
+        uint32_t head = q.head.load(std::memory_order_acquire);
+        if (q.connHandle == INGEST_FREE_SLOT || head == tail) {
+            q.deficit = 0;
+            turn = (turn + 1) % BLE_MAX_CONNECTIONS;
+            continue;
+        }
+
+        const IngestPacket& next = q.packets[tail & (INGEST_QUEUE_SIZE - 1)];
+        if (q.deficit == 0) {
+            q.deficit = next.priority + 1;
+        }
+        // Collapse only the run of readings from the same characteristic;
+        // a navigation packet queued behind it on this connection stops the skip
+        if (next.priority == NAV_PRIORITY_SENSOR) {
+            uint16_t attHandle = next.attHandle;
+            while (head - tail > 1) {
+                const IngestPacket& after = q.packets[(tail + 1) & (INGEST_QUEUE_SIZE - 1)];
+                if (after.priority != NAV_PRIORITY_SENSOR || after.attHandle != attHandle) break;
+                tail++;
+                q.stats.superseded++;
+            }
+        }
+
+        packet = q.packets[tail & (INGEST_QUEUE_SIZE - 1)];
+        q.tail.store(tail + 1, std::memory_order_release);
+        if (--q.deficit == 0) {
+            turn = (turn + 1) % BLE_MAX_CONNECTIONS;
+        }
+
+        uint32_t wait = nowMs - packet.arrivalMs;
+        if (wait > q.stats.maxWaitMs) q.stats.maxWaitMs = wait;
+        q.stats.delivered++;
+        xSemaphoreGive(slotLock);
+        return slot;
+    }
+    xSemaphoreGive(slotLock);
+    return -1;
+}
+
+uint8_t IngestScheduler::openCount() const {
+    uint8_t count = 0;
+    for (uint8_t i = 0; i < BLE_MAX_CONNECTIONS; i++) {
+        if (queues[i].connHandle != INGEST_FREE_SLOT) count++;
+    }
+    return count;
+}
+
+bool IngestScheduler::hasPending() const {
+    for (uint8_t i = 0; i < BLE_MAX_CONNECTIONS; i++) {
+        const Queue& q = queues[i];
+        if (q.connHandle != INGEST_FREE_SLOT &&
+            q.head.load(std::memory_order_acquire) != q.tail.load(std::memory_order_relaxed)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+const IngestStats* IngestScheduler::getStats(uint16_t connHandle) const {
+    int slot = find(connHandle);
+    return slot >= 0 ? &queues[slot].stats : nullptr;
+}
@@ -0,0 +1,92 @@
+#ifndef INGEST_SCHEDULER_H
+#define INGEST_SCHEDULER_H
+
+#include <Arduino.h>
+#include <atomic>
+#include <freertos/semphr.h>
+
+// Per-connection ingestion queues. The NimBLE host task pushes writes as
+// they arrive; the BLE ingest task pops them with deficit round-robin weighted
+// by priority, so a chatty source (e.g. a speed sensor) cannot delay
+// navigation updates.
+//
+// push() is lock-free against pop(). open() and close() also run on the
+// host task but reset the indices the consumer owns, so they and pop()
+// share a short lock.
+#ifdef CONFIG_BT_NIMBLE_MAX_CONNECTIONS
+#define BLE_MAX_CONNECTIONS     CONFIG_BT_NIMBLE_MAX_CONNECTIONS
+#else
+#define BLE_MAX_CONNECTIONS     3     // NimBLE-Arduino default
+#endif
+
+#define INGEST_QUEUE_SIZE       16    // Packets per connection (power of 2)
+#define INGEST_MAX_PAYLOAD      64    // Fits any v2 packet (NAV_V2_MAX_PACKET)
+#define INGEST_BUDGET           8     // Packets handled per BLEServer::update()
+
+// Decoder priorities: a queue may deliver priority + 1 packets per round.
+// Sensor packets carry absolute readings, so of consecutive queued readings
+// from the same characteristic only the freshest is decoded.
+#define NAV_PRIORITY_SENSOR     0
+#define NAV_PRIORITY_NAVIGATION 3
+
+struct IngestPacket {
+    uint16_t attHandle;
+    uint8_t priority;
+    uint8_t length;
+    uint32_t arrivalMs;
+    uint8_t data[INGEST_MAX_PAYLOAD];
+};
+
+struct IngestStats {
+    uint32_t enqueued;
+    uint32_t delivered;
+    uint32_t overflowed;   // Rejected because this connection's queue was full
+    uint32_t superseded;   // Sensor readings skipped for a newer one
+    uint32_t maxWaitMs;    // Longest time a packet waited in the queue
+};
+
+class IngestScheduler {
+private:
+    struct Queue {
+        uint16_t connHandle;   // 0xFFFF = free slot
+        IngestPacket packets[INGEST_QUEUE_SIZE];
+        std::atomic<uint32_t> head;   // Written by the producer only
+        std::atomic<uint32_t> tail;   // Written by the consumer only
+        uint8_t deficit;              // Packets left in this queue's turn
+        IngestStats stats;
+    };
+
+    Queue queues[BLE_MAX_CONNECTIONS];
+    uint8_t turn;                     // Queue currently being served
+    StaticSemaphore_t slotLockBuffer;
+    SemaphoreHandle_t slotLock;       // Slot lifetime: open()/close() against pop()
+
+    int find(uint16_t connHandle) const;
+
+public:
+    IngestScheduler();
+
+    // Reserves a queue for a new connection. Returns the slot or -1 if full.
+    int open(uint16_t connHandle);
+    // Frees the slot and discards anything still queued. Returns the slot or -1.
+    int close(uint16_t connHandle);
+
+    // Producer side (NimBLE host task). Returns false if the queue is full,
+    // the connection is unknown or the payload is too large.
+    bool push(uint16_t connHandle, uint16_t attHandle, uint8_t priority,
+              const uint8_t* data, size_t length, uint32_t nowMs);
+
+    // Consumer side (ingest task). Visits queues in turn; each non-empty queue
+    // delivers up to priority + 1 packets before the next one is served, so
+    // every source progresses and navigation gets the larger share.
+    // Returns the slot the packet came from, or -1 if everything is empty.
+    int pop(uint32_t nowMs, IngestPacket& packet);
+
+    uint8_t openCount() const;
+    // True while any connection has packets left to pop
+    bool hasPending() const;
+    uint16_t connHandleAt(uint8_t slot) const { return queues[slot].connHandle; }
+    const IngestStats* getStats(uint16_t connHandle) const;
+};
+
+#endif // INGEST_SCHEDULER_H
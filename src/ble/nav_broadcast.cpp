@@ -0,0 +1,132 @@
+#include "nav_broadcast.h"
+#include "ble_server.h"
+
+// --- Encoder ---
+
+size_t NavBroadcastEncoder::encode(const NavigationData& nav, uint8_t* out, size_t capacity) {
+    if (capacity <= NAV_BCAST_HEADER) return 0;
+
+    out[0] = NAV_BCAST_COMPANY_ID & 0xFF;
+    out[1] = NAV_BCAST_COMPANY_ID >> 8;
+    out[2] = NAV_BCAST_MAGIC;
+    out[3] = sequence;
+
+    // Size without the street name, then give the street what is left
+    NavigationData frame = nav;
+    frame.streetName = "";
+    NavV2Encoder sizing;
+    size_t base = sizing.encode(frame, out + NAV_BCAST_HEADER, capacity - NAV_BCAST_HEADER, true);
+    if (base == 0) return 0;
+
+    size_t room = capacity - NAV_BCAST_HEADER - base;
+    size_t len = min((size_t)nav.streetName.length(), room);
+    // Never cut a UTF-8 sequence in half
+    while (len > 0 && len < nav.streetName.length() &&
+           ((uint8_t)nav.streetName[len] & 0xC0) == 0x80) {
+        len--;
+    }
+    frame.streetName = nav.streetName.substring(0, len);
+
+    NavV2Encoder encoder;
+    size_t length = encoder.encode(frame, out + NAV_BCAST_HEADER, capacity - NAV_BCAST_HEADER, true);
+    if (length == 0) return 0;
+
+    sequence++;
+    return NAV_BCAST_HEADER + length;
+}
+
+// --- Receiver ---
+
+bool NavBroadcastReceiver::onManufacturerData(const uint8_t* data, size_t length, NavigationData& nav) {
+    if (length <= NAV_BCAST_HEADER ||
+        (data[0] | (data[1] << 8)) != NAV_BCAST_COMPANY_ID || data[2] != NAV_BCAST_MAGIC) {
+        stats.invalid++;
+        return false;
+    }
+
+    uint8_t sequence = data[3];
+    if (synced && sequence == lastSequence) {
+        stats.duplicates++;
+        return false;
+    }
+
+    decoder.reset();
+    if (!decoder.decode(data + NAV_BCAST_HEADER, length - NAV_BCAST_HEADER, nav)) {
+        stats.invalid++;
+        return false;
+    }
+
+    if (synced) {
+        stats.missed += (uint8_t)(sequence - lastSequence - 1);
+    }
+    synced = true;
+    lastSequence = sequence;
+    stats.frames++;
+    return true;
+}
+
+// --- Scanner ---
+
+class NavBroadcastScanner::ScanCallbacks: public NimBLEAdvertisedDeviceCallbacks {
+    NavBroadcastScanner* scanner;
+public:
+    ScanCallbacks(NavBroadcastScanner* s) : scanner(s) {}
+
+    void onResult(NimBLEAdvertisedDevice* device) {
+        if (!device->haveManufacturerData()) return;
+
+        std::string data = device->getManufacturerData();
+        if (data.length() <= NAV_BCAST_HEADER || data.length() > NAV_BCAST_MAX_FRAME ||
+            (uint8_t)data[2] != NAV_BCAST_MAGIC) {
+            return;
+        }
+
+        // Newest frame wins; the render task decodes it
+        portENTER_CRITICAL(&scanner->frameLock);
+        memcpy(scanner->pendingFrame, data.data(), data.length());
+        scanner->pendingLength = data.length();
+        portEXIT_CRITICAL(&scanner->frameLock);
+    }
+};
+
+NavBroadcastScanner::NavBroadcastScanner() : pendingLength(0) {
+    frameLock = portMUX_INITIALIZER_UNLOCKED;
+}
+
+bool NavBroadcastScanner::begin() {
+    Serial.println("Starting navigation broadcast scanner...");
+
+    NimBLEDevice::init("ESP32-S3-HUD");
+    NimBLEScan* scan = NimBLEDevice::getScan();
+
+    // Every repeat is needed: the payload changes while the address does not
+    scan->setAdvertisedDeviceCallbacks(new ScanCallbacks(this), true);
+    scan->setDuplicateFilter(false);
+    scan->setActiveScan(false);
+    scan->setInterval(NAV_BCAST_SCAN_INTERVAL);
+    scan->setWindow(NAV_BCAST_SCAN_INTERVAL);
+    scan->setMaxResults(0);
+
+    if (!scan->start(0, nullptr, false)) {
+        Serial.println("Failed to start broadcast scan");
+        return false;
+    }
+    return true;
+}
+
+void NavBroadcastScanner::stop() {
+    NimBLEDevice::getScan()->stop();
+}
+
+bool NavBroadcastScanner::poll(NavigationData& nav) {
+    uint8_t frame[NAV_BCAST_MAX_FRAME];
+    uint8_t length;
+
+    portENTER_CRITICAL(&frameLock);
+    length = pendingLength;
+    memcpy(frame, pendingFrame, length);
+    pendingLength = 0;
+    portEXIT_CRITICAL(&frameLock);
+
+    return length > 0 && receiver.onManufacturerData(frame, length, nav);
+}
@@ -0,0 +1,86 @@
+#ifndef NAV_BROADCAST_H
+#define NAV_BROADCAST_H
+
+#include <Arduino.h>
+#include <NimBLEDevice.h>
+#include "nav_protocol_v2.h"
+
+struct NavigationData;
+
+// Connectionless navigation broadcast. The unit linked to the phone
+// republishes each navigation update as manufacturer data in its
+// advertising packets; other units read it with a passive scan and never
+// connect, so the phone serves a single link however many HUDs there are.
+//
+// Frame: [company id LE][magic][sequence][v2 keyframe]
+// Every frame is a keyframe because a receiver may join at any time or
+// miss frames. Legacy advertising is used (see BLEServer) so the street
+// name is trimmed to fit the 31-byte packet.
+#define NAV_BCAST_COMPANY_ID     0xFFFF  // Bluetooth SIG value reserved for testing
+#define NAV_BCAST_MAGIC          0xD5
+#define NAV_BCAST_HEADER         4
+#define NAV_BCAST_MAX_FRAME      26      // 31 - flags (3) - AD header (2)
+#define NAV_BCAST_ADV_INTERVAL   0xA0    // 100 ms, 0.625 ms units
+#define NAV_BCAST_SCAN_INTERVAL  0x50    // 50 ms; window = interval for 100% duty
+
+class NavBroadcastEncoder {
+private:
+    uint8_t sequence;
+
+public:
+    NavBroadcastEncoder() : sequence(0) {}
+
+    // Builds the next frame. Returns its length, or 0 if capacity is too small.
+    size_t encode(const NavigationData& nav, uint8_t* out, size_t capacity);
+};
+
+struct NavBroadcastStats {
+    uint32_t frames;      // New frames decoded
+    uint32_t duplicates;  // Repeats of the current frame (normal: each is advertised many times)
+    uint32_t missed;      // Sequence gaps
+    uint32_t invalid;     // Not ours or failed to decode
+};
+
+class NavBroadcastReceiver {
+private:
+    NavV2Decoder decoder;
+    bool synced;
+    uint8_t lastSequence;
+    NavBroadcastStats stats;
+
+public:
+    NavBroadcastReceiver() : synced(false), lastSequence(0), stats() {}
+
+    // Feeds manufacturer data from an advertisement. Returns true when it
+    // carried a new frame and nav was updated.
+    bool onManufacturerData(const uint8_t* data, size_t length, NavigationData& nav);
+
+    const NavBroadcastStats& getStats() const { return stats; }
+};
+
+// Receiver role: passive scan that hands the newest frame to the render task
+class NavBroadcastScanner {
+private:
+    NavBroadcastReceiver receiver;
+
+    // Latest raw frame from the scan callback (NimBLE host task)
+    portMUX_TYPE frameLock;
+    uint8_t pendingFrame[NAV_BCAST_MAX_FRAME];
+    uint8_t pendingLength;
+
+    class ScanCallbacks;
+
+public:
+    NavBroadcastScanner();
+
+    bool begin();
+    void stop();
+
+    // Decodes the newest frame into nav, if one arrived since the last
+    // call. Returns true when nav was updated; call from the render task.
+    bool poll(NavigationData& nav);
+
+    const NavBroadcastStats& getStats() const { return receiver.getStats(); }
+};
+
+#endif // NAV_BROADCAST_H
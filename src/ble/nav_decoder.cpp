@@ -0,0 +1,42 @@
+#include "nav_decoder.h"
+
+NavDecoderRegistry::NavDecoderRegistry() : count(0) {
+    clearHandles();
+}
+
+int NavDecoderRegistry::add(const NavDecoder& decoder) {
+    if (count >= NAV_MAX_DECODERS || !decoder.parse) {
+        return -1;
+    }
+
+    decoders[count] = decoder;
+    return count++;
+}
+
+bool NavDecoderRegistry::bindHandle(uint16_t handle, uint8_t id) {
+    if (handle >= NAV_MAX_ATT_HANDLE || id >= count) {
+        Serial.printf("Cannot route ATT handle %u to decoder %u\n", handle, id);
+        return false;
+    }
+
+    handleTable[handle] = id;
+    return true;
+}
+
+void NavDecoderRegistry::clearHandles() {
+    memset(handleTable, NAV_DECODER_NONE, sizeof(handleTable));
+}
+
+void NavDecoderRegistry::reset(uint8_t id) {
+    if (id < count && decoders[id].reset) {
+        decoders[id].reset(decoders[id].context);
+    }
+}
+
+void NavDecoderRegistry::resetAll() {
+    for (uint8_t i = 0; i < count; i++) {
+        if (decoders[i].reset) {
+            decoders[i].reset(decoders[i].context);
+        }
+    }
+}
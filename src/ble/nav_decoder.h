@@ -0,0 +1,63 @@
+#ifndef NAV_DECODER_H
+#define NAV_DECODER_H
+
+#include <Arduino.h>
+
+// Registry of navigation app protocols. Each decoder declares where its
+// data arrives (service + characteristic UUID) and a parse function that
+// updates the common NavigationData record. Writes are routed by ATT
+// handle through a flat table, so dispatch cost does not depend on how
+// many decoders are registered.
+#define NAV_MAX_DECODERS    8
+#define NAV_MAX_ATT_HANDLE  128   // NimBLE assigns small, dense handles
+#define NAV_DECODER_NONE    0xFF
+
+struct NavigationData;
+
+// Returns true when nav was updated and should be shown
+typedef bool (*NavParseFn)(void* context, const uint8_t* data, size_t length, NavigationData& nav);
+
+// Drops per-connection state (e.g. delta baselines) on disconnect
+typedef void (*NavResetFn)(void* context);
+
+struct NavDecoder {
+    const char* name;
+    const char* serviceUuid;
+    const char* characteristicUuid;
+    uint32_t properties;          // NIMBLE_PROPERTY flags for the characteristic
+    NavParseFn parse;
+    NavResetFn reset;             // Optional
+    void* context;                // Passed back to parse/reset
+    uint8_t priority;             // NAV_PRIORITY_* (see ingest_scheduler.h)
+};
+
+class NavDecoderRegistry {
+private:
+    NavDecoder decoders[NAV_MAX_DECODERS];
+    uint8_t count;
+    uint8_t handleTable[NAV_MAX_ATT_HANDLE];
+
+public:
+    NavDecoderRegistry();
+
+    // Returns the decoder id (registration order), or -1 if full or invalid
+    int add(const NavDecoder& decoder);
+
+    // Routes writes on an ATT handle to a decoder id
+    bool bindHandle(uint16_t handle, uint8_t id);
+    void clearHandles();
+
+    // Decoder id for an ATT handle, or NAV_DECODER_NONE
+    inline uint8_t lookup(uint16_t handle) const {
+        return handle < NAV_MAX_ATT_HANDLE ? handleTable[handle] : NAV_DECODER_NONE;
+    }
+
+    const NavDecoder* get(uint8_t id) const { return id < count ? &decoders[id] : nullptr; }
+    uint8_t size() const { return count; }
+
+    // Calls the reset hook of one decoder, or of every decoder
+    void reset(uint8_t id);
+    void resetAll();
+};
+
+#endif // NAV_DECODER_H
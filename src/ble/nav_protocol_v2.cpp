@@ -0,0 +1,218 @@
+#include "nav_protocol_v2.h"
+#include "ble_server.h"
+
+static const char* const TURN_INSTRUCTIONS[NAV_TURN_COUNT] = {
+    "Continue",        // NAV_TURN_NONE
+    "Turn Left",
+    "Turn Right",
+    "Go Straight",
+    "U-Turn",
+    "Slight Left",
+    "Slight Right",
+    "Sharp Left",
+    "Sharp Right",
+    "Keep Left",
+    "Keep Right",
+    "Roundabout",
+    "Exit Left",
+    "Exit Right",
+    "Merge",
+    "Arrive",
+};
+
+const char* navTurnInstruction(uint8_t turn) {
+    return turn < NAV_TURN_COUNT ? TURN_INSTRUCTIONS[turn] : TURN_INSTRUCTIONS[NAV_TURN_NONE];
+}
+
+// --- Varint helpers (LEB128, little-endian base 128) ---
+
+static size_t putVarint(uint8_t* out, size_t pos, size_t capacity, uint32_t value) {
+    do {
+        if (pos >= capacity) return 0;
+        uint8_t byte = value & 0x7F;
+        value >>= 7;
+        out[pos++] = byte | (value ? 0x80 : 0);
+    } while (value);
+    return pos;
+}
+
+static bool getVarint(const uint8_t* data, size_t length, size_t& pos, uint32_t& value) {
+    value = 0;
+    for (uint8_t shift = 0; shift < 35; shift += 7) {
+        if (pos >= length) return false;
+        uint8_t byte = data[pos++];
+        value |= (uint32_t)(byte & 0x7F) << shift;
+        if (!(byte & 0x80)) return true;
+    }
+    return false;
+}
+
+static inline uint32_t zigzag(int32_t v) { return ((uint32_t)v << 1) ^ (uint32_t)(v >> 31); }
+static inline int32_t unzigzag(uint32_t v) { return (int32_t)(v >> 1) ^ -(int32_t)(v & 1); }
+
+// --- Encoder ---
+
+NavV2Encoder::NavV2Encoder() : hasPrevious(false), prevDistance(0), prevTurn(0),
+                               prevSpeedLimit(0), prevSpeed(0), prevEta(0),
+                               prevLaneCount(0), prevLaneMask(0) {
+}
+
+size_t NavV2Encoder::encode(const NavigationData& nav, uint8_t* out, size_t capacity, bool keyframe) {
+    if (!hasPrevious) keyframe = true;
+
+    uint32_t mask = 0;
+    if (keyframe) {
+        mask = NAV_V2_FIELD_KEYFRAME | NAV_V2_FIELD_DISTANCE | NAV_V2_FIELD_TURN |
+               NAV_V2_FIELD_SPEED_LIM | NAV_V2_FIELD_SPEED | NAV_V2_FIELD_ETA |
+               NAV_V2_FIELD_LANES | NAV_V2_FIELD_STREET;
+    } else {
+        if (nav.distance != prevDistance) mask |= NAV_V2_FIELD_DISTANCE;
+        if (nav.turnDirection != prevTurn) mask |= NAV_V2_FIELD_TURN;
+        if (nav.speedLimit != prevSpeedLimit) mask |= NAV_V2_FIELD_SPEED_LIM;
+        if (nav.currentSpeed != prevSpeed) mask |= NAV_V2_FIELD_SPEED;
+        if (nav.etaSeconds != prevEta) mask |= NAV_V2_FIELD_ETA;
+        if (nav.laneCount != prevLaneCount || nav.laneMask != prevLaneMask) mask |= NAV_V2_FIELD_LANES;
+        if (nav.streetName != prevStreet) mask |= NAV_V2_FIELD_STREET;
+    }
+
+    size_t pos = 0;
+    if (capacity < 2) return 0;
+    out[pos++] = NAV_V2_VERSION;
+    if (!(pos = putVarint(out, pos, capacity, mask))) return 0;
+
+    if (mask & NAV_V2_FIELD_DISTANCE) {
+        int32_t value = keyframe ? nav.distance : nav.distance - prevDistance;
+        if (!(pos = putVarint(out, pos, capacity, zigzag(value)))) return 0;
+    }
+    if (mask & NAV_V2_FIELD_TURN) {
+        if (pos >= capacity) return 0;
+        out[pos++] = (uint8_t)nav.turnDirection;
+    }
+    if (mask & NAV_V2_FIELD_SPEED_LIM) {
+        if (pos >= capacity) return 0;
+        out[pos++] = (uint8_t)constrain(nav.speedLimit, 0, 255);
+    }
+    if (mask & NAV_V2_FIELD_SPEED) {
+        if (pos >= capacity) return 0;
+        out[pos++] = (uint8_t)constrain(nav.currentSpeed, 0, 255);
+    }
+    if (mask & NAV_V2_FIELD_ETA) {
+        if (!(pos = putVarint(out, pos, capacity, nav.etaSeconds))) return 0;
+    }
+    if (mask & NAV_V2_FIELD_LANES) {
+        if (pos >= capacity) return 0;
+        out[pos++] = nav.laneCount;
+        if (!(pos = putVarint(out, pos, capacity, nav.laneMask))) return 0;
+    }
+    if (mask & NAV_V2_FIELD_STREET) {
+        size_t len = min((size_t)nav.streetName.length(), (size_t)NAV_V2_MAX_STREET);
+        // Cut on a code point boundary, never inside a UTF-8 sequence
+        while (len > 0 && len < nav.streetName.length() &&
+               ((uint8_t)nav.streetName[len] & 0xC0) == 0x80) {
+            len--;
+        }
+        if (pos + 1 + len > capacity) return 0;
+        out[pos++] = (uint8_t)len;
+        memcpy(out + pos, nav.streetName.c_str(), len);
+        pos += len;
+    }
+
+    hasPrevious = true;
+    prevDistance = nav.distance;
+    prevTurn = nav.turnDirection;
+    prevSpeedLimit = nav.speedLimit;
+    prevSpeed = nav.currentSpeed;
+    prevEta = nav.etaSeconds;
+    prevLaneCount = nav.laneCount;
+    prevLaneMask = nav.laneMask;
+    prevStreet = nav.streetName;
+    return pos;
+}
+
+// --- Decoder ---
+
+NavV2Decoder::NavV2Decoder() : synced(false), distance(0) {
+}
+
+bool NavV2Decoder::decode(const uint8_t* data, size_t length, NavigationData& nav) {
+    if (length < 2 || data[0] != NAV_V2_VERSION) return false;
+
+    size_t pos = 1;
+    uint32_t mask;
+    if (!getVarint(data, length, pos, mask)) return false;
+
+    bool keyframe = mask & NAV_V2_FIELD_KEYFRAME;
+    if (!keyframe && !synced) return false;
+
+    // Parse everything first so a truncated packet never half-applies
+    uint32_t rawDistance = 0, eta = 0, laneMask = 0;
+    uint8_t turn = 0, speedLimit = 0, speed = 0, laneCount = 0;
+    const uint8_t* street = nullptr;
+    uint8_t streetLen = 0;
+
+    if (mask & NAV_V2_FIELD_DISTANCE) {
+        if (!getVarint(data, length, pos, rawDistance)) return false;
+    }
+    if (mask & NAV_V2_FIELD_TURN) {
+        if (pos >= length) return false;
+        turn = data[pos++];
+    }
+    if (mask & NAV_V2_FIELD_SPEED_LIM) {
+        if (pos >= length) return false;
+        speedLimit = data[pos++];
+    }
+    if (mask & NAV_V2_FIELD_SPEED) {
+        if (pos >= length) return false;
+        speed = data[pos++];
+    }
+    if (mask & NAV_V2_FIELD_ETA) {
+        if (!getVarint(data, length, pos, eta)) return false;
+    }
+    if (mask & NAV_V2_FIELD_LANES) {
+        if (pos >= length) return false;
+        laneCount = data[pos++];
+        if (!getVarint(data, length, pos, laneMask)) return false;
+    }
+    if (mask & NAV_V2_FIELD_STREET) {
+        if (pos >= length) return false;
+        streetLen = data[pos++];
+        if (pos + streetLen > length) return false;
+        street = data + pos;
+        pos += streetLen;
+    }
+    // Extension fields: skip [length][bytes] for every higher bit
+    for (uint32_t ext = mask >> 8; ext; ext >>= 1) {
+        if (!(ext & 1)) continue;
+        uint32_t extLen;
+        if (!getVarint(data, length, pos, extLen) || pos + extLen > length) return false;
+        pos += extLen;
+    }
+
+    if (mask & NAV_V2_FIELD_DISTANCE) {
+        int32_t value = unzigzag(rawDistance);
+        distance = keyframe ? value : distance + value;
+        nav.distance = distance;
+    }
+    if (mask & NAV_V2_FIELD_TURN) {
+        nav.turnDirection = turn;
+        nav.instruction = navTurnInstruction(turn);
+    }
+    if (mask & NAV_V2_FIELD_SPEED_LIM) nav.speedLimit = speedLimit;
+    if (mask & NAV_V2_FIELD_SPEED) nav.currentSpeed = speed;
+    if (mask & NAV_V2_FIELD_ETA) nav.etaSeconds = eta;
+    if (mask & NAV_V2_FIELD_LANES) {
+        nav.laneCount = laneCount;
+        nav.laneMask = laneMask;
+    }
+    if (mask & NAV_V2_FIELD_STREET) {
+        char name[NAV_V2_MAX_STREET + 1];
+        uint8_t len = min(streetLen, (uint8_t)NAV_V2_MAX_STREET);
+        memcpy(name, street, len);
+        name[len] = '\0';
+        nav.streetName = name;
+    }
+
+    nav.isValid = true;
+    synced = true;
+    return true;
+}
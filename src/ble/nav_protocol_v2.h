@@ -0,0 +1,95 @@
+#ifndef NAV_PROTOCOL_V2_H
+#define NAV_PROTOCOL_V2_H
+
+#include <Arduino.h>
+
+struct NavigationData;
+
+// Compact binary navigation protocol, version 2.
+//
+// Packet layout:
+//   [0]     version (NAV_V2_VERSION)
+//   [1..]   varint bitmask of the fields present in this packet
+//   [...]   one value per set bit, in bit order
+//
+// Only fields that changed since the previous packet are sent. Bits 0-7
+// have the fixed encodings below; bits 8 and up are extension fields sent
+// as [varint length][bytes] so older decoders can skip them.
+#define NAV_V2_VERSION          0x02
+#define NAV_V2_MAX_PACKET       64
+#define NAV_V2_MAX_STREET       32
+
+#define NAV_V2_FIELD_DISTANCE   (1u << 0)  // zigzag varint, delta unless KEYFRAME
+#define NAV_V2_FIELD_TURN       (1u << 1)  // u8 NavTurn code
+#define NAV_V2_FIELD_SPEED_LIM  (1u << 2)  // u8 km/h
+#define NAV_V2_FIELD_SPEED      (1u << 3)  // u8 km/h
+#define NAV_V2_FIELD_ETA        (1u << 4)  // varint seconds to arrival
+#define NAV_V2_FIELD_LANES      (1u << 5)  // u8 lane count, varint recommended-lane mask
+#define NAV_V2_FIELD_STREET     (1u << 6)  // u8 length + UTF-8 bytes
+#define NAV_V2_FIELD_KEYFRAME   (1u << 7)  // values are absolute; decoder state resets
+
+// Turn codes. 0x01-0x04 match the Sygic format.
+enum NavTurn {
+    NAV_TURN_NONE = 0x00,
+    NAV_TURN_LEFT = 0x01,
+    NAV_TURN_RIGHT = 0x02,
+    NAV_TURN_STRAIGHT = 0x03,
+    NAV_TURN_UTURN = 0x04,
+    NAV_TURN_SLIGHT_LEFT = 0x05,
+    NAV_TURN_SLIGHT_RIGHT = 0x06,
+    NAV_TURN_SHARP_LEFT = 0x07,
+    NAV_TURN_SHARP_RIGHT = 0x08,
+    NAV_TURN_KEEP_LEFT = 0x09,
+    NAV_TURN_KEEP_RIGHT = 0x0A,
+    NAV_TURN_ROUNDABOUT = 0x0B,
+    NAV_TURN_EXIT_LEFT = 0x0C,
+    NAV_TURN_EXIT_RIGHT = 0x0D,
+    NAV_TURN_MERGE = 0x0E,
+    NAV_TURN_ARRIVE = 0x0F,
+    NAV_TURN_COUNT
+};
+
+const char* navTurnInstruction(uint8_t turn);
+
+// Phone side (and test/benchmark side) of the protocol
+class NavV2Encoder {
+private:
+    bool hasPrevious;
+    int prevDistance;
+    int prevTurn;
+    int prevSpeedLimit;
+    int prevSpeed;
+    uint32_t prevEta;
+    uint8_t prevLaneCount;
+    uint16_t prevLaneMask;
+    String prevStreet;
+
+public:
+    NavV2Encoder();
+
+    // Encodes the fields that changed since the last call. A keyframe
+    // carries every field with absolute values. Returns bytes written.
+    size_t encode(const NavigationData& nav, uint8_t* out, size_t capacity, bool keyframe = false);
+    void reset() { hasPrevious = false; }
+};
+
+// HUD side: applies packets onto a NavigationData record
+class NavV2Decoder {
+private:
+    bool synced;      // A keyframe has been seen
+    int32_t distance; // Delta base; kept here because other sources also write nav.distance
+
+public:
+    NavV2Decoder();
+
+    // Returns false for malformed packets, unknown versions, or deltas
+    // received before the first keyframe. nav is left untouched then.
+    bool decode(const uint8_t* data, size_t length, NavigationData& nav);
+    void reset() {
+        synced = false;
+        distance = 0;
+    }
+    bool isSynced() const { return synced; }
+};
+
+#endif // NAV_PROTOCOL_V2_H
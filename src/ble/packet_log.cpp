@@ -0,0 +1,239 @@
+#include "packet_log.h"
+#include "ingest_scheduler.h"
+
+#define PACKET_LOG_SECTOR_SIZE 4096
+#define RECORDS_PER_SECTOR (PACKET_LOG_SECTOR_SIZE / sizeof(PacketRecord))
+
+static_assert(sizeof(PacketRecord) == 128, "PacketRecord must stay 128 bytes");
+static_assert(PACKET_LOG_SECTOR_SIZE % sizeof(PacketRecord) == 0, "Records must not straddle sectors");
+static_assert(PACKET_LOG_MAX_PAYLOAD >= INGEST_MAX_PAYLOAD, "Every packet the server accepts must fit a record");
+static_assert((PACKET_LOG_STAGING_SIZE & (PACKET_LOG_STAGING_SIZE - 1)) == 0,
+              "Staging size must be a power of 2");
+
+PacketLog::PacketLog() : partition(nullptr), capacity(0), oldestIndex(0),
+                         writeIndex(0), nextSequence(0), enabled(true),
+                         flushTask(nullptr), stagingHead(0), stagingTail(0),
+                         stats() {
+}
+
+PacketLog::~PacketLog() {
+    if (flushTask) {
+        vTaskDelete(flushTask);
+    }
+}
+
+bool PacketLog::init(const char* label) {
+    partition = esp_partition_find_first(ESP_PARTITION_TYPE_DATA,
+                                         (esp_partition_subtype_t)PACKET_LOG_PARTITION_SUBTYPE,
+                                         label);
+    if (!partition) {
+        Serial.printf("Packet log: %s partition not found\n", label);
+        return false;
+    }
+
+    capacity = (partition->size / PACKET_LOG_SECTOR_SIZE) * RECORDS_PER_SECTOR;
+    locateHead();
+
+    Serial.printf("Packet log ready: %u records stored, capacity %u\n",
+                  recordCount(), capacity);
+    return true;
+}
+
+bool PacketLog::startFlushTask(uint8_t core, uint8_t priority) {
+    if (!partition || flushTask) return false;
+
+    BaseType_t result = xTaskCreatePinnedToCore(flushTaskEntry, "pktlog", PACKET_LOG_TASK_STACK, this,
+                                                priority, &flushTask, core);
+    return result == pdPASS;
+}
+
+void PacketLog::flushTaskEntry(void* param) {
+    PacketLog* log = static_cast<PacketLog*>(param);
+    for (;;) {
+        // Woken by record(); the timeout only bounds how long a lone packet waits
+        ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(500));
+        uint32_t wakeUs = micros();
+        log->flush();
+        log->taskLoad.add(micros() - wakeUs);
+    }
+}
+
+void PacketLog::record(uint8_t source, const uint8_t* data, size_t length) {
+    if (!enabled || !partition) return;
+
+    uint32_t head = stagingHead.load(std::memory_order_relaxed);
+    uint32_t tail = stagingTail.load(std::memory_order_acquire);
+    if (head - tail >= PACKET_LOG_STAGING_SIZE) {
+        stats.dropped++;
+        return;
+    }
+
+    PacketRecord& rec = staging[head & (PACKET_LOG_STAGING_SIZE - 1)];
+    rec.magic = PACKET_LOG_RECORD_MAGIC;
+    rec.source = source;
+    rec.flags = 0;
+    rec.timestampMs = millis();
+    if (length > PACKET_LOG_MAX_PAYLOAD) {
+        length = PACKET_LOG_MAX_PAYLOAD;
+        rec.flags |= PACKET_LOG_FLAG_TRUNCATED;
+    }
+    rec.length = length;
+    memcpy(rec.data, data, length);
+    memset(rec.data + length, 0, PACKET_LOG_MAX_PAYLOAD - length);
+
+    stagingHead.store(head + 1, std::memory_order_release);
+    stats.recorded++;
+
+    if (flushTask) {
+        xTaskNotifyGive(flushTask);
+    }
+}
+
+uint32_t PacketLog::flush() {
+    if (!partition) return 0;
+
+    uint32_t written = 0;
+    uint32_t tail = stagingTail.load(std::memory_order_relaxed);
+    while (tail != stagingHead.load(std::memory_order_acquire)) {
+        PacketRecord& rec = staging[tail & (PACKET_LOG_STAGING_SIZE - 1)];
+        rec.sequence = nextSequence;
+
+        if (!writeSlot(writeIndex, rec)) {
+            break;
+        }
+
+        nextSequence++;
+        writeIndex = (writeIndex + 1) % capacity;
+
+        // Keep the sector ahead of the write pointer erased so a power cut
+        // never leaves a half-overwritten sector behind the head
+        if (writeIndex % RECORDS_PER_SECTOR == 0) {
+            eraseSectorAt(writeIndex);
+        }
+
+        tail++;
+        stagingTail.store(tail, std::memory_order_release);
+        written++;
+    }
+
+    stats.flushed += written;
+    return written;
+}
+
+bool PacketLog::readSlot(uint32_t slot, PacketRecord& record) const {
+    if (esp_partition_read(partition, slot * sizeof(PacketRecord), &record, sizeof(record)) != ESP_OK) {
+        return false;
+    }
+    return record.magic == PACKET_LOG_RECORD_MAGIC;
+}
+
+bool PacketLog::writeSlot(uint32_t slot, const PacketRecord& record) {
+    return esp_partition_write(partition, slot * sizeof(PacketRecord), &record, sizeof(record)) == ESP_OK;
+}
+
+void PacketLog::eraseSectorAt(uint32_t slot) {
+    uint32_t sectorStart = slot - (slot % RECORDS_PER_SECTOR);
+
+    // Erasing the sector that holds the oldest records moves the tail forward.
+    // oldestIndex == writeIndex is ambiguous (empty or wrapped), so look at flash.
+    PacketRecord rec;
+    bool holdsOldest = oldestIndex >= sectorStart &&
+                       oldestIndex < sectorStart + RECORDS_PER_SECTOR &&
+                       readSlot(oldestIndex, rec);
+
+    esp_partition_erase_range(partition, sectorStart * sizeof(PacketRecord), PACKET_LOG_SECTOR_SIZE);
+
+    if (holdsOldest) {
+        oldestIndex = (sectorStart + RECORDS_PER_SECTOR) % capacity;
+    }
+}
+
+void PacketLog::locateHead() {
+    uint32_t sectors = capacity / RECORDS_PER_SECTOR;
+    PacketRecord rec;
+
+    // Sectors fill in order, so the first record of each one is enough to
+    // find the newest sector
+    int32_t newestSector = -1;
+    uint32_t newestSequence = 0;
+    for (uint32_t s = 0; s < sectors; s++) {
+        if (readSlot(s * RECORDS_PER_SECTOR, rec) &&
+            (newestSector < 0 || rec.sequence > newestSequence)) {
+            newestSector = s;
+            newestSequence = rec.sequence;
+        }
+    }
+
+    if (newestSector < 0) {
+        oldestIndex = 0;
+        writeIndex = 0;
+        nextSequence = 0;
+        esp_partition_read(partition, 0, &rec, sizeof(rec));
+        if (rec.magic != 0xFF) {
+            eraseSectorAt(0);
+        }
+        return;
+    }
+
+    // Binary search for the first empty slot inside the newest sector
+    uint32_t base = newestSector * RECORDS_PER_SECTOR;
+    uint32_t lo = 1, hi = RECORDS_PER_SECTOR;
+    while (lo < hi) {
+        uint32_t mid = (lo + hi) / 2;
+        if (readSlot(base + mid, rec)) lo = mid + 1;
+        else hi = mid;
+    }
+    readSlot(base + lo - 1, rec);
+    nextSequence = rec.sequence + 1;
+    writeIndex = (base + lo) % capacity;
+
+    // The oldest data is in the first populated sector after the newest one
+    oldestIndex = base;
+    for (uint32_t k = 1; k < sectors; k++) {
+        uint32_t s = (newestSector + k) % sectors;
+        if (s != (uint32_t)newestSector && readSlot(s * RECORDS_PER_SECTOR, rec)) {
+            oldestIndex = s * RECORDS_PER_SECTOR;
+            break;
+        }
+    }
+
+    if (writeIndex % RECORDS_PER_SECTOR == 0) {
+        eraseSectorAt(writeIndex);
+    }
+}
+
+uint32_t PacketLog::recordCount() const {
+    if (capacity == 0) return 0;
+    return (writeIndex + capacity - oldestIndex) % capacity;
+}
+
+bool PacketLog::readRecord(uint32_t index, PacketRecord& record) const {
+    if (!partition || index >= recordCount()) return false;
+    return readSlot((oldestIndex + index) % capacity, record);
+}
+
+void PacketLog::clear() {
+    if (!partition) return;
+
+    esp_partition_erase_range(partition, 0, partition->size);
+    oldestIndex = 0;
+    writeIndex = 0;
+    nextSequence = 0;
+    Serial.println("Packet log cleared");
+}
+
+void PacketLog::dumpToSerial() const {
+    PacketRecord rec;
+    uint32_t count = recordCount();
+
+    Serial.printf("# packet log: %u records\n", count);
+    for (uint32_t i = 0; i < count; i++) {
+        if (!readRecord(i, rec)) continue;
+
+        Serial.printf("%u,%u,%u,", rec.sequence, rec.timestampMs, rec.source);
+        for (uint8_t j = 0; j < rec.length; j++) {
+            Serial.printf("%02X", rec.data[j]);
+        }
+        Serial.println();
+    }
+}
@@ -0,0 +1,96 @@
+#ifndef PACKET_LOG_H
+#define PACKET_LOG_H
+
+#include <Arduino.h>
+#include <atomic>
+#include <esp_partition.h>
+#include "../core/task_monitor.h"
+
+// Flash ring log of raw BLE characteristic writes.
+// Records are staged in RAM from the BLE callback and written to the
+// "navlog" data partition (see partitions.csv) by a background task.
+#define PACKET_LOG_PARTITION_LABEL   "navlog"
+#define PACKET_LOG_TEST_LABEL        "navtest"  // Scratch copy for the unit tests
+#define PACKET_LOG_PARTITION_SUBTYPE 0x40
+#define PACKET_LOG_MAX_PAYLOAD       116  // Fills a 128-byte record; covers INGEST_MAX_PAYLOAD
+#define PACKET_LOG_STAGING_SIZE      64   // Records buffered in RAM (power of 2)
+#define PACKET_LOG_RECORD_MAGIC      0xA6 // 0xA5 marked the old 32-byte records
+#define PACKET_LOG_FLAG_TRUNCATED    0x01
+#define PACKET_LOG_TASK_CORE         0
+#define PACKET_LOG_TASK_PRIORITY     1
+#define PACKET_LOG_TASK_STACK        3072
+
+// One 128-byte flash record, so a sector holds a whole number of them.
+// Erased flash reads as 0xFF, so a record is only valid when magic matches.
+struct PacketRecord {
+    uint8_t magic;
+    uint8_t length;      // Payload bytes stored in data[]
+    uint8_t source;      // Characteristic the write arrived on (0 = Sygic)
+    uint8_t flags;
+    uint32_t sequence;   // Monotonic across reboots
+    uint32_t timestampMs;
+    uint8_t data[PACKET_LOG_MAX_PAYLOAD];
+};
+
+struct PacketLogStats {
+    uint32_t recorded;   // Writes accepted into the staging ring
+    uint32_t flushed;    // Records written to flash
+    uint32_t dropped;    // Writes lost because the staging ring was full
+};
+
+class PacketLog {
+private:
+    const esp_partition_t* partition;
+    uint32_t capacity;       // Records that fit in the partition
+    uint32_t oldestIndex;    // Flash slot of the oldest valid record
+    uint32_t writeIndex;     // Next flash slot to write
+    uint32_t nextSequence;
+    bool enabled;
+    TaskHandle_t flushTask;
+    TaskLoad taskLoad;
+
+    // Single-producer (BLE host task) / single-consumer (flush task) ring
+    PacketRecord staging[PACKET_LOG_STAGING_SIZE];
+    std::atomic<uint32_t> stagingHead;
+    std::atomic<uint32_t> stagingTail;
+
+    PacketLogStats stats;
+
+    bool readSlot(uint32_t slot, PacketRecord& record) const;
+    bool writeSlot(uint32_t slot, const PacketRecord& record);
+    void eraseSectorAt(uint32_t slot);
+    void locateHead();
+    static void flushTaskEntry(void* param);
+
+public:
+    PacketLog();
+    ~PacketLog();
+
+    // The tests pass PACKET_LOG_TEST_LABEL so they never erase a capture
+    bool init(const char* label = PACKET_LOG_PARTITION_LABEL);
+    bool startFlushTask(uint8_t core = PACKET_LOG_TASK_CORE, uint8_t priority = PACKET_LOG_TASK_PRIORITY);
+    bool isReady() const { return partition != nullptr; }
+    TaskHandle_t getTaskHandle() const { return flushTask; }
+    const TaskLoad& getTaskLoad() const { return taskLoad; }
+
+    void setEnabled(bool enable) { enabled = enable; }
+    bool isEnabled() const { return enabled; }
+
+    // Called from onWrite: copies into RAM only, never touches flash
+    void record(uint8_t source, const uint8_t* data, size_t length);
+
+    // Drains the staging ring to flash; returns records written
+    uint32_t flush();
+
+    // Chronological access to the records stored in flash
+    uint32_t recordCount() const;
+    bool readRecord(uint32_t index, PacketRecord& record) const;
+    void clear();
+
+    // Prints one "sequence,timestamp,source,hex" line per record
+    void dumpToSerial() const;
+
+    const PacketLogStats& getStats() const { return stats; }
+};
+
+#endif // PACKET_LOG_H
@@ -0,0 +1,56 @@
+#ifndef PACKET_REPLAY_H
+#define PACKET_REPLAY_H
+
+#include <Arduino.h>
+#include "packet_log.h"
+
+class BLEServer;
+
+struct ReplayStats {
+    uint32_t delivered;      // Packets fed into the server
+    uint32_t truncated;      // Records skipped because the capture cut them short
+    uint32_t maxLatenessMs;  // Worst delay between due time and delivery
+    uint32_t totalLatenessMs;
+};
+
+// Feeds a packet capture into BLEServer as if the phone were sending it.
+// Timing is driven entirely by the nowMs values passed to update(), so the
+// same capture and the same clock sequence always produce the same run.
+class PacketReplay {
+private:
+    BLEServer* target;
+    PacketLog* log;                  // Flash capture, or
+    const PacketRecord* records;     // in-memory capture
+    uint32_t count;
+    uint32_t position;
+
+    float speed;                     // 1.0 = real time, 0 = as fast as possible
+    uint32_t startMs;
+    uint32_t firstTimestampMs;
+    bool running;
+
+    ReplayStats stats;
+
+    bool fetch(uint32_t index, PacketRecord& record) const;
+    uint32_t dueTimeMs(const PacketRecord& record) const;
+    bool start(BLEServer* server, float playbackSpeed, uint32_t nowMs);
+
+public:
+    PacketReplay();
+
+    bool begin(BLEServer* server, PacketLog* source, float playbackSpeed, uint32_t nowMs);
+    bool begin(BLEServer* server, const PacketRecord* capture, uint32_t captureCount,
+               float playbackSpeed, uint32_t nowMs);
+    void stop() { running = false; }
+
+    // Delivers every packet that is due at nowMs; returns how many were fed.
+    // Truncated records are skipped and counted in the stats.
+    uint32_t update(uint32_t nowMs);
+
+    bool isRunning() const { return running; }
+    uint32_t getPosition() const { return position; }
+    uint32_t getCount() const { return count; }
+    const ReplayStats& getStats() const { return stats; }
+};
+
+#endif // PACKET_REPLAY_H
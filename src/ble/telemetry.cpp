@@ -0,0 +1,70 @@
+#include "telemetry.h"
+
+static inline uint8_t saturate8(uint32_t v) { return v > 0xFF ? 0xFF : v; }
+static inline uint16_t saturate16(uint32_t v) { return v > 0xFFFF ? 0xFFFF : v; }
+
+Telemetry::Telemetry() : frames(0), framesDrawn(0), frameMaxUs(0), spiBytes(0), lastCounters(),
+                         intervalMs(TELEMETRY_DEFAULT_MS), windowStartMs(0), sequence(0) {
+    memset(histogram, 0, sizeof(histogram));
+}
+
+void Telemetry::recordFrame(uint32_t frameUs, uint32_t spiBytesThisFrame) {
+    uint32_t bin = frameUs / TELEMETRY_BIN_US;
+    if (bin >= TELEMETRY_BINS) bin = TELEMETRY_BINS - 1;
+    if (histogram[bin] < 0xFFFF) histogram[bin]++;
+
+    frames++;
+    if (spiBytesThisFrame > 0) framesDrawn++;
+    spiBytes += spiBytesThisFrame;
+    if (frameUs > frameMaxUs) frameMaxUs = frameUs;
+}
+
+uint16_t Telemetry::percentile(uint8_t pct) const {
+    if (frames == 0) return 0;
+
+    // Upper edge of the bin holding the requested rank, capped at the
+    // observed maximum so p99 never reads above max
+    uint32_t rank = (frames * pct + 99) / 100;
+    uint32_t seen = 0;
+    uint32_t edgeUs = frameMaxUs;
+    for (uint16_t bin = 0; bin < TELEMETRY_BINS - 1; bin++) {
+        seen += histogram[bin];
+        if (seen >= rank) {
+            edgeUs = min((bin + 1) * (uint32_t)TELEMETRY_BIN_US, frameMaxUs);
+            break;
+        }
+    }
+    return saturate16(edgeUs / 100);
+}
+
+void Telemetry::resetWindow(uint32_t nowMs) {
+    memset(histogram, 0, sizeof(histogram));
+    frames = 0;
+    framesDrawn = 0;
+    frameMaxUs = 0;
+    spiBytes = 0;
+    windowStartMs = nowMs;
+}
+
+bool Telemetry::poll(uint32_t nowMs, const TelemetryCounters& counters, TelemetryPacket& packet) {
+    uint32_t elapsed = nowMs - windowStartMs;
+    if (elapsed < intervalMs) return false;
+
+    packet.version = TELEMETRY_VERSION;
+    packet.sequence = sequence++;
+    packet.frames = saturate8(frames);
+    packet.frameP50 = percentile(50);
+    packet.frameP95 = percentile(95);
+    packet.frameP99 = percentile(99);
+    packet.frameMax = saturate16(frameMaxUs / 100);
+    packet.spiBytesPerFrame = framesDrawn ? saturate16(spiBytes / framesDrawn / 8) : 0;
+    packet.packetsDropped = saturate8(counters.packetsDropped - lastCounters.packetsDropped);
+    packet.packetsReceived = saturate8(counters.packetsReceived - lastCounters.packetsReceived);
+    packet.heapLowWater = saturate16(counters.heapLowWater / 8);
+    packet.imuRate = saturate16((uint64_t)(counters.imuSamples - lastCounters.imuSamples) * 10000 / elapsed);
+    packet.framesDrawn = saturate8(framesDrawn);
+
+    lastCounters = counters;
+    resetWindow(nowMs);
+    return true;
+}
@@ -0,0 +1,73 @@
+#ifndef TELEMETRY_H
+#define TELEMETRY_H
+
+#include <Arduino.h>
+
+#define TELEMETRY_VERSION         0x02
+#ifndef TELEMETRY_DEFAULT_MS
+#define TELEMETRY_DEFAULT_MS      1000   // Override with -DTELEMETRY_DEFAULT_MS=...
+#endif
+#define TELEMETRY_BIN_US          500    // Frame time histogram resolution
+#define TELEMETRY_BINS            256    // Covers 0-128 ms, last bin is overflow
+
+// Notification payload, little-endian. Kept under 20 bytes so it fits the
+// default ATT MTU. tools/telemetry_decoder.py mirrors this layout.
+struct __attribute__((packed)) TelemetryPacket {
+    uint8_t version;
+    uint8_t sequence;
+    uint8_t frames;            // Frames rendered in the window, idle ones included (saturates)
+    uint16_t frameP50;         // Frame time percentiles, 0.1 ms units
+    uint16_t frameP95;
+    uint16_t frameP99;
+    uint16_t frameMax;
+    uint16_t spiBytesPerFrame; // Per frame that wrote to the panel, 8-byte units
+    uint8_t packetsDropped;    // In the window (saturates)
+    uint8_t packetsReceived;
+    uint16_t heapLowWater;     // Minimum free heap since boot, 8-byte units
+    uint16_t imuRate;          // IMU samples per second, 0.1 Hz units
+    uint8_t framesDrawn;       // Frames that wrote to the panel (saturates)
+};
+
+static_assert(sizeof(TelemetryPacket) <= 20, "Telemetry must fit the default ATT MTU");
+
+// Running totals sampled once per report
+struct TelemetryCounters {
+    uint32_t packetsReceived;
+    uint32_t packetsDropped;
+    uint32_t imuSamples;
+    uint32_t heapLowWater;
+};
+
+// Batches per-frame measurements and emits one packet per interval.
+// recordFrame() is O(1) so it can sit on the render path.
+class Telemetry {
+private:
+    uint16_t histogram[TELEMETRY_BINS];
+    uint32_t frames;
+    uint32_t framesDrawn;
+    uint32_t frameMaxUs;
+    uint64_t spiBytes;
+
+    TelemetryCounters lastCounters;
+    uint32_t intervalMs;
+    uint32_t windowStartMs;
+    uint8_t sequence;
+
+    uint16_t percentile(uint8_t pct) const;
+    void resetWindow(uint32_t nowMs);
+
+public:
+    Telemetry();
+
+    void setInterval(uint32_t ms) { intervalMs = max(ms, (uint32_t)100); }
+    uint32_t getInterval() const { return intervalMs; }
+
+    // Call for every frame, including ones that sent nothing over SPI, so
+    // the percentiles describe the whole render loop
+    void recordFrame(uint32_t frameUs, uint32_t spiBytesThisFrame);
+
+    // Builds a packet when the interval has elapsed. Returns false otherwise.
+    bool poll(uint32_t nowMs, const TelemetryCounters& counters, TelemetryPacket& packet);
+};
+
+#endif // TELEMETRY_H
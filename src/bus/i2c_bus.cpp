@@ -0,0 +1,268 @@
+#include "i2c_bus.h"
+#include <driver/i2c.h>
+
+// --- ESP-IDF driver ---
+
+bool IdfI2CDriver::begin(int sda, int scl, uint32_t clockHz) {
+    if (installed) return true;
+
+    i2c_config_t config = {};
+    config.mode = I2C_MODE_MASTER;
+    config.sda_io_num = sda;
+    config.scl_io_num = scl;
+    config.sda_pullup_en = GPIO_PULLUP_ENABLE;
+    config.scl_pullup_en = GPIO_PULLUP_ENABLE;
+    config.master.clk_speed = clockHz;
+    if (i2c_param_config((i2c_port_t)I2C_BUS_PORT, &config) != ESP_OK) {
+        return false;
+    }
+    // Master mode: no slave buffers, no ISR flags
+    installed = i2c_driver_install((i2c_port_t)I2C_BUS_PORT, I2C_MODE_MASTER, 0, 0, 0) == ESP_OK;
+    return installed;
+}
+
+bool IdfI2CDriver::transfer(uint8_t address, const uint8_t* tx, size_t txLen,
+                            uint8_t* rx, size_t rxLen) {
+    TickType_t timeout = pdMS_TO_TICKS(I2C_BUS_TIMEOUT_MS);
+    esp_err_t err;
+    if (rxLen == 0) {
+        err = i2c_master_write_to_device((i2c_port_t)I2C_BUS_PORT, address, tx, txLen, timeout);
+    } else if (txLen == 0) {
+        err = i2c_master_read_from_device((i2c_port_t)I2C_BUS_PORT, address, rx, rxLen, timeout);
+    } else {
+        err = i2c_master_write_read_device((i2c_port_t)I2C_BUS_PORT, address, tx, txLen,
+                                           rx, rxLen, timeout);
+    }
+    return err == ESP_OK;
+}
+
+// --- Bus ---
+
+I2CBus::I2CBus(I2CDriver* driver) : driver(driver ? driver : &idfDriver), started(false),
+                                    worker(nullptr), stopping(false) {
+    memset(queueHead, 0, sizeof(queueHead));
+    memset(queueCount, 0, sizeof(queueCount));
+    memset(stats, 0, sizeof(stats));
+    queueLock = xSemaphoreCreateMutexStatic(&queueLockBuffer);
+    wireLock = xSemaphoreCreateMutexStatic(&wireLockBuffer);
+    workerExit = xSemaphoreCreateBinaryStatic(&workerExitBuffer);
+}
+
+I2CBus::~I2CBus() {
+    stopTask();
+}
+
+bool I2CBus::begin(int sda, int scl, uint32_t clockHz) {
+    if (started) return true;
+    started = driver->begin(sda, scl, clockHz);
+    if (!started) {
+        Serial.printf("I2C bus init failed (SDA=%d, SCL=%d)\n", sda, scl);
+    }
+    return started;
+}
+
+bool I2CBus::startTask(uint8_t core, uint8_t priority) {
+    if (!started || worker) return false;
+
+    stopping = false;
+    BaseType_t result = xTaskCreatePinnedToCore(workerEntry, "i2c", I2C_BUS_TASK_STACK, this,
+                                                priority, &worker, core);
+    if (result != pdPASS) {
+        worker = nullptr;
+        return false;
+    }
+    return true;
+}
+
+void I2CBus::stopTask() {
+    TaskHandle_t task = worker;
+    if (!task) return;
+
+    // The worker leaves on its own, between transactions. Deleting it from
+    // here could catch it holding queueLock, or before the callback a
+    // blocking transfer() is waiting for.
+    stopping = true;
+    xTaskNotifyGive(task);
+    xSemaphoreTake(workerExit, portMAX_DELAY);
+    worker = nullptr;
+}
+
+void I2CBus::workerEntry(void* param) {
+    static_cast<I2CBus*>(param)->runWorker();
+}
+
+void I2CBus::runWorker() {
+    while (!stopping) {
+        // One notification per submit(); the loop drains whatever is queued
+        ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+        uint32_t wakeUs = micros();
+        while (runOnce()) {
+        }
+        taskLoad.add(micros() - wakeUs);
+    }
+
+    // Nothing of this object is touched after the signal
+    xSemaphoreGive(workerExit);
+    vTaskDelete(nullptr);
+}
+
+bool I2CBus::submit(uint8_t address, const uint8_t* tx, size_t txLen, uint8_t* rx, size_t rxLen,
+                    I2CPriority priority, I2CCallback callback, void* context) {
+    if (priority >= I2C_PRIORITY_COUNT || txLen > I2C_BUS_MAX_TX) return false;
+
+    xSemaphoreTake(queueLock, portMAX_DELAY);
+    if (queueCount[priority] >= I2C_BUS_QUEUE_DEPTH) {
+        stats[priority].rejected++;
+        xSemaphoreGive(queueLock);
+        return false;
+    }
+    uint8_t slot = (queueHead[priority] + queueCount[priority]) % I2C_BUS_QUEUE_DEPTH;
+    I2CTransaction& t = queues[priority][slot];
+    t.address = address;
+    memcpy(t.tx, tx, txLen);
+    t.txLen = txLen;
+    t.rx = rx;
+    t.rxLen = rxLen;
+    t.priority = priority;
+    t.callback = callback;
+    t.context = context;
+    t.queuedUs = driver->nowUs();
+    queueCount[priority]++;
+    xSemaphoreGive(queueLock);
+
+    TaskHandle_t task = worker;
+    if (task) {
+        xTaskNotifyGive(task);
+    }
+    return true;
+}
+
+bool I2CBus::pop(I2CTransaction& out) {
+    xSemaphoreTake(queueLock, portMAX_DELAY);
+    for (int p = 0; p < I2C_PRIORITY_COUNT; p++) {
+        if (queueCount[p] == 0) continue;
+        out = queues[p][queueHead[p]];
+        queueHead[p] = (queueHead[p] + 1) % I2C_BUS_QUEUE_DEPTH;
+        queueCount[p]--;
+        xSemaphoreGive(queueLock);
+        return true;
+    }
+    xSemaphoreGive(queueLock);
+    return false;
+}
+
+bool I2CBus::runOnce() {
+    // Chosen with the wire held, so the pick reflects everything queued
+    // up to the moment the bus became free
+    xSemaphoreTake(wireLock, portMAX_DELAY);
+    I2CTransaction t;
+    if (!pop(t)) {
+        xSemaphoreGive(wireLock);
+        return false;
+    }
+    uint32_t startUs = driver->nowUs();
+    bool ok = driver->transfer(t.address, t.tx, t.txLen, t.rx, t.rxLen);
+    uint32_t endUs = driver->nowUs();
+    xSemaphoreGive(wireLock);
+
+    xSemaphoreTake(queueLock, portMAX_DELAY);
+    I2CClientStats& s = stats[t.priority];
+    s.completed++;
+    if (!ok) s.errors++;
+    s.bytes += t.txLen + t.rxLen;
+    s.maxWaitUs = max(s.maxWaitUs, startUs - t.queuedUs);
+    s.maxLatencyUs = max(s.maxLatencyUs, endUs - t.queuedUs);
+    xSemaphoreGive(queueLock);
+
+    if (t.callback) {
+        t.callback(t.context, ok);
+    }
+    return true;
+}
+
+// Completion state of one blocking transfer(), on the caller's stack
+struct I2CWaiter {
+    SemaphoreHandle_t done;      // nullptr when the caller runs the queue itself
+    std::atomic<bool> finished;
+    bool ok;
+};
+
+static void onTransferDone(void* context, bool ok) {
+    I2CWaiter* waiter = static_cast<I2CWaiter*>(context);
+    waiter->ok = ok;
+    SemaphoreHandle_t done = waiter->done;
+    waiter->finished = true;
+    if (done) {
+        xSemaphoreGive(done);
+    }
+}
+
+bool I2CBus::transfer(uint8_t address, const uint8_t* tx, size_t txLen, uint8_t* rx, size_t rxLen,
+                      I2CPriority priority) {
+    I2CWaiter waiter;
+    waiter.finished = false;
+    waiter.ok = false;
+
+    if (worker) {
+        StaticSemaphore_t doneBuffer;
+        waiter.done = xSemaphoreCreateBinaryStatic(&doneBuffer);
+        if (!submit(address, tx, txLen, rx, rxLen, priority, onTransferDone, &waiter)) {
+            vSemaphoreDelete(waiter.done);
+            return false;
+        }
+        // The driver times out, so the callback comes from the worker, or
+        // from this task if the worker was stopped before reaching it
+        while (xSemaphoreTake(waiter.done, pdMS_TO_TICKS(I2C_BUS_TIMEOUT_MS)) != pdTRUE) {
+            if (!worker) {
+                runOnce();
+            }
+        }
+        vSemaphoreDelete(waiter.done);
+        return waiter.ok;
+    }
+
+    // No worker: run the queue on this task until our transaction is done
+    waiter.done = nullptr;
+    if (!submit(address, tx, txLen, rx, rxLen, priority, onTransferDone, &waiter)) {
+        runOnce();
+        if (!submit(address, tx, txLen, rx, rxLen, priority, onTransferDone, &waiter)) {
+            return false;
+        }
+    }
+    while (!waiter.finished) {
+        if (!runOnce()) {
+            // Another caller is running it
+            taskYIELD();
+        }
+    }
+    return waiter.ok;
+}
+
+bool I2CBus::writeRegister(uint8_t address, uint8_t reg, uint8_t value, I2CPriority priority) {
+    const uint8_t tx[2] = {reg, value};
+    return transfer(address, tx, sizeof(tx), nullptr, 0, priority);
+}
+
+bool I2CBus::readRegisters(uint8_t address, uint8_t reg, uint8_t* buffer, size_t length,
+                           I2CPriority priority) {
+    return transfer(address, &reg, 1, buffer, length, priority);
+}
+
+size_t I2CBus::pending(I2CPriority priority) const {
+    return priority < I2C_PRIORITY_COUNT ? queueCount[priority] : 0;
+}
+
+I2CClientStats I2CBus::getStats(I2CPriority priority) const {
+    I2CClientStats out = {};
+    if (priority >= I2C_PRIORITY_COUNT) return out;
+    xSemaphoreTake(queueLock, portMAX_DELAY);
+    out = stats[priority];
+    xSemaphoreGive(queueLock);
+    return out;
+}
+
+void I2CBus::resetStats() {
+    xSemaphoreTake(queueLock, portMAX_DELAY);
+    memset(stats, 0, sizeof(stats));
+    xSemaphoreGive(queueLock);
+}
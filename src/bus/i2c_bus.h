@@ -0,0 +1,158 @@
+#ifndef I2C_BUS_H
+#define I2C_BUS_H
+
+#include <Arduino.h>
+#include <atomic>
+#include <freertos/semphr.h>
+#include "../core/task_monitor.h"
+
+// Shared I2C bus: QMI8658 IMU (0x6B), touch controller and PCF85063 RTC
+// (0x51) on the touch pins, GPIO 47/48 (TOUCH_SDA/TOUCH_SCL).
+//
+// Clients queue transactions instead of driving the wire themselves. A
+// worker task runs them one at a time, highest priority class first
+// (IMU FIFO drain > touch > RTC), and reports each result to a completion
+// callback. A transaction is never interrupted once on the wire, so the
+// worst-case wait of any class is the longest transaction of the classes
+// below it plus everything queued above it.
+#define I2C_BUS_SDA             47
+#define I2C_BUS_SCL             48
+#define I2C_BUS_CLOCK_HZ        400000
+#define I2C_BUS_PORT            0
+#define I2C_BUS_TIMEOUT_MS      10
+#define I2C_BUS_QUEUE_DEPTH     8       // Pending transactions per priority class
+#define I2C_BUS_MAX_TX          8       // Bytes copied at submit (register + payload)
+
+// Worker task: above the IMU sampling task on the same core, so a queued
+// drain starts as soon as the wire is free
+#define I2C_BUS_TASK_CORE       0
+#define I2C_BUS_TASK_PRIORITY   6
+#define I2C_BUS_TASK_STACK      3072
+
+enum I2CPriority {
+    I2C_PRIORITY_IMU = 0,     // Served first
+    I2C_PRIORITY_TOUCH,
+    I2C_PRIORITY_RTC,
+    I2C_PRIORITY_COUNT
+};
+
+// Runs in the context that executed the transaction (the worker task, or
+// the caller of runOnce()). Keep it short and never block on the bus from it.
+typedef void (*I2CCallback)(void* context, bool ok);
+
+// Write of tx[0..txLen) followed, when rxLen > 0, by a repeated-start read
+// of rxLen bytes into rx. tx is copied at submit; rx must stay valid until
+// the callback runs.
+struct I2CTransaction {
+    uint8_t address;
+    uint8_t tx[I2C_BUS_MAX_TX];
+    uint8_t txLen;
+    uint8_t* rx;
+    size_t rxLen;
+    I2CPriority priority;
+    I2CCallback callback;
+    void* context;
+    uint32_t queuedUs;       // Set by submit()
+};
+
+struct I2CClientStats {
+    uint32_t completed;
+    uint32_t errors;         // NAK or timeout
+    uint32_t rejected;       // submit() with a full queue
+    uint32_t maxWaitUs;      // Queued until on the wire
+    uint32_t maxLatencyUs;   // Queued until complete
+    uint32_t bytes;
+};
+
+// Hardware access, one blocking transaction at a time. Only I2CBus calls it.
+class I2CDriver {
+public:
+    virtual ~I2CDriver() {}
+    virtual bool begin(int sda, int scl, uint32_t clockHz) = 0;
+    virtual bool transfer(uint8_t address, const uint8_t* tx, size_t txLen,
+                          uint8_t* rx, size_t rxLen) = 0;
+    // Time base for queue latency; the fake driver runs a virtual clock
+    virtual uint32_t nowUs() { return micros(); }
+};
+
+// ESP-IDF I2C master driver (legacy driver/i2c.h API, the one shipped
+// with the Arduino core). Replaces Wire on I2C_BUS_PORT.
+class IdfI2CDriver : public I2CDriver {
+private:
+    bool installed;
+
+public:
+    IdfI2CDriver() : installed(false) {}
+    bool begin(int sda, int scl, uint32_t clockHz) override;
+    bool transfer(uint8_t address, const uint8_t* tx, size_t txLen,
+                  uint8_t* rx, size_t rxLen) override;
+};
+
+class I2CBus {
+private:
+    I2CDriver* driver;
+    IdfI2CDriver idfDriver;
+    bool started;
+
+    // Per-class rings, guarded by queueLock
+    I2CTransaction queues[I2C_PRIORITY_COUNT][I2C_BUS_QUEUE_DEPTH];
+    uint8_t queueHead[I2C_PRIORITY_COUNT];
+    uint8_t queueCount[I2C_PRIORITY_COUNT];
+    I2CClientStats stats[I2C_PRIORITY_COUNT];
+    StaticSemaphore_t queueLockBuffer;
+    SemaphoreHandle_t queueLock;
+
+    // Held while a transaction is on the wire, so runOnce() callers
+    // without the worker task never overlap
+    StaticSemaphore_t wireLockBuffer;
+    SemaphoreHandle_t wireLock;
+
+    TaskHandle_t worker;
+    std::atomic<bool> stopping;
+    StaticSemaphore_t workerExitBuffer;
+    SemaphoreHandle_t workerExit;     // Given by the worker as it leaves its loop
+    TaskLoad taskLoad;
+
+    bool pop(I2CTransaction& out);
+    static void workerEntry(void* param);
+    void runWorker();
+
+public:
+    // driver = nullptr: the ESP-IDF driver
+    explicit I2CBus(I2CDriver* driver = nullptr);
+    ~I2CBus();
+
+    // Configures the pins and clock; repeated calls are no-ops
+    bool begin(int sda = I2C_BUS_SDA, int scl = I2C_BUS_SCL, uint32_t clockHz = I2C_BUS_CLOCK_HZ);
+    bool isStarted() const { return started; }
+
+    // Starts the worker. Without it, transactions run from runOnce() or
+    // inline in transfer() on the calling task.
+    bool startTask(uint8_t core = I2C_BUS_TASK_CORE, uint8_t priority = I2C_BUS_TASK_PRIORITY);
+    // Asks the worker to finish what is queued and exit, and waits for it
+    void stopTask();
+    bool isTaskRunning() const { return worker != nullptr; }
+    TaskHandle_t getTaskHandle() const { return worker; }
+    const TaskLoad& getTaskLoad() const { return taskLoad; }
+
+    // Queues a transaction without blocking; false when its class is full
+    // or txLen exceeds I2C_BUS_MAX_TX (the callback is not called)
+    bool submit(uint8_t address, const uint8_t* tx, size_t txLen, uint8_t* rx, size_t rxLen,
+                I2CPriority priority, I2CCallback callback = nullptr, void* context = nullptr);
+
+    // Runs the highest-priority pending transaction; false when idle
+    bool runOnce();
+
+    // Blocking helpers for drivers that poll: queue, then wait for the
+    // result. Ordering against other clients still follows priority.
+    bool transfer(uint8_t address, const uint8_t* tx, size_t txLen, uint8_t* rx, size_t rxLen,
+                  I2CPriority priority);
+    bool writeRegister(uint8_t address, uint8_t reg, uint8_t value, I2CPriority priority);
+    bool readRegisters(uint8_t address, uint8_t reg, uint8_t* buffer, size_t length, I2CPriority priority);
+
+    size_t pending(I2CPriority priority) const;
+    I2CClientStats getStats(I2CPriority priority) const;
+    void resetStats();
+};
+
+#endif // I2C_BUS_H
@@ -1,7 +1,9 @@
 #include "settings.h"
+#include <esp_rom_crc.h>
 
 // Preference keys
 const char* Settings::PREF_NAMESPACE = "hud_settings";
+const char* Settings::KEY_SLOTS[SETTINGS_SLOT_COUNT] = {"settings_a", "settings_b"};
 const char* Settings::KEY_BRIGHTNESS = "brightness";
 const char* Settings::KEY_ROTATION = "rotation";
 const char* Settings::KEY_AUTO_ROTATION = "auto_rot";
@@ -14,12 +16,72 @@ const char* Settings::KEY_RECONNECT_DELAY = "reconnect";
 const char* Settings::KEY_AUTO_CONNECT = "auto_conn";
 const char* Settings::KEY_SLEEP_TIMEOUT = "sleep_time";
 const char* Settings::KEY_WAKE_ON_DATA = "wake_data";
+const char* Settings::KEY_GYRO_BIAS_X = "gyro_bx";
+const char* Settings::KEY_GYRO_BIAS_Y = "gyro_by";
+const char* Settings::KEY_GYRO_BIAS_Z = "gyro_bz";
+const char* Settings::KEY_GYRO_BIAS_VALID = "gyro_cal";
+const char* Settings::KEY_GYRO_TEMP_COEFFS = "gyro_tc";
+const char* Settings::KEY_GYRO_TEMP_MIN = "gyro_tmin";
+const char* Settings::KEY_GYRO_TEMP_MAX = "gyro_tmax";
+const char* Settings::KEY_GYRO_TEMP_VALID = "gyro_tcal";
 
-Settings::Settings() : initialized(false) {
+// Upgrades indexed by the version they start from
+static SettingsMigration migrations[SETTINGS_BLOB_VERSION] = {};
+
+size_t NvsSettingsStore::read(const char* key, void* data, size_t maxLen) {
+    return preferences->getBytes(key, data, maxLen);
+}
+
+bool NvsSettingsStore::write(const char* key, const void* data, size_t len) {
+    return preferences->putBytes(key, data, len) == len;
+}
+
+bool NvsSettingsStore::erase(const char* key) {
+    return preferences->remove(key);
+}
+
+bool NvsSettingsStore::readLegacy(const char* key, SettingsLegacyType type, void* data, size_t len) {
+    if (!preferences->isKey(key)) return false;
+    
+    // NVS entries are typed: each one is read with its own getter
+    switch (type) {
+        case SETTINGS_LEGACY_U8:
+            *static_cast<uint8_t*>(data) = preferences->getUChar(key, *static_cast<uint8_t*>(data));
+            return true;
+        case SETTINGS_LEGACY_I8:
+            *static_cast<int8_t*>(data) = preferences->getChar(key, *static_cast<int8_t*>(data));
+            return true;
+        case SETTINGS_LEGACY_BOOL:
+            *static_cast<bool*>(data) = preferences->getBool(key, *static_cast<bool*>(data));
+            return true;
+        case SETTINGS_LEGACY_U16:
+            *static_cast<uint16_t*>(data) = preferences->getUShort(key, *static_cast<uint16_t*>(data));
+            return true;
+        case SETTINGS_LEGACY_FLOAT:
+            *static_cast<float*>(data) = preferences->getFloat(key, *static_cast<float*>(data));
+            return true;
+        case SETTINGS_LEGACY_BYTES:
+            return preferences->getBytes(key, data, len) == len;
+    }
+    return false;
+}
+
+Settings::Settings(SettingsStore* store) : initialized(false), dirty(0), lastChangeMs(0), stats(),
+                                           commitTask(nullptr), loadSource(SETTINGS_FROM_DEFAULTS),
+                                           legacyKeys(false), nvsStore(&preferences),
+                                           activeSlot(SETTINGS_SLOT_COUNT - 1), sequence(0) {
+    this->store = store ? store : &nvsStore;
+    lock = xSemaphoreCreateMutexStatic(&lockBuffer);
+    writeLock = xSemaphoreCreateMutexStatic(&writeLockBuffer);
 }
 
 Settings::~Settings() {
+    if (commitTask) {
+        vTaskDelete(commitTask);
+    }
     if (initialized) {
+        // Nothing set before destruction is lost
+        commit();
         preferences.end();
     }
 }
@@ -27,7 +89,8 @@ Settings::~Settings() {
 bool Settings::init() {
     Serial.println("Initializing settings...");
     
-    if (!preferences.begin(PREF_NAMESPACE, false)) {
+    // An injected store keeps everything; NVS is only opened for its own
+    if (store == &nvsStore && !preferences.begin(PREF_NAMESPACE, false)) {
         Serial.println("Failed to initialize preferences");
         return false;
     }
@@ -46,114 +109,400 @@ bool Settings::load() {
     
     Serial.println("Loading settings from flash...");
     
-    currentSettings.brightness = preferences.getUChar(KEY_BRIGHTNESS, currentSettings.brightness);
-    currentSettings.rotation = preferences.getUChar(KEY_ROTATION, currentSettings.rotation);
-    currentSettings.autoRotation = preferences.getBool(KEY_AUTO_ROTATION, currentSettings.autoRotation);
-    currentSettings.nightMode = preferences.getBool(KEY_NIGHT_MODE, currentSettings.nightMode);
-    currentSettings.showSpeedLimit = preferences.getBool(KEY_SHOW_SPEED_LIMIT, currentSettings.showSpeedLimit);
-    currentSettings.showDistance = preferences.getBool(KEY_SHOW_DISTANCE, currentSettings.showDistance);
-    currentSettings.showInstruction = preferences.getBool(KEY_SHOW_INSTRUCTION, currentSettings.showInstruction);
-    currentSettings.distanceUnit = preferences.getUChar(KEY_DISTANCE_UNIT, currentSettings.distanceUnit);
-    currentSettings.reconnectDelay = preferences.getUShort(KEY_RECONNECT_DELAY, currentSettings.reconnectDelay);
-    currentSettings.autoConnect = preferences.getBool(KEY_AUTO_CONNECT, currentSettings.autoConnect);
-    currentSettings.sleepTimeout = preferences.getUShort(KEY_SLEEP_TIMEOUT, currentSettings.sleepTimeout);
-    currentSettings.wakeonData = preferences.getBool(KEY_WAKE_ON_DATA, currentSettings.wakeonData);
+    xSemaphoreTake(writeLock, portMAX_DELAY);
+    HUDSettings loaded;
+    uint16_t rewrite = 0;
+    legacyKeys = false;
+    if (loadSlots(loaded)) {
+        if (loadSource != SETTINGS_FROM_BLOB) rewrite = SETTING_ALL;
+    } else if (loadSource == SETTINGS_FROM_CORRUPT) {
+        Serial.println("Stored settings are corrupt, using defaults");
+        rewrite = SETTING_ALL;
+    } else if (loadLegacy(loaded)) {
+        legacyKeys = true;
+        loadSource = SETTINGS_FROM_LEGACY;
+        rewrite = SETTING_ALL;
+    } else {
+        loadSource = SETTINGS_FROM_DEFAULTS;
+    }
+    
+    xSemaphoreTake(lock, portMAX_DELAY);
+    currentSettings = loaded;
+    dirty = 0;
+    if (rewrite) {
+        // Stored in the current format by the next commit
+        markDirty(rewrite);
+    }
+    xSemaphoreGive(lock);
+    xSemaphoreGive(writeLock);
     
     Serial.println("Settings loaded successfully");
     return true;
 }
 
+bool Settings::loadSlots(HUDSettings& out) {
+    bool found = false;
+    bool stored = false;
+    for (uint8_t slot = 0; slot < SETTINGS_SLOT_COUNT; slot++) {
+        uint8_t blob[SETTINGS_BLOB_MAX];
+        size_t size = store->read(KEY_SLOTS[slot], blob, sizeof(blob));
+        if (size == 0) continue;
+        stored = true;
+        
+        HUDSettings candidate;
+        uint32_t slotSequence;
+        bool migrated;
+        if (!parseSlot(blob, size, candidate, slotSequence, migrated)) continue;
+        
+        // Sequence numbers compare across wraparound
+        if (!found || (int32_t)(slotSequence - sequence) > 0) {
+            found = true;
+            out = candidate;
+            activeSlot = slot;
+            sequence = slotSequence;
+            loadSource = migrated ? SETTINGS_FROM_MIGRATION : SETTINGS_FROM_BLOB;
+        }
+    }
+    if (!found) {
+        activeSlot = SETTINGS_SLOT_COUNT - 1;
+        sequence = 0;
+        if (stored) loadSource = SETTINGS_FROM_CORRUPT;
+    }
+    return found;
+}
+
+bool Settings::parseSlot(uint8_t* blob, size_t size, HUDSettings& out, uint32_t& slotSequence, bool& migrated) {
+    if (size < sizeof(SettingsBlobHeader)) return false;
+    
+    SettingsBlobHeader header;
+    memcpy(&header, blob, sizeof(header));
+    if (header.length != size - sizeof(header) || header.version > SETTINGS_BLOB_VERSION) {
+        return false;
+    }
+    uint32_t crc = header.crc;
+    header.crc = 0;
+    uint32_t actual = crc32(0, &header, sizeof(header));
+    uint8_t* payload = blob + sizeof(header);
+    if (crc32(actual, payload, header.length) != crc) return false;
+    
+    uint16_t length = header.length;
+    for (uint8_t version = header.version; version < SETTINGS_BLOB_VERSION; version++) {
+        if (!migrations[version]) return false;
+        length = migrations[version](payload, length);
+        if (length == 0 || length > SETTINGS_BLOB_MAX_PAYLOAD) return false;
+    }
+    if (length != sizeof(SettingsRecord)) return false;
+    
+    SettingsRecord record;
+    memcpy(&record, payload, sizeof(record));
+    fromRecord(record, out);
+    slotSequence = header.sequence;
+    migrated = header.version != SETTINGS_BLOB_VERSION;
+    return true;
+}
+
+bool Settings::loadLegacy(HUDSettings& out) {
+    // Brightness was always written: without it there is no old layout
+    if (!readLegacy(KEY_BRIGHTNESS, SETTINGS_LEGACY_U8, out.brightness)) return false;
+    
+    readLegacy(KEY_ROTATION, SETTINGS_LEGACY_U8, out.rotation);
+    readLegacy(KEY_AUTO_ROTATION, SETTINGS_LEGACY_BOOL, out.autoRotation);
+    readLegacy(KEY_NIGHT_MODE, SETTINGS_LEGACY_BOOL, out.nightMode);
+    readLegacy(KEY_SHOW_SPEED_LIMIT, SETTINGS_LEGACY_BOOL, out.showSpeedLimit);
+    readLegacy(KEY_SHOW_DISTANCE, SETTINGS_LEGACY_BOOL, out.showDistance);
+    readLegacy(KEY_SHOW_INSTRUCTION, SETTINGS_LEGACY_BOOL, out.showInstruction);
+    readLegacy(KEY_DISTANCE_UNIT, SETTINGS_LEGACY_U8, out.distanceUnit);
+    readLegacy(KEY_RECONNECT_DELAY, SETTINGS_LEGACY_U16, out.reconnectDelay);
+    readLegacy(KEY_AUTO_CONNECT, SETTINGS_LEGACY_BOOL, out.autoConnect);
+    readLegacy(KEY_SLEEP_TIMEOUT, SETTINGS_LEGACY_U16, out.sleepTimeout);
+    readLegacy(KEY_WAKE_ON_DATA, SETTINGS_LEGACY_BOOL, out.wakeonData);
+    readLegacy(KEY_GYRO_BIAS_X, SETTINGS_LEGACY_FLOAT, out.gyroBiasX);
+    readLegacy(KEY_GYRO_BIAS_Y, SETTINGS_LEGACY_FLOAT, out.gyroBiasY);
+    readLegacy(KEY_GYRO_BIAS_Z, SETTINGS_LEGACY_FLOAT, out.gyroBiasZ);
+    readLegacy(KEY_GYRO_BIAS_VALID, SETTINGS_LEGACY_BOOL, out.gyroBiasValid);
+    readLegacy(KEY_GYRO_TEMP_MIN, SETTINGS_LEGACY_I8, out.gyroTempMinC);
+    readLegacy(KEY_GYRO_TEMP_MAX, SETTINGS_LEGACY_I8, out.gyroTempMaxC);
+    readLegacy(KEY_GYRO_TEMP_VALID, SETTINGS_LEGACY_BOOL, out.gyroTempValid);
+    out.gyroTempValid = out.gyroTempValid &&
+        readLegacy(KEY_GYRO_TEMP_COEFFS, SETTINGS_LEGACY_BYTES, out.gyroTempCoeffs);
+    return true;
+}
+
+void Settings::removeLegacyKeys() {
+    const char* keys[] = {
+        KEY_BRIGHTNESS, KEY_ROTATION, KEY_AUTO_ROTATION, KEY_NIGHT_MODE,
+        KEY_SHOW_SPEED_LIMIT, KEY_SHOW_DISTANCE, KEY_SHOW_INSTRUCTION, KEY_DISTANCE_UNIT,
+        KEY_RECONNECT_DELAY, KEY_AUTO_CONNECT, KEY_SLEEP_TIMEOUT, KEY_WAKE_ON_DATA,
+        KEY_GYRO_BIAS_X, KEY_GYRO_BIAS_Y, KEY_GYRO_BIAS_Z, KEY_GYRO_BIAS_VALID,
+        KEY_GYRO_TEMP_COEFFS, KEY_GYRO_TEMP_MIN, KEY_GYRO_TEMP_MAX, KEY_GYRO_TEMP_VALID
+    };
+    for (const char* key : keys) {
+        store->erase(key);
+    }
+    legacyKeys = false;
+}
+
+void Settings::toRecord(const HUDSettings& s, SettingsRecord& out) {
+    memset(&out, 0, sizeof(out));
+    out.brightness = s.brightness;
+    out.rotation = s.rotation;
+    out.autoRotation = s.autoRotation;
+    out.nightMode = s.nightMode;
+    out.showSpeedLimit = s.showSpeedLimit;
+    out.showDistance = s.showDistance;
+    out.showInstruction = s.showInstruction;
+    out.distanceUnit = s.distanceUnit;
+    out.reconnectDelay = s.reconnectDelay;
+    out.autoConnect = s.autoConnect;
+    out.sleepTimeout = s.sleepTimeout;
+    out.wakeonData = s.wakeonData;
+    out.gyroBias[0] = s.gyroBiasX;
+    out.gyroBias[1] = s.gyroBiasY;
+    out.gyroBias[2] = s.gyroBiasZ;
+    out.gyroBiasValid = s.gyroBiasValid;
+    memcpy(out.gyroTempCoeffs, s.gyroTempCoeffs, sizeof(out.gyroTempCoeffs));
+    out.gyroTempMinC = s.gyroTempMinC;
+    out.gyroTempMaxC = s.gyroTempMaxC;
+    out.gyroTempValid = s.gyroTempValid;
+}
+
+void Settings::fromRecord(const SettingsRecord& r, HUDSettings& out) {
+    out.brightness = r.brightness;
+    out.rotation = r.rotation % 4;
+    out.autoRotation = r.autoRotation;
+    out.nightMode = r.nightMode;
+    out.showSpeedLimit = r.showSpeedLimit;
+    out.showDistance = r.showDistance;
+    out.showInstruction = r.showInstruction;
+    out.distanceUnit = r.distanceUnit % 2;
+    out.reconnectDelay = r.reconnectDelay;
+    out.autoConnect = r.autoConnect;
+    out.sleepTimeout = r.sleepTimeout;
+    out.wakeonData = r.wakeonData;
+    out.gyroBiasX = r.gyroBias[0];
+    out.gyroBiasY = r.gyroBias[1];
+    out.gyroBiasZ = r.gyroBias[2];
+    out.gyroBiasValid = r.gyroBiasValid;
+    memcpy(out.gyroTempCoeffs, r.gyroTempCoeffs, sizeof(out.gyroTempCoeffs));
+    out.gyroTempMinC = r.gyroTempMinC;
+    out.gyroTempMaxC = r.gyroTempMaxC;
+    out.gyroTempValid = r.gyroTempValid;
+}
+
+uint32_t Settings::crc32(uint32_t crc, const void* data, size_t len) {
+    // Table-driven CRC in ROM; chains like zlib's crc32()
+    return esp_rom_crc32_le(crc, static_cast<const uint8_t*>(data), len);
+}
+
+bool Settings::registerMigration(uint8_t fromVersion, SettingsMigration migration) {
+    if (fromVersion >= SETTINGS_BLOB_VERSION) return false;
+    migrations[fromVersion] = migration;
+    return true;
+}
+
 bool Settings::save() {
     if (!initialized) return false;
     
     Serial.println("Saving settings to flash...");
     
-    preferences.putUChar(KEY_BRIGHTNESS, currentSettings.brightness);
-    preferences.putUChar(KEY_ROTATION, currentSettings.rotation);
-    preferences.putBool(KEY_AUTO_ROTATION, currentSettings.autoRotation);
-    preferences.putBool(KEY_NIGHT_MODE, currentSettings.nightMode);
-    preferences.putBool(KEY_SHOW_SPEED_LIMIT, currentSettings.showSpeedLimit);
-    preferences.putBool(KEY_SHOW_DISTANCE, currentSettings.showDistance);
-    preferences.putBool(KEY_SHOW_INSTRUCTION, currentSettings.showInstruction);
-    preferences.putUChar(KEY_DISTANCE_UNIT, currentSettings.distanceUnit);
-    preferences.putUShort(KEY_RECONNECT_DELAY, currentSettings.reconnectDelay);
-    preferences.putBool(KEY_AUTO_CONNECT, currentSettings.autoConnect);
-    preferences.putUShort(KEY_SLEEP_TIMEOUT, currentSettings.sleepTimeout);
-    preferences.putBool(KEY_WAKE_ON_DATA, currentSettings.wakeonData);
+    xSemaphoreTake(lock, portMAX_DELAY);
+    dirty |= SETTING_ALL;
+    xSemaphoreGive(lock);
+    if (!commit()) return false;
     
     Serial.println("Settings saved successfully");
     return true;
 }
 
+bool Settings::writeBlob(const HUDSettings& s) {
+    uint8_t blob[sizeof(SettingsBlobHeader) + sizeof(SettingsRecord)];
+    SettingsBlobHeader header = {SETTINGS_BLOB_VERSION, 0, sizeof(SettingsRecord), sequence + 1, 0};
+    SettingsRecord record;
+    toRecord(s, record);
+    header.crc = crc32(crc32(0, &header, sizeof(header)), &record, sizeof(record));
+    memcpy(blob, &header, sizeof(header));
+    memcpy(blob + sizeof(header), &record, sizeof(record));
+    
+    // The current slot stays intact until the other one is complete
+    uint8_t target = (activeSlot + 1) % SETTINGS_SLOT_COUNT;
+    if (!store->write(KEY_SLOTS[target], blob, sizeof(blob))) return false;
+    activeSlot = target;
+    sequence = header.sequence;
+    return true;
+}
+
+bool Settings::commit() {
+    if (!initialized) return false;
+    
+    // Snapshot under the lock, write outside it: a setter called meanwhile
+    // only marks its field dirty again for the next commit
+    xSemaphoreTake(writeLock, portMAX_DELAY);
+    xSemaphoreTake(lock, portMAX_DELAY);
+    uint16_t fields = dirty;
+    HUDSettings snapshot = currentSettings;
+    dirty = 0;
+    xSemaphoreGive(lock);
+    
+    bool written = false;
+    if (fields) {
+        // Every field is in the one blob: a commit is a single slot write
+        written = writeBlob(snapshot);
+        if (written) {
+            stats.commits++;
+            stats.keyWrites++;
+            if (legacyKeys) {
+                removeLegacyKeys();
+            }
+        } else {
+            stats.failures++;
+            Serial.println("Failed to write settings");
+            xSemaphoreTake(lock, portMAX_DELAY);
+            dirty |= fields;
+            xSemaphoreGive(lock);
+        }
+    }
+    xSemaphoreGive(writeLock);
+    return written;
+}
+
+bool Settings::flushIfQuiet(uint32_t nowMs) {
+    if (!dirty || nowMs - lastChangeMs < SETTINGS_COMMIT_QUIET_MS) return false;
+    return commit();
+}
+
+bool Settings::startCommitTask(uint8_t core, uint8_t priority) {
+    if (!initialized || commitTask) return false;
+    
+    BaseType_t result = xTaskCreatePinnedToCore(commitTaskEntry, "settings", SETTINGS_TASK_STACK, this,
+                                                priority, &commitTask, core);
+    if (result != pdPASS) {
+        commitTask = nullptr;
+        return false;
+    }
+    return true;
+}
+
+void Settings::commitTaskEntry(void* param) {
+    Settings* settings = static_cast<Settings*>(param);
+    for (;;) {
+        // Asleep until markDirty(); then checks for the quiet period
+        TickType_t wait = settings->getDirtyFields() ? pdMS_TO_TICKS(SETTINGS_COMMIT_POLL_MS) : portMAX_DELAY;
+        ulTaskNotifyTake(pdTRUE, wait);
+        uint32_t wakeUs = micros();
+        settings->flushIfQuiet(millis());
+        settings->taskLoad.add(micros() - wakeUs);
+    }
+}
+
+void Settings::markDirty(uint16_t fields) {
+    dirty |= fields;
+    lastChangeMs = millis();
+    stats.changes++;
+    
+    // Under lock, so publishers on different tasks are serialized
+    SettingsChangedEvent event = {fields};
+    EventBus<SettingsChangedEvent>::publish(event);
+    if (commitTask) {
+        xTaskNotifyGive(commitTask);
+    }
+}
+
 void Settings::reset() {
     if (!initialized) return;
     
     Serial.println("Resetting settings to defaults...");
     
-    preferences.clear();
+    xSemaphoreTake(writeLock, portMAX_DELAY);
+    for (uint8_t slot = 0; slot < SETTINGS_SLOT_COUNT; slot++) {
+        store->erase(KEY_SLOTS[slot]);
+    }
+    removeLegacyKeys();
+    activeSlot = SETTINGS_SLOT_COUNT - 1;
+    sequence = 0;
+    xSemaphoreTake(lock, portMAX_DELAY);
     currentSettings = HUDSettings(); // Reset to defaults
+    xSemaphoreGive(lock);
+    xSemaphoreGive(writeLock);
     save();
 }
 
-// Setters with automatic save
+// Setters only mark the changed field; commit() writes it
 void Settings::setBrightness(uint8_t brightness) {
-    currentSettings.brightness = constrain(brightness, 0, 255);
-    save();
+    assign(currentSettings.brightness, (uint8_t)constrain(brightness, 0, 255), SETTING_BRIGHTNESS);
 }
 
 void Settings::setRotation(uint8_t rotation) {
-    currentSettings.rotation = rotation % 4;
-    save();
+    assign(currentSettings.rotation, (uint8_t)(rotation % 4), SETTING_ROTATION);
 }
 
 void Settings::setAutoRotation(bool enabled) {
-    currentSettings.autoRotation = enabled;
-    save();
+    assign(currentSettings.autoRotation, enabled, SETTING_AUTO_ROTATION);
 }
 
 void Settings::setNightMode(bool enabled) {
-    currentSettings.nightMode = enabled;
-    save();
+    assign(currentSettings.nightMode, enabled, SETTING_NIGHT_MODE);
 }
 
 void Settings::setShowSpeedLimit(bool show) {
-    currentSettings.showSpeedLimit = show;
-    save();
+    assign(currentSettings.showSpeedLimit, show, SETTING_SHOW_SPEED_LIMIT);
 }
 
 void Settings::setShowDistance(bool show) {
-    currentSettings.showDistance = show;
-    save();
+    assign(currentSettings.showDistance, show, SETTING_SHOW_DISTANCE);
 }
 
 void Settings::setShowInstruction(bool show) {
-    currentSettings.showInstruction = show;
-    save();
+    assign(currentSettings.showInstruction, show, SETTING_SHOW_INSTRUCTION);
 }
 
 void Settings::setDistanceUnit(uint8_t unit) {
-    currentSettings.distanceUnit = unit % 2;
-    save();
+    assign(currentSettings.distanceUnit, (uint8_t)(unit % 2), SETTING_DISTANCE_UNIT);
 }
 
 void Settings::setReconnectDelay(uint16_t delay) {
-    currentSettings.reconnectDelay = max(delay, (uint16_t)1000);
-    save();
+    assign(currentSettings.reconnectDelay, max(delay, (uint16_t)1000), SETTING_RECONNECT_DELAY);
 }
 
 void Settings::setAutoConnect(bool enabled) {
-    currentSettings.autoConnect = enabled;
-    save();
+    assign(currentSettings.autoConnect, enabled, SETTING_AUTO_CONNECT);
 }
 
 void Settings::setSleepTimeout(uint16_t timeout) {
-    currentSettings.sleepTimeout = max(timeout, (uint16_t)30);
-    save();
+    assign(currentSettings.sleepTimeout, max(timeout, (uint16_t)30), SETTING_SLEEP_TIMEOUT);
 }
 
 void Settings::setWakeOnData(bool enabled) {
-    currentSettings.wakeonData = enabled;
-    save();
+    assign(currentSettings.wakeonData, enabled, SETTING_WAKE_ON_DATA);
+}
+
+bool Settings::setGyroBias(float x, float y, float z, float minChange) {
+    xSemaphoreTake(lock, portMAX_DELAY);
+    if (currentSettings.gyroBiasValid &&
+        fabs(x - currentSettings.gyroBiasX) <= minChange &&
+        fabs(y - currentSettings.gyroBiasY) <= minChange &&
+        fabs(z - currentSettings.gyroBiasZ) <= minChange) {
+        xSemaphoreGive(lock);
+        return false;
+    }
+    
+    currentSettings.gyroBiasX = x;
+    currentSettings.gyroBiasY = y;
+    currentSettings.gyroBiasZ = z;
+    currentSettings.gyroBiasValid = true;
+    markDirty(SETTING_GYRO_BIAS);
+    xSemaphoreGive(lock);
+    return initialized;
+}
+
+bool Settings::setGyroTempModel(const float coeffs[3][3], int8_t minC, int8_t maxC) {
+    xSemaphoreTake(lock, portMAX_DELAY);
+    memcpy(currentSettings.gyroTempCoeffs, coeffs, sizeof(currentSettings.gyroTempCoeffs));
+    currentSettings.gyroTempMinC = minC;
+    currentSettings.gyroTempMaxC = maxC;
+    currentSettings.gyroTempValid = true;
+    markDirty(SETTING_GYRO_TEMP);
+    xSemaphoreGive(lock);
+    return initialized;
 }
 
 void Settings::toggleNightMode() {
@@ -3,6 +3,152 @@
 
 #include <Arduino.h>
 #include <Preferences.h>
+#include <freertos/semphr.h>
+#include "../core/event_bus.h"
+#include "../core/events.h"
+#include "../core/task_monitor.h"
+
+// Setters only mark fields dirty. The settings are written once they have
+// been quiet for SETTINGS_COMMIT_QUIET_MS (a swipe burst is one commit),
+// by the commit task off the render path, or right away by commit() (call
+// it before sleeping or restarting).
+#define SETTINGS_COMMIT_QUIET_MS    2000
+#define SETTINGS_COMMIT_POLL_MS     250     // Check interval while changes are pending
+#define SETTINGS_TASK_CORE          0
+#define SETTINGS_TASK_PRIORITY      1
+#define SETTINGS_TASK_STACK         3072
+
+// Dirty bits, one per setting (or group set together)
+enum SettingsField : uint16_t {
+    SETTING_BRIGHTNESS       = 1 << 0,
+    SETTING_ROTATION         = 1 << 1,
+    SETTING_AUTO_ROTATION    = 1 << 2,
+    SETTING_NIGHT_MODE       = 1 << 3,
+    SETTING_SHOW_SPEED_LIMIT = 1 << 4,
+    SETTING_SHOW_DISTANCE    = 1 << 5,
+    SETTING_SHOW_INSTRUCTION = 1 << 6,
+    SETTING_DISTANCE_UNIT    = 1 << 7,
+    SETTING_RECONNECT_DELAY  = 1 << 8,
+    SETTING_AUTO_CONNECT     = 1 << 9,
+    SETTING_SLEEP_TIMEOUT    = 1 << 10,
+    SETTING_WAKE_ON_DATA     = 1 << 11,
+    SETTING_GYRO_BIAS        = 1 << 12,   // Bias and its valid flag
+    SETTING_GYRO_TEMP        = 1 << 13,   // Coefficients, range and valid flag
+    SETTING_ALL              = (1 << 14) - 1
+};
+
+// Flash traffic, for tests and telemetry
+struct SettingsStats {
+    uint32_t commits;        // Flushes whose blob write completed
+    uint32_t keyWrites;      // Completed slot writes, one per commit
+    uint32_t failures;       // Flushes whose write failed; the fields stay dirty
+    uint32_t changes;        // Setter calls that changed a value
+};
+
+// All settings live in one blob, read with a single lookup at boot:
+//   [SettingsBlobHeader][payload: SettingsRecord of that version]
+// The CRC covers the header (crc = 0) and the payload. A blob from an
+// older version is brought up to date by the registered migrations, one
+// version at a time; a corrupt, truncated or newer blob is ignored.
+// Devices that still hold the old one-key-per-field layout are imported
+// once and rewritten as a blob by the next commit.
+//
+// The blob is double-buffered for power loss (the ignition cuts power
+// at any moment): a commit writes the slot that is not current, with the
+// next sequence number, and never touches the current one. Boot loads
+// the valid slot with the newest sequence, so an interrupted write leaves
+// the previous settings in place and a finished one replaces them in a
+// single step.
+#define SETTINGS_BLOB_VERSION       1
+#define SETTINGS_BLOB_MAX_PAYLOAD   128     // Room for migrations to grow the record
+
+struct __attribute__((packed)) SettingsBlobHeader {
+    uint8_t version;
+    uint8_t reserved;
+    uint16_t length;         // Payload bytes
+    uint32_t sequence;       // Commit count; the newer slot wins
+    uint32_t crc;            // CRC-32 (IEEE)
+};
+
+#define SETTINGS_SLOT_COUNT         2
+#define SETTINGS_BLOB_MAX           (sizeof(SettingsBlobHeader) + SETTINGS_BLOB_MAX_PAYLOAD)
+
+// Payload of SETTINGS_BLOB_VERSION. Fields are only ever appended; any
+// other change needs a new version and a migration.
+struct __attribute__((packed)) SettingsRecord {
+    uint8_t brightness;
+    uint8_t rotation;
+    uint8_t autoRotation;
+    uint8_t nightMode;
+    uint8_t showSpeedLimit;
+    uint8_t showDistance;
+    uint8_t showInstruction;
+    uint8_t distanceUnit;
+    uint16_t reconnectDelay;
+    uint8_t autoConnect;
+    uint16_t sleepTimeout;
+    uint8_t wakeonData;
+    float gyroBias[3];
+    uint8_t gyroBiasValid;
+    float gyroTempCoeffs[3][3];
+    int8_t gyroTempMinC;
+    int8_t gyroTempMaxC;
+    uint8_t gyroTempValid;
+};
+
+static_assert(sizeof(SettingsRecord) <= SETTINGS_BLOB_MAX_PAYLOAD, "Settings record outgrew the blob buffer");
+
+// Upgrades a payload of version v, in place, to version v + 1. The buffer
+// holds SETTINGS_BLOB_MAX_PAYLOAD bytes; returns the new length, 0 if the
+// payload cannot be migrated.
+typedef uint16_t (*SettingsMigration)(uint8_t* payload, uint16_t length);
+
+// Value types of the old one-key-per-field layout
+enum SettingsLegacyType : uint8_t {
+    SETTINGS_LEGACY_U8,
+    SETTINGS_LEGACY_I8,
+    SETTINGS_LEGACY_BOOL,
+    SETTINGS_LEGACY_U16,
+    SETTINGS_LEGACY_FLOAT,
+    SETTINGS_LEGACY_BYTES
+};
+
+// Where the settings are kept, slots and old keys alike. NVS in the
+// firmware; tests substitute a fake that can cut power in the middle of
+// a write.
+class SettingsStore {
+public:
+    virtual ~SettingsStore() {}
+    // Bytes read; 0 when the key is missing or longer than maxLen
+    virtual size_t read(const char* key, void* data, size_t maxLen) = 0;
+    // False when the write did not complete
+    virtual bool write(const char* key, const void* data, size_t len) = 0;
+    virtual bool erase(const char* key) = 0;
+    // One key of the old layout, len bytes of the given type. data holds
+    // the fallback on entry; returns false when the key is missing.
+    virtual bool readLegacy(const char* key, SettingsLegacyType type, void* data, size_t len) = 0;
+};
+
+class NvsSettingsStore : public SettingsStore {
+private:
+    Preferences* preferences;
+
+public:
+    explicit NvsSettingsStore(Preferences* preferences) : preferences(preferences) {}
+    size_t read(const char* key, void* data, size_t maxLen) override;
+    bool write(const char* key, const void* data, size_t len) override;
+    bool erase(const char* key) override;
+    bool readLegacy(const char* key, SettingsLegacyType type, void* data, size_t len) override;
+};
+
+// How the last load() went
+enum SettingsLoadSource {
+    SETTINGS_FROM_DEFAULTS,  // Nothing stored
+    SETTINGS_FROM_BLOB,      // Newest valid slot
+    SETTINGS_FROM_MIGRATION, // Older blob, upgraded
+    SETTINGS_FROM_LEGACY,    // Old per-key layout
+    SETTINGS_FROM_CORRUPT    // Blob rejected, defaults loaded
+};
 
 struct HUDSettings {
     // Display settings
@@ -25,6 +171,18 @@ struct HUDSettings {
     uint16_t sleepTimeout;   // Timeout before sleep (seconds)
     bool wakeonData;         // Wake up when new navigation data arrives
     
+    // Sensor calibration, learned in the background by the IMU task
+    float gyroBiasX;         // deg/s
+    float gyroBiasY;
+    float gyroBiasZ;
+    bool gyroBiasValid;      // False until a first calibration was saved
+    
+    // Gyro bias vs temperature fit (see GyroTempModel)
+    float gyroTempCoeffs[3][3];  // Per axis: offset at 25 °C, slope, curvature
+    int8_t gyroTempMinC;         // Temperature span the fit was learned over
+    int8_t gyroTempMaxC;
+    bool gyroTempValid;
+    
     // Default constructor with sensible defaults
     HUDSettings() {
         brightness = 200;
@@ -39,6 +197,11 @@ struct HUDSettings {
         autoConnect = true;
         sleepTimeout = 300; // 5 minutes
         wakeonData = true;
+        gyroBiasX = gyroBiasY = gyroBiasZ = 0.0f;
+        gyroBiasValid = false;
+        memset(gyroTempCoeffs, 0, sizeof(gyroTempCoeffs));
+        gyroTempMinC = gyroTempMaxC = 0;
+        gyroTempValid = false;
     }
 };
 
@@ -48,8 +211,30 @@ private:
     HUDSettings currentSettings;
     bool initialized;
     
+    // Deferred commit. lock guards currentSettings and the dirty bits
+    // against the commit task; writeLock serializes flash writers, so the
+    // setters never wait for a flash write.
+    uint16_t dirty;
+    uint32_t lastChangeMs;
+    SettingsStats stats;
+    StaticSemaphore_t lockBuffer;
+    SemaphoreHandle_t lock;
+    StaticSemaphore_t writeLockBuffer;
+    SemaphoreHandle_t writeLock;
+    TaskHandle_t commitTask;
+    TaskLoad taskLoad;
+    SettingsLoadSource loadSource;
+    bool legacyKeys;         // Per-key layout still in flash, removed by the next commit
+    
+    SettingsStore* store;
+    NvsSettingsStore nvsStore;
+    uint8_t activeSlot;      // Slot holding the loaded settings; commits go to the other
+    uint32_t sequence;       // Its sequence number
+    
     // Keys for preferences storage
     static const char* PREF_NAMESPACE;
+    static const char* KEY_SLOTS[SETTINGS_SLOT_COUNT];
+    // Old per-key layout, read once to import it
     static const char* KEY_BRIGHTNESS;
     static const char* KEY_ROTATION;
     static const char* KEY_AUTO_ROTATION;
@@ -62,9 +247,42 @@ private:
     static const char* KEY_AUTO_CONNECT;
     static const char* KEY_SLEEP_TIMEOUT;
     static const char* KEY_WAKE_ON_DATA;
+    static const char* KEY_GYRO_BIAS_X;
+    static const char* KEY_GYRO_BIAS_Y;
+    static const char* KEY_GYRO_BIAS_Z;
+    static const char* KEY_GYRO_BIAS_VALID;
+    static const char* KEY_GYRO_TEMP_COEFFS;
+    static const char* KEY_GYRO_TEMP_MIN;
+    static const char* KEY_GYRO_TEMP_MAX;
+    static const char* KEY_GYRO_TEMP_VALID;
+    
+    // Stores value into field and marks it dirty when it differs
+    template <typename T>
+    void assign(T& field, T value, uint16_t bit) {
+        xSemaphoreTake(lock, portMAX_DELAY);
+        if (field != value) {
+            field = value;
+            markDirty(bit);
+        }
+        xSemaphoreGive(lock);
+    }
+    void markDirty(uint16_t fields);
+    template <typename T>
+    bool readLegacy(const char* key, SettingsLegacyType type, T& field) {
+        return store->readLegacy(key, type, &field, sizeof(field));
+    }
+    // Checks and decodes one slot's blob (migrated in place if older)
+    bool parseSlot(uint8_t* blob, size_t size, HUDSettings& out, uint32_t& slotSequence, bool& migrated);
+    bool loadSlots(HUDSettings& out);
+    // False when the old layout is not in the store
+    bool loadLegacy(HUDSettings& out);
+    void removeLegacyKeys();
+    bool writeBlob(const HUDSettings& s);
+    static void commitTaskEntry(void* param);
     
 public:
-    Settings();
+    // store = nullptr: NVS, through preferences
+    explicit Settings(SettingsStore* store = nullptr);
     ~Settings();
     
     bool init();
@@ -72,9 +290,31 @@ public:
     
     // Settings management
     bool load();
-    bool save();
+    bool save();             // Writes everything now, dirty or not
     void reset();
     
+    // Writes the blob now if anything changed; false when nothing was written
+    bool commit();
+    // commit() once nothing changed for SETTINGS_COMMIT_QUIET_MS
+    bool flushIfQuiet(uint32_t nowMs);
+    // Runs flushIfQuiet() in a low-priority task that sleeps while nothing is dirty
+    bool startCommitTask(uint8_t core = SETTINGS_TASK_CORE, uint8_t priority = SETTINGS_TASK_PRIORITY);
+    TaskHandle_t getTaskHandle() const { return commitTask; }
+    const TaskLoad& getTaskLoad() const { return taskLoad; }
+    uint16_t getDirtyFields() const { return dirty; }
+    const SettingsStats& getStats() const { return stats; }
+    SettingsLoadSource getLoadSource() const { return loadSource; }
+    uint8_t getActiveSlot() const { return activeSlot; }
+    uint32_t getSequence() const { return sequence; }
+    
+    // Blob encoding, exposed for migrations and tests
+    static void toRecord(const HUDSettings& s, SettingsRecord& out);
+    static void fromRecord(const SettingsRecord& r, HUDSettings& out);
+    static uint32_t crc32(uint32_t crc, const void* data, size_t len);
+    
+    // Registers the upgrade from fromVersion to fromVersion + 1
+    static bool registerMigration(uint8_t fromVersion, SettingsMigration migration);
+    
     // Getters
     const HUDSettings& getSettings() const { return currentSettings; }
     uint8_t getBrightness() const { return currentSettings.brightness; }
@@ -89,6 +329,8 @@ public:
     bool getAutoConnect() const { return currentSettings.autoConnect; }
     uint16_t getSleepTimeout() const { return currentSettings.sleepTimeout; }
     bool getWakeOnData() const { return currentSettings.wakeonData; }
+    bool hasGyroBias() const { return currentSettings.gyroBiasValid; }
+    bool hasGyroTempModel() const { return currentSettings.gyroTempValid; }
     
     // Setters
     void setBrightness(uint8_t brightness);
@@ -104,7 +346,18 @@ public:
     void setSleepTimeout(uint16_t timeout);
     void setWakeOnData(bool enabled);
     
+    // Stores a gyro bias (deg/s). Leaves it clean when no axis moved by
+    // more than minChange from the stored value; returns true if it will
+    // be written by the next commit.
+    bool setGyroBias(float x, float y, float z, float minChange = 0.0f);
+    
+    // Stores a gyro bias-vs-temperature fit for the next commit; the caller
+    // decides whether it changed enough to be worth a flash write
+    bool setGyroTempModel(const float coeffs[3][3], int8_t minC, int8_t maxC);
+    
     // Convenience methods
     void toggleNightMode();
     void toggleAutoRotation();
-};
\ No newline at end of file
+};
+
+#endif // SETTINGS_H
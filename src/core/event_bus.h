@@ -0,0 +1,132 @@
+#ifndef EVENT_BUS_H
+#define EVENT_BUS_H
+
+#include <Arduino.h>
+#include <atomic>
+#include <type_traits>
+
+// Typed publish/subscribe between tasks.
+//
+// Each event type E has its own channel, EventBus<E>, selected at compile
+// time: publish() is a loop over that type's subscribers with no virtual
+// calls, no locks and no allocation. Every subscriber owns an
+// EventQueue<E>, a fixed single-producer/single-consumer ring, so a slow
+// subscriber only overflows its own queue. A queue can name a task to
+// notify on every push; that task sleeps in ulTaskNotifyTake() instead of
+// polling the modules.
+//
+// Rules: events are small trivially copyable structs (see events.h).
+// Subscribe during setup, before the first publish. Publishing of one
+// event type must be serialized (one task, or under the publisher's own
+// lock), and must not happen from an ISR.
+#define EVENT_QUEUE_DEPTH           8       // Per subscriber (power of 2)
+#define EVENT_BUS_MAX_SUBSCRIBERS   4       // Per event type
+
+template <typename E>
+class EventQueue {
+    static_assert(std::is_trivially_copyable<E>::value, "Events must be trivially copyable");
+    static_assert((EVENT_QUEUE_DEPTH & (EVENT_QUEUE_DEPTH - 1)) == 0,
+                  "Event queue depth must be a power of 2");
+
+private:
+    E items[EVENT_QUEUE_DEPTH];
+    std::atomic<uint32_t> head;       // Next slot to write (publisher)
+    std::atomic<uint32_t> tail;       // Next slot to read (subscriber)
+    std::atomic<uint32_t> dropped;
+    std::atomic<bool> overflow;
+    TaskHandle_t waiter;
+
+public:
+    explicit EventQueue(TaskHandle_t waiter = nullptr)
+        : items(), head(0), tail(0), dropped(0), overflow(false), waiter(waiter) {}
+
+    // Task woken by every push; nullptr to poll instead
+    void setWaiter(TaskHandle_t task) { waiter = task; }
+
+    // Publisher side. A full queue drops the event and flags the overflow.
+    bool push(const E& event) {
+        uint32_t h = head.load(std::memory_order_relaxed);
+        bool queued = h - tail.load(std::memory_order_acquire) < EVENT_QUEUE_DEPTH;
+        if (queued) {
+            items[h & (EVENT_QUEUE_DEPTH - 1)] = event;
+            head.store(h + 1, std::memory_order_release);
+        } else {
+            dropped.fetch_add(1, std::memory_order_relaxed);
+            overflow.store(true, std::memory_order_release);
+        }
+        if (waiter) {
+            xTaskNotifyGive(waiter);
+        }
+        return queued;
+    }
+
+    // Subscriber side: oldest pending event
+    bool pop(E& out) {
+        uint32_t t = tail.load(std::memory_order_relaxed);
+        if (t == head.load(std::memory_order_acquire)) return false;
+        out = items[t & (EVENT_QUEUE_DEPTH - 1)];
+        tail.store(t + 1, std::memory_order_release);
+        return true;
+    }
+
+    // True once after events were dropped: the subscriber should resync
+    // from the source instead of relying on the events it got
+    bool takeOverflow() { return overflow.exchange(false, std::memory_order_acq_rel); }
+
+    uint32_t pending() const {
+        return head.load(std::memory_order_acquire) - tail.load(std::memory_order_acquire);
+    }
+    uint32_t getDropped() const { return dropped.load(std::memory_order_relaxed); }
+};
+
+template <typename E>
+class EventBus {
+private:
+    static EventQueue<E>* subscribers[EVENT_BUS_MAX_SUBSCRIBERS];
+    static std::atomic<uint8_t> subscriberCount;
+    static std::atomic<uint32_t> published;
+
+public:
+    static bool subscribe(EventQueue<E>& queue) {
+        uint8_t count = subscriberCount.load(std::memory_order_relaxed);
+        if (count >= EVENT_BUS_MAX_SUBSCRIBERS) return false;
+        subscribers[count] = &queue;
+        subscriberCount.store(count + 1, std::memory_order_release);
+        return true;
+    }
+
+    // For tests and teardown; not safe against a concurrent publish
+    static void unsubscribe(EventQueue<E>& queue) {
+        uint8_t count = subscriberCount.load(std::memory_order_relaxed);
+        for (uint8_t i = 0; i < count; i++) {
+            if (subscribers[i] == &queue) {
+                subscribers[i] = subscribers[count - 1];
+                subscriberCount.store(count - 1, std::memory_order_release);
+                return;
+            }
+        }
+    }
+
+    // Copies event into every subscriber's queue; returns how many took it
+    static uint8_t publish(const E& event) {
+        uint8_t count = subscriberCount.load(std::memory_order_acquire);
+        uint8_t delivered = 0;
+        for (uint8_t i = 0; i < count; i++) {
+            if (subscribers[i]->push(event)) delivered++;
+        }
+        published.fetch_add(1, std::memory_order_relaxed);
+        return delivered;
+    }
+
+    static uint8_t getSubscriberCount() { return subscriberCount.load(std::memory_order_acquire); }
+    static uint32_t getPublished() { return published.load(std::memory_order_relaxed); }
+};
+
+template <typename E>
+EventQueue<E>* EventBus<E>::subscribers[EVENT_BUS_MAX_SUBSCRIBERS] = {};
+template <typename E>
+std::atomic<uint8_t> EventBus<E>::subscriberCount(0);
+template <typename E>
+std::atomic<uint32_t> EventBus<E>::published(0);
+
+#endif // EVENT_BUS_H
@@ -0,0 +1,32 @@
+#ifndef EVENTS_H
+#define EVENTS_H
+
+#include <Arduino.h>
+
+// Events carried on the EventBus (see event_bus.h). Each is a small POD
+// telling subscribers what changed; bulky state (navigation strings, the
+// full settings) stays with its owner and is read from there. Touch
+// gestures travel as GestureEvent (input/gesture_recognizer.h).
+
+// Settings::markDirty(), on every setter call that changed a value
+struct SettingsChangedEvent {
+    uint16_t fields;         // SettingsField bits
+};
+
+// BLEServer, when a packet decoded into new navigation data, or the last
+// data should be redrawn after a reconnect
+struct NavUpdateEvent {
+    uint32_t timeMs;
+    uint8_t source;          // Decoder id, NAV_DECODER_NONE for a redraw
+    bool valid;
+    int32_t distance;        // m, for subscribers that need nothing else
+};
+
+// IMUHandler, when the display orientation moved to another quarter turn
+struct OrientationEvent {
+    float rotation;          // Degrees 0-360, as IMUOrientation
+    uint8_t quarterTurns;    // 0-3, the rotation the display snaps to
+    uint32_t timeUs;
+};
+
+#endif // EVENTS_H
@@ -0,0 +1,66 @@
+#ifndef LATEST_VALUE_H
+#define LATEST_VALUE_H
+
+#include <Arduino.h>
+#include <atomic>
+#include <type_traits>
+
+// Single-writer, many-reader slot holding the most recent value of T.
+// The writer never waits; a reader that overlaps a write retries the copy
+// (sequence lock), so neither side takes a lock or disables interrupts.
+// Intended for small trivially copyable records published at sensor rate
+// and read at frame rate, where only the newest value matters.
+#define LATEST_VALUE_MAX_RETRIES 8
+
+template <typename T>
+class LatestValue {
+    static_assert(std::is_trivially_copyable<T>::value,
+                  "LatestValue needs a trivially copyable type");
+
+private:
+    T value;
+    std::atomic<uint32_t> sequence;   // Odd while a write is in progress
+
+public:
+    LatestValue() : value(), sequence(0) {}
+
+    // Writer side (one task only)
+    void publish(const T& next) {
+        uint32_t seq = sequence.load(std::memory_order_relaxed);
+        sequence.store(seq + 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+        value = next;
+        sequence.store(seq + 2, std::memory_order_release);
+    }
+
+    // Copies the newest value. Returns false if nothing was published yet
+    // or the writer kept overlapping the copy.
+    bool read(T& out, uint32_t* version = nullptr) const {
+        for (uint8_t attempt = 0; attempt < LATEST_VALUE_MAX_RETRIES; attempt++) {
+            uint32_t before = sequence.load(std::memory_order_acquire);
+            if (before & 1) continue;
+
+            out = value;
+            std::atomic_thread_fence(std::memory_order_acquire);
+            if (sequence.load(std::memory_order_relaxed) == before) {
+                if (version) *version = before;
+                return before != 0;
+            }
+        }
+        return false;
+    }
+
+    // Like read(), but only succeeds when a value newer than *lastVersion
+    // was published; updates *lastVersion on success
+    bool readIfNewer(T& out, uint32_t& lastVersion) const {
+        uint32_t version;
+        if (!read(out, &version) || version == lastVersion) return false;
+        lastVersion = version;
+        return true;
+    }
+
+    // Number of values published so far
+    uint32_t publishCount() const { return sequence.load(std::memory_order_acquire) / 2; }
+};
+
+#endif // LATEST_VALUE_H
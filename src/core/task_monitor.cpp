@@ -0,0 +1,94 @@
+#include "task_monitor.h"
+
+TaskMonitor::TaskMonitor() : count(0), windowStartUs(0), windows(0) {
+    memset(entries, 0, sizeof(entries));
+}
+
+int TaskMonitor::add(const char* name, TaskHandle_t handle, uint8_t core, uint8_t priority,
+                     uint32_t stackBytes, const TaskLoad* load) {
+    if (count >= TASK_MONITOR_MAX_TASKS) return -1;
+
+    Entry& entry = entries[count];
+    entry.handle = handle;
+    entry.load = load;
+    entry.lastBusyUs = load ? load->getBusyUs() : 0;
+    entry.lastWakeups = load ? load->getWakeups() : 0;
+
+    TaskReport& report = entry.report;
+    report.name = name;
+    report.core = core;
+    report.priority = priority;
+    report.stackBytes = stackBytes;
+    report.stackFree = stackBytes;
+    report.cpuLoad = -1;
+    report.peakLoad = 0;
+    report.wakeups = 0;
+    report.maxBusyUs = 0;
+    report.running = handle != nullptr;
+
+    if (count == 0) {
+        windowStartUs = micros();
+    }
+    return count++;
+}
+
+bool TaskMonitor::sample(uint32_t nowUs) {
+    uint32_t windowUs = nowUs - windowStartUs;
+    if (windowUs < TASK_MONITOR_WINDOW_MS * 1000UL) return false;
+    windowStartUs = nowUs;
+    windows++;
+
+    for (uint8_t i = 0; i < count; i++) {
+        Entry& entry = entries[i];
+        TaskReport& report = entry.report;
+
+        if (entry.handle) {
+            // ESP-IDF counts the high-water mark in bytes
+            uint32_t free = uxTaskGetStackHighWaterMark(entry.handle);
+            report.stackFree = min(report.stackFree, free);
+        }
+
+        if (entry.load) {
+            uint32_t busy = entry.load->getBusyUs();
+            uint32_t wakeups = entry.load->getWakeups();
+            report.cpuLoad = min((float)(busy - entry.lastBusyUs) / windowUs, 1.0f);
+            report.peakLoad = max(report.peakLoad, report.cpuLoad);
+            report.wakeups = wakeups - entry.lastWakeups;
+            report.maxBusyUs = entry.load->getMaxBusyUs();
+            entry.lastBusyUs = busy;
+            entry.lastWakeups = wakeups;
+        }
+    }
+    return true;
+}
+
+uint8_t TaskMonitor::countTightStacks() const {
+    uint8_t tight = 0;
+    for (uint8_t i = 0; i < count; i++) {
+        if (entries[i].report.running && entries[i].report.stackFree < TASK_STACK_MARGIN) {
+            tight++;
+        }
+    }
+    return tight;
+}
+
+void TaskMonitor::print() const {
+    Serial.println("Task          core prio   cpu%  peak%  wake/s  max us  stack free/size");
+    for (uint8_t i = 0; i < count; i++) {
+        const TaskReport& r = entries[i].report;
+        if (!r.running) {
+            Serial.printf("%-12s  %4u %4u   (not running)\n", r.name, r.core, r.priority);
+            continue;
+        }
+        if (r.cpuLoad < 0) {
+            Serial.printf("%-12s  %4u %4u      -      -       -       -  %5u/%u%s\n",
+                          r.name, r.core, r.priority, r.stackFree, r.stackBytes,
+                          r.stackFree < TASK_STACK_MARGIN ? " LOW" : "");
+            continue;
+        }
+        Serial.printf("%-12s  %4u %4u  %5.1f  %5.1f  %6u  %6u  %5u/%u%s\n",
+                      r.name, r.core, r.priority, r.cpuLoad * 100.0f, r.peakLoad * 100.0f,
+                      r.wakeups, r.maxBusyUs, r.stackFree, r.stackBytes,
+                      r.stackFree < TASK_STACK_MARGIN ? " LOW" : "");
+    }
+}
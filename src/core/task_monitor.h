@@ -0,0 +1,93 @@
+#ifndef TASK_MONITOR_H
+#define TASK_MONITOR_H
+
+#include <Arduino.h>
+#include <atomic>
+
+// Per-task CPU load and stack usage.
+//
+// Every task owns a TaskLoad and adds the time from each wake-up to its
+// next sleep. TaskMonitor turns those totals into a load per window,
+// reads the stack high-water marks from the kernel and keeps the worst
+// values seen. It works without the kernel's run-time statistics, which
+// the Arduino core does not enable.
+#define TASK_MONITOR_MAX_TASKS  10
+#define TASK_MONITOR_WINDOW_MS  1000
+#define TASK_STACK_MARGIN       512     // Free bytes below which a task is reported as tight
+
+// Busy time of one task, written by that task only and read by the monitor
+class TaskLoad {
+private:
+    std::atomic<uint32_t> busyUs;     // Wraps after ~71 min; the monitor uses differences
+    std::atomic<uint32_t> wakeups;
+    std::atomic<uint32_t> maxBusyUs;
+
+public:
+    TaskLoad() : busyUs(0), wakeups(0), maxBusyUs(0) {}
+
+    // One call per wake-up, with the time until the task sleeps again
+    void add(uint32_t us) {
+        busyUs.fetch_add(us, std::memory_order_relaxed);
+        wakeups.fetch_add(1, std::memory_order_relaxed);
+        if (us > maxBusyUs.load(std::memory_order_relaxed)) {
+            maxBusyUs.store(us, std::memory_order_relaxed);
+        }
+    }
+
+    uint32_t getBusyUs() const { return busyUs.load(std::memory_order_relaxed); }
+    uint32_t getWakeups() const { return wakeups.load(std::memory_order_relaxed); }
+    uint32_t getMaxBusyUs() const { return maxBusyUs.load(std::memory_order_relaxed); }
+};
+
+struct TaskReport {
+    const char* name;
+    uint8_t core;
+    uint8_t priority;
+    uint32_t stackBytes;     // Budget given to xTaskCreatePinnedToCore
+    uint32_t stackFree;      // High-water mark: least free stack so far, bytes
+    float cpuLoad;           // Fraction of one core over the last window, -1 if not measured
+    float peakLoad;          // Highest cpuLoad of any window
+    uint32_t wakeups;        // In the last window
+    uint32_t maxBusyUs;      // Longest single wake-up so far
+    bool running;            // Handle known; a task that failed to start keeps its row
+};
+
+class TaskMonitor {
+private:
+    struct Entry {
+        TaskHandle_t handle;
+        const TaskLoad* load;
+        uint32_t lastBusyUs;
+        uint32_t lastWakeups;
+        TaskReport report;
+    };
+
+    Entry entries[TASK_MONITOR_MAX_TASKS];
+    uint8_t count;
+    uint32_t windowStartUs;
+    uint32_t windows;
+
+public:
+    TaskMonitor();
+
+    // Registers a task for the report. load may be nullptr for stack-only
+    // tracking. Returns the row or -1 when the table is full.
+    int add(const char* name, TaskHandle_t handle, uint8_t core, uint8_t priority,
+            uint32_t stackBytes, const TaskLoad* load = nullptr);
+
+    // Closes the window once TASK_MONITOR_WINDOW_MS have passed since the
+    // previous one: refreshes every row and returns true
+    bool sample(uint32_t nowUs);
+
+    uint8_t getCount() const { return count; }
+    const TaskReport& getReport(uint8_t row) const { return entries[row].report; }
+    uint32_t getWindows() const { return windows; }
+
+    // Rows with less than TASK_STACK_MARGIN bytes of stack left
+    uint8_t countTightStacks() const;
+
+    // One line per task on Serial
+    void print() const;
+};
+
+#endif // TASK_MONITOR_H
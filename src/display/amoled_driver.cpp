@@ -1,6 +1,6 @@
 #include "amoled_driver.h"
 
-AmoledDriver::AmoledDriver() : spi(nullptr), initialized(false), rotation(0) {
+AmoledDriver::AmoledDriver() : spi(nullptr), initialized(false), rotation(0), bytesWritten(0) {
 }
 
 AmoledDriver::~AmoledDriver() {
@@ -68,16 +68,19 @@ void AmoledDriver::initDisplay() {
 void AmoledDriver::writeCommand(uint8_t cmd) {
     // QSPI command write - simplified for single data line
     spi->transfer(cmd);
+    bytesWritten++;
 }
 
 void AmoledDriver::writeData(uint8_t data) {
     // QSPI data write - simplified for single data line
     spi->transfer(data);
+    bytesWritten++;
 }
 
 void AmoledDriver::writeData16(uint16_t data) {
     // QSPI 16-bit data write - simplified for single data line
     spi->transfer16(data);
+    bytesWritten += 2;
 }
 
 void AmoledDriver::setAddrWindow(uint16_t x0, uint16_t y0, uint16_t x1, uint16_t y1) {
@@ -243,4 +246,8 @@ void AmoledDriver::sleep() {
 void AmoledDriver::wakeup() {
     writeCommand(0x11); // Sleep out
     delay(120);
-}
\ No newline at end of file
+}
+void AmoledDriver::setBrightness(uint8_t level) {
+    writeCommand(0x51); // Write display brightness
+    writeData(level);
+}
@@ -37,6 +37,7 @@ private:
     SPIClass* spi;
     bool initialized;
     uint8_t rotation;
+    uint32_t bytesWritten;   // Total SPI bytes sent, for telemetry
     
     void writeCommand(uint8_t cmd);
     void writeData(uint8_t data);
@@ -52,6 +53,7 @@ public:
     void reset();
     void sleep();
     void wakeup();
+    void setBrightness(uint8_t level);   // 0-255, AMOLED luminance (DCS 0x51)
     
     // Display control
     void setRotation(uint8_t rot);
@@ -76,4 +78,7 @@ public:
     uint16_t width() const { return AMOLED_WIDTH; }
     uint16_t height() const { return AMOLED_HEIGHT; }
     bool isInitialized() const { return initialized; }
-};
\ No newline at end of file
+    uint32_t getBytesWritten() const { return bytesWritten; }
+};
+
+#endif // AMOLED_DRIVER_H
\ No newline at end of file
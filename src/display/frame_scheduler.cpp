@@ -0,0 +1,45 @@
+#include "frame_scheduler.h"
+
+FrameScheduler::FrameScheduler(uint32_t budgetUs) : budgetUs(budgetUs), demanded(false), animating(false),
+                                                    started(false), lastFrameMs(0) {
+    resetStats();
+}
+
+uint32_t FrameScheduler::msUntilNextFrame(uint32_t nowMs) const {
+    if (demanded || !started) return 0;
+
+    uint32_t elapsed = nowMs - lastFrameMs;
+    uint32_t period = getPeriodMs();
+    return elapsed < period ? period - elapsed : 0;
+}
+
+bool FrameScheduler::beginFrame(uint32_t nowMs) {
+    if (msUntilNextFrame(nowMs) > 0) return false;
+
+    // Counted as on demand only when the period alone would not have started it
+    if (demanded && started && nowMs - lastFrameMs < getPeriodMs()) {
+        stats.demandFrames++;
+    }
+    if (animating) {
+        stats.animationFrames++;
+    }
+    demanded = false;
+    started = true;
+    lastFrameMs = nowMs;
+    return true;
+}
+
+void FrameScheduler::endFrame(uint32_t frameUs, uint8_t deferredWidgets) {
+    stats.frames++;
+    stats.lastFrameUs = frameUs;
+    if (frameUs > stats.maxFrameUs) {
+        stats.maxFrameUs = frameUs;
+    }
+    if (frameUs > budgetUs) {
+        stats.overruns++;
+    }
+    if (deferredWidgets) {
+        stats.deferredFrames++;
+        stats.deferredWidgets += __builtin_popcount(deferredWidgets);
+    }
+}
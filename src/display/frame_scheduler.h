@@ -0,0 +1,66 @@
+#ifndef FRAME_SCHEDULER_H
+#define FRAME_SCHEDULER_H
+
+#include <Arduino.h>
+
+// Frame pacing for the render task. Instead of a fixed frame period the
+// rate follows what is on screen: status screens and a steady navigation
+// screen tick at ~1 FPS, a change (new navigation data, a setting) is
+// drawn on the next pass, and animations run at 30 FPS. Every frame has
+// a drawing budget; UIManager::drawFrame() defers low-priority widgets
+// once it is spent, and the frames that went over are counted here.
+#define FRAME_IDLE_MS       1000    // ~1 FPS
+#define FRAME_ANIMATION_MS  33      // 30 FPS
+#define FRAME_BUDGET_US     20000   // Leaves the rest of an animation period to events and touch
+
+enum FrameMode : uint8_t {
+    FRAME_MODE_IDLE,
+    FRAME_MODE_ANIMATION
+};
+
+struct FrameStats {
+    uint32_t frames;
+    uint32_t demandFrames;     // Started early by requestFrame()
+    uint32_t animationFrames;
+    uint32_t overruns;         // Frames that took longer than the budget
+    uint32_t deferredFrames;   // Frames that left widgets for the next one
+    uint32_t deferredWidgets;
+    uint32_t maxFrameUs;
+    uint32_t lastFrameUs;
+};
+
+class FrameScheduler {
+private:
+    uint32_t budgetUs;
+    bool demanded;
+    bool animating;
+    bool started;
+    uint32_t lastFrameMs;
+    FrameStats stats;
+
+public:
+    explicit FrameScheduler(uint32_t budgetUs = FRAME_BUDGET_US);
+
+    // Something on screen changed: the next frame is due now
+    void requestFrame() { demanded = true; }
+    void setAnimating(bool active) { animating = active; }
+
+    FrameMode getMode() const { return animating ? FRAME_MODE_ANIMATION : FRAME_MODE_IDLE; }
+    uint32_t getPeriodMs() const { return animating ? FRAME_ANIMATION_MS : FRAME_IDLE_MS; }
+    uint32_t getBudgetUs() const { return budgetUs; }
+
+    // How long the render task may sleep; events end the sleep early
+    uint32_t msUntilNextFrame(uint32_t nowMs) const;
+
+    // Starts a frame when one is due. Returns false otherwise.
+    bool beginFrame(uint32_t nowMs);
+    // Closes the frame begun last: its duration and the widgets it deferred
+    void endFrame(uint32_t frameUs, uint8_t deferredWidgets);
+
+    const FrameStats& getStats() const { return stats; }
+    // Fraction of frames over budget
+    float getOverrunRate() const { return stats.frames ? (float)stats.overruns / stats.frames : 0.0f; }
+    void resetStats() { memset(&stats, 0, sizeof(stats)); }
+};
+
+#endif // FRAME_SCHEDULER_H
@@ -2,7 +2,10 @@
 #include <math.h>
 
 UIManager::UIManager() : display(nullptr), currentState(UI_STARTUP), 
-                         currentTheme(THEME_DAY), currentRotation(0.0) {
+                         currentTheme(THEME_DAY), currentRotation(0.0),
+                         dirtyWidgets(0), approachTarget(0), approachShown(0), approachDrawn(0),
+                         lastBlinkMs(0), indicatorOn(true),
+                         showSpeedLimit(true), showDistance(true), showInstruction(true) {
     centerX = AMOLED_WIDTH / 2;
     centerY = AMOLED_HEIGHT / 2;
     radius = AMOLED_RADIUS;
@@ -49,7 +52,7 @@ void UIManager::setTheme(UITheme theme) {
     switch (currentState) {
         case UI_STARTUP: showStartupScreen(); break;
         case UI_CONNECTING: showConnectingScreen(); break;
-        case UI_NAVIGATION: updateNavigation(lastNavData); break;
+        case UI_NAVIGATION: invalidate(WIDGET_ALL); break;
         case UI_NO_DATA: showNoDataScreen(); break;
         case UI_ERROR: showErrorScreen("Theme changed"); break;
     }
@@ -59,6 +62,33 @@ void UIManager::toggleTheme() {
     setTheme(currentTheme == THEME_DAY ? THEME_NIGHT : THEME_DAY);
 }
 
+void UIManager::applySettings(const HUDSettings& settings, uint16_t fields) {
+    UITheme theme = settings.nightMode ? THEME_NIGHT : THEME_DAY;
+    if ((fields & SETTING_NIGHT_MODE) && theme != currentTheme) {
+        // Redraws the current screen
+        setTheme(theme);
+    }
+    
+    const uint16_t layout = SETTING_SHOW_SPEED_LIMIT | SETTING_SHOW_DISTANCE | SETTING_SHOW_INSTRUCTION;
+    if (!(fields & layout)) return;
+    
+    uint8_t changed = 0;
+    if (showSpeedLimit != settings.showSpeedLimit) changed |= WIDGET_SPEED_LIMIT;
+    if (showDistance != settings.showDistance) changed |= WIDGET_DISTANCE;
+    if (showInstruction != settings.showInstruction) changed |= WIDGET_INSTRUCTION;
+    showSpeedLimit = settings.showSpeedLimit;
+    showDistance = settings.showDistance;
+    showInstruction = settings.showInstruction;
+    if (currentState == UI_NAVIGATION) {
+        invalidate(changed);
+    }
+}
+
+void UIManager::invalidate(uint8_t widgets) {
+    // A new background wipes every widget
+    dirtyWidgets |= (widgets & WIDGET_BACKGROUND) ? WIDGET_ALL : widgets;
+}
+
 void UIManager::setState(UIState state) {
     currentState = state;
 }
@@ -88,34 +118,123 @@ void UIManager::showConnectingScreen() {
     drawCenteredText("Waiting for", centerY, 1, textColor);
     drawCenteredText("Sygic Connection", centerY + 20, 1, accentColor);
     
-    // Draw BLE indicator
+    // Draw BLE indicator; update() blinks it
+    indicatorOn = true;
     display->fillCircle(centerX, centerY + 60, 8, accentColor);
 }
 
 void UIManager::updateNavigation(const NavigationData& navData) {
-    setState(UI_NAVIGATION);
-    lastNavData = navData;
-    
+    setNavigation(navData);
+    if (currentState == UI_NAVIGATION) {
+        drawFrame(UI_NO_BUDGET);
+    }
+}
+
+void UIManager::setNavigation(const NavigationData& navData) {
     if (!navData.isValid) {
+        lastNavData = navData;
         showNoDataScreen();
         return;
     }
     
-    drawBackground();
+    uint8_t changed = 0;
+    if (currentState != UI_NAVIGATION) {
+        changed = WIDGET_ALL;
+    } else {
+        if (navData.distance != lastNavData.distance) changed |= WIDGET_DISTANCE;
+        if (navData.turnDirection != lastNavData.turnDirection) changed |= WIDGET_TURN;
+        if (navData.instruction != lastNavData.instruction) changed |= WIDGET_INSTRUCTION;
+        if (navData.speedLimit != lastNavData.speedLimit) changed |= WIDGET_SPEED_LIMIT;
+    }
     
-    // Draw speed limit (top)
-    if (navData.speedLimit > 0) {
-        drawSpeedLimit(navData.speedLimit);
+    // Entering the screen shows the ring where it belongs; afterwards it eases
+    approachTarget = approachTicks(navData.distance);
+    if (changed & WIDGET_BACKGROUND) {
+        approachShown = approachTarget;
     }
     
-    // Draw instruction (center)
-    drawInstruction(navData.instruction);
+    setState(UI_NAVIGATION);
+    lastNavData = navData;
+    invalidate(changed);
+}
+
+UIFrameResult UIManager::drawFrame(uint32_t budgetUs) {
+    UIFrameResult result = {0, 0, 0};
+    if (!display || currentState != UI_NAVIGATION) {
+        dirtyWidgets = 0;
+        return result;
+    }
     
-    // Draw distance (bottom)
-    drawDistance(navData.distance);
+    uint32_t startUs = micros();
+    if (isAnimating()) {
+        int diff = approachTarget - approachShown;
+        int step = diff / UI_APPROACH_EASE;
+        if (step == 0) step = diff > 0 ? 1 : -1;
+        approachShown += step;
+        dirtyWidgets |= WIDGET_APPROACH;
+    }
     
-    // Draw turn direction indicator
-    drawTurnDirection(navData.turnDirection);
+    bool cleared = dirtyWidgets & WIDGET_BACKGROUND;
+    for (uint8_t widget = 1; widget & WIDGET_ALL; widget <<= 1) {
+        if (!(dirtyWidgets & widget)) continue;
+        if (!(widget & WIDGET_CRITICAL) && micros() - startUs >= budgetUs) break;
+        drawWidget(widget, cleared);
+        dirtyWidgets &= ~widget;
+        result.drawn |= widget;
+    }
+    
+    result.deferred = dirtyWidgets;
+    result.elapsedUs = micros() - startUs;
+    return result;
+}
+
+void UIManager::drawWidget(uint8_t widget, bool cleared) {
+    switch (widget) {
+        case WIDGET_BACKGROUND:
+            drawBackground();
+            approachDrawn = 0;
+            return;
+        case WIDGET_APPROACH:
+            // Incremental, never cleared
+            drawApproach();
+            return;
+    }
+    
+    if (!cleared) {
+        clearWidget(widget);
+    }
+    switch (widget) {
+        case WIDGET_DISTANCE:
+            if (showDistance) drawDistance(lastNavData.distance);
+            break;
+        case WIDGET_TURN:
+            drawTurnDirection(lastNavData.turnDirection);
+            break;
+        case WIDGET_INSTRUCTION:
+            if (showInstruction) drawInstruction(lastNavData.instruction);
+            break;
+        case WIDGET_SPEED_LIMIT:
+            if (showSpeedLimit && lastNavData.speedLimit > 0) drawSpeedLimit(lastNavData.speedLimit);
+            break;
+    }
+}
+
+// Background over the widget's bounding box, so it can be redrawn alone
+void UIManager::clearWidget(uint8_t widget) {
+    switch (widget) {
+        case WIDGET_DISTANCE:
+            display->fillRect(centerX - 80, centerY + 100, 160, 16, bgColor);
+            break;
+        case WIDGET_TURN:
+            display->fillRect(centerX - 20, centerY + 30, 41, 31, bgColor);
+            break;
+        case WIDGET_INSTRUCTION:
+            display->fillRect(centerX - 200, centerY, 400, 8, bgColor);
+            break;
+        case WIDGET_SPEED_LIMIT:
+            display->fillRect(centerX - 35, centerY - 155, 71, 71, bgColor);
+            break;
+    }
 }
 
 void UIManager::showNoDataScreen() {
@@ -212,6 +331,26 @@ void UIManager::drawTurnDirection(int direction) {
     }
 }
 
+uint8_t UIManager::approachTicks(int distance) {
+    if (distance < 0 || distance >= UI_APPROACH_START_M) return 0;
+    return (UI_APPROACH_START_M - distance) * UI_APPROACH_TICKS / UI_APPROACH_START_M;
+}
+
+void UIManager::drawApproach() {
+    // Only the ticks between what is on screen and the animation step,
+    // clockwise from the top, just inside the border
+    int16_t ringRadius = radius - 12;
+    uint8_t from = min(approachDrawn, approachShown);
+    uint8_t to = max(approachDrawn, approachShown);
+    for (uint8_t i = from; i < to; i++) {
+        float angle = i * (2.0f * PI / UI_APPROACH_TICKS) - PI / 2.0f;
+        int16_t x = centerX + (int16_t)(ringRadius * cosf(angle));
+        int16_t y = centerY + (int16_t)(ringRadius * sinf(angle));
+        display->fillCircle(x, y, 3, i < approachShown ? accentColor : bgColor);
+    }
+    approachDrawn = approachShown;
+}
+
 void UIManager::drawCenteredText(const String& text, int16_t y, uint8_t size, uint16_t color) {
     int16_t textWidth = text.length() * 6 * size;
     int16_t x = centerX - textWidth / 2;
@@ -231,12 +370,13 @@ void UIManager::setRotation(float rotation) {
 }
 
 void UIManager::update() {
-    // UI update logic - can be used for animations or periodic updates
-    static unsigned long lastUpdate = 0;
-    unsigned long now = millis();
+    uint32_t now = millis();
+    if (!display || now - lastBlinkMs < UI_BLINK_MS) return;
+    lastBlinkMs = now;
     
-    if (now - lastUpdate > 1000) { // Update every second
-        // Update connection indicator or other periodic elements
-        lastUpdate = now;
+    // Blinking BLE indicator while waiting for the phone
+    if (currentState == UI_CONNECTING) {
+        indicatorOn = !indicatorOn;
+        display->fillCircle(centerX, centerY + 60, 8, indicatorOn ? accentColor : bgColor);
     }
 }
\ No newline at end of file
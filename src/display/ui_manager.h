@@ -4,6 +4,7 @@
 #include <Arduino.h>
 #include "amoled_driver.h"
 #include "../ble/ble_server.h"
+#include "../config/settings.h"
 
 enum UIState {
     UI_STARTUP,
@@ -18,6 +19,35 @@ enum UITheme {
     THEME_NIGHT
 };
 
+// Navigation screen widgets, in drawing order. drawFrame() draws the dirty
+// ones until the frame budget runs out and leaves the rest for the next
+// frame. The critical ones are drawn even over budget: a late distance is
+// worse than a late speed limit.
+enum UIWidget : uint8_t {
+    WIDGET_BACKGROUND  = 1 << 0,    // Clears the screen: every other widget follows
+    WIDGET_DISTANCE    = 1 << 1,
+    WIDGET_TURN        = 1 << 2,
+    WIDGET_INSTRUCTION = 1 << 3,
+    WIDGET_SPEED_LIMIT = 1 << 4,
+    WIDGET_APPROACH    = 1 << 5,    // Ring filling up over the last meters to the turn
+    WIDGET_ALL         = 0x3F
+};
+#define WIDGET_CRITICAL     (WIDGET_BACKGROUND | WIDGET_DISTANCE)
+#define UI_NO_BUDGET        UINT32_MAX
+
+// Approach ring: empty at UI_APPROACH_START_M, full at the maneuver. It
+// eases toward the latest distance, so it animates between BLE updates.
+#define UI_APPROACH_START_M 200
+#define UI_APPROACH_TICKS   60      // One tick per 6°
+#define UI_APPROACH_EASE    4       // Each frame covers 1/4 of the remaining ticks
+#define UI_BLINK_MS         1000    // Status indicator on the waiting screen
+
+struct UIFrameResult {
+    uint8_t drawn;           // UIWidget bits
+    uint8_t deferred;        // Left dirty for the next frame
+    uint32_t elapsedUs;
+};
+
 class UIManager {
 private:
     AmoledDriver* display;
@@ -26,6 +56,19 @@ private:
     NavigationData lastNavData;
     float currentRotation;
     
+    // Navigation widgets waiting to be drawn (UIWidget bits)
+    uint8_t dirtyWidgets;
+    uint8_t approachTarget;  // Ticks for the latest distance
+    uint8_t approachShown;   // Ticks the animation reached
+    uint8_t approachDrawn;   // Ticks currently on screen
+    uint32_t lastBlinkMs;
+    bool indicatorOn;
+    
+    // Navigation elements enabled in Settings
+    bool showSpeedLimit;
+    bool showDistance;
+    bool showInstruction;
+    
     // Display positions for round screen
     int16_t centerX, centerY;
     int16_t radius;
@@ -40,6 +83,10 @@ private:
     void drawDistance(int distance);
     void drawInstruction(const String& instruction);
     void drawTurnDirection(int direction);
+    void drawApproach();
+    void drawWidget(uint8_t widget, bool cleared);
+    void clearWidget(uint8_t widget);
+    static uint8_t approachTicks(int distance);
     
     // Text rendering helpers
     void drawCenteredText(const String& text, int16_t y, uint8_t size, uint16_t color);
@@ -50,6 +97,7 @@ public:
     ~UIManager();
     
     bool init(AmoledDriver* disp);
+    // Periodic elements (waiting screen indicator), at most every UI_BLINK_MS
     void update();
     
     // State management
@@ -61,14 +109,31 @@ public:
     UITheme getTheme() const { return currentTheme; }
     void toggleTheme();
     
+    // Takes the display-related fields named by a SettingsChangedEvent
+    // (SettingsField bits) from settings and redraws once if needed
+    void applySettings(const HUDSettings& settings, uint16_t fields);
+    
     // Display updates
     void showStartupScreen();
     void showConnectingScreen();
+    // Draws the navigation screen now, whatever it costs
     void updateNavigation(const NavigationData& navData);
+    // Takes new navigation data and only marks the widgets that changed;
+    // drawFrame() draws them. Invalid data shows the no-data screen at once.
+    void setNavigation(const NavigationData& navData);
+    // Draws dirty widgets in UIWidget order within budgetUs (critical ones
+    // always). Also advances the approach animation by one step.
+    UIFrameResult drawFrame(uint32_t budgetUs);
+    void invalidate(uint8_t widgets);
+    uint8_t getDirtyWidgets() const { return dirtyWidgets; }
+    // True while the approach ring has not reached the latest distance
+    bool isAnimating() const { return currentState == UI_NAVIGATION && approachShown != approachTarget; }
     void showNoDataScreen();
     void showErrorScreen(const String& error);
     
     // Rotation support
     void setRotation(float rotation);
     float getRotation() const { return currentRotation; }
-};
\ No newline at end of file
+};
+
+#endif // UI_MANAGER_H
\ No newline at end of file
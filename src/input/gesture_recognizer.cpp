@@ -0,0 +1,153 @@
+#include "gesture_recognizer.h"
+
+static_assert((GESTURE_QUEUE_SIZE & (GESTURE_QUEUE_SIZE - 1)) == 0,
+              "Gesture queue size must be a power of 2");
+
+static inline int32_t distanceSq(int32_t dx, int32_t dy) {
+    return dx * dx + dy * dy;
+}
+
+GestureRecognizer::GestureRecognizer() : rotation(0) {
+    reset();
+}
+
+void GestureRecognizer::reset() {
+    state = IDLE;
+    secondTap = false;
+    moved = false;
+    downX = downY = 0;
+    downMs = 0;
+    tapX = tapY = 0;
+    tapUpMs = 0;
+    queueHead = 0;
+    queueCount = 0;
+    dropped = 0;
+}
+
+void GestureRecognizer::emit(GestureType type, int16_t x, int16_t y, uint32_t nowMs) {
+    if (queueCount >= GESTURE_QUEUE_SIZE) {
+        dropped++;
+        return;
+    }
+    GestureEvent& event = queue[(queueHead + queueCount) & (GESTURE_QUEUE_SIZE - 1)];
+    event.type = type;
+    event.x = x;
+    event.y = y;
+    event.timeMs = nowMs;
+    queueCount++;
+}
+
+bool GestureRecognizer::next(GestureEvent& out) {
+    if (queueCount == 0) return false;
+    out = queue[queueHead];
+    queueHead = (queueHead + 1) & (GESTURE_QUEUE_SIZE - 1);
+    queueCount--;
+    return true;
+}
+
+void GestureRecognizer::flushPendingTap(uint32_t nowMs) {
+    if (secondTap) {
+        secondTap = false;
+        emit(GESTURE_TAP, tapX, tapY, nowMs);
+    }
+}
+
+GestureType GestureRecognizer::swipeDirection(int32_t dx, int32_t dy) const {
+    // Panel frame, screen y pointing down: 0 up, 1 right, 2 down, 3 left
+    uint8_t panel;
+    if (abs(dx) > abs(dy)) {
+        panel = dx > 0 ? 1 : 3;
+    } else {
+        panel = dy < 0 ? 0 : 2;
+    }
+    // Content turned clockwise by `rotation` quarters: its "up" is panel direction `rotation`
+    return (GestureType)(GESTURE_SWIPE_UP + (panel + 4 - rotation) % 4);
+}
+
+void GestureRecognizer::update(const TouchPoint& point, uint32_t nowMs) {
+    // Deadlines that passed before this report come first
+    poll(nowMs);
+
+    switch (state) {
+        case TAP_RELEASED:
+            if (!point.down) break;
+            secondTap = distanceSq(point.x - tapX, point.y - tapY) <=
+                        GESTURE_DOUBLE_TAP_SLOP_PX * GESTURE_DOUBLE_TAP_SLOP_PX;
+            if (!secondTap) {
+                // Too far away to pair with the first tap
+                emit(GESTURE_TAP, tapX, tapY, nowMs);
+            }
+            // fall through
+        case IDLE:
+            if (!point.down) break;
+            if (state == IDLE) secondTap = false;
+            state = PRESSED;
+            moved = false;
+            downX = point.x;
+            downY = point.y;
+            downMs = nowMs;
+            break;
+
+        case PRESSED: {
+            int32_t dx = point.x - downX;
+            int32_t dy = point.y - downY;
+            uint32_t heldMs = nowMs - downMs;
+
+            if (point.down) {
+                int32_t travel = distanceSq(dx, dy);
+                if (travel > GESTURE_TAP_SLOP_PX * GESTURE_TAP_SLOP_PX) {
+                    moved = true;
+                }
+                if (travel >= GESTURE_SWIPE_MIN_PX * GESTURE_SWIPE_MIN_PX && heldMs <= GESTURE_SWIPE_MAX_MS) {
+                    flushPendingTap(nowMs);
+                    emit(swipeDirection(dx, dy), downX, downY, nowMs);
+                    state = CONSUMED;
+                } else if (moved && heldMs > GESTURE_SWIPE_MAX_MS) {
+                    // A slow drag is not a gesture
+                    flushPendingTap(nowMs);
+                    state = CONSUMED;
+                }
+                break;
+            }
+
+            // Released
+            if (!moved && heldMs <= GESTURE_TAP_MAX_MS) {
+                if (secondTap) {
+                    secondTap = false;
+                    emit(GESTURE_DOUBLE_TAP, tapX, tapY, nowMs);
+                    state = IDLE;
+                } else {
+                    tapX = downX;
+                    tapY = downY;
+                    tapUpMs = nowMs;
+                    state = TAP_RELEASED;
+                }
+            } else {
+                flushPendingTap(nowMs);
+                state = IDLE;
+            }
+            break;
+        }
+
+        case CONSUMED:
+            if (!point.down) state = IDLE;
+            break;
+    }
+}
+
+void GestureRecognizer::poll(uint32_t nowMs) {
+    if (state == PRESSED && !moved && nowMs - downMs >= GESTURE_LONG_PRESS_MS) {
+        flushPendingTap(nowMs);
+        emit(GESTURE_LONG_PRESS, downX, downY, nowMs);
+        state = CONSUMED;
+    } else if (state == TAP_RELEASED && nowMs - tapUpMs >= GESTURE_DOUBLE_TAP_MS) {
+        emit(GESTURE_TAP, tapX, tapY, nowMs);
+        state = IDLE;
+    }
+}
+
+uint32_t GestureRecognizer::nextDeadline() const {
+    if (state == PRESSED && !moved) return downMs + GESTURE_LONG_PRESS_MS;
+    if (state == TAP_RELEASED) return tapUpMs + GESTURE_DOUBLE_TAP_MS;
+    return GESTURE_NO_DEADLINE;
+}
@@ -0,0 +1,106 @@
+#ifndef GESTURE_RECOGNIZER_H
+#define GESTURE_RECOGNIZER_H
+
+#include <Arduino.h>
+
+// Turns a stream of touch reports into gestures.
+//
+// Every gesture is emitted at the first moment it is unambiguous, not at
+// the end of the touch: a swipe as soon as the finger travelled
+// GESTURE_SWIPE_MIN_PX fast enough, a long press when the hold time is
+// reached (from poll(), no report needed), a double tap on the second
+// release. A single tap is only certain once the double-tap window closed
+// without a second touch, so it is emitted from poll() at that deadline.
+// The driver sleeps until nextDeadline(), so deadline events are as
+// prompt as report-driven ones.
+#define GESTURE_TAP_MAX_MS          250     // Longest press that is still a tap
+#define GESTURE_TAP_SLOP_PX         24      // Travel allowed for taps and long presses
+#define GESTURE_DOUBLE_TAP_MS       250     // Release to second touch
+#define GESTURE_DOUBLE_TAP_SLOP_PX  48      // Distance between the two taps
+#define GESTURE_LONG_PRESS_MS       600
+#define GESTURE_SWIPE_MIN_PX        60
+#define GESTURE_SWIPE_MAX_MS        400     // Touch-down to GESTURE_SWIPE_MIN_PX
+#define GESTURE_LATENCY_BUDGET_MS   30      // Decisive report to event, checked by the trace tests
+#define GESTURE_QUEUE_SIZE          8       // Pending events (power of 2)
+#define GESTURE_NO_DEADLINE         0xFFFFFFFF
+
+enum GestureType {
+    GESTURE_NONE,
+    GESTURE_TAP,
+    GESTURE_DOUBLE_TAP,
+    GESTURE_LONG_PRESS,
+    GESTURE_SWIPE_UP,         // Directions as seen on the rotated display
+    GESTURE_SWIPE_RIGHT,
+    GESTURE_SWIPE_DOWN,
+    GESTURE_SWIPE_LEFT
+};
+
+// One controller report, in panel coordinates
+struct TouchPoint {
+    bool down;
+    int16_t x;
+    int16_t y;
+    uint32_t timeMs;
+};
+
+struct GestureEvent {
+    GestureType type;
+    int16_t x;               // Where the gesture started, panel coordinates
+    int16_t y;
+    uint32_t timeMs;         // When it was recognized
+};
+
+class GestureRecognizer {
+private:
+    enum State {
+        IDLE,
+        PRESSED,             // Down, nothing decided yet
+        TAP_RELEASED,        // One tap done, double-tap window open
+        CONSUMED             // Gesture emitted (or drag too slow), waiting for release
+    };
+
+    State state;
+    bool secondTap;          // Current press started inside the double-tap window
+    bool moved;              // Current press left GESTURE_TAP_SLOP_PX
+    int16_t downX, downY;
+    uint32_t downMs;
+    int16_t tapX, tapY;      // First tap, while its double-tap window is open
+    uint32_t tapUpMs;
+    uint8_t rotation;        // Display quarter turns, for swipe directions
+
+    GestureEvent queue[GESTURE_QUEUE_SIZE];
+    uint8_t queueHead;
+    uint8_t queueCount;
+    uint32_t dropped;
+
+    void emit(GestureType type, int16_t x, int16_t y, uint32_t nowMs);
+    // The pending first tap, when the second press turned into something else
+    void flushPendingTap(uint32_t nowMs);
+    GestureType swipeDirection(int32_t dx, int32_t dy) const;
+
+public:
+    GestureRecognizer();
+
+    void reset();
+
+    // Quarter turns (0-3) the display content is rotated by; swipe
+    // directions are reported in the rotated frame
+    void setRotation(uint8_t quarterTurns) { rotation = quarterTurns % 4; }
+
+    // Feeds one report; nowMs is when it was read
+    void update(const TouchPoint& point, uint32_t nowMs);
+
+    // Emits deadline gestures (tap, long press) that are due at nowMs
+    void poll(uint32_t nowMs);
+
+    // Time of the next poll() that can emit something, or GESTURE_NO_DEADLINE
+    uint32_t nextDeadline() const;
+
+    bool isTouching() const { return state == PRESSED || state == CONSUMED; }
+
+    // Oldest recognized gesture; false when none is pending
+    bool next(GestureEvent& out);
+    uint32_t getDropped() const { return dropped; }
+};
+
+#endif // GESTURE_RECOGNIZER_H
@@ -0,0 +1,125 @@
+#include "touch_driver.h"
+
+TouchDriver::TouchDriver() : bus(nullptr), initialized(false), reports(0), readErrors(0),
+                             task(nullptr), gestures(0) {
+    memset(&lastPoint, 0, sizeof(lastPoint));
+}
+
+TouchDriver::~TouchDriver() {
+    if (task) {
+        vTaskDelete(task);
+    }
+    if (initialized && TOUCH_INT_PIN >= 0) {
+        detachInterrupt(digitalPinToInterrupt(TOUCH_INT_PIN));
+    }
+}
+
+bool TouchDriver::init(I2CBus* shared) {
+    Serial.println("Initializing touch controller...");
+
+    bus = shared;
+    if (!bus || !bus->begin()) {
+        return false;
+    }
+
+    // The write doubles as the presence check: an absent controller NAKs
+    if (!bus->writeRegister(FT3168_I2C_ADDR, FT3168_ID_G_MODE, FT3168_G_MODE_TRIGGER, I2C_PRIORITY_TOUCH)) {
+        Serial.println("Touch controller not detected");
+        return false;
+    }
+
+    if (TOUCH_INT_PIN >= 0) {
+        pinMode(TOUCH_INT_PIN, INPUT_PULLUP);
+        attachInterruptArg(digitalPinToInterrupt(TOUCH_INT_PIN), onTouchInterrupt, this, FALLING);
+    }
+
+    recognizer.reset();
+    initialized = true;
+    Serial.println("Touch controller initialized successfully");
+    return true;
+}
+
+void IRAM_ATTR TouchDriver::onTouchInterrupt(void* arg) {
+    TouchDriver* touch = static_cast<TouchDriver*>(arg);
+    if (touch->task) {
+        BaseType_t woken = pdFALSE;
+        vTaskNotifyGiveFromISR(touch->task, &woken);
+        portYIELD_FROM_ISR(woken);
+    }
+}
+
+bool TouchDriver::startTask(uint8_t core, uint8_t priority) {
+    if (!initialized || task) return false;
+
+    BaseType_t result = xTaskCreatePinnedToCore(taskEntry, "touch", TOUCH_TASK_STACK, this,
+                                                priority, &task, core);
+    if (result != pdPASS) {
+        task = nullptr;
+        return false;
+    }
+    return true;
+}
+
+void TouchDriver::taskEntry(void* param) {
+    static_cast<TouchDriver*>(param)->runTask();
+}
+
+void TouchDriver::runTask() {
+    const bool polled = TOUCH_INT_PIN < 0;
+
+    for (;;) {
+        // Sleep until the INT edge or the recognizer's next deadline. While
+        // a finger is down the controller is also read on a timeout, so a
+        // missed release edge cannot turn into a long press.
+        uint32_t waitMs = UINT32_MAX;
+        if (polled || recognizer.isTouching()) {
+            waitMs = TOUCH_POLL_MS;
+        }
+        uint32_t deadline = recognizer.nextDeadline();
+        if (deadline != GESTURE_NO_DEADLINE) {
+            int32_t untilDeadline = (int32_t)(deadline - millis());
+            waitMs = min(waitMs, (uint32_t)max(untilDeadline, (int32_t)0));
+        }
+
+        TickType_t ticks = waitMs == UINT32_MAX ? portMAX_DELAY : pdMS_TO_TICKS(waitMs);
+        bool edge = ulTaskNotifyTake(pdTRUE, ticks) > 0;
+        uint32_t wakeUs = micros();
+        service(edge || polled || recognizer.isTouching(), millis());
+        taskLoad.add(micros() - wakeUs);
+    }
+}
+
+bool TouchDriver::readPoint(TouchPoint& point) {
+    uint8_t raw[FT3168_REPORT_LEN];
+    if (!bus->readRegisters(FT3168_I2C_ADDR, FT3168_TD_STATUS, raw, sizeof(raw), I2C_PRIORITY_TOUCH)) {
+        readErrors++;
+        return false;
+    }
+
+    uint8_t points = raw[0] & 0x0F;
+    uint8_t event = raw[1] >> 6;
+    point.down = points > 0 && event != FT3168_EVENT_UP;
+    point.x = ((raw[1] & 0x0F) << 8) | raw[2];
+    point.y = ((raw[3] & 0x0F) << 8) | raw[4];
+    reports++;
+    return true;
+}
+
+void TouchDriver::service(bool reportPending, uint32_t nowMs) {
+    if (!initialized) return;
+
+    TouchPoint point;
+    if (reportPending && readPoint(point)) {
+        point.timeMs = nowMs;
+        lastPoint = point;
+        recognizer.update(point, nowMs);
+    } else {
+        recognizer.poll(nowMs);
+    }
+
+    GestureEvent event;
+    while (recognizer.next(event)) {
+        EventBus<GestureEvent>::publish(event);
+        gestures++;
+    }
+}
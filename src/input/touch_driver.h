@@ -0,0 +1,80 @@
+#ifndef TOUCH_DRIVER_H
+#define TOUCH_DRIVER_H
+
+#include <Arduino.h>
+#include "../bus/i2c_bus.h"
+#include "../core/event_bus.h"
+#include "../core/task_monitor.h"
+#include "gesture_recognizer.h"
+
+// FT3168 capacitive touch controller on the shared I2C bus (TOUCH_SDA/TOUCH_SCL)
+#define FT3168_I2C_ADDR     0x38
+#define FT3168_TD_STATUS    0x02    // Number of touch points (bits 3:0)
+#define FT3168_P1_XH        0x03    // Event flag (bits 7:6), X high bits (3:0)
+#define FT3168_ID_G_MODE    0xA4    // INT mode
+#define FT3168_G_MODE_TRIGGER 0x01  // One INT pulse per report, instead of level while touched
+#define FT3168_REPORT_LEN   5       // TD_STATUS through P1_YL
+#define FT3168_EVENT_UP     0x01
+
+// Controller INT line, falling edge on every report while touched and on
+// release. The board pin map (amoled_driver.h) has no TP_INT entry, so the
+// default is -1: the task polls every TOUCH_POLL_MS. Build with
+// -DTOUCH_INT_PIN=<gpio> once the pin is checked against the schematic;
+// it must not share a line with the display's QSPI bus.
+#ifndef TOUCH_INT_PIN
+#define TOUCH_INT_PIN       -1
+#endif
+#define TOUCH_POLL_MS       20
+
+// Reader task: on the rendering core, above the render task (priority 2),
+// so reports are read and recognized while a frame is being drawn
+#define TOUCH_TASK_CORE     1
+#define TOUCH_TASK_PRIORITY 3
+#define TOUCH_TASK_STACK    3072
+
+class TouchDriver {
+private:
+    I2CBus* bus;
+    bool initialized;
+    GestureRecognizer recognizer;
+    TouchPoint lastPoint;
+    uint32_t reports;
+    uint32_t readErrors;
+
+    TaskHandle_t task;
+    TaskLoad taskLoad;
+    uint32_t gestures;
+
+    static void IRAM_ATTR onTouchInterrupt(void* arg);
+    static void taskEntry(void* param);
+    void runTask();
+    bool readPoint(TouchPoint& point);
+
+public:
+    TouchDriver();
+    ~TouchDriver();
+
+    // Configures the controller for one INT pulse per report
+    bool init(I2CBus* shared);
+    bool isInitialized() const { return initialized; }
+
+    // Reads on the INT line, or polls, in its own task
+    bool startTask(uint8_t core = TOUCH_TASK_CORE, uint8_t priority = TOUCH_TASK_PRIORITY);
+    bool isTaskRunning() const { return task != nullptr; }
+    TaskHandle_t getTaskHandle() const { return task; }
+    const TaskLoad& getTaskLoad() const { return taskLoad; }
+
+    // One reader step at nowMs: reads a report when reportPending (INT
+    // seen, or still touching), runs the recognizer's deadlines and
+    // publishes the gestures as GestureEvent on the EventBus. Called by
+    // the task, or directly without one.
+    void service(bool reportPending, uint32_t nowMs);
+
+    void setRotation(uint8_t quarterTurns) { recognizer.setRotation(quarterTurns); }
+    const TouchPoint& getLastPoint() const { return lastPoint; }
+    uint32_t getReportCount() const { return reports; }
+    uint32_t getReadErrors() const { return readErrors; }
+    uint32_t getGestureCount() const { return gestures; }
+};
+
+#endif // TOUCH_DRIVER_H
@@ -1,23 +1,375 @@
 #include <Arduino.h>
 #include "ble/ble_server.h"
+#include "ble/packet_log.h"
+#include "ble/packet_replay.h"
+#include "ble/telemetry.h"
+#include "ble/nav_broadcast.h"
 #include "display/amoled_driver.h"
 #include "display/ui_manager.h"
+#include "display/frame_scheduler.h"
+#include "bus/i2c_bus.h"
+#include "input/touch_driver.h"
 #include "sensors/imu_handler.h"
 #include "config/settings.h"
+#include "core/event_bus.h"
+#include "core/events.h"
+#include "core/task_monitor.h"
 
 // Global objects
 BLEServer bleServer;
 AmoledDriver display;
 UIManager ui;
+I2CBus i2cBus;
+TouchDriver touch;
 IMUHandler imu;
 Settings config;
+PacketLog packetLog;
+Telemetry telemetry;
+
+#ifdef HUD_REPLAY_CAPTURE
+PacketReplay replay;
+#endif
+
+#ifdef HUD_BROADCAST_RECEIVER
+NavBroadcastScanner broadcastScanner;
+NavigationData broadcastNav;
+#endif
+
+// Runtime tasks besides the module-owned ones (i2c, imu, touch, ble,
+// settings, pktlog). Core 0 runs radio, bus and sensors; core 1 only
+// reads touch and renders, so drawing never delays a BLE write or a
+// sensor batch. loop() is not used.
+#define RENDER_TASK_CORE            1
+#define RENDER_TASK_PRIORITY        2       // Below touch (3), so gestures are read mid-frame
+#define RENDER_TASK_STACK           8192
+#define HOUSEKEEPING_TASK_CORE      0
+#define HOUSEKEEPING_TASK_PRIORITY  1
+#define HOUSEKEEPING_TASK_STACK     4096
+#define HOUSEKEEPING_PERIOD_MS      TASK_MONITOR_WINDOW_MS
+#define TASK_REPORT_INTERVAL_MS     10000   // Task table on Serial
+
+// The render task's subscriptions; every event wakes it from the frame wait
+EventQueue<SettingsChangedEvent> settingsEvents;
+EventQueue<NavUpdateEvent> navEvents;
+EventQueue<OrientationEvent> orientationEvents;
+EventQueue<GestureEvent> gestureEvents;
+
+// Frame pacing (see display/frame_scheduler.h). Sources without events
+// (broadcast scanner, capture replay) are polled at HUD_POLL_MS instead.
+FrameScheduler frames;
+#define HUD_POLL_MS 50
+
+TaskHandle_t renderTask = nullptr;
+TaskHandle_t housekeepingTask = nullptr;
+TaskLoad renderLoad;
+TaskLoad housekeepingLoad;
+TaskMonitor taskMonitor;
+
+// Temperature model as stored in Settings
+static GyroTempCoeffs savedTempModel(const HUDSettings& saved) {
+    GyroTempCoeffs model;
+    memcpy(model.coeff, saved.gyroTempCoeffs, sizeof(model.coeff));
+    model.minC = saved.gyroTempMinC;
+    model.maxC = saved.gyroTempMaxC;
+    model.valid = saved.gyroTempValid;
+    return model;
+}
+
+static void setDisplayRotation(float rotation) {
+    ui.setRotation(rotation);
+    touch.setRotation((uint8_t)((ui.getRotation() + 45) / 90) % 4);
+}
+
+// Applies settings that changed (SettingsField bits), whoever changed them
+static void applySettings(uint16_t fields) {
+    ui.applySettings(config.getSettings(), fields);
+    if (fields & SETTING_BRIGHTNESS) {
+        display.setBrightness(config.getBrightness());
+    }
+    if (fields & (SETTING_ROTATION | SETTING_AUTO_ROTATION)) {
+        IMUOrientation orientation;
+        uint32_t version = 0;
+        if (!config.getAutoRotation()) {
+            setDisplayRotation(config.getRotation() * 90.0f);
+        } else if (imu.readOrientation(orientation, version)) {
+            setDisplayRotation(orientation.rotation);
+        }
+    }
+#ifndef HUD_BROADCAST_RECEIVER
+    if (fields & (SETTING_AUTO_CONNECT | SETTING_RECONNECT_DELAY)) {
+        bleServer.setReconnectPolicy(config.getAutoConnect(), config.getReconnectDelay());
+    }
+#endif
+}
+
+// Gesture actions (see docs/proximos-passos.md, Fase 3). They only change
+// Settings; the resulting SettingsChangedEvent updates the screen.
+#define GESTURE_BRIGHTNESS_STEP 32
+
+static void onGesture(const GestureEvent& gesture) {
+    switch (gesture.type) {
+        case GESTURE_TAP:
+            config.toggleNightMode();
+            break;
+        case GESTURE_DOUBLE_TAP:
+            imu.resetRotation();
+            break;
+        case GESTURE_LONG_PRESS:
+            // No settings menu yet: toggles IMU auto-rotation
+            config.setAutoRotation(!config.getAutoRotation());
+            break;
+        case GESTURE_SWIPE_UP:
+        case GESTURE_SWIPE_DOWN: {
+            int step = gesture.type == GESTURE_SWIPE_UP ? GESTURE_BRIGHTNESS_STEP : -GESTURE_BRIGHTNESS_STEP;
+            config.setBrightness(constrain(config.getBrightness() + step, 16, 255));
+            break;
+        }
+        case GESTURE_SWIPE_LEFT:
+        case GESTURE_SWIPE_RIGHT:
+            // Manual rotation, used while auto-rotation is off
+            config.setRotation(config.getRotation() + (gesture.type == GESTURE_SWIPE_RIGHT ? 1 : 3));
+            break;
+        default:
+            break;
+    }
+}
+
+// Drains the render task's event queues. Navigation only marks widgets
+// dirty; the next frame draws them.
+static void handleEvents() {
+#ifdef HUD_BROADCAST_RECEIVER
+    if (broadcastScanner.poll(broadcastNav)) {
+        ui.setNavigation(broadcastNav);
+    }
+#else
+#ifdef HUD_REPLAY_CAPTURE
+    replay.update(millis());
+#endif
+    
+    // Show the waiting screen while the phone is away; the last navigation
+    // state stays cached in bleServer and is redrawn on reconnect
+    static bool wasConnected = false;
+    bool connected = bleServer.isConnected();
+    if (connected != wasConnected) {
+        wasConnected = connected;
+        if (!connected) {
+            ui.showConnectingScreen();
+        }
+    }
+    
+    // New navigation data, decoded by the ble task; a burst of updates is
+    // taken once
+    NavUpdateEvent navUpdate;
+    bool navChanged = navEvents.takeOverflow();
+    while (navEvents.pop(navUpdate)) {
+        navChanged = true;
+    }
+    if (navChanged && bleServer.hasNewData()) {
+        ui.setNavigation(bleServer.getNavigationData());
+        // Even unchanged data gets a frame: reconnect latency ends on it
+        frames.requestFrame();
+    }
+#endif
+    
+    // Orientation changes from the IMU task (sampled here if it is not running)
+    if (!imu.isTaskRunning()) {
+        imu.update();
+    }
+    OrientationEvent orientation;
+    bool rotated = false;
+    while (orientationEvents.pop(orientation)) {
+        rotated = true;
+    }
+    if (rotated && config.getAutoRotation()) {
+        setDisplayRotation(orientation.rotation);
+    }
+    
+    // Gestures only change settings; all setting changes are applied here
+    GestureEvent gesture;
+    while (gestureEvents.pop(gesture)) {
+        onGesture(gesture);
+    }
+    uint16_t changed = settingsEvents.takeOverflow() ? SETTING_ALL : 0;
+    SettingsChangedEvent settingsChange;
+    while (settingsEvents.pop(settingsChange)) {
+        changed |= settingsChange.fields;
+    }
+    if (changed) {
+        applySettings(changed);
+    }
+}
+
+// One frame: periodic elements and the dirty widgets within the budget
+static void renderFrame() {
+    unsigned long frameStart = micros();
+    uint32_t spiBefore = display.getBytesWritten();
+    
+    ui.update();
+    UIFrameResult result = ui.drawFrame(frames.getBudgetUs());
+    
+    uint32_t frameUs = micros() - frameStart;
+    frames.endFrame(frameUs, result.deferred);
+#ifndef HUD_BROADCAST_RECEIVER
+    if (ui.getState() == UI_NAVIGATION) {
+        bleServer.markFrameRendered(millis());
+    }
+#endif
+    
+    telemetry.recordFrame(frameUs, display.getBytesWritten() - spiBefore);
+}
+
+// Batched telemetry notification (no-op unless a client subscribed).
+// Polled by the render task, next to recordFrame(), so Telemetry has a
+// single owner.
+static void pollTelemetry() {
+    TelemetryPacket packet;
+    TelemetryCounters counters = {
+        bleServer.getPacketsReceived(),
+        bleServer.getPacketsDropped(),
+        imu.getSampleCount(),
+        ESP.getMinFreeHeap()
+    };
+    if (telemetry.poll(millis(), counters, packet)) {
+        bleServer.notify((const uint8_t*)&packet, sizeof(packet));
+    }
+}
+
+static void renderTaskEntry(void* param) {
+    TaskHandle_t self = xTaskGetCurrentTaskHandle();
+    settingsEvents.setWaiter(self);
+    navEvents.setWaiter(self);
+    orientationEvents.setWaiter(self);
+    gestureEvents.setWaiter(self);
+    
+    for (;;) {
+        uint32_t wakeUs = micros();
+        handleEvents();
+        
+        // Changed or deferred widgets are drawn now; the approach ring
+        // animating raises the rate to 30 FPS
+        if (ui.getDirtyWidgets()) {
+            frames.requestFrame();
+        }
+        frames.setAnimating(ui.isAnimating());
+        if (frames.beginFrame(millis())) {
+            renderFrame();
+        }
+        pollTelemetry();
+        renderLoad.add(micros() - wakeUs);
+        
+        // Sleep until the next event or frame
+        uint32_t waitMs = frames.msUntilNextFrame(millis());
+#if defined(HUD_BROADCAST_RECEIVER) || defined(HUD_REPLAY_CAPTURE)
+        waitMs = min(waitMs, (uint32_t)HUD_POLL_MS);
+#endif
+        ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(waitMs));
+    }
+}
+
+// Saves what the IMU task learned in the background
+static void persistCalibration() {
+    // Gyro bias, when it moved noticeably
+    static uint32_t calibrationVersion = 0;
+    GyroCalibration calibration;
+    if (imu.readCalibration(calibration, calibrationVersion) &&
+        calibration.state == GYRO_CAL_CALIBRATED) {
+        config.setGyroBias(calibration.bias[0], calibration.bias[1], calibration.bias[2],
+                           GYRO_CAL_SAVE_DELTA);
+    }
+    
+    // Same for the temperature model: refit every still window, saved
+    // only when the curve moved or covers a new temperature range
+    static uint32_t tempModelVersion = 0;
+    GyroTempCoeffs tempModel;
+    if (imu.readTempModel(tempModel, tempModelVersion) && tempModel.valid) {
+        if (GyroTempModel::differs(savedTempModel(config.getSettings()), tempModel, GYRO_CAL_SAVE_DELTA)) {
+            config.setGyroTempModel(tempModel.coeff, tempModel.minC, tempModel.maxC);
+        }
+    }
+}
+
+// Every task of the firmware, whether it started or not
+static void registerTasks() {
+    taskMonitor.add("i2c", i2cBus.getTaskHandle(), I2C_BUS_TASK_CORE, I2C_BUS_TASK_PRIORITY,
+                    I2C_BUS_TASK_STACK, &i2cBus.getTaskLoad());
+    taskMonitor.add("imu", imu.getTaskHandle(), IMU_TASK_CORE, IMU_TASK_PRIORITY,
+                    IMU_TASK_STACK, &imu.getTaskLoad());
+    taskMonitor.add("ble", bleServer.getTaskHandle(), BLE_TASK_CORE, BLE_TASK_PRIORITY,
+                    BLE_TASK_STACK, &bleServer.getTaskLoad());
+    taskMonitor.add("touch", touch.getTaskHandle(), TOUCH_TASK_CORE, TOUCH_TASK_PRIORITY,
+                    TOUCH_TASK_STACK, &touch.getTaskLoad());
+    taskMonitor.add("render", renderTask, RENDER_TASK_CORE, RENDER_TASK_PRIORITY,
+                    RENDER_TASK_STACK, &renderLoad);
+    taskMonitor.add("settings", config.getTaskHandle(), SETTINGS_TASK_CORE, SETTINGS_TASK_PRIORITY,
+                    SETTINGS_TASK_STACK, &config.getTaskLoad());
+    taskMonitor.add("pktlog", packetLog.getTaskHandle(), PACKET_LOG_TASK_CORE, PACKET_LOG_TASK_PRIORITY,
+                    PACKET_LOG_TASK_STACK, &packetLog.getTaskLoad());
+    taskMonitor.add("housekeeping", housekeepingTask, HOUSEKEEPING_TASK_CORE, HOUSEKEEPING_TASK_PRIORITY,
+                    HOUSEKEEPING_TASK_STACK, &housekeepingLoad);
+}
+
+// Low-rate work that must not sit on the render path: saving the
+// calibration and the task report. The only task on a fixed period.
+static void housekeepingTaskEntry(void* param) {
+    registerTasks();
+    
+    TickType_t lastWake = xTaskGetTickCount();
+    uint32_t lastReportMs = millis();
+    for (;;) {
+        vTaskDelayUntil(&lastWake, pdMS_TO_TICKS(HOUSEKEEPING_PERIOD_MS));
+        uint32_t wakeUs = micros();
+        
+        persistCalibration();
+        
+        if (taskMonitor.sample(micros())) {
+            uint32_t nowMs = millis();
+            if (nowMs - lastReportMs >= TASK_REPORT_INTERVAL_MS || taskMonitor.countTightStacks() > 0) {
+                lastReportMs = nowMs;
+                taskMonitor.print();
+                
+                // Counters written by the render task; a snapshot is enough here
+                const FrameStats& f = frames.getStats();
+                Serial.printf("Frames: %u (%u on demand, %u animated), %u over the %u us budget (%.1f%%), "
+                              "%u deferred widgets, max %u us\n",
+                              f.frames, f.demandFrames, f.animationFrames, f.overruns, frames.getBudgetUs(),
+                              frames.getOverrunRate() * 100.0f, f.deferredWidgets, f.maxFrameUs);
+            }
+        }
+        
+        housekeepingLoad.add(micros() - wakeUs);
+    }
+}
+
+static void startTasks() {
+    // The render task owns the UI from here on; setup() must not draw after this
+    if (xTaskCreatePinnedToCore(renderTaskEntry, "render", RENDER_TASK_STACK, nullptr,
+                                RENDER_TASK_PRIORITY, &renderTask, RENDER_TASK_CORE) != pdPASS) {
+        renderTask = nullptr;
+        Serial.println("Failed to start render task!");
+    }
+    if (xTaskCreatePinnedToCore(housekeepingTaskEntry, "housekeeping", HOUSEKEEPING_TASK_STACK, nullptr,
+                                HOUSEKEEPING_TASK_PRIORITY, &housekeepingTask, HOUSEKEEPING_TASK_CORE) != pdPASS) {
+        housekeepingTask = nullptr;
+        Serial.println("Failed to start housekeeping task!");
+    }
+}
 
 void setup() {
     Serial.begin(115200);
     Serial.println("ESP32-S3 HUD Navigation Starting...");
     
-    // Initialize configuration
-    config.init();
+    // Subscribe before any module can publish; events queue up until the
+    // render task starts and drains them
+    EventBus<SettingsChangedEvent>::subscribe(settingsEvents);
+    EventBus<NavUpdateEvent>::subscribe(navEvents);
+    EventBus<OrientationEvent>::subscribe(orientationEvents);
+    EventBus<GestureEvent>::subscribe(gestureEvents);
+    
+    // Initialize configuration; changes are committed to flash in the
+    // background once the user stopped adjusting them
+    if (config.init()) {
+        config.startCommitTask();
+    }
     
     // Initialize display
     if (!display.init()) {
@@ -25,35 +377,73 @@ void setup() {
         return;
     }
     
+    display.setBrightness(config.getBrightness());
+    
     // Initialize UI manager
     ui.init(&display);
+    ui.applySettings(config.getSettings(), SETTING_ALL);
     ui.showStartupScreen();
     
-    // Initialize sensors
-    imu.init();
+    // Shared I2C bus (IMU, touch, RTC): transactions run in its worker task
+    if (i2cBus.begin()) {
+        i2cBus.startTask();
+    }
+    
+    // Initialize sensors; samples are batched in the on-chip FIFO and
+    // fused in their own task, independent of the frame rate
+    if (imu.init(&i2cBus)) {
+        // Start from the last learned gyro bias; refined in the background
+        const HUDSettings& saved = config.getSettings();
+        if (saved.gyroBiasValid) {
+            imu.seedGyroBias(saved.gyroBiasX, saved.gyroBiasY, saved.gyroBiasZ);
+        }
+        if (saved.gyroTempValid) {
+            imu.seedTempModel(savedTempModel(saved));
+        }
+        imu.enableFifo();
+        imu.startTask();
+    }
+    
+    // Touch gestures, recognized in their own task on the INT line
+    if (touch.init(&i2cBus)) {
+        touch.startTask();
+    }
+    applySettings(SETTING_ROTATION | SETTING_AUTO_ROTATION);
+    
+#ifdef HUD_BROADCAST_RECEIVER
+    // Follow another HUD's navigation broadcast instead of pairing a phone
+    broadcastScanner.begin();
+    startTasks();
+    Serial.println("ESP32-S3 HUD initialized as broadcast receiver");
+    return;
+#endif
     
-    // Initialize BLE server
+    // Initialize BLE server; writes are decoded in its own task
     bleServer.init();
+#ifdef HUD_BROADCAST_SENDER
+    bleServer.setBroadcastEnabled(true);
+#endif
+    
+    // Packet capture (flash ring log of raw writes)
+    if (packetLog.init()) {
+#ifdef HUD_REPLAY_CAPTURE
+        // Replay the stored capture instead of recording new traffic
+        replay.begin(&bleServer, &packetLog, HUD_REPLAY_CAPTURE, millis());
+#else
+        packetLog.startFlushTask();
+        bleServer.setPacketLog(&packetLog);
+#endif
+    }
+    
+    bleServer.setReconnectPolicy(config.getAutoConnect(), config.getReconnectDelay());
     bleServer.startAdvertising();
+    bleServer.startTask();
     
+    startTasks();
     Serial.println("ESP32-S3 HUD initialized successfully!");
 }
 
 void loop() {
-    // Update UI
-    ui.update();
-    
-    // Check for BLE data
-    if (bleServer.hasNewData()) {
-        NavigationData navData = bleServer.getNavigationData();
-        ui.updateNavigation(navData);
-    }
-    
-    // Check sensor data for rotation
-    if (imu.hasNewData()) {
-        float rotation = imu.getRotation();
-        ui.setRotation(rotation);
-    }
-    
-    delay(50); // 20 FPS update rate
-}
\ No newline at end of file
+    // Everything runs in the tasks started by setup(); free the loop task's stack
+    vTaskDelete(nullptr);
+}
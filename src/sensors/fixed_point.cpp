@@ -0,0 +1,110 @@
+#include "fixed_point.h"
+
+// atan(2^-i) as binary angles
+static const uint32_t cordicAngles[CORDIC_ITERATIONS] = {
+    0x20000000, 0x12E4051E, 0x09FB385B, 0x051111D4, 0x028B0D43, 0x0145D7E1,
+    0x00A2F61E, 0x00517C55, 0x0028BE53, 0x00145F2F, 0x000A2F98, 0x000517CC,
+    0x00028BE6, 0x000145F3, 0x0000A2FA, 0x0000517D, 0x000028BE, 0x0000145F
+};
+
+uint32_t cordicAtan2(int32_t y, int32_t x) {
+    // Headroom for the CORDIC gain (~1.65 * sqrt(2))
+    x >>= 2;
+    y >>= 2;
+
+    // Vectoring mode works in the right half plane
+    uint32_t angle = 0;
+    if (x < 0) {
+        x = -x;
+        y = -y;
+        angle = 0x80000000;
+    }
+
+    for (int i = 0; i < CORDIC_ITERATIONS; i++) {
+        int32_t xShift = x >> i;
+        int32_t yShift = y >> i;
+        if (y > 0) {
+            x += yShift;
+            y -= xShift;
+            angle += cordicAngles[i];
+        } else {
+            x -= yShift;
+            y += xShift;
+            angle -= cordicAngles[i];
+        }
+    }
+    return angle;
+}
+
+FixedGravityFilter::FixedGravityFilter() : gyroStep(0), accelToQ28(0), blend(0),
+                                           normSqMin(0), normSqMax(0) {
+    reset();
+}
+
+void FixedGravityFilter::configure(float gyroDpsPerLsb, float accelGPerLsb, float odrHz,
+                                   float kp, float accelTolerance) {
+    gyroStep = (q31_t)(gyroDpsPerLsb * (PI / 180.0f) / odrHz * 2147483648.0f + 0.5f);
+    accelToQ28 = (int32_t)(accelGPerLsb * Q28_ONE + 0.5f);
+    blend = (q31_t)(kp / odrHz * 2147483648.0f + 0.5f);
+
+    float oneG = 1.0f / accelGPerLsb;
+    float low = 1.0f - accelTolerance;
+    float high = 1.0f + accelTolerance;
+    normSqMin = (int64_t)(low * low * oneG * oneG);
+    normSqMax = (int64_t)(high * high * oneG * oneG);
+}
+
+void FixedGravityFilter::reset() {
+    gravity[0] = Q28_ONE;
+    gravity[1] = gravity[2] = 0;
+    gyroBias[0] = gyroBias[1] = gyroBias[2] = 0;
+    aligned = false;
+}
+
+void FixedGravityFilter::setGyroBias(int16_t x, int16_t y, int16_t z) {
+    gyroBias[0] = x;
+    gyroBias[1] = y;
+    gyroBias[2] = z;
+}
+
+int32_t FixedGravityFilter::accelSampleToQ28(q15_t raw) const {
+    // A ±16 g full scale would overflow the product at the rails
+    int64_t value = (int64_t)raw * accelToQ28;
+    return (int32_t)constrain(value, -(int64_t)Q28_ACCEL_LIMIT, (int64_t)Q28_ACCEL_LIMIT);
+}
+
+void FixedGravityFilter::update(const q15_t accel[3], const q15_t gyro[3], uint32_t ticks) {
+    int64_t normSq = (int64_t)accel[0] * accel[0] + (int64_t)accel[1] * accel[1] +
+                     (int64_t)accel[2] * accel[2];
+    bool accelUsable = normSq >= normSqMin && normSq <= normSqMax;
+
+    if (!aligned) {
+        if (!accelUsable) return;
+        for (int i = 0; i < 3; i++) {
+            gravity[i] = accelSampleToQ28(accel[i]);
+        }
+        aligned = true;
+        return;
+    }
+
+    // Rotation over this sample, radians (Q31). A long polling gap could
+    // exceed the format; the rotation is clamped instead of wrapping.
+    q31_t theta[3];
+    for (int i = 0; i < 3; i++) {
+        int64_t step = (int64_t)(gyro[i] - gyroBias[i]) * gyroStep * ticks;
+        theta[i] = (q31_t)constrain(step, (int64_t)INT32_MIN, (int64_t)INT32_MAX);
+    }
+
+    // A world-fixed vector seen from the sensor turns the other way: v' = v x theta
+    int32_t gx = gravity[0], gy = gravity[1], gz = gravity[2];
+    gravity[0] += mulQ31(gy, theta[2]) - mulQ31(gz, theta[1]);
+    gravity[1] += mulQ31(gz, theta[0]) - mulQ31(gx, theta[2]);
+    gravity[2] += mulQ31(gx, theta[1]) - mulQ31(gy, theta[0]);
+
+    if (accelUsable) {
+        for (int i = 0; i < 3; i++) {
+            int32_t measured = accelSampleToQ28(accel[i]);
+            gravity[i] += mulQ31(measured - gravity[i], blend);
+        }
+    }
+}
@@ -0,0 +1,72 @@
+#ifndef FIXED_POINT_H
+#define FIXED_POINT_H
+
+#include <Arduino.h>
+
+// Integer IMU pipeline, selected with -DIMU_FIXED_POINT.
+//
+// Formats:
+//   raw samples   int16, as read (Q15 of the configured full scale)
+//   gravity       Q28 per axis, 1 g = 1 << 28. int32 tops out just under
+//                 8 g; accelerometer input is clamped to ±2 g before
+//                 conversion so sums and differences never overflow
+//   gyro step     Q31 radians per LSB per sample
+//   angles        uint32 binary angle, 2^32 = 360°: wrapping is the
+//                 natural integer overflow, no while loops
+//
+// FixedGravityFilter tracks gravity in the sensor frame: each sample
+// rotates the estimate by the gyro (v' = v x w dt) and blends it toward the
+// accelerometer with weight kp * dt, skipping readings far from 1 g. The
+// display rotation is the CORDIC atan2 of its X/Y components. It drives
+// auto-rotation only: roll and pitch come from gravity, and there is no
+// yaw or bias estimate (the background calibrator still removes the bias).
+#define Q28_ONE             (1L << 28)
+#define Q28_ACCEL_LIMIT     (2L * Q28_ONE)  // Gravity only ever blends toward ~1 g
+#define CORDIC_ITERATIONS   18              // ~0.0004° resolution
+#define BINARY_ANGLE_DEG    (360.0f / 4294967296.0f)
+
+typedef int16_t q15_t;
+typedef int32_t q31_t;
+
+static inline q31_t mulQ31(q31_t a, q31_t b) {
+    return (q31_t)(((int64_t)a * b) >> 31);
+}
+
+// Angle of (x, y) from +X, counter-clockwise, as a binary angle
+uint32_t cordicAtan2(int32_t y, int32_t x);
+
+static inline float binaryAngleToDegrees(uint32_t angle) {
+    return angle * BINARY_ANGLE_DEG;
+}
+
+class FixedGravityFilter {
+private:
+    int32_t gravity[3];       // Q28
+    q31_t gyroStep;           // Radians per gyro LSB per sample
+    int32_t accelToQ28;       // Raw accel LSB to Q28
+    q31_t blend;              // Accel weight per sample
+    int64_t normSqMin;        // Accepted |a|^2 window, raw LSB^2
+    int64_t normSqMax;
+    int16_t gyroBias[3];      // Raw LSB
+    bool aligned;
+
+    int32_t accelSampleToQ28(q15_t raw) const;
+
+public:
+    FixedGravityFilter();
+
+    // Conversion constants are computed here, once, in float
+    void configure(float gyroDpsPerLsb, float accelGPerLsb, float odrHz,
+                   float kp, float accelTolerance);
+    void reset();
+    void setGyroBias(int16_t x, int16_t y, int16_t z);
+
+    // One raw sample; ticks is the number of ODR periods it covers
+    void update(const q15_t accel[3], const q15_t gyro[3], uint32_t ticks = 1);
+
+    uint32_t getAngle() const { return cordicAtan2(gravity[1], gravity[0]); }
+    float getRotationDegrees() const { return binaryAngleToDegrees(getAngle()); }
+    const int32_t* getGravity() const { return gravity; }
+};
+
+#endif // FIXED_POINT_H
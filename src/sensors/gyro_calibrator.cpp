@@ -0,0 +1,99 @@
+#include "gyro_calibrator.h"
+#include <math.h>
+
+GyroCalibrator::GyroCalibrator() : stillWindows(0), movingWindows(0) {
+    restart();
+}
+
+void GyroCalibrator::restart() {
+    state = GYRO_CAL_UNCALIBRATED;
+    bias[0] = bias[1] = bias[2] = 0.0f;
+    lastMean[0] = lastMean[1] = lastMean[2] = 0.0f;
+    clearWindow();
+}
+
+void GyroCalibrator::seed(float x, float y, float z) {
+    bias[0] = x;
+    bias[1] = y;
+    bias[2] = z;
+    state = GYRO_CAL_SEEDED;
+    clearWindow();
+}
+
+void GyroCalibrator::clearWindow() {
+    count = 0;
+    for (int i = 0; i < 3; i++) {
+        gyroSum[i] = gyroSumSq[i] = 0.0f;
+        accelSum[i] = accelSumSq[i] = 0.0f;
+    }
+    normErrorMax = 0.0f;
+}
+
+bool GyroCalibrator::feed(float gx, float gy, float gz, float ax, float ay, float az) {
+    const float gyro[3] = {gx, gy, gz};
+    const float accel[3] = {ax, ay, az};
+
+    if (count == 0) {
+        memcpy(gyroRef, gyro, sizeof(gyroRef));
+        memcpy(accelRef, accel, sizeof(accelRef));
+    }
+    for (int i = 0; i < 3; i++) {
+        float dg = gyro[i] - gyroRef[i];
+        float da = accel[i] - accelRef[i];
+        gyroSum[i] += dg;
+        gyroSumSq[i] += dg * dg;
+        accelSum[i] += da;
+        accelSumSq[i] += da * da;
+    }
+    float normError = fabsf(sqrtf(ax * ax + ay * ay + az * az) - 1.0f);
+    if (normError > normErrorMax) normErrorMax = normError;
+
+    if (++count < GYRO_CAL_WINDOW) return false;
+
+    float mean[3];
+    bool still = windowIsStill(mean);
+    clearWindow();
+
+    if (!still) {
+        movingWindows++;
+        return false;
+    }
+
+    stillWindows++;
+    float alpha = state == GYRO_CAL_CALIBRATED ? GYRO_CAL_ALPHA : 1.0f;
+    for (int i = 0; i < 3; i++) {
+        bias[i] += alpha * (mean[i] - bias[i]);
+        lastMean[i] = mean[i];
+    }
+    state = GYRO_CAL_CALIBRATED;
+    return true;
+}
+
+bool GyroCalibrator::windowIsStill(float gyroMean[3]) const {
+    if (normErrorMax > GYRO_CAL_ACCEL_NORM_TOL) return false;
+
+    for (int i = 0; i < 3; i++) {
+        float gyroOffset = gyroSum[i] / count;
+        float gyroVar = gyroSumSq[i] / count - gyroOffset * gyroOffset;
+        float accelOffset = accelSum[i] / count;
+        float accelVar = accelSumSq[i] / count - accelOffset * accelOffset;
+        gyroMean[i] = gyroRef[i] + gyroOffset;
+
+        if (gyroVar > GYRO_CAL_GYRO_VAR || accelVar > GYRO_CAL_ACCEL_VAR ||
+            fabsf(gyroMean[i]) > GYRO_CAL_MAX_BIAS) {
+            return false;
+        }
+    }
+    return true;
+}
+
+GyroCalibration GyroCalibrator::snapshot() const {
+    GyroCalibration cal;
+    cal.bias[0] = bias[0];
+    cal.bias[1] = bias[1];
+    cal.bias[2] = bias[2];
+    cal.state = state;
+    cal.stillWindows = stillWindows;
+    cal.movingWindows = movingWindows;
+    return cal;
+}
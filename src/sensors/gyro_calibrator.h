@@ -0,0 +1,76 @@
+#ifndef GYRO_CALIBRATOR_H
+#define GYRO_CALIBRATOR_H
+
+#include <Arduino.h>
+
+// Background gyro zero-rate calibration. Samples are grouped in windows;
+// a window counts as still when gyro and accel variance are both low and
+// the accel magnitude is close to 1 g. Each still window's mean gyro is a
+// bias measurement: the first one replaces the current bias, later ones
+// are blended in so the estimate follows temperature drift. Moving
+// windows are discarded, so a car in traffic just calibrates at the next
+// stop instead of learning its motion as bias.
+#define GYRO_CAL_WINDOW         112     // Samples per window (~0.5 s at IMU_ODR_HZ)
+#define GYRO_CAL_GYRO_VAR       0.04f   // Max gyro variance per axis, (deg/s)^2
+#define GYRO_CAL_ACCEL_VAR      0.0004f // Max accel variance per axis, g^2
+#define GYRO_CAL_ACCEL_NORM_TOL 0.05f   // Max | |a| - 1 g |
+#define GYRO_CAL_MAX_BIAS       5.0f    // A larger mean is rotation, not bias (deg/s)
+#define GYRO_CAL_ALPHA          0.2f    // Weight of a new still window once calibrated
+#define GYRO_CAL_SAVE_DELTA     0.05f   // Bias change worth persisting (deg/s)
+
+enum GyroCalState {
+    GYRO_CAL_UNCALIBRATED,   // No bias yet: rotation may drift
+    GYRO_CAL_SEEDED,         // Using the bias saved on a previous run
+    GYRO_CAL_CALIBRATED      // Bias measured during this run
+};
+
+// Snapshot published by the IMU task
+struct GyroCalibration {
+    float bias[3];           // deg/s
+    uint8_t state;           // GyroCalState
+    uint32_t stillWindows;
+    uint32_t movingWindows;
+};
+
+class GyroCalibrator {
+private:
+    GyroCalState state;
+    float bias[3];
+
+    // Current window: sums of offsets from the window's first sample, so
+    // float variance keeps its precision around 1 g
+    uint16_t count;
+    float gyroRef[3], accelRef[3];
+    float gyroSum[3], gyroSumSq[3];
+    float accelSum[3], accelSumSq[3];
+    float normErrorMax;
+
+    float lastMean[3];       // Gyro mean of the most recent still window
+
+    uint32_t stillWindows;
+    uint32_t movingWindows;
+
+    void clearWindow();
+    bool windowIsStill(float gyroMean[3]) const;
+
+public:
+    GyroCalibrator();
+
+    // Forgets the bias and starts over (e.g. after a sensor swap)
+    void restart();
+
+    // Starts from a stored bias; replaced by the first still window
+    void seed(float x, float y, float z);
+
+    // One raw sample: gyro in deg/s, accel in g. Returns true when a still
+    // window completed and the bias was updated.
+    bool feed(float gx, float gy, float gz, float ax, float ay, float az);
+
+    GyroCalState getState() const { return state; }
+    bool isCalibrated() const { return state != GYRO_CAL_UNCALIBRATED; }
+    const float* getBias() const { return bias; }
+    const float* getLastMean() const { return lastMean; }
+    GyroCalibration snapshot() const;
+};
+
+#endif // GYRO_CALIBRATOR_H
@@ -0,0 +1,174 @@
+#include "gyro_temp_model.h"
+#include "gyro_calibrator.h"
+#include <math.h>
+
+GyroTempModel::GyroTempModel() {
+    reset();
+}
+
+void GyroTempModel::reset() {
+    memset(binBias, 0, sizeof(binBias));
+    memset(binTemp, 0, sizeof(binTemp));
+    memset(binUsed, 0, sizeof(binUsed));
+    memset(&coeffs, 0, sizeof(coeffs));
+    memset(table, 0, sizeof(table));
+}
+
+int GyroTempModel::binIndex(float celsius) {
+    long i = lroundf((celsius - GYRO_TEMP_MIN_C) / GYRO_TEMP_STEP_C);
+    return constrain(i, 0L, (long)GYRO_TEMP_BINS - 1);
+}
+
+float GyroTempModel::evaluate(const float c[GYRO_TEMP_COEFFS], float celsius) {
+    float x = celsius - GYRO_TEMP_REF_C;
+    return c[0] + x * (c[1] + x * c[2]);
+}
+
+void GyroTempModel::seed(const GyroTempCoeffs& saved) {
+    reset();
+    if (!saved.valid) return;
+
+    for (int i = binIndex(saved.minC); i <= binIndex(saved.maxC); i++) {
+        float celsius = GYRO_TEMP_MIN_C + i * GYRO_TEMP_STEP_C;
+        for (int axis = 0; axis < 3; axis++) {
+            binBias[i][axis] = evaluate(saved.coeff[axis], celsius);
+        }
+        binTemp[i] = celsius;
+        binUsed[i] = true;
+    }
+    fit();
+}
+
+bool GyroTempModel::addObservation(float celsius, const float bias[3]) {
+    int i = binIndex(celsius);
+    float alpha = binUsed[i] ? GYRO_CAL_ALPHA : 1.0f;
+    for (int axis = 0; axis < 3; axis++) {
+        binBias[i][axis] += alpha * (bias[axis] - binBias[i][axis]);
+    }
+    binTemp[i] += alpha * (celsius - binTemp[i]);
+    binUsed[i] = true;
+
+    fit();
+    return coeffs.valid;
+}
+
+// Solves the n x n system a * x = b in place (Gaussian elimination with
+// partial pivoting); false when singular
+static bool solve(double a[GYRO_TEMP_COEFFS][GYRO_TEMP_COEFFS], double b[GYRO_TEMP_COEFFS],
+                  int n, double x[GYRO_TEMP_COEFFS]) {
+    for (int col = 0; col < n; col++) {
+        int pivot = col;
+        for (int row = col + 1; row < n; row++) {
+            if (fabs(a[row][col]) > fabs(a[pivot][col])) pivot = row;
+        }
+        if (fabs(a[pivot][col]) < 1e-12) return false;
+        for (int k = 0; k < n; k++) {
+            double t = a[col][k];
+            a[col][k] = a[pivot][k];
+            a[pivot][k] = t;
+        }
+        double t = b[col];
+        b[col] = b[pivot];
+        b[pivot] = t;
+
+        for (int row = col + 1; row < n; row++) {
+            double f = a[row][col] / a[col][col];
+            for (int k = col; k < n; k++) a[row][k] -= f * a[col][k];
+            b[row] -= f * b[col];
+        }
+    }
+    for (int row = n - 1; row >= 0; row--) {
+        double sum = b[row];
+        for (int k = row + 1; k < n; k++) sum -= a[row][k] * x[k];
+        x[row] = sum / a[row][row];
+    }
+    return true;
+}
+
+void GyroTempModel::fit() {
+    int used = 0, first = -1, last = -1;
+    for (int i = 0; i < GYRO_TEMP_BINS; i++) {
+        if (!binUsed[i]) continue;
+        if (first < 0) first = i;
+        last = i;
+        used++;
+    }
+    int span = used > 0 ? (last - first) * GYRO_TEMP_STEP_C : 0;
+    if (used < 2 || span < GYRO_TEMP_MIN_SPAN_C) {
+        coeffs.valid = false;
+        return;
+    }
+    int terms = span >= GYRO_TEMP_QUAD_SPAN_C && used >= 3 ? 3 : 2;
+
+    // Normal equations: sums of x^k and x^k * bias over the used bins
+    double powers[2 * GYRO_TEMP_COEFFS - 1] = {0};
+    double moments[3][GYRO_TEMP_COEFFS] = {{0}};
+    for (int i = first; i <= last; i++) {
+        if (!binUsed[i]) continue;
+        double x = binTemp[i] - GYRO_TEMP_REF_C;
+        double xk = 1.0;
+        for (int k = 0; k < 2 * terms - 1; k++) {
+            powers[k] += xk;
+            if (k < terms) {
+                for (int axis = 0; axis < 3; axis++) moments[axis][k] += xk * binBias[i][axis];
+            }
+            xk *= x;
+        }
+    }
+
+    GyroTempCoeffs next;
+    memset(&next, 0, sizeof(next));
+    for (int axis = 0; axis < 3; axis++) {
+        double a[GYRO_TEMP_COEFFS][GYRO_TEMP_COEFFS];
+        double x[GYRO_TEMP_COEFFS] = {0};
+        for (int r = 0; r < terms; r++) {
+            for (int c = 0; c < terms; c++) a[r][c] = powers[r + c];
+        }
+        if (!solve(a, moments[axis], terms, x)) {
+            coeffs.valid = false;
+            return;
+        }
+        for (int k = 0; k < terms; k++) next.coeff[axis][k] = x[k];
+    }
+    next.minC = GYRO_TEMP_MIN_C + first * GYRO_TEMP_STEP_C;
+    next.maxC = GYRO_TEMP_MIN_C + last * GYRO_TEMP_STEP_C;
+    next.valid = true;
+
+    coeffs = next;
+    buildTable();
+}
+
+void GyroTempModel::buildTable() {
+    for (int i = 0; i < GYRO_TEMP_BINS; i++) {
+        float celsius = constrain(GYRO_TEMP_MIN_C + i * GYRO_TEMP_STEP_C,
+                                  (int)coeffs.minC, (int)coeffs.maxC);
+        for (int axis = 0; axis < 3; axis++) {
+            table[i][axis] = evaluate(coeffs.coeff[axis], celsius);
+        }
+    }
+}
+
+void GyroTempModel::lookup(float celsius, float bias[3]) const {
+    float pos = (celsius - GYRO_TEMP_MIN_C) / GYRO_TEMP_STEP_C;
+    pos = constrain(pos, 0.0f, (float)(GYRO_TEMP_BINS - 1));
+    int i = min((int)pos, GYRO_TEMP_BINS - 2);
+    float frac = pos - i;
+    for (int axis = 0; axis < 3; axis++) {
+        bias[axis] = table[i][axis] + frac * (table[i + 1][axis] - table[i][axis]);
+    }
+}
+
+bool GyroTempModel::differs(const GyroTempCoeffs& a, const GyroTempCoeffs& b, float delta) {
+    if (a.valid != b.valid) return true;
+    if (!a.valid) return false;
+    if (a.minC != b.minC || a.maxC != b.maxC) return true;
+
+    for (int celsius = a.minC; celsius <= a.maxC; celsius += GYRO_TEMP_STEP_C) {
+        for (int axis = 0; axis < 3; axis++) {
+            if (fabsf(evaluate(a.coeff[axis], celsius) - evaluate(b.coeff[axis], celsius)) > delta) {
+                return true;
+            }
+        }
+    }
+    return false;
+}
@@ -0,0 +1,75 @@
+#ifndef GYRO_TEMP_MODEL_H
+#define GYRO_TEMP_MODEL_H
+
+#include <Arduino.h>
+
+// Gyro bias as a function of die temperature, learned per device.
+//
+// Each still window from GyroCalibrator is a (temperature, bias) point.
+// Points are averaged into 2 °C bins so an hour parked at one temperature
+// weighs no more than a minute at another. Every new point refits a
+// least-squares polynomial in (T - GYRO_TEMP_REF_C) per axis: linear once
+// the bins span GYRO_TEMP_MIN_SPAN_C, quadratic from GYRO_TEMP_QUAD_SPAN_C.
+// The fit is evaluated into a table at the bin temperatures, and the bias
+// for the current temperature is interpolated from it: no polynomial and
+// no recalibration pause while driving. Beyond the learned span the table
+// holds the edge values instead of extrapolating.
+#define GYRO_TEMP_MIN_C         -20     // Table range, °C
+#define GYRO_TEMP_MAX_C         80
+#define GYRO_TEMP_STEP_C        2
+#define GYRO_TEMP_BINS          ((GYRO_TEMP_MAX_C - GYRO_TEMP_MIN_C) / GYRO_TEMP_STEP_C + 1)
+#define GYRO_TEMP_REF_C         25.0f   // Polynomial origin
+#define GYRO_TEMP_MIN_SPAN_C    6       // Learned span needed for a slope
+#define GYRO_TEMP_QUAD_SPAN_C   20      // Learned span needed for curvature
+#define GYRO_TEMP_COEFFS        3       // Offset, slope, curvature
+
+// Fitted model, as persisted in Settings
+struct GyroTempCoeffs {
+    float coeff[3][GYRO_TEMP_COEFFS];   // Per axis: deg/s, deg/s/°C, deg/s/°C²
+    int8_t minC;                        // Learned span
+    int8_t maxC;
+    bool valid;
+};
+
+class GyroTempModel {
+private:
+    // Averaged bias, and the temperature it was measured at, per bin
+    float binBias[GYRO_TEMP_BINS][3];
+    float binTemp[GYRO_TEMP_BINS];
+    bool binUsed[GYRO_TEMP_BINS];
+
+    GyroTempCoeffs coeffs;
+    float table[GYRO_TEMP_BINS][3];     // Fit evaluated per bin, deg/s
+
+    static int binIndex(float celsius);
+    static float evaluate(const float c[GYRO_TEMP_COEFFS], float celsius);
+    void fit();
+    void buildTable();
+
+public:
+    GyroTempModel();
+
+    // Forgets every point and the fit
+    void reset();
+
+    // Restores a fit from a previous run: its span is filled with points
+    // on the curve, which new measurements then replace bin by bin
+    void seed(const GyroTempCoeffs& saved);
+
+    // One still-window bias measurement at the given temperature; refits.
+    // Returns true when a fit is available.
+    bool addObservation(float celsius, const float bias[3]);
+
+    bool isFitted() const { return coeffs.valid; }
+    const GyroTempCoeffs& getCoeffs() const { return coeffs; }
+
+    // Bias at the given temperature from the table (deg/s). Only
+    // meaningful when isFitted().
+    void lookup(float celsius, float bias[3]) const;
+
+    // True when the fits disagree by more than delta (deg/s) anywhere in
+    // their span, or cover different spans: worth persisting
+    static bool differs(const GyroTempCoeffs& a, const GyroTempCoeffs& b, float delta);
+};
+
+#endif // GYRO_TEMP_MODEL_H
@@ -0,0 +1,122 @@
+#include "imu_filter.h"
+#include <math.h>
+
+#define HALF_TAPS (IMU_FILTER_TAPS / 2)
+#define HISTORY   (IMU_FILTER_TAPS - 1)
+
+// First half of each symmetric impulse response, Q14 (full response sums to 16384)
+#if IMU_FILTER_PROFILE == IMU_FILTER_CAR
+static const int16_t accelTaps[HALF_TAPS] = {      // 6 Hz
+    18, 28, 46, 77, 125, 192, 277, 379, 495, 619, 746, 867, 975, 1064, 1126, 1158
+};
+static const int16_t gyroTaps[HALF_TAPS] = {       // 15 Hz
+    6, -6, -26, -58, -100, -140, -156, -120, -4, 208, 517, 900, 1313, 1699, 1998, 2161
+};
+#elif IMU_FILTER_PROFILE == IMU_FILTER_SMOOTH
+static const int16_t accelTaps[HALF_TAPS] = {      // 3 Hz
+    60, 70, 96, 137, 194, 265, 348, 440, 537, 636, 731, 818, 894, 954, 996, 1016
+};
+static const int16_t gyroTaps[HALF_TAPS] = {       // 8 Hz
+    -10, -4, 6, 25, 61, 118, 199, 307, 438, 588, 748, 908, 1054, 1177, 1265, 1312
+};
+#elif IMU_FILTER_PROFILE != IMU_FILTER_OFF
+#error "Unknown IMU_FILTER_PROFILE"
+#endif
+
+#if IMU_FILTER_PROFILE != IMU_FILTER_OFF
+// out[n] = sum over k of taps[k] * x[n + k], folded on the symmetric taps
+static void firBlock(const int16_t* x, const int16_t* taps, int16_t* out, size_t count) {
+    for (size_t n = 0; n < count; n++) {
+        const int16_t* head = x + n;
+        const int16_t* tail = x + n + IMU_FILTER_TAPS - 1;
+        int32_t acc = 1 << 13;   // Rounding
+        for (int k = 0; k < HALF_TAPS; k++) {
+            acc += (int32_t)(head[k] + tail[-k]) * taps[k];
+        }
+        acc >>= 14;
+        out[n] = (int16_t)constrain(acc, (int32_t)INT16_MIN, (int32_t)INT16_MAX);
+    }
+}
+#endif
+
+IMUFilterBank::IMUFilterBank() : notchEnabled(false), notchB0(0), notchB1(0),
+                                 notchA1(0), notchA2(0) {
+    reset();
+}
+
+void IMUFilterBank::reset() {
+    primed = false;
+    memset(window, 0, sizeof(window));
+    memset(notchX1, 0, sizeof(notchX1));
+    memset(notchX2, 0, sizeof(notchX2));
+    memset(notchY1, 0, sizeof(notchY1));
+    memset(notchY2, 0, sizeof(notchY2));
+}
+
+void IMUFilterBank::setNotch(float hz, float sampleRateHz, float q) {
+    if (hz <= 0 || hz >= sampleRateHz / 2) {
+        notchEnabled = false;
+        return;
+    }
+
+    float w0 = 2.0f * PI * hz / sampleRateHz;
+    float alpha = sinf(w0) / (2.0f * q);
+    float a0 = 1.0f + alpha;
+    notchB0 = lroundf(16384.0f / a0);
+    notchB1 = lroundf(-2.0f * cosf(w0) * 16384.0f / a0);
+    notchA1 = notchB1;
+    notchA2 = lroundf((1.0f - alpha) * 16384.0f / a0);
+    notchEnabled = true;
+}
+
+void IMUFilterBank::prime(int16_t* const channels[IMU_FILTER_CHANNELS]) {
+    // Start from a steady signal instead of zeros: gravity does not ramp up
+    for (uint8_t c = 0; c < IMU_FILTER_CHANNELS; c++) {
+        for (int i = 0; i < HISTORY; i++) {
+            window[c][i] = channels[c][0];
+        }
+        notchX1[c] = notchX2[c] = notchY1[c] = notchY2[c] = channels[c][0];
+    }
+    primed = true;
+}
+
+void IMUFilterBank::notch(uint8_t c, int16_t* samples, size_t count) {
+    int32_t x1 = notchX1[c], x2 = notchX2[c], y1 = notchY1[c], y2 = notchY2[c];
+    for (size_t n = 0; n < count; n++) {
+        int32_t x0 = samples[n];
+        int64_t acc = (int64_t)notchB0 * (x0 + x2) + (int64_t)notchB1 * x1 -
+                      (int64_t)notchA1 * y1 - (int64_t)notchA2 * y2;
+        int32_t y0 = (int32_t)constrain(acc >> 14, (int64_t)INT16_MIN, (int64_t)INT16_MAX);
+        x2 = x1;
+        x1 = x0;
+        y2 = y1;
+        y1 = y0;
+        samples[n] = y0;
+    }
+    notchX1[c] = x1;
+    notchX2[c] = x2;
+    notchY1[c] = y1;
+    notchY2[c] = y2;
+}
+
+void IMUFilterBank::process(int16_t* const channels[IMU_FILTER_CHANNELS], size_t count) {
+    if (count == 0) return;
+    if (!primed) prime(channels);
+
+    for (size_t offset = 0; offset < count; offset += IMU_FILTER_BLOCK) {
+        size_t block = min(count - offset, (size_t)IMU_FILTER_BLOCK);
+
+        for (uint8_t c = 0; c < IMU_FILTER_CHANNELS; c++) {
+            int16_t* samples = channels[c] + offset;
+            if (notchEnabled) {
+                notch(c, samples, block);
+            }
+#if IMU_FILTER_PROFILE != IMU_FILTER_OFF
+            int16_t* w = window[c];
+            memcpy(w + HISTORY, samples, block * sizeof(int16_t));
+            firBlock(w, c < 3 ? accelTaps : gyroTaps, samples, block);
+            memmove(w, w + block, HISTORY * sizeof(int16_t));
+#endif
+        }
+    }
+}
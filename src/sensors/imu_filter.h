@@ -0,0 +1,70 @@
+#ifndef IMU_FILTER_H
+#define IMU_FILTER_H
+
+#include <Arduino.h>
+
+// Vibration rejection for the raw IMU streams, applied before fusion.
+// Each of the six channels (accel XYZ, gyro XYZ) runs a linear-phase FIR
+// low-pass, plus an optional notch for a known vibration frequency.
+//
+// Samples are filtered a FIFO batch at a time, channel by channel, over a
+// contiguous history + batch buffer: the inner loop is a folded dot
+// product over int16 data with int32 accumulation, the shape the compiler
+// vectorizes (and that esp-dsp's dsps_fird_s16 implements with the S3 SIMD
+// unit, if that library is ever added).
+//
+// Coefficients are chosen at compile time with IMU_FILTER_PROFILE
+// (Hamming-windowed sinc, 32 taps, fs = IMU_ODR_HZ, Q14):
+//   IMU_FILTER_OFF     pass-through
+//   IMU_FILTER_CAR     accel 6 Hz, gyro 15 Hz: engine and road (25 Hz+) at -35 dB or better
+//   IMU_FILTER_SMOOTH  accel 3 Hz, gyro 8 Hz: motorcycles, stiff mounts
+// Group delay is 15.5 samples (~69 ms) in both filtered profiles.
+#define IMU_FILTER_OFF      0
+#define IMU_FILTER_CAR      1
+#define IMU_FILTER_SMOOTH   2
+
+#ifndef IMU_FILTER_PROFILE
+#define IMU_FILTER_PROFILE  IMU_FILTER_CAR
+#endif
+
+// Notch center frequency in Hz (0 = disabled), applied by IMUHandler::init();
+// can also be changed at run time with setNotch()
+#ifndef IMU_FILTER_NOTCH_HZ
+#define IMU_FILTER_NOTCH_HZ 0
+#endif
+#define IMU_FILTER_NOTCH_Q      2.0f
+
+#define IMU_FILTER_TAPS         32
+#define IMU_FILTER_CHANNELS     6       // accel XYZ, gyro XYZ
+#define IMU_FILTER_BLOCK        32      // Samples per processing block
+#define IMU_FILTER_CPU_BUDGET_US 10     // Per six-axis sample, checked by the benchmark test
+
+class IMUFilterBank {
+private:
+    // Per channel: the last TAPS-1 inputs followed by the block being filtered
+    int16_t window[IMU_FILTER_CHANNELS][IMU_FILTER_TAPS - 1 + IMU_FILTER_BLOCK];
+    bool primed;
+
+    // Notch biquad (direct form I, Q14 coefficients)
+    bool notchEnabled;
+    int32_t notchB0, notchB1, notchA1, notchA2;   // b2 == b0
+    int16_t notchX1[IMU_FILTER_CHANNELS], notchX2[IMU_FILTER_CHANNELS];
+    int16_t notchY1[IMU_FILTER_CHANNELS], notchY2[IMU_FILTER_CHANNELS];
+
+    void prime(int16_t* const channels[IMU_FILTER_CHANNELS]);
+    void notch(uint8_t channel, int16_t* samples, size_t count);
+
+public:
+    IMUFilterBank();
+
+    void reset();
+
+    // Notch at hz with quality q, computed for the given sample rate; hz = 0 disables
+    void setNotch(float hz, float sampleRateHz, float q = IMU_FILTER_NOTCH_Q);
+
+    // Filters count samples in place; channels[i] points to channel i's
+    // samples (structure of arrays). Any count is accepted.
+    void process(int16_t* const channels[IMU_FILTER_CHANNELS], size_t count);
+};
+
+#endif // IMU_FILTER_H
@@ -1,22 +1,47 @@
 #include "imu_handler.h"
 #include <math.h>
 
-IMUHandler::IMUHandler() : i2c(nullptr), initialized(false), hasNewData(false),
-                           accelScale(1.0/16384.0), gyroScale(1.0/131.0), 
-                           rotationOffset(0.0), currentRotation(0.0), 
-                           lastUpdateTime(0) {
+// Little-endian 16-bit value at register reg within a burst from QMI8658_DATA_START
+static inline int16_t burstValue16(const uint8_t* raw, uint8_t reg) {
+    const uint8_t* p = raw + (reg - QMI8658_DATA_START);
+    return (int16_t)(p[0] | (p[1] << 8));
+}
+
+// Indexed by IMURate. Range bits 6:4, ODR code bits 3:0.
+static const IMURateConfig imuRates[] = {
+    {0x05, 0x55, IMU_ODR_HZ,     1.0f / 16384.0f, 1.0f / 64.0f},    // ±2 g, ±512 dps, 224.2 Hz
+    {0x08, 0x38, IMU_LOW_ODR_HZ, 1.0f / 16384.0f, 1.0f / 256.0f}    // ±2 g, ±128 dps, 28 Hz
+};
+
+IMUHandler::IMUHandler() : bus(nullptr), initialized(false), newDataAvailable(false),
+                           sampleCount(0), i2cTransactions(0),
+                           accelScale(1.0/16384.0), gyroScale(1.0/64.0), 
+                           rotationOffset(0.0), rate(IMU_RATE_HIGH), odrHz(IMU_ODR_HZ),
+                           adaptiveRate(false), lastMotionPollMs(0), requestedRate(-1),
+                           notchHz(IMU_FILTER_NOTCH_HZ),
+                           temperatureRaw(0), temperatureValid(false),
+                           lastTemperatureUs(0), currentRotation(0.0), publishedQuarter(0xFF),
+                           missedSamples(0), calibrationRestart(false), resetRequested(false), fifoEnabled(false), fifoPending(false),
+                           fifoCtrl(0), task(nullptr), taskPeriodUs(0) {
+    gyroBias[0] = gyroBias[1] = gyroBias[2] = 0.0f;
 }
 
 IMUHandler::~IMUHandler() {
+    if (task) {
+        vTaskDelete(task);
+    }
 }
 
-bool IMUHandler::init() {
+bool IMUHandler::init(I2CBus* shared) {
     Serial.println("Initializing IMU sensor...");
     
-    // Initialize I2C with pins for ESP32-S3 Touch AMOLED (Official Waveshare pinout)
-    i2c = &Wire;
-    i2c->begin(47, 48); // SDA=GPIO47, SCL=GPIO48
-    i2c->setClock(400000); // 400kHz
+    // I2C on the ESP32-S3 Touch AMOLED pins (official Waveshare pinout),
+    // SDA=GPIO47, SCL=GPIO48 at 400kHz, shared with touch and RTC
+    static I2CBus privateBus;
+    bus = shared ? shared : &privateBus;
+    if (!bus->begin()) {
+        return false;
+    }
     
     delay(10);
     
@@ -28,69 +53,96 @@ bool IMUHandler::init() {
     }
     
     // Reset the device
-    writeRegister(QMI8658_CTRL1, 0x60);
-    delay(10);
+    writeRegister(QMI8658_RESET, QMI8658_RESET_CMD);
+    delay(15);
     
-    // Configure accelerometer
-    // CTRL2: Accelerometer enable, ±2g range, 100Hz ODR
-    writeRegister(QMI8658_CTRL2, 0x05);
+    // Auto-increment addressing for burst reads, little-endian data
+    writeRegister(QMI8658_CTRL1, QMI8658_CTRL1_ADDR_AI);
     
-    // Configure gyroscope  
-    // CTRL3: Gyroscope enable, ±500dps range, 100Hz ODR
-    writeRegister(QMI8658_CTRL3, 0x55);
+    // Configure accelerometer and gyroscope at the full rate:
+    // CTRL2 ±2g, CTRL3 ±512dps, both 224Hz ODR
+    const IMURateConfig& config = imuRates[IMU_RATE_HIGH];
+    writeRegister(QMI8658_CTRL2, config.ctrl2);
+    writeRegister(QMI8658_CTRL3, config.ctrl3);
+    rate = IMU_RATE_HIGH;
+    odrHz = config.odrHz;
+    accelScale = config.accelScale;
+    gyroScale = config.gyroScale;
     
     // Enable accelerometer and gyroscope
     writeRegister(QMI8658_CTRL7, 0x03);
     
     delay(50);
     
-    // Initial calibration
-    calibrate();
+    filter.reset();
+    filter.setNotch(notchHz, odrHz);
+    
+#ifdef IMU_FIXED_POINT
+    fixedFilter.configure(gyroScale, accelScale, odrHz, FUSION_KP, FUSION_ACCEL_TOLERANCE);
+    applyGyroBias();
+#endif
     
+    adaptiveRate = configureMotionDetection();
+    
+    // No blocking calibration: the bias is learned once the device is still
     initialized = true;
-    lastUpdateTime = millis();
     
     Serial.println("IMU sensor initialized successfully");
     return true;
 }
 
 bool IMUHandler::writeRegister(uint8_t reg, uint8_t value) {
-    i2c->beginTransmission(QMI8658_I2C_ADDR);
-    i2c->write(reg);
-    i2c->write(value);
-    return (i2c->endTransmission() == 0);
+    i2cTransactions++;
+    return bus->writeRegister(QMI8658_I2C_ADDR, reg, value, I2C_PRIORITY_IMU);
 }
 
 uint8_t IMUHandler::readRegister(uint8_t reg) {
-    i2c->beginTransmission(QMI8658_I2C_ADDR);
-    i2c->write(reg);
-    i2c->endTransmission(false);
-    
-    i2c->requestFrom(QMI8658_I2C_ADDR, 1);
-    if (i2c->available()) {
-        return i2c->read();
-    }
-    return 0;
+    uint8_t value = 0;
+    readRegisters(reg, &value, 1);
+    return value;
 }
 
-int16_t IMUHandler::readRegister16(uint8_t regLow, uint8_t regHigh) {
-    uint8_t low = readRegister(regLow);
-    uint8_t high = readRegister(regHigh);
-    return (int16_t)((high << 8) | low);
+bool IMUHandler::readRegisters(uint8_t reg, uint8_t* buffer, size_t length) {
+    i2cTransactions++;
+    return bus->readRegisters(QMI8658_I2C_ADDR, reg, buffer, length, I2C_PRIORITY_IMU);
 }
 
 bool IMUHandler::readData() {
     if (!initialized) return false;
     
-    // Read accelerometer data
-    int16_t ax = readRegister16(QMI8658_AX_L, QMI8658_AX_H);
-    int16_t ay = readRegister16(QMI8658_AY_L, QMI8658_AY_H);
-    int16_t az = readRegister16(QMI8658_AZ_L, QMI8658_AZ_H);
+    // Timestamp, temperature, accelerometer and gyroscope in one burst
+    uint8_t raw[QMI8658_DATA_LEN];
+    if (!readRegisters(QMI8658_DATA_START, raw, sizeof(raw))) {
+        return false;
+    }
+    
+    int16_t ax = burstValue16(raw, QMI8658_AX_L);
+    int16_t ay = burstValue16(raw, QMI8658_AY_L);
+    int16_t az = burstValue16(raw, QMI8658_AZ_L);
+    int16_t gx = burstValue16(raw, QMI8658_GX_L);
+    int16_t gy = burstValue16(raw, QMI8658_GY_L);
+    int16_t gz = burstValue16(raw, QMI8658_GZ_L);
+    int16_t temp = burstValue16(raw, QMI8658_TEMP_L);
+    
+    // The sensor counts samples at its ODR: integrate over the counter
+    // delta rather than host time, and skip reads that found no new sample
+    const uint8_t* ts = raw + (QMI8658_TIMESTAMP_L - QMI8658_DATA_START);
+    uint32_t timestamp = ts[0] | (ts[1] << 8) | ((uint32_t)ts[2] << 16);
+    uint32_t ticks = currentData.isValid ? ((timestamp - currentData.timestamp) & 0xFFFFFF) : 0;
+    if (currentData.isValid && ticks == 0) {
+        return true;
+    }
+    if (ticks > 1) {
+        missedSamples += ticks - 1;
+    }
+    currentData.timestamp = timestamp;
+    setTemperature(temp);
     
-    // Read gyroscope data
-    int16_t gx = readRegister16(QMI8658_GX_L, QMI8658_GX_H);
-    int16_t gy = readRegister16(QMI8658_GY_L, QMI8658_GY_H);
-    int16_t gz = readRegister16(QMI8658_GZ_L, QMI8658_GZ_H);
+    // Polled samples go through the filter bank as batches of one
+    if (ticks > 0) {
+        int16_t* const channels[IMU_FILTER_CHANNELS] = {&ax, &ay, &az, &gx, &gy, &gz};
+        filter.process(channels, 1);
+    }
     
     // Convert to physical units
     currentData.accelX = ax * accelScale;
@@ -102,70 +154,578 @@ bool IMUHandler::readData() {
     currentData.gyroZ = gz * gyroScale;
     
     // Calculate rotation
-    unsigned long now = millis();
-    float deltaTime = (now - lastUpdateTime) / 1000.0;
-    if (deltaTime > 0) {
-        updateRotation(currentData.gyroZ, deltaTime);
-        lastUpdateTime = now;
+    if (ticks > 0) {
+        const int16_t accel[3] = {ax, ay, az};
+        const int16_t gyro[3] = {gx, gy, gz};
+        updateFusion(accel, gyro, ticks);
+        refreshRotation();
     }
     
     currentData.rotation = currentRotation;
     currentData.isValid = true;
-    hasNewData = true;
+    newDataAvailable = true;
+    sampleCount++;
+    publishOrientation(micros());
     
     return true;
 }
 
-void IMUHandler::updateRotation(float gyroZ, float deltaTime) {
-    // Integrate gyroscope data to get rotation angle
-    currentRotation += (gyroZ - rotationOffset) * deltaTime;
+// --- FIFO mode ---
+
+void IMUSampleRing::push(const IMUSample& sample) {
+    if (head - tail >= IMU_RING_SIZE) {
+        tail++;
+        overwritten++;
+    }
+    samples[head & (IMU_RING_SIZE - 1)] = sample;
+    head++;
+}
+
+bool IMUSampleRing::pop(IMUSample& sample) {
+    if (head == tail) return false;
+    sample = samples[tail & (IMU_RING_SIZE - 1)];
+    tail++;
+    return true;
+}
+
+void IRAM_ATTR IMUHandler::onFifoInterrupt(void* arg) {
+    IMUHandler* imu = static_cast<IMUHandler*>(arg);
+    imu->fifoPending = true;
     
-    // Keep rotation within 0-360 degrees
-    while (currentRotation < 0) currentRotation += 360.0;
-    while (currentRotation >= 360.0) currentRotation -= 360.0;
+    if (imu->task) {
+        BaseType_t woken = pdFALSE;
+        vTaskNotifyGiveFromISR(imu->task, &woken);
+        portYIELD_FROM_ISR(woken);
+    }
+}
+
+bool IMUHandler::sendCommand(uint8_t command) {
+    writeRegister(QMI8658_CTRL9, command);
     
-    // Optional: Use accelerometer for drift correction
-    float tiltAngle = calculateTiltAngle(currentData.accelX, currentData.accelY, currentData.accelZ);
-    if (abs(tiltAngle) < 30.0) { // Only correct if device is relatively upright
-        // Simple complementary filter for drift correction
-        currentRotation = 0.98 * currentRotation + 0.02 * tiltAngle;
+    // The sensor raises CmdDone, the host acknowledges, CmdDone clears
+    for (int i = 0; i < 50; i++) {
+        if (readRegister(QMI8658_STATUSINT) & QMI8658_STATUSINT_CMD_DONE) {
+            writeRegister(QMI8658_CTRL9, QMI8658_CMD_ACK);
+            return true;
+        }
+        delayMicroseconds(100);
     }
+    Serial.printf("IMU CTRL9 command 0x%02X timed out\n", command);
+    return false;
 }
 
-float IMUHandler::calculateTiltAngle(float accelX, float accelY, float accelZ) {
-    // Calculate tilt angle from accelerometer data
-    return atan2(accelY, accelX) * 180.0 / PI;
+bool IMUHandler::enableFifo(uint8_t watermark) {
+    if (!initialized) return false;
+    
+    uint8_t ctrl1 = QMI8658_CTRL1_ADDR_AI;
+    if (IMU_INT_PIN >= 0) {
+        ctrl1 |= QMI8658_CTRL1_INT1_EN | QMI8658_CTRL1_FIFO_INT1;
+    }
+    writeRegister(QMI8658_CTRL1, ctrl1);
+    
+    // Stream mode keeps the newest samples if a drain is ever late
+    fifoCtrl = QMI8658_FIFO_SIZE_128 | QMI8658_FIFO_MODE_STREAM;
+    writeRegister(QMI8658_FIFO_WTM_TH, watermark);
+    writeRegister(QMI8658_FIFO_CTRL, fifoCtrl);
+    if (!sendCommand(QMI8658_CMD_RST_FIFO)) {
+        return false;
+    }
+    
+    if (IMU_INT_PIN >= 0) {
+        pinMode(IMU_INT_PIN, INPUT);
+        attachInterruptArg(digitalPinToInterrupt(IMU_INT_PIN), onFifoInterrupt, this, RISING);
+    }
+    
+    fifoEnabled = true;
+    fifoPending = false;
+    Serial.printf("IMU FIFO enabled: watermark %u samples\n", watermark);
+    return true;
 }
 
-IMUData IMUHandler::getData() {
-    hasNewData = false;
-    return currentData;
+uint16_t IMUHandler::drainFifo() {
+    uint8_t status[2];
+    
+    if (IMU_INT_PIN < 0) {
+        // No interrupt line: one status read per call decides
+        if (!readRegisters(QMI8658_FIFO_SMPL_CNT, status, sizeof(status)) ||
+            !(status[1] & (QMI8658_FIFO_WTM | QMI8658_FIFO_FULL))) {
+            return 0;
+        }
+    } else if (!fifoPending) {
+        return 0;
+    }
+    fifoPending = false;
+    
+    if (!sendCommand(QMI8658_CMD_REQ_FIFO) ||
+        !readRegisters(QMI8658_FIFO_SMPL_CNT, status, sizeof(status))) {
+        return 0;
+    }
+    if (status[1] & QMI8658_FIFO_OVERFLOW) {
+        fifoStats.overflows++;
+    }
+    
+    uint16_t bytes = 2 * (((status[1] & 0x03) << 8) | status[0]);
+    uint16_t count = bytes / IMU_FIFO_SAMPLE_BYTES;
+    
+    // Samples are evenly spaced at the ODR and the last one is the newest
+    uint32_t nowUs = micros();
+    uint32_t periodUs = 1000000.0f / odrHz;
+    
+    uint8_t chunk[IMU_FIFO_CHUNK];
+    uint16_t index = 0;
+    while (index < count) {
+        uint16_t samplesInChunk = min(count - index, IMU_FIFO_CHUNK / IMU_FIFO_SAMPLE_BYTES);
+        if (!readRegisters(QMI8658_FIFO_DATA, chunk, samplesInChunk * IMU_FIFO_SAMPLE_BYTES)) {
+            break;
+        }
+        
+        for (uint16_t i = 0; i < samplesInChunk; i++, index++) {
+            const uint8_t* p = chunk + i * IMU_FIFO_SAMPLE_BYTES;
+            IMUSample sample;
+            sample.timeUs = nowUs - (count - 1 - index) * periodUs;
+            for (int axis = 0; axis < 3; axis++) {
+                sample.accel[axis] = (int16_t)(p[axis * 2] | (p[axis * 2 + 1] << 8));
+                sample.gyro[axis] = (int16_t)(p[6 + axis * 2] | (p[7 + axis * 2] << 8));
+            }
+            ring.push(sample);
+        }
+    }
+    
+    // Leave FIFO read mode
+    writeRegister(QMI8658_FIFO_CTRL, fifoCtrl);
+    
+    // The FIFO carries no temperature; it changes slowly enough to poll
+    if (!temperatureValid || nowUs - lastTemperatureUs >= IMU_TEMP_PERIOD_US) {
+        lastTemperatureUs = nowUs;
+        readTemperature();
+    }
+    
+    fifoStats.batches++;
+    fifoStats.samples += index;
+    fifoStats.lastBatch = index;
+    if (index > fifoStats.maxBatch) fifoStats.maxBatch = index;
+    return index;
 }
 
-float IMUHandler::getRotation() {
-    hasNewData = false;
-    return currentRotation;
+bool IMUHandler::readTemperature() {
+    uint8_t raw[2];
+    if (!readRegisters(QMI8658_TEMP_L, raw, sizeof(raw))) {
+        return false;
+    }
+    setTemperature((int16_t)(raw[0] | (raw[1] << 8)));
+    return true;
 }
 
-void IMUHandler::resetRotation() {
-    currentRotation = 0.0;
+void IMUHandler::processSamples() {
+    // Pop up to a filter block of samples into one array per channel, filter
+    // the block in place, then fuse the filtered samples one by one
+    int16_t block[IMU_FILTER_CHANNELS][IMU_FILTER_BLOCK];
+    int16_t* const channels[IMU_FILTER_CHANNELS] = {
+        block[0], block[1], block[2], block[3], block[4], block[5]
+    };
+    IMUSample sample;
+    bool any = false;
+    uint32_t lastTimeUs = 0;
+    
+    for (;;) {
+        size_t count = 0;
+        while (count < IMU_FILTER_BLOCK && ring.pop(sample)) {
+            for (int axis = 0; axis < 3; axis++) {
+                block[axis][count] = sample.accel[axis];
+                block[3 + axis][count] = sample.gyro[axis];
+            }
+            lastTimeUs = sample.timeUs;
+            count++;
+        }
+        if (count == 0) break;
+        
+        filter.process(channels, count);
+        
+        for (size_t i = 0; i < count; i++) {
+            const int16_t accel[3] = {block[0][i], block[1][i], block[2][i]};
+            const int16_t gyro[3] = {block[3][i], block[4][i], block[5][i]};
+            currentData.accelX = accel[0] * accelScale;
+            currentData.accelY = accel[1] * accelScale;
+            currentData.accelZ = accel[2] * accelScale;
+            currentData.gyroX = gyro[0] * gyroScale;
+            currentData.gyroY = gyro[1] * gyroScale;
+            currentData.gyroZ = gyro[2] * gyroScale;
+            
+            // Integrate with the sensor's own sample spacing, not loop timing
+            updateFusion(accel, gyro, 1);
+            sampleCount++;
+        }
+        any = true;
+    }
+    
+    if (any) {
+        refreshRotation();
+        currentData.rotation = currentRotation;
+        currentData.isValid = true;
+        newDataAvailable = true;
+        publishOrientation(lastTimeUs);
+    }
 }
 
-void IMUHandler::calibrate() {
+void IMUHandler::update() {
     if (!initialized) return;
     
-    Serial.println("Calibrating IMU... keep device still");
+    if (resetRequested.exchange(false)) {
+        applyRotationReset();
+    }
+    
+    if (!fifoEnabled) {
+        readData();
+    } else if (drainFifo() > 0) {
+        processSamples();
+    }
+    
+    int8_t requested = requestedRate.exchange(-1);
+    if (requested >= 0) {
+        adaptiveRate = false;
+        if (requested != rate) setRate((IMURate)requested);
+    } else if (adaptiveRate) {
+        updateMotion();
+    }
+}
+
+// --- Adaptive data rate ---
+
+bool IMUHandler::configureMotionDetection() {
+    // CONFIGURE_MOTION takes two passes of CAL1_L..CAL4_H, numbered in
+    // CAL4_H: thresholds and axis logic, then windows (significant motion
+    // is not used)
+    const uint8_t passes[2][QMI8658_CAL4_H - QMI8658_CAL1_L + 1] = {
+        {IMU_ANY_MOTION_THR, IMU_ANY_MOTION_THR, IMU_ANY_MOTION_THR,
+         IMU_NO_MOTION_THR, IMU_NO_MOTION_THR, IMU_NO_MOTION_THR,
+         QMI8658_MOTION_MODE_XYZ, 0x01},
+        {IMU_ANY_MOTION_WINDOW, IMU_NO_MOTION_WINDOW, 0, 0, 0, 0, 0, 0x02}
+    };
+    
+    for (const auto& args : passes) {
+        for (uint8_t i = 0; i < sizeof(args); i++) {
+            writeRegister(QMI8658_CAL1_L + i, args[i]);
+        }
+        if (!sendCommand(QMI8658_CMD_CONFIGURE_MOTION)) {
+            Serial.println("IMU motion detection unavailable: fixed ODR");
+            return false;
+        }
+    }
+    
+    writeRegister(QMI8658_CTRL8, QMI8658_CTRL8_ANY_MOTION | QMI8658_CTRL8_NO_MOTION);
+    return true;
+}
+
+bool IMUMotionTracker::update(uint8_t status1, uint32_t nowMs) {
+    if (status1 & QMI8658_STATUS1_ANY_MOTION) {
+        restPending = false;
+        if (state == IMU_MOTION_STILL) {
+            state = IMU_MOTION_ACTIVE;
+            transitions++;
+            return true;
+        }
+        return false;
+    }
+    
+    if (state == IMU_MOTION_ACTIVE) {
+        if ((status1 & QMI8658_STATUS1_NO_MOTION) && !restPending) {
+            restPending = true;
+            restSinceMs = nowMs;
+        }
+        if (restPending && nowMs - restSinceMs >= IMU_STILL_HOLD_MS) {
+            restPending = false;
+            state = IMU_MOTION_STILL;
+            transitions++;
+            return true;
+        }
+    }
+    return false;
+}
+
+void IMUHandler::updateMotion() {
+    uint32_t now = millis();
+    if (now - lastMotionPollMs < IMU_MOTION_POLL_MS) return;
+    lastMotionPollMs = now;
+    
+    uint8_t status1;
+    if (!readRegisters(QMI8658_STATUS1, &status1, 1)) return;
+    if (motion.update(status1, now)) {
+        setRate(motion.getState() == IMU_MOTION_STILL ? IMU_RATE_LOW : IMU_RATE_HIGH);
+    }
+}
+
+bool IMUHandler::setRate(IMURate next) {
+    const IMURateConfig& config = imuRates[next];
+    if (!writeRegister(QMI8658_CTRL2, config.ctrl2) || !writeRegister(QMI8658_CTRL3, config.ctrl3)) {
+        return false;
+    }
+    
+    rate = next;
+    odrHz = config.odrHz;
+    accelScale = config.accelScale;
+    gyroScale = config.gyroScale;
+    
+    // Queued samples were taken at the old rate and range
+    if (fifoEnabled) {
+        sendCommand(QMI8658_CMD_RST_FIFO);
+    }
+    
+    // Filter coefficients are relative to the sample rate; start clean
+    filter.reset();
+    filter.setNotch(notchHz, odrHz);
+#ifdef IMU_FIXED_POINT
+    fixedFilter.configure(gyroScale, accelScale, odrHz, FUSION_KP, FUSION_ACCEL_TOLERANCE);
+    applyGyroBias();
+#endif
     
-    float gyroZSum = 0;
-    int samples = 100;
+    if (task) {
+        computeTaskPeriod();
+    }
+    Serial.printf("IMU rate: %.1f Hz (%s)\n", odrHz, next == IMU_RATE_LOW ? "still" : "moving");
+    return true;
+}
+
+// --- Sampling task ---
+
+void IMURateMeter::begin(uint32_t nominalPeriodUs, uint32_t nowUs) {
+    *this = IMURateMeter();
+    periodUs = nominalPeriodUs;
+    windowStartUs = nowUs;
+    lastWakeUs = nowUs;
+}
+
+bool IMURateMeter::record(uint32_t wakeUs, uint32_t busyUs, uint32_t newSamples, IMURateStats& stats,
+                          uint32_t busTransactions) {
+    uint32_t interval = wakeUs - lastWakeUs;
+    uint32_t deviation = interval > periodUs ? interval - periodUs : periodUs - interval;
+    lastWakeUs = wakeUs;
+    
+    wakeups++;
+    samples += newSamples;
+    if (deviation > jitterMaxUs) jitterMaxUs = deviation;
+    jitterSumSq += (float)deviation * deviation;
+    if (busyUs > periodUs) overruns++;
+    this->busyUs += busyUs;
+    transactions += busTransactions;
+    
+    uint32_t elapsed = wakeUs - windowStartUs;
+    if (elapsed < IMU_STATS_WINDOW_US) return false;
+    
+    stats.sampleRateHz = samples * 1000000.0f / elapsed;
+    stats.periodUs = periodUs;
+    stats.wakeups = wakeups;
+    stats.jitterMaxUs = jitterMaxUs;
+    stats.jitterRmsUs = sqrtf(jitterSumSq / wakeups);
+    stats.overruns = overruns;
+    stats.cpuLoad = (float)this->busyUs / elapsed;
+    stats.busRate = transactions * 1000000.0f / elapsed;
+    
+    begin(periodUs, wakeUs);
+    return true;
+}
+
+void IMUHandler::publishOrientation(uint32_t timeUs) {
+    IMUOrientation next;
+    next.rotation = currentRotation;
+    next.temperature = currentData.temperature;
+    next.timeUs = timeUs;
+    next.sampleCount = sampleCount;
+#ifdef IMU_FIXED_POINT
+    const int32_t* g = fixedFilter.getGravity();
+    next.attitude = SensorFusion::fromGravity(g[0], g[1], g[2]);
+#else
+    next.attitude = fusion.getQuaternion();
+#endif
+    next.euler = SensorFusion::toEuler(next.attitude);
+    orientation.publish(next);
+    
+    // Same snapping as UIManager::setRotation
+    uint8_t quarter = (uint8_t)((int)((currentRotation + 45) / 90) % 4);
+    if (quarter != publishedQuarter) {
+        publishedQuarter = quarter;
+        OrientationEvent event = {currentRotation, quarter, timeUs};
+        EventBus<OrientationEvent>::publish(event);
+    }
+}
+
+void IMUHandler::computeTaskPeriod() {
+    // Poll once per sample, or twice per watermark batch so a batch never
+    // waits more than half a batch period
+    float periodUs = 1000000.0f / odrHz;
+    if (fifoEnabled) {
+        periodUs *= IMU_FIFO_WATERMARK / 2;
+    }
+    TickType_t ticks = pdMS_TO_TICKS((uint32_t)(periodUs / 1000));
+    if (ticks == 0) ticks = 1;
+    taskPeriodUs = ticks * portTICK_PERIOD_MS * 1000;
+}
+
+bool IMUHandler::startTask(uint8_t core, uint8_t priority) {
+    if (!initialized || task) return false;
+    
+    computeTaskPeriod();
+    BaseType_t result = xTaskCreatePinnedToCore(taskEntry, "imu", IMU_TASK_STACK, this,
+                                                priority, &task, core);
+    if (result != pdPASS) {
+        task = nullptr;
+        return false;
+    }
+    Serial.printf("IMU task started on core %u: %u us period\n", core, taskPeriodUs);
+    return true;
+}
+
+void IMUHandler::taskEntry(void* param) {
+    static_cast<IMUHandler*>(param)->runTask();
+}
+
+void IMUHandler::runTask() {
+    TickType_t lastWake = xTaskGetTickCount();
+    bool interruptDriven = fifoEnabled && IMU_INT_PIN >= 0;
+    IMURate windowRate = rate;
+    rateMeter.begin(interruptDriven ? IMU_FIFO_WATERMARK * 1000000.0f / odrHz : taskPeriodUs,
+                    micros());
     
-    for (int i = 0; i < samples; i++) {
-        int16_t gz = readRegister16(QMI8658_GZ_L, QMI8658_GZ_H);
-        gyroZSum += gz * gyroScale;
-        delay(10);
+    for (;;) {
+        // The period follows the data rate
+        TickType_t period = pdMS_TO_TICKS(taskPeriodUs / 1000);
+        if (interruptDriven) {
+            // The timeout only covers a missed edge
+            ulTaskNotifyTake(pdTRUE, 4 * period);
+        } else {
+            vTaskDelayUntil(&lastWake, period);
+        }
+        
+        uint32_t wakeUs = micros();
+        uint32_t before = sampleCount;
+        uint32_t transactionsBefore = i2cTransactions;
+        update();
+        taskLoad.add(micros() - wakeUs);
+        
+        // A rate switch starts a new statistics window at the new period
+        if (rate != windowRate) {
+            windowRate = rate;
+            rateMeter.begin(interruptDriven ? IMU_FIFO_WATERMARK * 1000000.0f / odrHz : taskPeriodUs,
+                            micros());
+            continue;
+        }
+        
+        IMURateStats stats;
+        if (rateMeter.record(wakeUs, micros() - wakeUs, sampleCount - before, stats,
+                             i2cTransactions - transactionsBefore)) {
+            stats.missedSamples = missedSamples;
+            stats.rate = rate;
+            rateStats.publish(stats);
+        }
+    }
+}
+
+void IMUHandler::updateFusion(const int16_t accel[3], const int16_t gyro[3], uint32_t ticks) {
+    if (calibrationRestart.exchange(false)) {
+        calibrator.restart();
+        tempModel.reset();
+#ifndef IMU_FIXED_POINT
+        fusion.setGyroBias(0, 0, 0);
+#endif
+        refreshGyroBias();
+        calibration.publish(calibrator.snapshot());
+        tempCoeffs.publish(tempModel.getCoeffs());
     }
     
-    rotationOffset = gyroZSum / samples;
+    if (calibrator.feed(currentData.gyroX, currentData.gyroY, currentData.gyroZ,
+                        currentData.accelX, currentData.accelY, currentData.accelZ)) {
+        const float* mean = calibrator.getLastMean();
+        if (temperatureValid && tempModel.addObservation(currentData.temperature, mean)) {
+            tempCoeffs.publish(tempModel.getCoeffs());
+        }
+        refreshGyroBias();
+#ifndef IMU_FIXED_POINT
+        // The still window measured the whole bias: hand the fusion only
+        // what the applied estimate does not cover yet
+        fusion.setGyroBias(mean[0] - gyroBias[0], mean[1] - gyroBias[1], mean[2] - gyroBias[2]);
+#endif
+        calibration.publish(calibrator.snapshot());
+    }
     
-    Serial.printf("IMU calibration complete. Gyro Z offset: %.3f\n", rotationOffset);
-}
\ No newline at end of file
+#ifdef IMU_FIXED_POINT
+    fixedFilter.update(accel, gyro, ticks);
+#else
+    fusion.update(currentData.gyroX - gyroBias[0], currentData.gyroY - gyroBias[1],
+                  currentData.gyroZ - gyroBias[2] - rotationOffset,
+                  currentData.accelX, currentData.accelY, currentData.accelZ,
+                  ticks / odrHz);
+#endif
+}
+
+void IMUHandler::setTemperature(int16_t raw) {
+    if (temperatureValid && raw == temperatureRaw) return;
+    temperatureRaw = raw;
+    temperatureValid = true;
+    currentData.temperature = raw / 256.0;
+    refreshGyroBias();
+}
+
+void IMUHandler::refreshGyroBias() {
+    if (temperatureValid && tempModel.isFitted()) {
+        tempModel.lookup(currentData.temperature, gyroBias);
+    } else {
+        memcpy(gyroBias, calibrator.getBias(), sizeof(gyroBias));
+    }
+    applyGyroBias();
+}
+
+void IMUHandler::applyGyroBias() {
+#ifdef IMU_FIXED_POINT
+    // The integer path subtracts the bias in raw LSB
+    fixedFilter.setGyroBias(lroundf(gyroBias[0] / gyroScale), lroundf(gyroBias[1] / gyroScale),
+                            lroundf((gyroBias[2] + rotationOffset) / gyroScale));
+#endif
+}
+
+void IMUHandler::refreshRotation() {
+#ifdef IMU_FIXED_POINT
+    currentRotation = fixedFilter.getRotationDegrees();
+#else
+    currentRotation = fusion.getScreenRotation();
+#endif
+}
+
+IMUData IMUHandler::getData() {
+    newDataAvailable = false;
+    return currentData;
+}
+
+float IMUHandler::getRotation() {
+    newDataAvailable = false;
+    return currentRotation;
+}
+
+void IMUHandler::applyRotationReset() {
+#ifdef IMU_FIXED_POINT
+    fixedFilter.reset();
+    applyGyroBias();
+#else
+    fusion.reset();
+#endif
+    currentRotation = 0.0;
+}
+
+void IMUHandler::calibrate() {
+    calibrationRestart = true;
+    Serial.println("IMU calibration restarted: keep the device still for a moment");
+}
+
+void IMUHandler::seedGyroBias(float x, float y, float z) {
+    calibrator.seed(x, y, z);
+    refreshGyroBias();
+    calibration.publish(calibrator.snapshot());
+    Serial.printf("IMU gyro bias restored: %.3f %.3f %.3f dps\n", x, y, z);
+}
+
+void IMUHandler::seedTempModel(const GyroTempCoeffs& saved) {
+    tempModel.seed(saved);
+    refreshGyroBias();
+    tempCoeffs.publish(tempModel.getCoeffs());
+    if (tempModel.isFitted()) {
+        Serial.printf("IMU gyro temperature model restored: %d to %d °C\n", saved.minC, saved.maxC);
+    }
+}
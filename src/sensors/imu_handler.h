@@ -2,7 +2,17 @@
 #define IMU_HANDLER_H
 
 #include <Arduino.h>
-#include <Wire.h>
+#include "../core/latest_value.h"
+#include "../core/event_bus.h"
+#include "../core/events.h"
+#include "../core/task_monitor.h"
+#include "../bus/i2c_bus.h"
+#include "sensor_fusion.h"
+#include "fixed_point.h"
+#include "gyro_calibrator.h"
+#include "gyro_temp_model.h"
+#include "imu_filter.h"
+#include <atomic>
 
 // QMI8658 IMU sensor I2C address and registers
 #define QMI8658_I2C_ADDR    0x6B
@@ -15,9 +25,53 @@
 #define QMI8658_CTRL5       0x06
 #define QMI8658_CTRL6       0x07
 #define QMI8658_CTRL7       0x08
+#define QMI8658_CTRL8       0x09
+#define QMI8658_CTRL9       0x0A
+#define QMI8658_CAL1_L      0x0B    // CAL1_L..CAL4_H: CTRL9 command arguments
+#define QMI8658_CAL4_H      0x12
+#define QMI8658_FIFO_WTM_TH 0x13
+#define QMI8658_FIFO_CTRL   0x14
+#define QMI8658_FIFO_SMPL_CNT 0x15
+#define QMI8658_FIFO_STATUS 0x16
+#define QMI8658_FIFO_DATA   0x17
 #define QMI8658_STATUSINT   0x2D
 #define QMI8658_STATUS0     0x2E
 #define QMI8658_STATUS1     0x2F
+#define QMI8658_RESET       0x60
+
+// CTRL1 bits
+#define QMI8658_CTRL1_ADDR_AI   0x40    // Register address auto-increment
+#define QMI8658_CTRL1_BE        0x20    // Big-endian data (left clear: little-endian)
+#define QMI8658_CTRL1_INT1_EN   0x08    // INT1 pin output enable
+#define QMI8658_CTRL1_FIFO_INT1 0x04    // FIFO interrupt on INT1 (clear: INT2)
+#define QMI8658_RESET_CMD       0xB0
+
+// CTRL9 host commands; completion is flagged in STATUSINT bit 7
+#define QMI8658_CMD_ACK         0x00
+#define QMI8658_CMD_RST_FIFO    0x04
+#define QMI8658_CMD_REQ_FIFO    0x05
+#define QMI8658_CMD_CONFIGURE_MOTION 0x0E
+#define QMI8658_STATUSINT_CMD_DONE 0x80
+
+// FIFO_CTRL / FIFO_STATUS bits
+#define QMI8658_FIFO_RD_MODE    0x80
+#define QMI8658_FIFO_SIZE_128   0x0C
+#define QMI8658_FIFO_MODE_STREAM 0x02
+#define QMI8658_FIFO_FULL       0x80
+#define QMI8658_FIFO_WTM        0x40
+#define QMI8658_FIFO_OVERFLOW   0x20
+
+// Motion engine: CTRL8 enables, STATUS1 reports (cleared on read)
+#define QMI8658_CTRL8_ANY_MOTION    0x02
+#define QMI8658_CTRL8_NO_MOTION     0x04
+#define QMI8658_STATUS1_ANY_MOTION  0x20
+#define QMI8658_STATUS1_NO_MOTION   0x40
+#define QMI8658_MOTION_MODE_XYZ     0xF7    // No-motion: all axes (AND); any-motion: any axis (OR)
+
+// Sample timestamp (24-bit counter) and temperature registers
+#define QMI8658_TIMESTAMP_L 0x30
+#define QMI8658_TEMP_L      0x33
+#define QMI8658_TEMP_H      0x34
 
 // Accelerometer data registers
 #define QMI8658_AX_L        0x35
@@ -35,61 +89,353 @@
 #define QMI8658_GZ_L        0x3F
 #define QMI8658_GZ_H        0x40
 
+// Timestamp, temperature, accel and gyro are contiguous: one burst reads all
+#define QMI8658_DATA_START  QMI8658_TIMESTAMP_L
+#define QMI8658_DATA_LEN    (QMI8658_GZ_H - QMI8658_TIMESTAMP_L + 1)
+
+// FIFO batching. INT1 is not listed in the Waveshare pinout, so the
+// watermark interrupt is opt-in: build with -DIMU_INT_PIN=<gpio> on boards
+// that route it. Without it the FIFO status is polled, still one batch at a time.
+#ifndef IMU_INT_PIN
+#define IMU_INT_PIN         -1
+#endif
+#define IMU_ODR_HZ          224.2f  // CTRL2/CTRL3 ODR code 5 in 6-axis mode
+#define IMU_FIFO_WATERMARK  16      // Samples per batch (~71 ms at IMU_ODR_HZ)
+#define IMU_FIFO_SAMPLE_BYTES 12    // Accel + gyro, 3 x int16 each
+#define IMU_FIFO_CHUNK      120     // Bytes per burst: bounds how long touch and RTC wait behind a drain
+#define IMU_RING_SIZE       256     // Samples (power of 2)
+#define IMU_TEMP_PERIOD_US  1000000 // Temperature read interval in FIFO mode (not in the FIFO)
+
+// Adaptive output data rate. The sensor's any-motion / no-motion engine
+// watches the accelerometer; once the mount has been at rest for
+// IMU_STILL_HOLD_MS the IMU drops to IMU_LOW_ODR_HZ (with a finer gyro
+// range for the bias estimate), and the first any-motion event restores
+// the full rate. STATUS1 is polled every IMU_MOTION_POLL_MS.
+#define IMU_LOW_ODR_HZ      28.025f // ODR code 8
+#define IMU_STILL_HOLD_MS   2000
+#define IMU_MOTION_POLL_MS  100
+#define IMU_ANY_MOTION_THR  3       // 1/32 g per axis (~94 mg)
+#define IMU_NO_MOTION_THR   2       // 1/32 g per axis (~62 mg)
+#define IMU_ANY_MOTION_WINDOW 4     // Samples over the threshold to flag motion
+#define IMU_NO_MOTION_WINDOW  255   // Samples under the threshold to flag rest
+
+enum IMURate {
+    IMU_RATE_HIGH,           // IMU_ODR_HZ, ±2 g, ±512 dps
+    IMU_RATE_LOW             // IMU_LOW_ODR_HZ, ±2 g, ±128 dps
+};
+
+// Range and ODR share CTRL2/CTRL3, so they switch together with the
+// matching conversion factors
+struct IMURateConfig {
+    uint8_t ctrl2;           // Accel range | ODR code
+    uint8_t ctrl3;           // Gyro range | ODR code
+    float odrHz;
+    float accelScale;        // g per LSB
+    float gyroScale;         // deg/s per LSB
+};
+
+enum IMUMotionState {
+    IMU_MOTION_ACTIVE,
+    IMU_MOTION_STILL
+};
+
+// Debounces the sensor's motion events into a rate decision: rest must
+// last IMU_STILL_HOLD_MS, motion wins at once
+class IMUMotionTracker {
+private:
+    IMUMotionState state;
+    bool restPending;
+    uint32_t restSinceMs;
+    uint32_t transitions;
+    
+public:
+    IMUMotionTracker() : state(IMU_MOTION_ACTIVE), restPending(false), restSinceMs(0), transitions(0) {}
+    
+    // One STATUS1 read; returns true when the state changed
+    bool update(uint8_t status1, uint32_t nowMs);
+    IMUMotionState getState() const { return state; }
+    uint32_t getTransitions() const { return transitions; }
+};
+
+// Sampling task. The render task runs on core 1, so the IMU
+// gets core 0 next to the NimBLE host, above the BLE ingest task.
+#define IMU_TASK_CORE       0
+#define IMU_TASK_PRIORITY   5
+#define IMU_TASK_STACK      4096
+#define IMU_STATS_WINDOW_US 1000000     // Rate/jitter statistics window
+
+// One raw FIFO sample with its estimated capture time
+struct IMUSample {
+    uint32_t timeUs;
+    int16_t accel[3];
+    int16_t gyro[3];
+};
+
+// Single producer / single consumer ring of raw samples
+class IMUSampleRing {
+private:
+    IMUSample samples[IMU_RING_SIZE];
+    uint32_t head;
+    uint32_t tail;
+    uint32_t overwritten;
+    
+public:
+    IMUSampleRing() : head(0), tail(0), overwritten(0) {}
+    
+    void push(const IMUSample& sample);
+    bool pop(IMUSample& sample);
+    uint32_t size() const { return head - tail; }
+    uint32_t getOverwritten() const { return overwritten; }
+};
+
+struct IMUFifoStats {
+    uint32_t batches;
+    uint32_t samples;
+    uint32_t overflows;      // FIFO filled before it was drained
+    uint32_t lastBatch;      // Samples in the most recent batch
+    uint32_t maxBatch;
+    
+    IMUFifoStats() : batches(0), samples(0), overflows(0), lastBatch(0), maxBatch(0) {}
+};
+
+// Sampling task timing over the last statistics window
+struct IMURateStats {
+    float sampleRateHz;      // Samples fused per second
+    uint32_t periodUs;       // Nominal wake-up period
+    uint32_t wakeups;
+    uint32_t jitterMaxUs;    // Worst deviation of a wake-up interval from the period
+    float jitterRmsUs;
+    uint32_t overruns;       // Iterations that took longer than the period
+    uint32_t missedSamples;  // Gaps in the sensor timestamp (total)
+    uint8_t rate;            // IMURate during the window
+    float cpuLoad;           // Fraction of the window spent in update()
+    float busRate;           // I2C transactions per second
+};
+
+// Accumulates wake-up intervals and sample counts into IMURateStats
+class IMURateMeter {
+private:
+    uint32_t periodUs;
+    uint32_t windowStartUs;
+    uint32_t lastWakeUs;
+    uint32_t wakeups;
+    uint32_t samples;
+    uint32_t jitterMaxUs;
+    float jitterSumSq;
+    uint32_t overruns;
+    uint32_t busyUs;
+    uint32_t transactions;
+    
+public:
+    IMURateMeter() : periodUs(0), windowStartUs(0), lastWakeUs(0), wakeups(0),
+                     samples(0), jitterMaxUs(0), jitterSumSq(0), overruns(0),
+                     busyUs(0), transactions(0) {}
+    
+    void begin(uint32_t nominalPeriodUs, uint32_t nowUs);
+    
+    // One call per task iteration. Returns true when a window completed
+    // and stats was filled (missedSamples and rate are left to the caller).
+    bool record(uint32_t wakeUs, uint32_t busyUs, uint32_t newSamples, IMURateStats& stats,
+                uint32_t busTransactions = 0);
+};
+
+// Orientation published by the sampling task
+struct IMUOrientation {
+    float rotation;          // Display rotation, degrees 0-360 (SensorFusion::getScreenRotation)
+    float temperature;       // °C, die temperature
+    uint32_t timeUs;         // micros() when the newest fused sample was captured
+    uint32_t sampleCount;    // Samples fused so far
+    Quaternion attitude;
+    EulerAngles euler;
+};
+
 struct IMUData {
     float accelX, accelY, accelZ;
     float gyroX, gyroY, gyroZ;
     float rotation;  // Calculated rotation angle
+    float temperature;   // °C
+    uint32_t timestamp;  // Sensor sample counter (24-bit)
     bool isValid;
     
     IMUData() : accelX(0), accelY(0), accelZ(0), 
                 gyroX(0), gyroY(0), gyroZ(0), 
-                rotation(0), isValid(false) {}
+                rotation(0), temperature(0), timestamp(0), isValid(false) {}
 };
 
 class IMUHandler {
 private:
-    TwoWire* i2c;
+    I2CBus* bus;
     IMUData currentData;
     bool initialized;
-    bool hasNewData;
+    bool newDataAvailable;
+    uint32_t sampleCount;
+    uint32_t i2cTransactions;
     
     // Calibration values
     float accelScale;
     float gyroScale;
     float rotationOffset;
     
-    // Internal state for rotation calculation
+    // Output data rate, switched by motion state
+    IMURate rate;
+    float odrHz;
+    bool adaptiveRate;
+    IMUMotionTracker motion;
+    uint32_t lastMotionPollMs;
+    std::atomic<int8_t> requestedRate;   // Set by requestRate(), applied by the sampling task (-1: none)
+    
+    // Vibration rejection on the raw samples ahead of calibration and fusion
+    IMUFilterBank filter;
+    float notchHz;
+    
+    // Attitude estimation. -DIMU_FIXED_POINT swaps the float quaternion
+    // filter for the integer gravity tracker (see fixed_point.h).
+#ifdef IMU_FIXED_POINT
+    FixedGravityFilter fixedFilter;
+#else
+    SensorFusion fusion;
+#endif
+    GyroCalibrator calibrator;
+    GyroTempModel tempModel;
+    float gyroBias[3];           // Applied bias, deg/s: tempModel at the current temperature once fitted, else the calibrator's
+    int16_t temperatureRaw;      // 1/256 °C
+    bool temperatureValid;
+    uint32_t lastTemperatureUs;
     float currentRotation;
-    unsigned long lastUpdateTime;
+    uint8_t publishedQuarter;    // Last OrientationEvent quarter turn, 0xFF before the first
+    uint32_t missedSamples;      // Sensor timestamp gaps between polled reads
+    std::atomic<bool> calibrationRestart;   // Set by calibrate(), handled by the sampling task
+    std::atomic<bool> resetRequested;       // Set by resetRotation(), handled by the sampling task
+    LatestValue<GyroCalibration> calibration;
+    LatestValue<GyroTempCoeffs> tempCoeffs;
+    
+    // FIFO mode
+    bool fifoEnabled;
+    volatile bool fifoPending;   // Set by the watermark interrupt
+    uint8_t fifoCtrl;
+    IMUSampleRing ring;
+    IMUFifoStats fifoStats;
+    
+    static void IRAM_ATTR onFifoInterrupt(void* arg);
+    bool sendCommand(uint8_t command);
+    uint16_t drainFifo();
+    bool readTemperature();
+    
+    bool configureMotionDetection();
+    void updateMotion();
+    bool setRate(IMURate next);
+    void computeTaskPeriod();
+    void processSamples();
+    
+    // Sampling task
+    TaskHandle_t task;
+    uint32_t taskPeriodUs;
+    IMURateMeter rateMeter;
+    TaskLoad taskLoad;
+    LatestValue<IMUOrientation> orientation;
+    LatestValue<IMURateStats> rateStats;
+    
+    static void taskEntry(void* param);
+    void runTask();
+    // Newest orientation for readers, plus an OrientationEvent when the
+    // display quarter turn changed
+    void publishOrientation(uint32_t timeUs);
     
     // I2C communication
     bool writeRegister(uint8_t reg, uint8_t value);
     uint8_t readRegister(uint8_t reg);
-    int16_t readRegister16(uint8_t regLow, uint8_t regHigh);
+    // Auto-increment burst: one register write plus one read of length bytes
+    bool readRegisters(uint8_t reg, uint8_t* buffer, size_t length);
     
-    // Data processing
-    void updateRotation(float gyroZ, float deltaTime);
-    float calculateTiltAngle(float accelX, float accelY, float accelZ);
+    // Feeds one sample (raw, and scaled in currentData) to the calibrator
+    // and the attitude filter; ticks is the number of ODR periods it covers
+    void updateFusion(const int16_t accel[3], const int16_t gyro[3], uint32_t ticks);
+    void setTemperature(int16_t raw);
+    // Recomputes gyroBias after a temperature or calibration change
+    void refreshGyroBias();
+    void applyGyroBias();
+    // Display rotation from the filter state; evaluated once per publish
+    void refreshRotation();
+    void applyRotationReset();
     
 public:
     IMUHandler();
     ~IMUHandler();
     
-    bool init();
+    // Registers on the shared bus at IMU priority. Without one, a private
+    // bus on the board pins is used (single-client setups and tests).
+    bool init(I2CBus* shared = nullptr);
     bool isInitialized() const { return initialized; }
     
     // Data reading
     bool readData();
-    bool hasNewData() const { return hasNewData; }
+    
+    // Moves the sensor to FIFO batching with a watermark interrupt
+    bool enableFifo(uint8_t watermark = IMU_FIFO_WATERMARK);
+    bool isFifoEnabled() const { return fifoEnabled; }
+    const IMUFifoStats& getFifoStats() const { return fifoStats; }
+    
+    // Drains a FIFO batch when one is ready, or reads a single sample when
+    // FIFO mode is off. Called by the sampling task, or by the render task
+    // when no task was started.
+    void update();
+    
+    // Runs update() in its own task at a fixed period: one ODR interval
+    // when polling, half a watermark batch in FIFO mode, or on the
+    // watermark interrupt when IMU_INT_PIN is wired. Call after enableFifo().
+    bool startTask(uint8_t core = IMU_TASK_CORE, uint8_t priority = IMU_TASK_PRIORITY);
+    bool isTaskRunning() const { return task != nullptr; }
+    TaskHandle_t getTaskHandle() const { return task; }
+    const TaskLoad& getTaskLoad() const { return taskLoad; }
+    
+    // Lock-free reads of the task's output, safe from any core.
+    // readOrientation() succeeds only when a newer orientation than
+    // *version was published and updates *version.
+    bool readOrientation(IMUOrientation& out, uint32_t& version) const { return orientation.readIfNewer(out, version); }
+    bool getRateStats(IMURateStats& out) const { return rateStats.read(out); }
+    bool hasNewData() const { return newDataAvailable; }
     IMUData getData();
+    uint32_t getSampleCount() const { return sampleCount; }
+    // Bus transactions issued so far (a write-then-read counts as one)
+    uint32_t getI2CTransactions() const { return i2cTransactions; }
     
     // Rotation specific functions
     float getRotation();
-    void resetRotation();
+    // Restarts the attitude filter; applied by the next update(), so it is
+    // safe while the task runs
+    void resetRotation() { resetRequested = true; }
+    
+    // Gyro bias is learned in the background whenever the device is still
+    // (see GyroCalibrator). calibrate() discards it and starts over without
+    // blocking; seedGyroBias() starts from a saved bias (call before startTask()).
     void calibrate();
+    void seedGyroBias(float x, float y, float z);
+    bool readCalibration(GyroCalibration& out, uint32_t& version) const { return calibration.readIfNewer(out, version); }
+    
+    // Bias-vs-temperature model fitted from the calibrator's still windows
+    // (see GyroTempModel); once fitted, the bias follows the die
+    // temperature without waiting for the next stop. Seed before startTask().
+    void seedTempModel(const GyroTempCoeffs& saved);
+    bool readTempModel(GyroTempCoeffs& out, uint32_t& version) const { return tempCoeffs.readIfNewer(out, version); }
+    
+    // Notch for a known vibration (e.g. engine idle), 0 disables.
+    // Not synchronized with the sampling task: set before startTask().
+    void setVibrationNotch(float hz) { notchHz = hz; filter.setNotch(hz, odrHz); }
+    
+    // Motion-driven ODR switching (on by default when the sensor accepted
+    // the motion configuration). Not synchronized: set before startTask().
+    void setAdaptiveRate(bool enabled) { adaptiveRate = enabled; }
+    // Pins the data rate and turns adaptive switching off; applied by the
+    // next update(), so it is safe while the task runs
+    void requestRate(IMURate next) { requestedRate = next; }
+    IMURate getRate() const { return rate; }
+    float getOdrHz() const { return odrHz; }
+    IMUMotionState getMotionState() const { return motion.getState(); }
     
     // Configuration
     void setAccelScale(float scale) { accelScale = scale; }
     void setGyroScale(float scale) { gyroScale = scale; }
-    void setRotationOffset(float offset) { rotationOffset = offset; }
-};
\ No newline at end of file
+    void setRotationOffset(float offset) { rotationOffset = offset; applyGyroBias(); }
+};
+
+#endif // IMU_HANDLER_H
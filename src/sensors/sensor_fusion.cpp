@@ -0,0 +1,132 @@
+#include "sensor_fusion.h"
+#include <math.h>
+
+#define DEG2RAD (PI / 180.0f)
+#define RAD2DEG (180.0f / PI)
+
+SensorFusion::SensorFusion(float kp, float ki) : kp(kp), ki(ki) {
+    reset();
+}
+
+void SensorFusion::reset() {
+    q = {1.0f, 0.0f, 0.0f, 0.0f};
+    biasX = biasY = biasZ = 0.0f;
+    aligned = false;
+}
+
+Quaternion SensorFusion::fromGravity(float ax, float ay, float az) {
+    // Shortest rotation taking the measured gravity to earth +Z
+    float norm = sqrtf(ax * ax + ay * ay + az * az);
+    ax /= norm;
+    ay /= norm;
+    az /= norm;
+
+    float w = sqrtf(0.5f * (1.0f + az));
+    if (w < 1e-4f) {
+        return {0.0f, 1.0f, 0.0f, 0.0f};   // Upside down
+    }
+    return {w, ay / (2.0f * w), -ax / (2.0f * w), 0.0f};
+}
+
+void SensorFusion::update(float gx, float gy, float gz, float ax, float ay, float az, float dt) {
+    gx *= DEG2RAD;
+    gy *= DEG2RAD;
+    gz *= DEG2RAD;
+
+    float normSq = ax * ax + ay * ay + az * az;
+    bool accelUsable = fabsf(normSq - 1.0f) < 2.0f * FUSION_ACCEL_TOLERANCE;
+
+    if (!aligned) {
+        if (!accelUsable) return;
+        q = fromGravity(ax, ay, az);
+        aligned = true;
+        return;
+    }
+
+    // Correct only with a plausible gravity reading: braking, cornering
+    // and bumps add linear acceleration that is not tilt
+    if (accelUsable) {
+        float recipNorm = 1.0f / sqrtf(normSq);
+        ax *= recipNorm;
+        ay *= recipNorm;
+        az *= recipNorm;
+
+        // Estimated gravity direction in the sensor frame
+        float vx = 2.0f * (q.x * q.z - q.w * q.y);
+        float vy = 2.0f * (q.w * q.x + q.y * q.z);
+        float vz = q.w * q.w - q.x * q.x - q.y * q.y + q.z * q.z;
+
+        // Error is the cross product of measured and estimated gravity
+        float ex = ay * vz - az * vy;
+        float ey = az * vx - ax * vz;
+        float ez = ax * vy - ay * vx;
+
+        // The integral settles where it cancels the gyro bias
+        if (ki > 0.0f) {
+            const float limit = FUSION_BIAS_LIMIT_DPS * DEG2RAD;
+            biasX = constrain(biasX - ki * ex * dt, -limit, limit);
+            biasY = constrain(biasY - ki * ey * dt, -limit, limit);
+            biasZ = constrain(biasZ - ki * ez * dt, -limit, limit);
+        }
+
+        gx += kp * ex;
+        gy += kp * ey;
+        gz += kp * ez;
+    }
+
+    gx -= biasX;
+    gy -= biasY;
+    gz -= biasZ;
+
+    // q' = 0.5 * q * (0, g)
+    float half = 0.5f * dt;
+    float qw = q.w, qx = q.x, qy = q.y, qz = q.z;
+    q.w += (-qx * gx - qy * gy - qz * gz) * half;
+    q.x += ( qw * gx + qy * gz - qz * gy) * half;
+    q.y += ( qw * gy - qx * gz + qz * gx) * half;
+    q.z += ( qw * gz + qx * gy - qy * gx) * half;
+
+    float recipNorm = 1.0f / sqrtf(q.w * q.w + q.x * q.x + q.y * q.y + q.z * q.z);
+    q.w *= recipNorm;
+    q.x *= recipNorm;
+    q.y *= recipNorm;
+    q.z *= recipNorm;
+}
+
+EulerAngles SensorFusion::getEuler() const {
+    return toEuler(q);
+}
+
+EulerAngles SensorFusion::toEuler(const Quaternion& q) {
+    EulerAngles e;
+    e.roll = atan2f(2.0f * (q.w * q.x + q.y * q.z), 1.0f - 2.0f * (q.x * q.x + q.y * q.y)) * RAD2DEG;
+    float sinPitch = constrain(2.0f * (q.w * q.y - q.z * q.x), -1.0f, 1.0f);
+    e.pitch = asinf(sinPitch) * RAD2DEG;
+    e.yaw = atan2f(2.0f * (q.w * q.z + q.x * q.y), 1.0f - 2.0f * (q.y * q.y + q.z * q.z)) * RAD2DEG;
+    return e;
+}
+
+void SensorFusion::getGravity(float& x, float& y, float& z) const {
+    x = 2.0f * (q.x * q.z - q.w * q.y);
+    y = 2.0f * (q.w * q.x + q.y * q.z);
+    z = q.w * q.w - q.x * q.x - q.y * q.y + q.z * q.z;
+}
+
+float SensorFusion::getScreenRotation() const {
+    float x, y, z;
+    getGravity(x, y, z);
+    float angle = atan2f(y, x) * RAD2DEG;
+    return angle < 0.0f ? angle + 360.0f : angle;
+}
+
+void SensorFusion::getGyroBias(float& x, float& y, float& z) const {
+    x = biasX * RAD2DEG;
+    y = biasY * RAD2DEG;
+    z = biasZ * RAD2DEG;
+}
+
+void SensorFusion::setGyroBias(float x, float y, float z) {
+    biasX = x * DEG2RAD;
+    biasY = y * DEG2RAD;
+    biasZ = z * DEG2RAD;
+}
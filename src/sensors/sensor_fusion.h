@@ -0,0 +1,65 @@
+#ifndef SENSOR_FUSION_H
+#define SENSOR_FUSION_H
+
+#include <Arduino.h>
+
+// 6-DoF attitude estimation (Mahony complementary filter on SO(3)).
+// The gyro is integrated as a quaternion; the accelerometer's gravity
+// direction pulls roll and pitch back with a proportional gain, and an
+// integral term of the same error converges to the gyro bias. Yaw has no
+// absolute reference without a magnetometer, so only its drift from bias
+// on the tilted axes is corrected.
+//
+// Cost: ~120 float operations per update, no trigonometry. Budget is
+// FUSION_CPU_BUDGET_US per update on the ESP32-S3 (240 MHz, single-precision
+// FPU), i.e. at most 1% of a core at 500 Hz.
+#define FUSION_KP               1.0f    // Accel correction gain (rad/s per unit error)
+#define FUSION_KI               0.05f   // Bias integration gain
+#define FUSION_ACCEL_TOLERANCE  0.15f   // Skip correction when |a| is further than this from 1 g
+#define FUSION_BIAS_LIMIT_DPS   10.0f   // Clamp on the estimated gyro bias
+#define FUSION_CPU_BUDGET_US    20
+
+struct Quaternion {
+    float w, x, y, z;
+};
+
+// Degrees. Roll about X, pitch about Y, yaw about Z (aerospace sequence).
+struct EulerAngles {
+    float roll, pitch, yaw;
+};
+
+class SensorFusion {
+private:
+    Quaternion q;              // Sensor frame to earth frame
+    float biasX, biasY, biasZ; // Gyro bias estimate, rad/s
+    float kp, ki;
+    bool aligned;              // Seeded from the first accelerometer sample
+
+public:
+    SensorFusion(float kp = FUSION_KP, float ki = FUSION_KI);
+
+    void reset();
+
+    // Gyro in deg/s, accel in g, dt in seconds
+    void update(float gx, float gy, float gz, float ax, float ay, float az, float dt);
+
+    const Quaternion& getQuaternion() const { return q; }
+    EulerAngles getEuler() const;
+
+    // Unit gravity direction in the sensor frame
+    void getGravity(float& x, float& y, float& z) const;
+
+    // Angle of gravity in the sensor XY plane (the display plane), 0-360°,
+    // 0 when gravity points along +X. Drives display auto-rotation.
+    float getScreenRotation() const;
+
+    // Attitude with zero yaw that maps a gravity reading to earth +Z
+    static Quaternion fromGravity(float ax, float ay, float az);
+    static EulerAngles toEuler(const Quaternion& q);
+
+    // Estimated gyro bias in deg/s (already removed from the integration)
+    void getGyroBias(float& x, float& y, float& z) const;
+    void setGyroBias(float x, float y, float z);
+};
+
+#endif // SENSOR_FUSION_H
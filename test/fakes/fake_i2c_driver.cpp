@@ -0,0 +1,54 @@
+#include "fake_i2c_driver.h"
+
+FakeI2CDriver::FakeI2CDriver(uint32_t overheadUs) : deviceCount(0), clockHz(I2C_BUS_CLOCK_HZ),
+                                                    overheadUs(overheadUs), timeUs(0),
+                                                    transactions(0), busyUs(0) {
+}
+
+bool FakeI2CDriver::begin(int sda, int scl, uint32_t clockHz) {
+    this->clockHz = clockHz;
+    return clockHz > 0;
+}
+
+bool FakeI2CDriver::addDevice(uint8_t address, FakeI2CDevice handler, void* context) {
+    if (deviceCount >= FAKE_I2C_MAX_DEVICES) return false;
+    devices[deviceCount].address = address;
+    devices[deviceCount].handler = handler;
+    devices[deviceCount].context = context;
+    deviceCount++;
+    return true;
+}
+
+uint32_t FakeI2CDriver::transactionUs(size_t txLen, size_t rxLen) const {
+    // Start + address byte + data bytes, per phase; one stop at the end
+    uint32_t clocks = 1;
+    if (txLen > 0) clocks += 1 + 9 * (1 + txLen);
+    if (rxLen > 0) clocks += 1 + 9 * (1 + rxLen);
+    return overheadUs + (uint32_t)(((uint64_t)clocks * 1000000 + clockHz - 1) / clockHz);
+}
+
+bool FakeI2CDriver::transfer(uint8_t address, const uint8_t* tx, size_t txLen,
+                             uint8_t* rx, size_t rxLen) {
+    transactions++;
+
+    const Device* device = nullptr;
+    for (uint8_t i = 0; i < deviceCount; i++) {
+        if (devices[i].address == address) device = &devices[i];
+    }
+    if (!device) {
+        // NAK on the address byte ends the transaction early
+        uint32_t us = transactionUs(1, 0) - 9 * 1000000 / clockHz;
+        timeUs += us;
+        busyUs += us;
+        return false;
+    }
+
+    uint32_t us = transactionUs(txLen, rxLen);
+    timeUs += us;
+    busyUs += us;
+    if (!device->handler) {
+        if (rxLen > 0) memset(rx, 0, rxLen);
+        return true;
+    }
+    return device->handler(device->context, tx, txLen, rx, rxLen);
+}
@@ -0,0 +1,59 @@
+#ifndef FAKE_I2C_DRIVER_H
+#define FAKE_I2C_DRIVER_H
+
+#include "../../src/bus/i2c_bus.h"
+
+// Bus driver for tests: no hardware, a virtual clock and a timing model.
+//
+// Each transaction advances the clock by its wire time: start, address and
+// 9 clocks per byte (8 data + ACK) for the write, the same again after a
+// repeated start for the read, a stop, plus FAKE_I2C_OVERHEAD_US for the
+// driver's command setup and completion interrupt. Latencies measured by
+// I2CBus against nowUs() are then exact and repeatable, so tests can bound
+// the worst case per client instead of sampling it.
+#define FAKE_I2C_OVERHEAD_US    25
+#define FAKE_I2C_MAX_DEVICES    4
+
+// Answers one transaction for a simulated device; false NAKs it
+typedef bool (*FakeI2CDevice)(void* context, const uint8_t* tx, size_t txLen,
+                              uint8_t* rx, size_t rxLen);
+
+class FakeI2CDriver : public I2CDriver {
+private:
+    struct Device {
+        uint8_t address;
+        FakeI2CDevice handler;
+        void* context;
+    };
+
+    Device devices[FAKE_I2C_MAX_DEVICES];
+    uint8_t deviceCount;
+    uint32_t clockHz;
+    uint32_t overheadUs;
+    uint32_t timeUs;
+    uint32_t transactions;
+    uint32_t busyUs;
+
+public:
+    explicit FakeI2CDriver(uint32_t overheadUs = FAKE_I2C_OVERHEAD_US);
+
+    bool begin(int sda, int scl, uint32_t clockHz) override;
+    bool transfer(uint8_t address, const uint8_t* tx, size_t txLen,
+                  uint8_t* rx, size_t rxLen) override;
+    uint32_t nowUs() override { return timeUs; }
+
+    // Unregistered addresses NAK. A device without a handler accepts
+    // every write and reads as zeros.
+    bool addDevice(uint8_t address, FakeI2CDevice handler = nullptr, void* context = nullptr);
+
+    // Wire time of one transaction under the model
+    uint32_t transactionUs(size_t txLen, size_t rxLen) const;
+
+    // Idle time between transactions
+    void advance(uint32_t us) { timeUs += us; }
+
+    uint32_t getTransactions() const { return transactions; }
+    uint32_t getBusyUs() const { return busyUs; }
+};
+
+#endif // FAKE_I2C_DRIVER_H
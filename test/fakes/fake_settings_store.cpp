@@ -0,0 +1,82 @@
+#include "fake_settings_store.h"
+
+FakeSettingsStore::FakeSettingsStore() : writePoints(0), cutAt(FAKE_SETTINGS_NO_CUT), powered(true) {
+    memset(entries, 0, sizeof(entries));
+}
+
+FakeSettingsStore::Entry* FakeSettingsStore::find(const char* key) {
+    for (uint8_t i = 0; i < FAKE_SETTINGS_MAX_KEYS; i++) {
+        if (entries[i].used && strncmp(entries[i].key, key, FAKE_SETTINGS_MAX_KEY) == 0) {
+            return &entries[i];
+        }
+    }
+    return nullptr;
+}
+
+bool FakeSettingsStore::step() {
+    if (!powered) return false;
+    if (writePoints == cutAt) {
+        powered = false;
+        return false;
+    }
+    writePoints++;
+    return true;
+}
+
+size_t FakeSettingsStore::read(const char* key, void* data, size_t maxLen) {
+    Entry* entry = find(key);
+    if (!entry || entry->length > maxLen) return 0;
+    memcpy(data, entry->data, entry->length);
+    return entry->length;
+}
+
+bool FakeSettingsStore::write(const char* key, const void* data, size_t len) {
+    if (len > SETTINGS_BLOB_MAX || strlen(key) >= FAKE_SETTINGS_MAX_KEY) return false;
+
+    Entry* entry = find(key);
+    if (!entry) {
+        for (uint8_t i = 0; i < FAKE_SETTINGS_MAX_KEYS && !entry; i++) {
+            if (!entries[i].used) entry = &entries[i];
+        }
+        if (!entry) return false;
+    }
+
+    // Erase
+    if (!step()) return false;
+    entry->used = true;
+    strcpy(entry->key, key);
+    memset(entry->data, 0xFF, sizeof(entry->data));
+    entry->length = len;
+
+    // Program, one word per write point
+    const uint8_t* bytes = static_cast<const uint8_t*>(data);
+    for (size_t offset = 0; offset < len; offset += FAKE_SETTINGS_WORD) {
+        if (!step()) return false;
+        memcpy(entry->data + offset, bytes + offset, min((size_t)FAKE_SETTINGS_WORD, len - offset));
+    }
+    return true;
+}
+
+bool FakeSettingsStore::erase(const char* key) {
+    Entry* entry = find(key);
+    if (!entry) return false;
+    if (!step()) return false;
+    entry->used = false;
+    return true;
+}
+
+bool FakeSettingsStore::readLegacy(const char* key, SettingsLegacyType type, void* data, size_t len) {
+    Entry* entry = find(key);
+    if (!entry || entry->length != len) return false;
+    memcpy(data, entry->data, len);
+    return true;
+}
+
+void FakeSettingsStore::cutPowerAfter(uint32_t points) {
+    cutAt = writePoints + points;
+}
+
+void FakeSettingsStore::restorePower() {
+    cutAt = FAKE_SETTINGS_NO_CUT;
+    powered = true;
+}
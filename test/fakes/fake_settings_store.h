@@ -0,0 +1,57 @@
+#ifndef FAKE_SETTINGS_STORE_H
+#define FAKE_SETTINGS_STORE_H
+
+#include "../../src/config/settings.h"
+
+// Settings store for tests: RAM only, with power-loss injection.
+//
+// A write is modelled the way flash is programmed: one write point erases
+// the value (all bytes 0xFF, new length), then one write point per
+// FAKE_SETTINGS_WORD bytes programs it. An erase is one write point.
+// cutPowerAfter(n) lets n more write points happen; the next one and
+// everything after it fail, leaving whatever was half written in place,
+// until restorePower(). Tests cut at every point of a commit sequence and
+// boot again to check a consistent set is always recovered.
+//
+// Keys of the old per-key layout are plain entries too: a test seeds one
+// with write() and readLegacy() returns it when the length matches.
+#define FAKE_SETTINGS_MAX_KEYS      24      // Both slots and the 20 old keys
+#define FAKE_SETTINGS_MAX_KEY       16
+#define FAKE_SETTINGS_WORD          4
+#define FAKE_SETTINGS_NO_CUT        0xFFFFFFFF
+
+class FakeSettingsStore : public SettingsStore {
+private:
+    struct Entry {
+        bool used;
+        char key[FAKE_SETTINGS_MAX_KEY];
+        uint8_t data[SETTINGS_BLOB_MAX];
+        size_t length;
+    };
+
+    Entry entries[FAKE_SETTINGS_MAX_KEYS];
+    uint32_t writePoints;
+    uint32_t cutAt;
+    bool powered;
+
+    Entry* find(const char* key);
+    // Performs one write point; false once power is gone
+    bool step();
+
+public:
+    FakeSettingsStore();
+
+    size_t read(const char* key, void* data, size_t maxLen) override;
+    bool write(const char* key, const void* data, size_t len) override;
+    bool erase(const char* key) override;
+    bool readLegacy(const char* key, SettingsLegacyType type, void* data, size_t len) override;
+
+    void cutPowerAfter(uint32_t points);
+    void restorePower();
+    bool isPowered() const { return powered; }
+
+    // Write points performed so far
+    uint32_t getWritePoints() const { return writePoints; }
+};
+
+#endif // FAKE_SETTINGS_STORE_H
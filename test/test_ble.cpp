@@ -1,6 +1,13 @@
 #include <unity.h>
 #include <Arduino.h>
 #include "../src/ble/ble_server.h"
+#include "../src/ble/packet_log.h"
+#include "../src/ble/packet_replay.h"
+#include "../src/ble/nav_protocol_v2.h"
+#include "../src/ble/conn_policy.h"
+#include "../src/ble/telemetry.h"
+#include "../src/ble/nav_decoder.h"
+#include "../src/ble/nav_broadcast.h"
 
 // Mock navigation data for testing
 const uint8_t MOCK_NAV_DATA[] = {0x01, 0x32, 0x0A, 0x33, 0x35, 0x30, 0x6D};
@@ -117,6 +124,915 @@ void test_data_packet_validation() {
     TEST_ASSERT_EQUAL_HEX8_MESSAGE(0x01, MOCK_NAV_DATA[0], "First byte should be data flag");
 }
 
+// Build an in-memory capture record
+static PacketRecord makeRecord(uint32_t sequence, uint32_t timestampMs, const uint8_t* data, uint8_t length) {
+    PacketRecord rec;
+    memset(&rec, 0, sizeof(rec));
+    rec.magic = PACKET_LOG_RECORD_MAGIC;
+    rec.sequence = sequence;
+    rec.timestampMs = timestampMs;
+    rec.length = length;
+    memcpy(rec.data, data, length);
+    return rec;
+}
+
+// Test packet log record/flush round trip. Runs on the navtest partition,
+// so the capture in navlog survives a test run.
+void test_packet_log_roundtrip() {
+    PacketLog log;
+    if (!log.init(PACKET_LOG_TEST_LABEL)) {
+        TEST_IGNORE_MESSAGE("navtest partition not present in this firmware");
+        return;
+    }
+    log.clear();
+    
+    const uint8_t second[] = {0x01, 0x00, 0x50, 0x02, 0x31, 0x32, 0x30};
+    log.record(0, MOCK_NAV_DATA, MOCK_NAV_SIZE);
+    log.record(0, second, sizeof(second));
+    
+    // record() only stages in RAM; nothing reaches flash until flush()
+    TEST_ASSERT_EQUAL_INT_MESSAGE(0, log.recordCount(), "Records should not be in flash before flush");
+    TEST_ASSERT_EQUAL_INT_MESSAGE(2, log.flush(), "Flush should write both records");
+    TEST_ASSERT_EQUAL_INT_MESSAGE(2, log.recordCount(), "Flash should hold two records");
+    
+    PacketRecord rec;
+    TEST_ASSERT_TRUE_MESSAGE(log.readRecord(1, rec), "Second record should be readable");
+    TEST_ASSERT_EQUAL_INT_MESSAGE(sizeof(second), rec.length, "Stored length should match");
+    TEST_ASSERT_EQUAL_UINT8_ARRAY_MESSAGE(second, rec.data, sizeof(second), "Stored payload should match");
+    TEST_ASSERT_EQUAL_INT_MESSAGE(1, rec.sequence, "Sequence should increase per record");
+    
+    // Anything the ingest queue accepts fits whole
+    uint8_t large[PACKET_LOG_MAX_PAYLOAD + 8];
+    memset(large, 0xAB, sizeof(large));
+    log.record(0, large, INGEST_MAX_PAYLOAD);
+    log.flush();
+    TEST_ASSERT_TRUE_MESSAGE(log.readRecord(2, rec), "Full-size record should be readable");
+    TEST_ASSERT_EQUAL_INT_MESSAGE(INGEST_MAX_PAYLOAD, rec.length, "A 64-byte write should be stored whole");
+    TEST_ASSERT_FALSE_MESSAGE(rec.flags & PACKET_LOG_FLAG_TRUNCATED, "A 64-byte write should not be truncated");
+    
+    // Oversized writes are truncated, not rejected
+    log.record(0, large, sizeof(large));
+    log.flush();
+    TEST_ASSERT_TRUE_MESSAGE(log.readRecord(3, rec), "Truncated record should be readable");
+    TEST_ASSERT_EQUAL_INT_MESSAGE(PACKET_LOG_MAX_PAYLOAD, rec.length, "Payload should be truncated");
+    TEST_ASSERT_TRUE_MESSAGE(rec.flags & PACKET_LOG_FLAG_TRUNCATED, "Truncated flag should be set");
+    
+    log.clear();
+}
+
+// Test replay timing at accelerated speed
+void test_packet_replay_accelerated() {
+    BLEServer bleServer;
+    
+    const uint8_t left[]  = {0x01, 0x00, 0x32, 0x01, 0x33, 0x35, 0x30};
+    const uint8_t right[] = {0x01, 0x00, 0x3C, 0x02, 0x32, 0x30, 0x30};
+    const uint8_t ahead[] = {0x01, 0x00, 0x50, 0x03, 0x31, 0x30, 0x30};
+    PacketRecord capture[] = {
+        makeRecord(0, 10000, left, sizeof(left)),
+        makeRecord(1, 10500, right, sizeof(right)),
+        makeRecord(2, 12000, ahead, sizeof(ahead)),
+    };
+    
+    PacketReplay replay;
+    TEST_ASSERT_TRUE_MESSAGE(replay.begin(&bleServer, capture, 3, 2.0, 0), "Replay should start");
+    
+    // At 2x, packets are due at 0, 250 and 1000 ms
+    TEST_ASSERT_EQUAL_INT_MESSAGE(1, replay.update(0), "First packet is due immediately");
+    TEST_ASSERT_EQUAL_INT_MESSAGE(0, replay.update(249), "Second packet is not due yet");
+    TEST_ASSERT_EQUAL_INT_MESSAGE(1, replay.update(250), "Second packet is due at 250ms");
+    TEST_ASSERT_EQUAL_INT_MESSAGE(1, replay.update(1010), "Third packet is due at 1000ms");
+    TEST_ASSERT_FALSE_MESSAGE(replay.isRunning(), "Replay should finish after last packet");
+    TEST_ASSERT_EQUAL_INT_MESSAGE(10, replay.getStats().maxLatenessMs, "Lateness should be tracked");
+    
+    TEST_ASSERT_TRUE_MESSAGE(bleServer.hasNewData(), "Replayed packets should reach the server");
+    NavigationData navData = bleServer.getNavigationData();
+    TEST_ASSERT_EQUAL_INT_MESSAGE(0x03, navData.turnDirection, "Last packet should win");
+    TEST_ASSERT_EQUAL_INT_MESSAGE(80, navData.speedLimit, "Speed limit should come from last packet");
+}
+
+// Test that a v2 keyframe with a street name survives capture, and that
+// truncated records are skipped instead of fed to the decoders
+void test_packet_replay_truncated() {
+    NavigationData nav;
+    nav.distance = 750;
+    nav.turnDirection = NAV_TURN_RIGHT;
+    nav.streetName = "Avenida Brigadeiro Faria Lima";
+    NavV2Encoder encoder;
+    uint8_t keyframe[NAV_V2_MAX_PACKET];
+    size_t len = encoder.encode(nav, keyframe, sizeof(keyframe));
+    TEST_ASSERT_TRUE_MESSAGE(len > 20, "Keyframe should exceed the default ATT payload");
+    
+    PacketRecord capture[] = {
+        makeRecord(0, 1000, keyframe, 20),
+        makeRecord(1, 1100, keyframe, len),
+    };
+    capture[0].source = NAV_SOURCE_V2;
+    capture[0].flags = PACKET_LOG_FLAG_TRUNCATED;
+    capture[1].source = NAV_SOURCE_V2;
+    
+    BLEServer bleServer;
+    PacketReplay replay;
+    TEST_ASSERT_TRUE(replay.begin(&bleServer, capture, 2, 0, 0));
+    TEST_ASSERT_EQUAL_INT_MESSAGE(1, replay.update(0), "Only the whole record should be fed");
+    TEST_ASSERT_EQUAL_INT_MESSAGE(1, replay.getStats().truncated, "The cut record should be counted");
+    
+    NavigationData shown = bleServer.getNavigationData();
+    TEST_ASSERT_EQUAL_INT_MESSAGE(750, shown.distance, "The v2 keyframe should sync the decoder");
+    TEST_ASSERT_EQUAL_STRING_MESSAGE("Avenida Brigadeiro Faria Lima", shown.streetName.c_str(), "Street should survive capture");
+}
+
+// Test that replays are repeatable for the same clock sequence
+void test_packet_replay_deterministic() {
+    const uint8_t pkt[] = {0x01, 0x00, 0x32, 0x01, 0x33, 0x35, 0x30};
+    PacketRecord capture[20];
+    for (uint32_t i = 0; i < 20; i++) {
+        capture[i] = makeRecord(i, 5000 + i * 137, pkt, sizeof(pkt));
+    }
+    
+    uint32_t delivered[2][40];
+    for (int run = 0; run < 2; run++) {
+        BLEServer bleServer;
+        PacketReplay replay;
+        replay.begin(&bleServer, capture, 20, 1.0, 1000);
+        for (uint32_t step = 0; step < 40; step++) {
+            delivered[run][step] = replay.update(1000 + step * 75);
+        }
+    }
+    
+    TEST_ASSERT_EQUAL_UINT8_ARRAY_MESSAGE(delivered[0], delivered[1], sizeof(delivered[0]),
+                                          "Two replays should deliver identically");
+    
+    // Speed 0 delivers the whole capture in one update
+    BLEServer bleServer;
+    PacketReplay replay;
+    replay.begin(&bleServer, capture, 20, 0, 0);
+    TEST_ASSERT_EQUAL_INT_MESSAGE(20, replay.update(0), "Speed 0 should replay everything at once");
+}
+
+// Test v2 keyframe round trip including the v2-only fields
+void test_protocol_v2_roundtrip() {
+    NavigationData sent;
+    sent.distance = 1250;
+    sent.turnDirection = NAV_TURN_ROUNDABOUT;
+    sent.speedLimit = 80;
+    sent.currentSpeed = 74;
+    sent.etaSeconds = 1380;
+    sent.laneCount = 4;
+    sent.laneMask = 0x06;
+    sent.streetName = "Av. Paulista";
+    
+    NavV2Encoder encoder;
+    uint8_t packet[NAV_V2_MAX_PACKET];
+    size_t len = encoder.encode(sent, packet, sizeof(packet));
+    TEST_ASSERT_TRUE_MESSAGE(len > 0, "Keyframe should encode");
+    TEST_ASSERT_EQUAL_HEX8_MESSAGE(NAV_V2_VERSION, packet[0], "First byte should be the version");
+    
+    NavV2Decoder decoder;
+    NavigationData received;
+    TEST_ASSERT_TRUE_MESSAGE(decoder.decode(packet, len, received), "Keyframe should decode");
+    TEST_ASSERT_TRUE_MESSAGE(received.isValid, "Decoded data should be valid");
+    TEST_ASSERT_EQUAL_INT_MESSAGE(1250, received.distance, "Distance should round trip");
+    TEST_ASSERT_EQUAL_INT_MESSAGE(NAV_TURN_ROUNDABOUT, received.turnDirection, "Turn should round trip");
+    TEST_ASSERT_EQUAL_STRING_MESSAGE("Roundabout", received.instruction.c_str(), "Instruction should follow turn code");
+    TEST_ASSERT_EQUAL_INT_MESSAGE(80, received.speedLimit, "Speed limit should round trip");
+    TEST_ASSERT_EQUAL_INT_MESSAGE(74, received.currentSpeed, "Current speed should round trip");
+    TEST_ASSERT_EQUAL_INT_MESSAGE(1380, received.etaSeconds, "ETA should round trip");
+    TEST_ASSERT_EQUAL_INT_MESSAGE(4, received.laneCount, "Lane count should round trip");
+    TEST_ASSERT_EQUAL_INT_MESSAGE(0x06, received.laneMask, "Lane mask should round trip");
+    TEST_ASSERT_EQUAL_STRING_MESSAGE("Av. Paulista", received.streetName.c_str(), "Street should round trip");
+}
+
+// Test that deltas only carry changed fields and need a keyframe first
+void test_protocol_v2_delta() {
+    NavigationData nav;
+    nav.distance = 500;
+    nav.turnDirection = NAV_TURN_LEFT;
+    nav.speedLimit = 50;
+    
+    NavV2Encoder encoder;
+    NavV2Decoder decoder;
+    NavigationData received;
+    uint8_t packet[NAV_V2_MAX_PACKET];
+    
+    size_t len = encoder.encode(nav, packet, sizeof(packet));
+    decoder.decode(packet, len, received);
+    
+    nav.distance = 492;
+    len = encoder.encode(nav, packet, sizeof(packet));
+    TEST_ASSERT_EQUAL_INT_MESSAGE(3, len, "Distance-only delta should be 3 bytes");
+    TEST_ASSERT_TRUE_MESSAGE(decoder.decode(packet, len, received), "Delta should decode");
+    TEST_ASSERT_EQUAL_INT_MESSAGE(492, received.distance, "Delta should apply to previous distance");
+    TEST_ASSERT_EQUAL_INT_MESSAGE(50, received.speedLimit, "Unchanged fields should be kept");
+    
+    // A fresh decoder cannot apply a delta
+    NavV2Decoder fresh;
+    NavigationData untouched;
+    TEST_ASSERT_FALSE_MESSAGE(fresh.decode(packet, len, untouched), "Delta before keyframe should be rejected");
+    TEST_ASSERT_FALSE_MESSAGE(untouched.isValid, "Rejected packet should not modify data");
+    
+    // Truncated packets are rejected without side effects
+    nav.streetName = "Rua Augusta";
+    len = encoder.encode(nav, packet, sizeof(packet));
+    TEST_ASSERT_FALSE_MESSAGE(decoder.decode(packet, len - 3, received), "Truncated packet should be rejected");
+    TEST_ASSERT_EQUAL_STRING_MESSAGE("", received.streetName.c_str(), "Truncated packet should not apply");
+}
+
+// Test that unknown extension fields are skipped
+void test_protocol_v2_extension_skip() {
+    // Keyframe (bits 0, 7) with distance=100, plus extension bit 8 carrying 2 opaque bytes
+    const uint8_t packet[] = {NAV_V2_VERSION, 0x81, 0x03, 0xC8, 0x01, 0x02, 0xAA, 0xBB};
+    NavV2Decoder decoder;
+    NavigationData received;
+    TEST_ASSERT_TRUE_MESSAGE(decoder.decode(packet, sizeof(packet), received), "Extension field should be skipped");
+    TEST_ASSERT_EQUAL_INT_MESSAGE(100, received.distance, "Known fields should still decode");
+    
+    const uint8_t wrongVersion[] = {0x03, 0x81, 0x01, 0xC8, 0x01};
+    TEST_ASSERT_FALSE_MESSAGE(decoder.decode(wrongVersion, sizeof(wrongVersion), received), "Unknown version should be rejected");
+}
+
+// Test that v2 deltas build on the v2 stream, not on distances from other sources
+void test_protocol_v2_delta_base() {
+    NavigationData nav;
+    nav.distance = 500;
+    NavV2Encoder encoder;
+    NavV2Decoder decoder;
+    NavigationData shared;
+    uint8_t packet[NAV_V2_MAX_PACKET];
+
+    size_t len = encoder.encode(nav, packet, sizeof(packet));
+    TEST_ASSERT_TRUE(decoder.decode(packet, len, shared));
+
+    // A Sygic packet overwrites the shared record between two v2 deltas
+    shared.distance = 9000;
+    nav.distance = 492;
+    len = encoder.encode(nav, packet, sizeof(packet));
+    TEST_ASSERT_TRUE(decoder.decode(packet, len, shared));
+    TEST_ASSERT_EQUAL_INT_MESSAGE(492, shared.distance, "Delta should apply to the last v2 distance");
+
+    // A reset drops the base along with the sync
+    decoder.reset();
+    TEST_ASSERT_FALSE_MESSAGE(decoder.decode(packet, len, shared), "Delta after reset should be rejected");
+}
+
+// Test that long street names are cut on a UTF-8 code point boundary
+void test_protocol_v2_street_utf8() {
+    NavigationData nav;
+    // 31 ASCII bytes, then a two-byte character straddling the 32-byte limit
+    nav.streetName = "Rua Professor Doutor Joao Silva\xC3\xA3o";
+    NavV2Encoder encoder;
+    NavV2Decoder decoder;
+    NavigationData received;
+    uint8_t packet[NAV_V2_MAX_PACKET];
+
+    size_t len = encoder.encode(nav, packet, sizeof(packet));
+    TEST_ASSERT_TRUE(decoder.decode(packet, len, received));
+    TEST_ASSERT_EQUAL_INT_MESSAGE(31, received.streetName.length(), "Partial character should be dropped");
+    TEST_ASSERT_EQUAL_STRING_MESSAGE("Rua Professor Doutor Joao Silva", received.streetName.c_str(), "ASCII prefix should be kept");
+}
+
+// Benchmark: bytes per update and decode time, Sygic vs v2, over a simulated approach
+void test_protocol_benchmark() {
+    const int UPDATES = 200;
+    // ~15 KB of encoded packets: static, off the loop task stack
+    static uint8_t sygic[UPDATES][7];
+    static uint8_t v2[UPDATES][NAV_V2_MAX_PACKET];
+    static size_t v2Len[UPDATES];
+    size_t sygicBytes = 0, v2Bytes = 0;
+    
+    // Approach at ~50 km/h, one update per second, a turn change every 50 updates
+    NavV2Encoder encoder;
+    NavigationData nav;
+    nav.speedLimit = 50;
+    nav.currentSpeed = 48;
+    nav.streetName = "Rua da Consolacao";
+    for (int i = 0; i < UPDATES; i++) {
+        nav.distance = 999 - (i % 50) * 14;
+        nav.turnDirection = 1 + (i / 50) % 4;
+        nav.etaSeconds = 600 - i;
+        
+        char digits[4];
+        snprintf(digits, sizeof(digits), "%03d", nav.distance);
+        sygic[i][0] = 0x01;
+        sygic[i][1] = 0x00;
+        sygic[i][2] = nav.speedLimit;
+        sygic[i][3] = nav.turnDirection;
+        memcpy(&sygic[i][4], digits, 3);
+        sygicBytes += 7;
+        
+        v2Len[i] = encoder.encode(nav, v2[i], NAV_V2_MAX_PACKET, i % 50 == 0);
+        v2Bytes += v2Len[i];
+    }
+    
+    BLEServer bleServer;
+    unsigned long start = micros();
+    for (int i = 0; i < UPDATES; i++) {
+        bleServer.injectPacket(sygic[i], 7, NAV_SOURCE_SYGIC);
+    }
+    unsigned long sygicUs = micros() - start;
+    
+    start = micros();
+    for (int i = 0; i < UPDATES; i++) {
+        bleServer.injectPacket(v2[i], v2Len[i], NAV_SOURCE_V2);
+    }
+    unsigned long v2Us = micros() - start;
+    
+    char report[160];
+    snprintf(report, sizeof(report),
+             "bytes/update sygic=%.2f v2=%.2f | decode us/update sygic=%.2f v2=%.2f",
+             (float)sygicBytes / UPDATES, (float)v2Bytes / UPDATES,
+             (float)sygicUs / UPDATES, (float)v2Us / UPDATES);
+    TEST_MESSAGE(report);
+    
+    TEST_ASSERT_TRUE_MESSAGE(v2Bytes < sygicBytes, "v2 should use fewer bytes per update on average");
+    TEST_ASSERT_EQUAL_INT_MESSAGE(nav.distance, bleServer.getNavigationData().distance, "v2 stream should track distance exactly");
+}
+
+// Scripted stand-in central: disconnect, reconnect and first frame latency
+void test_fast_reconnect_cached_navigation() {
+    BLEServer bleServer;
+    bleServer.setReconnectPolicy(true, 3000);
+    
+    NimBLEAddress phone;
+    bleServer.getDecoders().bindHandle(10, NAV_SOURCE_SYGIC);
+    bleServer.handleConnect(1, &phone, 0);
+    bleServer.enqueueWrite(1, 10, MOCK_NAV_DATA, MOCK_NAV_SIZE, 10);
+    bleServer.update(10);
+    NavigationData before = bleServer.getNavigationData();
+    bleServer.markFrameRendered(20);
+    
+    // Phone drops out: directed burst first, then fast, then slow advertising
+    bleServer.handleDisconnect(1, 1000);
+    TEST_ASSERT_FALSE_MESSAGE(bleServer.isConnected(), "Should be disconnected");
+    TEST_ASSERT_EQUAL_INT_MESSAGE(ADV_DIRECTED, bleServer.getAdvertisingPhase(), "Bonded peer should get directed advertising");
+    
+    bleServer.update(1000 + ADV_DIRECTED_WINDOW_MS);
+    TEST_ASSERT_EQUAL_INT_MESSAGE(ADV_FAST, bleServer.getAdvertisingPhase(), "Directed burst should fall back to fast advertising");
+    
+    bleServer.update(1000 + ADV_DIRECTED_WINDOW_MS + 3000);
+    TEST_ASSERT_EQUAL_INT_MESSAGE(ADV_SLOW, bleServer.getAdvertisingPhase(), "Fast advertising should fall back to slow after reconnectDelay");
+    
+    // Phone comes back; cached navigation is available without a new packet
+    bleServer.handleConnect(1, &phone, 5600);
+    TEST_ASSERT_EQUAL_INT_MESSAGE(ADV_SLOW, bleServer.getAdvertisingPhase(), "Connected with free slots should keep slow advertising");
+    TEST_ASSERT_TRUE_MESSAGE(bleServer.hasNewData(), "Cached navigation should be offered on reconnect");
+    NavigationData after = bleServer.getNavigationData();
+    TEST_ASSERT_EQUAL_INT_MESSAGE(before.turnDirection, after.turnDirection, "Cached navigation should match last state");
+    TEST_ASSERT_EQUAL_INT_MESSAGE(before.speedLimit, after.speedLimit, "Cached navigation should match last state");
+    
+    bleServer.markFrameRendered(5612);
+    const ReconnectStats& stats = bleServer.getReconnectStats();
+    TEST_ASSERT_EQUAL_INT_MESSAGE(1, stats.reconnects, "One reconnect should be counted");
+    TEST_ASSERT_EQUAL_INT_MESSAGE(4600, stats.lastDisconnectToConnectMs, "Disconnect to connect should be measured");
+    TEST_ASSERT_EQUAL_INT_MESSAGE(4612, stats.lastDisconnectToFrameMs, "Disconnect to first frame should be measured");
+    TEST_ASSERT_EQUAL_INT_MESSAGE(12, stats.lastConnectToFrameMs, "Connect to first frame should be measured");
+    
+    char report[96];
+    snprintf(report, sizeof(report), "disconnect->frame %ums, connect->frame %ums",
+             stats.lastDisconnectToFrameMs, stats.lastConnectToFrameMs);
+    TEST_MESSAGE(report);
+}
+
+// Without auto-connect the directed burst is skipped
+void test_reconnect_without_auto_connect() {
+    BLEServer bleServer;
+    bleServer.setReconnectPolicy(false, 2000);
+    
+    NimBLEAddress phone;
+    bleServer.handleConnect(1, &phone, 0);
+    bleServer.handleDisconnect(1, 100);
+    TEST_ASSERT_EQUAL_INT_MESSAGE(ADV_FAST, bleServer.getAdvertisingPhase(), "Auto-connect off should start with fast advertising");
+    
+    // No cached navigation yet, so nothing to redraw on reconnect
+    bleServer.handleConnect(1, &phone, 500);
+    TEST_ASSERT_FALSE_MESSAGE(bleServer.hasNewData(), "Nothing cached should mean no redraw");
+}
+
+// A speed sensor linked next to the phone never becomes the reconnect target
+void test_reconnect_targets_navigation_peer() {
+    BLEServer bleServer;
+    bleServer.setReconnectPolicy(true, 3000);
+    NavDecoderRegistry& registry = bleServer.getDecoders();
+    registry.bindHandle(10, NAV_SOURCE_SYGIC);
+    registry.bindHandle(12, NAV_SOURCE_SPEED);
+    
+    NimBLEAddress phone("AA:AA:AA:AA:AA:01");
+    NimBLEAddress sensor("BB:BB:BB:BB:BB:02");
+    NimBLEAddress peer;
+    
+    // The sensor connects after the phone and keeps streaming
+    bleServer.handleConnect(1, &phone, 0);
+    bleServer.handleConnect(2, &sensor, 50);
+    TEST_ASSERT_FALSE_MESSAGE(bleServer.getReconnectPeer(peer), "A bare connection should not pick a target");
+    
+    const uint8_t speed[2] = {0x20, 0x03};
+    bleServer.enqueueWrite(2, 12, speed, sizeof(speed), 60);
+    bleServer.enqueueWrite(1, 10, MOCK_NAV_DATA, MOCK_NAV_SIZE, 60);
+    bleServer.enqueueWrite(2, 12, speed, sizeof(speed), 70);
+    bleServer.update(70);
+    TEST_ASSERT_TRUE(bleServer.getReconnectPeer(peer));
+    TEST_ASSERT_TRUE_MESSAGE(peer == phone, "The navigation link should be the target");
+    
+    // Phone drops first, then the sensor: the burst goes to the phone
+    bleServer.handleDisconnect(1, 1000);
+    TEST_ASSERT_EQUAL_INT_MESSAGE(ADV_FAST, bleServer.getAdvertisingPhase(), "Sensor still linked: open advertising");
+    bleServer.enqueueWrite(2, 12, speed, sizeof(speed), 1100);
+    bleServer.update(1100);
+    bleServer.handleDisconnect(2, 1200);
+    TEST_ASSERT_EQUAL_INT_MESSAGE(ADV_DIRECTED, bleServer.getAdvertisingPhase(), "Last link gone: directed burst");
+    TEST_ASSERT_TRUE(bleServer.getReconnectPeer(peer));
+    TEST_ASSERT_TRUE_MESSAGE(peer == phone, "The burst should target the phone, not the sensor");
+}
+
+// The ingest task sleeps until a write or the next advertising/connection timer
+void test_ingest_task_deadlines() {
+    BLEServer bleServer;
+    bleServer.setReconnectPolicy(true, 3000);
+    TEST_ASSERT_EQUAL_UINT32_MESSAGE(BLE_TASK_NO_DEADLINE, bleServer.msUntilNextUpdate(0), "Idle server should sleep until an event");
+    
+    NimBLEAddress phone;
+    bleServer.handleConnect(1, &phone, 0);
+    TEST_ASSERT_EQUAL_UINT32_MESSAGE(BLE_TASK_CONNECTED_MS, bleServer.msUntilNextUpdate(0), "Connected: wake for the connection timers");
+    
+    // A queued write needs no wait; once decoded the timer step is back
+    bleServer.getDecoders().bindHandle(10, NAV_SOURCE_SYGIC);
+    TEST_ASSERT_TRUE(bleServer.enqueueWrite(1, 10, MOCK_NAV_DATA, MOCK_NAV_SIZE, 10));
+    TEST_ASSERT_EQUAL_UINT32_MESSAGE(0, bleServer.msUntilNextUpdate(10), "Queued write should be decoded without waiting");
+    bleServer.update(10);
+    TEST_ASSERT_TRUE_MESSAGE(bleServer.hasNewData(), "Write should be decoded by update()");
+    TEST_ASSERT_EQUAL_UINT32_MESSAGE(BLE_TASK_CONNECTED_MS, bleServer.msUntilNextUpdate(10), "Queue drained: back to the timer step");
+    
+    bleServer.handleDisconnect(1, 1000);
+    TEST_ASSERT_EQUAL_UINT32_MESSAGE(ADV_DIRECTED_WINDOW_MS - 200, bleServer.msUntilNextUpdate(1200), "Directed burst should end on time");
+    
+    bleServer.update(1000 + ADV_DIRECTED_WINDOW_MS);
+    TEST_ASSERT_EQUAL_UINT32_MESSAGE(3000, bleServer.msUntilNextUpdate(1000 + ADV_DIRECTED_WINDOW_MS), "Fast advertising lasts reconnectDelay");
+    TEST_ASSERT_EQUAL_UINT32_MESSAGE(0, bleServer.msUntilNextUpdate(1000 + ADV_DIRECTED_WINDOW_MS + 5000), "An overdue phase should run now");
+    
+    bleServer.update(1000 + ADV_DIRECTED_WINDOW_MS + 3000);
+    TEST_ASSERT_EQUAL_UINT32_MESSAGE(BLE_TASK_NO_DEADLINE, bleServer.msUntilNextUpdate(6000), "Slow advertising needs no timer");
+}
+
+// Test active/idle profile switching from packet flow
+void test_connection_policy_profiles() {
+    ConnectionPolicy policy;
+    ConnProfileId requested;
+    
+    TEST_ASSERT_FALSE_MESSAGE(policy.update(0, requested), "No switching while disconnected");
+    
+    policy.onConnect(1, 1000);
+    TEST_ASSERT_TRUE_MESSAGE(policy.update(1000, requested), "Connect should request a profile");
+    TEST_ASSERT_EQUAL_INT_MESSAGE(CONN_PROFILE_ACTIVE, requested, "New connections start active");
+    
+    // Packets keep flowing every second: stay active
+    for (uint32_t t = 2000; t <= 10000; t += 1000) {
+        policy.onPacket(t);
+        TEST_ASSERT_FALSE_MESSAGE(policy.update(t, requested), "Flowing packets should not switch");
+    }
+    
+    // Navigation stops: idle after CONN_IDLE_AFTER_MS
+    TEST_ASSERT_FALSE_MESSAGE(policy.update(10000 + CONN_IDLE_AFTER_MS - 1, requested), "Should stay active before timeout");
+    TEST_ASSERT_TRUE_MESSAGE(policy.update(10000 + CONN_IDLE_AFTER_MS, requested), "Should go idle after timeout");
+    TEST_ASSERT_EQUAL_INT_MESSAGE(CONN_PROFILE_IDLE, requested, "Quiet link should use idle profile");
+    
+    // First packet after idle switches back immediately
+    policy.onPacket(16000);
+    TEST_ASSERT_TRUE_MESSAGE(policy.update(16000, requested), "Packet should switch back to active");
+    TEST_ASSERT_EQUAL_INT_MESSAGE(CONN_PROFILE_ACTIVE, requested, "Navigation should use active profile");
+    TEST_ASSERT_EQUAL_INT_MESSAGE(2, policy.getStats().profileSwitches, "Two switches should be counted");
+    
+    policy.recordNegotiated(24, 0, 200);
+    policy.recordMtu(185);
+    TEST_ASSERT_FLOAT_WITHIN_MESSAGE(0.01, 30.0, policy.getStats().intervalMs(), "Interval should convert to ms");
+    TEST_ASSERT_EQUAL_INT_MESSAGE(185, policy.getStats().mtu, "Negotiated MTU should be exposed");
+}
+
+// A streaming sensor on a second link must not hold the phone's link active
+void test_connection_policy_ignores_sensor_link() {
+    BLEServer bleServer;
+    NavDecoderRegistry& registry = bleServer.getDecoders();
+    registry.bindHandle(10, NAV_SOURCE_SYGIC);
+    registry.bindHandle(12, NAV_SOURCE_SPEED);
+    
+    NimBLEAddress phone, sensor;
+    bleServer.handleConnect(1, &phone, 0);
+    bleServer.handleConnect(2, &sensor, 0);
+    bleServer.enqueueWrite(1, 10, MOCK_NAV_DATA, MOCK_NAV_SIZE, 100);
+    bleServer.update(100);
+    TEST_ASSERT_EQUAL_INT_MESSAGE(CONN_PROFILE_ACTIVE, bleServer.getConnectionStats().profile, "New link starts active");
+    
+    // Navigation goes quiet while the sensor keeps writing every 200 ms
+    const uint8_t speed[2] = {0x20, 0x03};
+    uint32_t now = 100;
+    for (; now <= 100 + CONN_IDLE_AFTER_MS + 1000; now += 200) {
+        bleServer.enqueueWrite(2, 12, speed, sizeof(speed), now);
+        bleServer.update(now);
+    }
+    TEST_ASSERT_EQUAL_INT_MESSAGE(CONN_PROFILE_IDLE, bleServer.getConnectionStats().profile, "Sensor traffic should not keep the phone link active");
+    
+    // Navigation resumes on the phone link
+    bleServer.enqueueWrite(1, 10, MOCK_NAV_DATA, MOCK_NAV_SIZE, now + CONN_MIN_HOLD_MS);
+    bleServer.update(now + CONN_MIN_HOLD_MS);
+    TEST_ASSERT_EQUAL_INT_MESSAGE(CONN_PROFILE_ACTIVE, bleServer.getConnectionStats().profile, "Navigation should switch back to active");
+    
+    // MTU exchanges on the sensor link do not overwrite the phone's
+    bleServer.handleMtuChange(2, 185);
+    TEST_ASSERT_EQUAL_INT_MESSAGE(23, bleServer.getConnectionStats().mtu, "Sensor MTU should be ignored");
+    bleServer.handleMtuChange(1, CONN_PREFERRED_MTU);
+    TEST_ASSERT_EQUAL_INT_MESSAGE(CONN_PREFERRED_MTU, bleServer.getConnectionStats().mtu, "Phone MTU should be recorded");
+}
+
+// Test that profile parameters respect the Apple accessory guidelines
+void test_connection_profile_limits() {
+    const ConnectionProfile* profiles[] = {&CONN_PROFILE_ACTIVE_PARAMS, &CONN_PROFILE_IDLE_PARAMS};
+    for (int i = 0; i < 2; i++) {
+        const ConnectionProfile& p = *profiles[i];
+        float maxMs = p.maxInterval * 1.25f;
+        float effectiveMs = maxMs * (p.latency + 1);
+        TEST_ASSERT_TRUE_MESSAGE(p.minInterval * 1.25f >= 15.0f, "Min interval should be at least 15 ms");
+        TEST_ASSERT_TRUE_MESSAGE(p.minInterval <= p.maxInterval, "Min interval should not exceed max");
+        TEST_ASSERT_TRUE_MESSAGE(effectiveMs <= 2000.0f, "Interval * (latency + 1) should be at most 2 s");
+        TEST_ASSERT_TRUE_MESSAGE(p.supervisionTimeout * 10.0f > 3 * effectiveMs, "Timeout should exceed 3 effective intervals");
+        TEST_ASSERT_TRUE_MESSAGE(p.supervisionTimeout * 10 <= 6000, "Timeout should be at most 6 s");
+    }
+    TEST_ASSERT_TRUE_MESSAGE(CONN_PROFILE_IDLE_PARAMS.maxInterval > CONN_PROFILE_ACTIVE_PARAMS.maxInterval, "Idle should use a longer interval");
+    TEST_ASSERT_TRUE_MESSAGE(CONN_PROFILE_IDLE_PARAMS.latency > 0, "Idle should allow peripheral latency");
+}
+
+// Test telemetry batching, percentiles and window deltas
+void test_telemetry_report() {
+    Telemetry telemetry;
+    telemetry.setInterval(1000);
+    TelemetryCounters counters = {0, 0, 0, 180000};
+    TelemetryPacket packet;
+    
+    // 90 fast frames (4 ms) and 10 slow frames (40 ms)
+    for (int i = 0; i < 90; i++) telemetry.recordFrame(4000, 16000);
+    for (int i = 0; i < 10; i++) telemetry.recordFrame(40000, 16000);
+    // Idle frames count toward timing but not toward SPI bytes per frame
+    for (int i = 0; i < 100; i++) telemetry.recordFrame(400, 0);
+    
+    TEST_ASSERT_FALSE_MESSAGE(telemetry.poll(999, counters, packet), "No report before the interval");
+    
+    counters.packetsReceived = 20;
+    counters.packetsDropped = 3;
+    counters.imuSamples = 200;
+    TEST_ASSERT_TRUE_MESSAGE(telemetry.poll(1000, counters, packet), "Report after the interval");
+    TEST_ASSERT_EQUAL_INT_MESSAGE(TELEMETRY_VERSION, packet.version, "Version should be set");
+    TEST_ASSERT_EQUAL_INT_MESSAGE(200, packet.frames, "All frames should be counted");
+    TEST_ASSERT_EQUAL_INT_MESSAGE(100, packet.framesDrawn, "Only frames with SPI traffic are drawn");
+    TEST_ASSERT_EQUAL_INT_MESSAGE(5, packet.frameP50, "p50 should be the idle frames' bin edge (0.1 ms units)");
+    TEST_ASSERT_EQUAL_INT_MESSAGE(45, packet.frameP95, "p95 should be the 4 ms bin edge");
+    TEST_ASSERT_EQUAL_INT_MESSAGE(400, packet.frameP99, "p99 should land in the slow frames");
+    TEST_ASSERT_EQUAL_INT_MESSAGE(400, packet.frameMax, "Max should be 40 ms");
+    TEST_ASSERT_EQUAL_INT_MESSAGE(2000, packet.spiBytesPerFrame, "SPI bytes per frame in 8-byte units");
+    TEST_ASSERT_EQUAL_INT_MESSAGE(3, packet.packetsDropped, "Dropped packets in window");
+    TEST_ASSERT_EQUAL_INT_MESSAGE(2000, packet.imuRate, "IMU rate should be 200 Hz in 0.1 Hz units");
+    TEST_ASSERT_EQUAL_INT_MESSAGE(22500, packet.heapLowWater, "Heap low-water in 8-byte units");
+    
+    // Next window reports deltas only
+    counters.packetsReceived = 25;
+    TEST_ASSERT_TRUE_MESSAGE(telemetry.poll(2000, counters, packet), "Second report");
+    TEST_ASSERT_EQUAL_INT_MESSAGE(1, packet.sequence, "Sequence should advance");
+    TEST_ASSERT_EQUAL_INT_MESSAGE(0, packet.frames, "Window should reset");
+    TEST_ASSERT_EQUAL_INT_MESSAGE(0, packet.spiBytesPerFrame, "No drawn frames, no SPI average");
+    TEST_ASSERT_EQUAL_INT_MESSAGE(5, packet.packetsReceived, "Counters should be per window");
+    TEST_ASSERT_EQUAL_INT_MESSAGE(0, packet.packetsDropped, "No new drops");
+    TEST_ASSERT_TRUE_MESSAGE(sizeof(TelemetryPacket) <= 20, "Packet should fit the default MTU");
+}
+
+// Minimal third-party protocol: [distance lo][distance hi]
+static bool parseTestPacket(void* context, const uint8_t* data, size_t length, NavigationData& nav) {
+    if (length < 2) return false;
+    if (context) (*static_cast<uint32_t*>(context))++;
+    nav.distance = data[0] | (data[1] << 8);
+    nav.isValid = true;
+    return true;
+}
+
+// Test registering a decoder and routing writes by ATT handle
+void test_decoder_registry_dispatch() {
+    BLEServer bleServer;
+    uint32_t calls = 0;
+    NavDecoder decoder = {"Test", "0000FFF0-0000-1000-8000-00805F9B34FB",
+                          "0000FFF1-0000-1000-8000-00805F9B34FB",
+                          NIMBLE_PROPERTY::WRITE, parseTestPacket, nullptr, &calls,
+                          NAV_PRIORITY_NAVIGATION};
+    
+    int id = bleServer.registerDecoder(decoder);
+    TEST_ASSERT_EQUAL_INT_MESSAGE(NAV_SOURCE_SPEED + 1, id, "Registered after the built-ins");
+    TEST_ASSERT_TRUE(bleServer.getDecoders().bindHandle(42, id));
+    
+    const uint8_t packet[] = {0x2C, 0x01}; // 300 m
+    bleServer.dispatchWrite(1, 42, packet, sizeof(packet), 0);
+    TEST_ASSERT_EQUAL_INT_MESSAGE(1, calls, "Handle should route to the registered decoder");
+    TEST_ASSERT_TRUE(bleServer.hasNewData());
+    TEST_ASSERT_EQUAL_INT(300, bleServer.getNavigationData().distance);
+    
+    // Unbound and out-of-range handles are ignored
+    bleServer.dispatchWrite(1, 43, packet, sizeof(packet), 0);
+    bleServer.dispatchWrite(1, 0xFFFF, packet, sizeof(packet), 0);
+    TEST_ASSERT_EQUAL_INT(1, calls);
+    TEST_ASSERT_FALSE(bleServer.hasNewData());
+    
+    // Registry capacity is fixed
+    NavDecoderRegistry registry;
+    for (int i = 0; i < NAV_MAX_DECODERS; i++) {
+        TEST_ASSERT_EQUAL_INT(i, registry.add(decoder));
+    }
+    TEST_ASSERT_EQUAL_INT_MESSAGE(-1, registry.add(decoder), "Full registry should reject");
+    TEST_ASSERT_FALSE(registry.bindHandle(NAV_MAX_ATT_HANDLE, 0));
+}
+
+// Benchmark handle dispatch as decoders are added; cost should stay flat
+void test_decoder_dispatch_benchmark() {
+    const int PACKETS = 2000;
+    const uint8_t packet[] = {0x10, 0x00};
+    char report[200];
+    int pos = snprintf(report, sizeof(report), "dispatch ns/packet by decoder count:");
+    
+    for (int decoderCount = 1; decoderCount <= NAV_MAX_DECODERS; decoderCount++) {
+        NavDecoderRegistry registry;
+        uint32_t calls[NAV_MAX_DECODERS] = {0};
+        for (int i = 0; i < decoderCount; i++) {
+            NavDecoder decoder = {"Bench", "", "", 0, parseTestPacket, nullptr, &calls[i],
+                                  NAV_PRIORITY_NAVIGATION};
+            registry.add(decoder);
+            registry.bindHandle(3 + i * 4, i); // Spread like real GATT tables
+        }
+        
+        // Always hit the most recently registered decoder (worst case for a linear scan)
+        uint16_t handle = 3 + (decoderCount - 1) * 4;
+        NavigationData nav;
+        unsigned long start = micros();
+        for (int n = 0; n < PACKETS; n++) {
+            const NavDecoder* decoder = registry.get(registry.lookup(handle));
+            decoder->parse(decoder->context, packet, sizeof(packet), nav);
+        }
+        unsigned long elapsed = micros() - start;
+        
+        TEST_ASSERT_EQUAL_INT_MESSAGE(PACKETS, calls[decoderCount - 1], "Every packet should reach its decoder");
+        pos += snprintf(report + pos, sizeof(report) - pos, " %d=%lu", decoderCount,
+                        elapsed * 1000UL / PACKETS);
+    }
+    TEST_MESSAGE(report);
+}
+
+// Load test: phone, chatty speed sensor and a third central at once
+void test_multi_connection_fair_ingest() {
+    BLEServer bleServer;
+    NimBLEAddress phone, sensor, extra;
+    uint32_t navCalls = 0, extraCalls = 0;
+    
+    // Stand-in decoders on fixed ATT handles for the three centrals
+    NavDecoder nav = {"Nav", "", "", 0, parseTestPacket, nullptr, &navCalls, NAV_PRIORITY_NAVIGATION};
+    NavDecoder other = {"Other", "", "", 0, parseTestPacket, nullptr, &extraCalls, 1};
+    NavDecoderRegistry& registry = bleServer.getDecoders();
+    registry.bindHandle(10, bleServer.registerDecoder(nav));
+    registry.bindHandle(12, NAV_SOURCE_SPEED);
+    registry.bindHandle(14, bleServer.registerDecoder(other));
+    
+    bleServer.handleConnect(1, &phone, 0);
+    bleServer.handleConnect(2, &sensor, 0);
+    TEST_ASSERT_EQUAL_INT_MESSAGE(ADV_SLOW, bleServer.getAdvertisingPhase(), "Third slot free: keep advertising");
+    bleServer.handleConnect(3, &extra, 0);
+    TEST_ASSERT_EQUAL_INT_MESSAGE(3, bleServer.getConnectionCount(), "Three simultaneous connections");
+    TEST_ASSERT_EQUAL_INT_MESSAGE(ADV_OFF, bleServer.getAdvertisingPhase(), "All slots used: advertising stops");
+    
+    // 1 s at 50 ms ticks: phone sends 1 update per tick, the sensor floods
+    // 12 per tick, the extra central 2 per tick
+    const int TICKS = 20;
+    uint32_t maxNavLatency = 0;
+    for (int tick = 0; tick < TICKS; tick++) {
+        uint32_t now = tick * 50;
+        uint8_t speed[2] = {(uint8_t)(tick * 5), 0};
+        for (int i = 0; i < 12; i++) {
+            bleServer.enqueueWrite(2, 12, speed, sizeof(speed), now);
+        }
+        uint8_t distance[2] = {(uint8_t)(200 - tick), 0};
+        bleServer.enqueueWrite(1, 10, distance, sizeof(distance), now);
+        bleServer.enqueueWrite(3, 14, distance, sizeof(distance), now);
+        bleServer.enqueueWrite(3, 14, distance, sizeof(distance), now);
+        
+        // The ingest task drains up to INGEST_BUDGET packets per update
+        uint32_t before = navCalls;
+        bleServer.update(now + 1);
+        if (navCalls == before) maxNavLatency += 50;
+    }
+    
+    const IngestStats* navStats = bleServer.getIngestStats(1);
+    const IngestStats* sensorStats = bleServer.getIngestStats(2);
+    const IngestStats* extraStats = bleServer.getIngestStats(3);
+    TEST_ASSERT_NOT_NULL(navStats);
+    TEST_ASSERT_EQUAL_INT_MESSAGE(TICKS, navCalls, "Every navigation update should be decoded");
+    TEST_ASSERT_EQUAL_INT_MESSAGE(0, navStats->overflowed, "Navigation queue should never overflow");
+    TEST_ASSERT_EQUAL_INT_MESSAGE(0, maxNavLatency, "Navigation should be handled on the tick it arrived");
+    TEST_ASSERT_TRUE_MESSAGE(sensorStats->delivered >= TICKS, "Freshest sensor reading should be decoded every tick");
+    TEST_ASSERT_TRUE_MESSAGE(sensorStats->superseded > 0, "Sensor flood should be collapsed to the newest reading");
+    TEST_ASSERT_TRUE_MESSAGE(extraStats->delivered > 0, "Low priority sources should still progress");
+    
+    char report[160];
+    snprintf(report, sizeof(report),
+             "nav delivered=%u maxWait=%ums | sensor delivered=%u superseded=%u | extra delivered=%u maxWait=%ums",
+             navStats->delivered, navStats->maxWaitMs, sensorStats->delivered,
+             sensorStats->superseded, extraStats->delivered, extraStats->maxWaitMs);
+    TEST_MESSAGE(report);
+    
+    // Phone leaves: the other links stay up and advertising resumes
+    bleServer.handleDisconnect(1, 2000);
+    TEST_ASSERT_TRUE_MESSAGE(bleServer.isConnected(), "Remaining links keep the server connected");
+    TEST_ASSERT_EQUAL_INT_MESSAGE(ADV_FAST, bleServer.getAdvertisingPhase(), "Freed slot should advertise fast");
+    TEST_ASSERT_NULL(bleServer.getIngestStats(1));
+}
+
+// A phone that also writes speed: v2 deltas queued behind speed readings
+// on the same connection must all be decoded, in order
+void test_ingest_keeps_navigation_behind_sensor() {
+    BLEServer bleServer;
+    NimBLEAddress phone;
+    NavDecoderRegistry& registry = bleServer.getDecoders();
+    registry.bindHandle(10, NAV_SOURCE_V2);
+    registry.bindHandle(12, NAV_SOURCE_SPEED);
+    bleServer.handleConnect(1, &phone, 0);
+    
+    NavV2Encoder encoder;
+    NavigationData nav;
+    nav.distance = 500;
+    nav.turnDirection = NAV_TURN_LEFT;
+    uint8_t packet[NAV_V2_MAX_PACKET];
+    size_t length = encoder.encode(nav, packet, sizeof(packet), true);
+    bleServer.enqueueWrite(1, 10, packet, length, 0);
+    
+    // speed, speed, delta, speed, delta, ... all queued before one update
+    for (int i = 1; i <= 4; i++) {
+        uint8_t speed[2] = {(uint8_t)(i * 100), 0};
+        bleServer.enqueueWrite(1, 12, speed, sizeof(speed), 0);
+        bleServer.enqueueWrite(1, 12, speed, sizeof(speed), 0);
+        nav.distance -= 25;
+        length = encoder.encode(nav, packet, sizeof(packet));
+        TEST_ASSERT_TRUE(bleServer.enqueueWrite(1, 10, packet, length, 0));
+    }
+    uint8_t speed[2] = {0x20, 0x03};  // 80 km/h
+    bleServer.enqueueWrite(1, 12, speed, sizeof(speed), 0);
+    bleServer.enqueueWrite(1, 12, speed, sizeof(speed), 0);
+    
+    for (int i = 0; i < 4; i++) {
+        bleServer.update(1);
+    }
+    
+    const IngestStats* stats = bleServer.getIngestStats(1);
+    TEST_ASSERT_EQUAL_INT_MESSAGE(0, stats->overflowed, "Queue should hold the whole burst");
+    TEST_ASSERT_EQUAL_INT_MESSAGE(5, stats->superseded, "Only the earlier reading of each pair is skipped");
+    TEST_ASSERT_EQUAL_INT(stats->enqueued - stats->superseded, stats->delivered);
+    
+    NavigationData shown = bleServer.getNavigationData();
+    TEST_ASSERT_EQUAL_INT_MESSAGE(400, shown.distance, "Every v2 delta should be applied");
+    TEST_ASSERT_EQUAL_INT_MESSAGE(80, shown.currentSpeed, "Freshest speed reading wins");
+}
+
+// Test broadcast frame encoding, trimming and sequence tracking
+void test_broadcast_frame_roundtrip() {
+    NavigationData nav;
+    nav.distance = 1250;
+    nav.turnDirection = NAV_TURN_RIGHT;
+    nav.speedLimit = 60;
+    nav.currentSpeed = 57;
+    nav.etaSeconds = 845;
+    nav.streetName = "Avenida Brigadeiro Faria Lima";
+    
+    NavBroadcastEncoder encoder;
+    NavBroadcastReceiver receiver;
+    uint8_t frame[NAV_BCAST_MAX_FRAME];
+    size_t length = encoder.encode(nav, frame, sizeof(frame));
+    TEST_ASSERT_TRUE_MESSAGE(length > NAV_BCAST_HEADER && length <= NAV_BCAST_MAX_FRAME, "Frame should fit legacy advertising");
+    
+    NavigationData out;
+    TEST_ASSERT_TRUE(receiver.onManufacturerData(frame, length, out));
+    TEST_ASSERT_EQUAL_INT(1250, out.distance);
+    TEST_ASSERT_EQUAL_INT(NAV_TURN_RIGHT, out.turnDirection);
+    TEST_ASSERT_EQUAL_INT(57, out.currentSpeed);
+    TEST_ASSERT_EQUAL_INT(845, out.etaSeconds);
+    TEST_ASSERT_TRUE_MESSAGE(out.streetName.length() > 0, "Street should be kept as far as it fits");
+    TEST_ASSERT_TRUE_MESSAGE(nav.streetName.indexOf(out.streetName) == 0, "Street should be a trimmed prefix");
+    
+    // Repeats are duplicates; a skipped sequence counts as missed
+    TEST_ASSERT_FALSE(receiver.onManufacturerData(frame, length, out));
+    encoder.encode(nav, frame, sizeof(frame));
+    length = encoder.encode(nav, frame, sizeof(frame));
+    TEST_ASSERT_TRUE(receiver.onManufacturerData(frame, length, out));
+    TEST_ASSERT_EQUAL_INT(1, receiver.getStats().duplicates);
+    TEST_ASSERT_EQUAL_INT(1, receiver.getStats().missed);
+    
+    // Other manufacturers' data is ignored
+    frame[2] = 0x00;
+    TEST_ASSERT_FALSE(receiver.onManufacturerData(frame, length, out));
+    TEST_ASSERT_EQUAL_INT(1, receiver.getStats().invalid);
+}
+
+// Simulated air: one broadcasting HUD, N passive receivers
+static uint32_t simRandom(uint32_t& state) {
+    state ^= state << 13;
+    state ^= state >> 17;
+    state ^= state << 5;
+    return state;
+}
+
+struct BroadcastSimResult {
+    uint32_t published;
+    uint32_t lost;           // Frames a receiver never saw
+    float meanLatencyMs;
+    uint32_t maxLatencyMs;
+};
+
+static BroadcastSimResult simulateBroadcast(int receivers) {
+    const uint32_t DURATION_MS = 20000;
+    const uint32_t UPDATE_MS = 200;            // Phone sends 5 updates/s
+    const uint32_t ADV_MS = NAV_BCAST_ADV_INTERVAL * 625 / 1000;
+    const uint32_t SCAN_MS = NAV_BCAST_SCAN_INTERVAL * 625 / 1000;
+    const uint32_t CHANNEL_SWITCH_MS = 2;      // Receiver deaf while retuning
+    const uint32_t LOSS_PER_MILLE = 50;        // 5% packet error per copy
+    
+    // The sender relies on the 32 KB loop task stack (see test_main.cpp);
+    // the per-frame bookkeeping is static and cleared on every run
+    BLEServer sender;
+    sender.setBroadcastEnabled(true);
+    
+    static NavBroadcastReceiver rx[8];
+    static uint32_t publishMs[256];
+    static bool seen[8][256];
+    uint32_t rng[8];
+    for (int r = 0; r < 8; r++) rx[r] = NavBroadcastReceiver();
+    for (int r = 0; r < receivers; r++) rng[r] = 0x9E3779B9u * (r + 1);
+    memset(publishMs, 0, sizeof(publishMs));
+    memset(seen, 0, sizeof(seen));
+    uint32_t advRng = 12345;
+    uint32_t published = 0, delivered = 0, latencySum = 0, latencyMax = 0;
+    uint8_t sequence = 0;
+    
+    uint32_t nextUpdate = 0;
+    uint32_t nextAdv = 0;
+    for (uint32_t now = 0; now < DURATION_MS; now++) {
+        if (now == nextUpdate) {
+            uint8_t packet[7] = {0x01, 0x00, 60, 0x02, '3', '0', '0'};
+            packet[6] = '0' + (published % 10);
+            sender.injectPacket(packet, sizeof(packet));
+            sender.getNavigationData();
+            sequence = published & 0xFF;
+            publishMs[sequence] = now;
+            for (int r = 0; r < receivers; r++) seen[r][sequence] = false;
+            published++;
+            nextUpdate += UPDATE_MS;
+        }
+        if (now != nextAdv) continue;
+        nextAdv += ADV_MS + simRandom(advRng) % 11; // advDelay 0-10 ms
+        
+        size_t length;
+        const uint8_t* frame = sender.getBroadcastFrame(length);
+        for (int r = 0; r < receivers; r++) {
+            // Each receiver listens on one channel per scan interval; the
+            // event covers all three, so only retune gaps and errors lose it
+            uint32_t phase = (now + r * 7) % SCAN_MS;
+            if (phase < CHANNEL_SWITCH_MS) continue;
+            if (simRandom(rng[r]) % 1000 < LOSS_PER_MILLE) continue;
+            
+            NavigationData nav;
+            if (rx[r].onManufacturerData(frame, length, nav)) {
+                seen[r][sequence] = true;
+                uint32_t latency = now - publishMs[sequence];
+                latencySum += latency;
+                if (latency > latencyMax) latencyMax = latency;
+                delivered++;
+            }
+        }
+    }
+    
+    BroadcastSimResult result;
+    result.published = published;
+    result.lost = published * receivers - delivered;
+    result.meanLatencyMs = delivered ? (float)latencySum / delivered : 0;
+    result.maxLatencyMs = latencyMax;
+    return result;
+}
+
+// Latency and loss with 1, 4 and 8 receivers
+void test_broadcast_latency_loss() {
+    const int COUNTS[] = {1, 4, 8};
+    char report[200];
+    int pos = snprintf(report, sizeof(report), "broadcast receivers:");
+    
+    for (int count : COUNTS) {
+        BroadcastSimResult result = simulateBroadcast(count);
+        float lossPct = 100.0f * result.lost / (result.published * count);
+        pos += snprintf(report + pos, sizeof(report) - pos, " [%d: loss %.2f%% mean %.1fms max %ums]",
+                        count, lossPct, result.meanLatencyMs, result.maxLatencyMs);
+        
+        // ~2 copies per frame at 5% error + retune gaps: a few % of frames lost
+        TEST_ASSERT_TRUE_MESSAGE(lossPct < 5.0f, "Repeated advertising should keep frame loss under 5%");
+        TEST_ASSERT_TRUE_MESSAGE(result.meanLatencyMs < NAV_BCAST_ADV_INTERVAL * 0.625f, "Mean latency should stay under one advertising interval");
+        TEST_ASSERT_TRUE_MESSAGE(result.maxLatencyMs < 200, "A received frame should arrive before the next update");
+    }
+    TEST_MESSAGE(report);
+}
+
 // Main test runner for BLE module
 void run_ble_tests() {
     RUN_TEST(test_ble_server_initialization);
@@ -126,4 +1042,28 @@ void run_ble_tests() {
     RUN_TEST(test_turn_direction_mapping);
     RUN_TEST(test_ble_service_uuid);
     RUN_TEST(test_data_packet_validation);
+    RUN_TEST(test_packet_log_roundtrip);
+    RUN_TEST(test_packet_replay_accelerated);
+    RUN_TEST(test_packet_replay_truncated);
+    RUN_TEST(test_packet_replay_deterministic);
+    RUN_TEST(test_protocol_v2_roundtrip);
+    RUN_TEST(test_protocol_v2_delta);
+    RUN_TEST(test_protocol_v2_extension_skip);
+    RUN_TEST(test_protocol_v2_delta_base);
+    RUN_TEST(test_protocol_v2_street_utf8);
+    RUN_TEST(test_protocol_benchmark);
+    RUN_TEST(test_fast_reconnect_cached_navigation);
+    RUN_TEST(test_reconnect_without_auto_connect);
+    RUN_TEST(test_reconnect_targets_navigation_peer);
+    RUN_TEST(test_ingest_task_deadlines);
+    RUN_TEST(test_connection_policy_profiles);
+    RUN_TEST(test_connection_policy_ignores_sensor_link);
+    RUN_TEST(test_connection_profile_limits);
+    RUN_TEST(test_telemetry_report);
+    RUN_TEST(test_decoder_registry_dispatch);
+    RUN_TEST(test_decoder_dispatch_benchmark);
+    RUN_TEST(test_multi_connection_fair_ingest);
+    RUN_TEST(test_ingest_keeps_navigation_behind_sensor);
+    RUN_TEST(test_broadcast_frame_roundtrip);
+    RUN_TEST(test_broadcast_latency_loss);
 }
\ No newline at end of file
@@ -0,0 +1,293 @@
+#include <unity.h>
+#include <Arduino.h>
+#include "../src/bus/i2c_bus.h"
+#include "fakes/fake_i2c_driver.h"
+
+#define TEST_IMU_ADDR     0x6B
+#define TEST_TOUCH_ADDR   0x38
+#define TEST_RTC_ADDR     0x51
+
+// Auto-increment register file: tx[0] selects the register, the rest of
+// tx is written from there, reads continue from there
+struct FakeRegisters {
+    uint8_t regs[256];
+};
+
+static bool registerDevice(void* context, const uint8_t* tx, size_t txLen, uint8_t* rx, size_t rxLen) {
+    FakeRegisters* dev = static_cast<FakeRegisters*>(context);
+    if (txLen == 0) return false;
+    uint8_t reg = tx[0];
+    for (size_t i = 1; i < txLen; i++) dev->regs[reg++] = tx[i];
+    for (size_t i = 0; i < rxLen; i++) rx[i] = dev->regs[reg++];
+    return true;
+}
+
+// Completion order across callbacks
+struct CompletionLog {
+    char order[16];
+    uint8_t count;
+    uint8_t failures;
+};
+
+struct CompletionTag {
+    CompletionLog* log;
+    char tag;
+};
+
+static void logCompletion(void* context, bool ok) {
+    CompletionTag* t = static_cast<CompletionTag*>(context);
+    t->log->order[t->log->count++] = t->tag;
+    if (!ok) t->log->failures++;
+}
+
+// Test strict priority between classes and FIFO order within a class
+void test_bus_priority_order() {
+    FakeI2CDriver fake;
+    fake.addDevice(TEST_IMU_ADDR);
+    fake.addDevice(TEST_TOUCH_ADDR);
+    fake.addDevice(TEST_RTC_ADDR);
+    I2CBus bus(&fake);
+    TEST_ASSERT_TRUE(bus.begin());
+
+    CompletionLog log = {};
+    CompletionTag rtc = {&log, 'r'}, touch1 = {&log, 't'}, touch2 = {&log, 'u'}, imu = {&log, 'i'};
+    uint8_t reg = 0, rx[7];
+    TEST_ASSERT_TRUE(bus.submit(TEST_RTC_ADDR, &reg, 1, rx, 7, I2C_PRIORITY_RTC, logCompletion, &rtc));
+    TEST_ASSERT_TRUE(bus.submit(TEST_TOUCH_ADDR, &reg, 1, rx, 7, I2C_PRIORITY_TOUCH, logCompletion, &touch1));
+    TEST_ASSERT_TRUE(bus.submit(TEST_TOUCH_ADDR, &reg, 1, rx, 7, I2C_PRIORITY_TOUCH, logCompletion, &touch2));
+    TEST_ASSERT_TRUE(bus.submit(TEST_IMU_ADDR, &reg, 1, rx, 7, I2C_PRIORITY_IMU, logCompletion, &imu));
+    TEST_ASSERT_EQUAL_INT(2, bus.pending(I2C_PRIORITY_TOUCH));
+
+    // submit() only queues: nothing on the wire yet
+    TEST_ASSERT_EQUAL_UINT32_MESSAGE(0, fake.getTransactions(), "submit() must not block on the bus");
+    TEST_ASSERT_EQUAL_INT(0, log.count);
+
+    while (bus.runOnce()) {
+    }
+    log.order[log.count] = '\0';
+    TEST_ASSERT_EQUAL_STRING_MESSAGE("itur", log.order, "IMU, then touch in order, then RTC");
+    TEST_ASSERT_EQUAL_INT(0, log.failures);
+    TEST_ASSERT_FALSE_MESSAGE(bus.runOnce(), "runOnce() should report an idle bus");
+}
+
+// Test full queues and oversized writes are refused without a callback
+void test_bus_queue_limits() {
+    FakeI2CDriver fake;
+    fake.addDevice(TEST_TOUCH_ADDR);
+    I2CBus bus(&fake);
+    bus.begin();
+
+    CompletionLog log = {};
+    CompletionTag tag = {&log, 't'};
+    uint8_t reg = 0, rx[2];
+    for (int i = 0; i < I2C_BUS_QUEUE_DEPTH; i++) {
+        TEST_ASSERT_TRUE(bus.submit(TEST_TOUCH_ADDR, &reg, 1, rx, 2, I2C_PRIORITY_TOUCH, logCompletion, &tag));
+    }
+    TEST_ASSERT_FALSE_MESSAGE(bus.submit(TEST_TOUCH_ADDR, &reg, 1, rx, 2, I2C_PRIORITY_TOUCH, logCompletion, &tag),
+                              "A full class should refuse new transactions");
+    TEST_ASSERT_TRUE_MESSAGE(bus.submit(TEST_TOUCH_ADDR, &reg, 1, rx, 2, I2C_PRIORITY_RTC),
+                             "Other classes keep their own queues");
+
+    uint8_t big[I2C_BUS_MAX_TX + 1] = {0};
+    TEST_ASSERT_FALSE(bus.submit(TEST_TOUCH_ADDR, big, sizeof(big), nullptr, 0, I2C_PRIORITY_RTC));
+
+    while (bus.runOnce()) {
+    }
+    TEST_ASSERT_EQUAL_INT(I2C_BUS_QUEUE_DEPTH, log.count);
+    TEST_ASSERT_EQUAL_UINT32(1, bus.getStats(I2C_PRIORITY_TOUCH).rejected);
+    TEST_ASSERT_EQUAL_UINT32(I2C_BUS_QUEUE_DEPTH, bus.getStats(I2C_PRIORITY_TOUCH).completed);
+}
+
+// Test a missing device fails its own transaction only
+void test_bus_nak() {
+    FakeI2CDriver fake;
+    FakeRegisters imuRegs = {};
+    imuRegs.regs[0x00] = 0x05;
+    fake.addDevice(TEST_IMU_ADDR, registerDevice, &imuRegs);
+    I2CBus bus(&fake);
+    bus.begin();
+
+    uint8_t value = 0;
+    TEST_ASSERT_FALSE_MESSAGE(bus.readRegisters(TEST_RTC_ADDR, 0x04, &value, 1, I2C_PRIORITY_RTC),
+                              "An absent RTC should NAK");
+    TEST_ASSERT_TRUE(bus.readRegisters(TEST_IMU_ADDR, 0x00, &value, 1, I2C_PRIORITY_IMU));
+    TEST_ASSERT_EQUAL_HEX8(0x05, value);
+    TEST_ASSERT_EQUAL_UINT32(1, bus.getStats(I2C_PRIORITY_RTC).errors);
+    TEST_ASSERT_EQUAL_UINT32(0, bus.getStats(I2C_PRIORITY_IMU).errors);
+}
+
+// Test the fake's timing model against hand-counted clocks at 400 kHz
+void test_bus_fake_timing() {
+    FakeI2CDriver fake(0);
+    fake.addDevice(TEST_IMU_ADDR);
+    fake.begin(I2C_BUS_SDA, I2C_BUS_SCL, 400000);
+
+    // Register write: S + addr + reg + value + P = 29 clocks, 2.5 us each
+    TEST_ASSERT_EQUAL_UINT32(73, fake.transactionUs(2, 0));
+    // FIFO chunk: S + addr + reg, Sr + addr + 120 bytes, P = 1110 clocks
+    TEST_ASSERT_EQUAL_UINT32(2775, fake.transactionUs(1, 120));
+
+    uint8_t reg = 0, rx[120];
+    uint32_t before = fake.nowUs();
+    fake.transfer(TEST_IMU_ADDR, &reg, 1, rx, sizeof(rx));
+    TEST_ASSERT_EQUAL_UINT32_MESSAGE(2775, fake.nowUs() - before, "The clock should advance by the wire time");
+    fake.advance(1000);
+    TEST_ASSERT_EQUAL_UINT32(2775 + 1000, fake.nowUs() - before);
+}
+
+// --- Worst-case latency per client ---
+
+#define SIM_DURATION_US     10000000
+#define SIM_IMU_PERIOD_US   35684       // Half a watermark batch at 224.2 Hz
+#define SIM_TOUCH_PERIOD_US 10000       // 100 Hz touch report
+#define SIM_RTC_PERIOD_US   1000000     // Clock refresh once a second
+
+// One client's request stream; latency is measured from when the request
+// arose, which can be mid-transaction, to completion
+struct SimClient {
+    FakeI2CDriver* fake;
+    I2CBus* bus;
+    uint32_t arrivalUs;
+    uint32_t maxLatencyUs;
+    uint32_t requests;
+    uint8_t step;            // IMU drain: transaction within the batch
+    uint8_t rx[120];
+};
+
+static void simComplete(void* context, bool ok) {
+    SimClient* c = static_cast<SimClient*>(context);
+    c->maxLatencyUs = max(c->maxLatencyUs, c->fake->nowUs() - c->arrivalUs);
+}
+
+// IMU FIFO drain as IMUHandler issues it: status/count read, then the
+// batch in IMU_FIFO_CHUNK bursts, each queued when the previous completes
+static const uint8_t simDrainReads[] = {3, 120, 72};
+
+static void simDrainStep(void* context, bool ok) {
+    SimClient* c = static_cast<SimClient*>(context);
+    if (++c->step < sizeof(simDrainReads)) {
+        uint8_t reg = 0x17;
+        c->bus->submit(TEST_IMU_ADDR, &reg, 1, c->rx, simDrainReads[c->step], I2C_PRIORITY_IMU,
+                       simDrainStep, c);
+        return;
+    }
+    simComplete(context, ok);
+}
+
+void test_bus_worst_case_latency() {
+    FakeI2CDriver fake;
+    fake.addDevice(TEST_IMU_ADDR);
+    fake.addDevice(TEST_TOUCH_ADDR);
+    fake.addDevice(TEST_RTC_ADDR);
+    I2CBus bus(&fake);
+    bus.begin();
+
+    SimClient imu = {&fake, &bus}, touch = {&fake, &bus}, rtc = {&fake, &bus};
+    uint32_t imuNext = 0, touchNext = 3000, rtcNext = 7000;
+    uint8_t reg = 0;
+
+    while (fake.nowUs() < SIM_DURATION_US) {
+        uint32_t now = fake.nowUs();
+        if (now >= imuNext) {
+            imu.arrivalUs = imuNext;
+            imu.step = 0;
+            imu.requests++;
+            bus.submit(TEST_IMU_ADDR, &reg, 1, imu.rx, simDrainReads[0], I2C_PRIORITY_IMU, simDrainStep, &imu);
+            imuNext += SIM_IMU_PERIOD_US;
+        }
+        if (now >= touchNext) {
+            touch.arrivalUs = touchNext;
+            touch.requests++;
+            bus.submit(TEST_TOUCH_ADDR, &reg, 1, touch.rx, 7, I2C_PRIORITY_TOUCH, simComplete, &touch);
+            touchNext += SIM_TOUCH_PERIOD_US;
+        }
+        if (now >= rtcNext) {
+            rtc.arrivalUs = rtcNext;
+            rtc.requests++;
+            bus.submit(TEST_RTC_ADDR, &reg, 1, rtc.rx, 7, I2C_PRIORITY_RTC, simComplete, &rtc);
+            rtcNext += SIM_RTC_PERIOD_US;
+        }
+        if (!bus.runOnce()) {
+            uint32_t next = min(imuNext, min(touchNext, rtcNext));
+            fake.advance(next - now);
+        }
+    }
+
+    // Analytic bounds for a non-preemptive bus: wait for whatever is on
+    // the wire, then everything of higher priority, then run
+    uint32_t drainUs = 0;
+    for (uint8_t n : simDrainReads) drainUs += fake.transactionUs(1, n);
+    uint32_t touchUs = fake.transactionUs(1, 7);
+    uint32_t rtcUs = fake.transactionUs(1, 7);
+    uint32_t imuBound = max(touchUs, rtcUs) + drainUs;
+    uint32_t touchBound = drainUs + rtcUs + touchUs;
+    uint32_t rtcBound = drainUs + 2 * touchUs + rtcUs;
+
+    TEST_ASSERT_EQUAL_UINT32(SIM_DURATION_US / SIM_IMU_PERIOD_US + 1, imu.requests);
+    TEST_ASSERT_EQUAL_UINT32(0, bus.getStats(I2C_PRIORITY_IMU).rejected +
+                                bus.getStats(I2C_PRIORITY_TOUCH).rejected +
+                                bus.getStats(I2C_PRIORITY_RTC).rejected);
+    TEST_ASSERT_TRUE_MESSAGE(imu.maxLatencyUs <= imuBound, "IMU drain should wait for at most one lower-priority transaction");
+    TEST_ASSERT_TRUE_MESSAGE(imu.maxLatencyUs > drainUs, "The load should make the IMU wait at least once");
+    TEST_ASSERT_TRUE_MESSAGE(touch.maxLatencyUs <= touchBound, "Touch should wait for at most a drain and an RTC read");
+    TEST_ASSERT_TRUE_MESSAGE(rtc.maxLatencyUs <= rtcBound, "RTC latency should stay bounded under the load");
+
+    char report[160];
+    snprintf(report, sizeof(report),
+             "worst case: IMU drain %u us (bound %u), touch %u us (bound %u), RTC %u us (bound %u), bus %.1f%% busy",
+             imu.maxLatencyUs, imuBound, touch.maxLatencyUs, touchBound, rtc.maxLatencyUs, rtcBound,
+             fake.getBusyUs() * 100.0f / fake.nowUs());
+    TEST_MESSAGE(report);
+}
+
+// Test the worker task runs queued transactions and blocking transfers
+void test_bus_worker_task() {
+    FakeI2CDriver fake;
+    FakeRegisters touchRegs = {};
+    fake.addDevice(TEST_TOUCH_ADDR, registerDevice, &touchRegs);
+    I2CBus bus(&fake);
+    bus.begin();
+    TEST_ASSERT_TRUE(bus.startTask());
+
+    TEST_ASSERT_TRUE(bus.writeRegister(TEST_TOUCH_ADDR, 0x10, 0xA5, I2C_PRIORITY_TOUCH));
+    TEST_ASSERT_EQUAL_HEX8(0xA5, touchRegs.regs[0x10]);
+    uint8_t value = 0;
+    TEST_ASSERT_TRUE(bus.readRegisters(TEST_TOUCH_ADDR, 0x10, &value, 1, I2C_PRIORITY_TOUCH));
+    TEST_ASSERT_EQUAL_HEX8(0xA5, value);
+
+    // Fire-and-forget: the callback arrives from the worker
+    CompletionLog log = {};
+    CompletionTag tag = {&log, 't'};
+    uint8_t reg = 0x10, rx[1];
+    TEST_ASSERT_TRUE(bus.submit(TEST_TOUCH_ADDR, &reg, 1, rx, 1, I2C_PRIORITY_TOUCH, logCompletion, &tag));
+    for (int i = 0; i < 100 && log.count == 0; i++) {
+        delay(1);
+    }
+    TEST_ASSERT_EQUAL_INT_MESSAGE(1, log.count, "The worker should complete submitted transactions");
+
+    // Stopping with work queued: the worker finishes it, callbacks included
+    log.count = 0;
+    for (int i = 0; i < 4; i++) {
+        TEST_ASSERT_TRUE(bus.submit(TEST_TOUCH_ADDR, &reg, 1, rx, 1, I2C_PRIORITY_TOUCH, logCompletion, &tag));
+    }
+    bus.stopTask();
+    TEST_ASSERT_FALSE(bus.isTaskRunning());
+    TEST_ASSERT_EQUAL_INT_MESSAGE(4, log.count, "Queued transactions should complete before the worker exits");
+    TEST_ASSERT_EQUAL_UINT32(7, bus.getStats(I2C_PRIORITY_TOUCH).completed);
+
+    // No lock left behind: the bus keeps working inline, and restarts
+    TEST_ASSERT_TRUE(bus.readRegisters(TEST_TOUCH_ADDR, 0x10, &value, 1, I2C_PRIORITY_TOUCH));
+    TEST_ASSERT_TRUE(bus.startTask());
+    TEST_ASSERT_TRUE(bus.writeRegister(TEST_TOUCH_ADDR, 0x11, 0x5A, I2C_PRIORITY_TOUCH));
+    bus.stopTask();
+    TEST_ASSERT_EQUAL_HEX8(0x5A, touchRegs.regs[0x11]);
+}
+
+void run_bus_tests() {
+    RUN_TEST(test_bus_priority_order);
+    RUN_TEST(test_bus_queue_limits);
+    RUN_TEST(test_bus_nak);
+    RUN_TEST(test_bus_fake_timing);
+    RUN_TEST(test_bus_worst_case_latency);
+    RUN_TEST(test_bus_worker_task);
+}
@@ -1,6 +1,11 @@
 #include <unity.h>
 #include <Arduino.h>
 #include "../src/sensors/imu_handler.h"
+#include "../src/sensors/sensor_fusion.h"
+#include "../src/sensors/gyro_calibrator.h"
+#include "../src/sensors/gyro_temp_model.h"
+#include "../src/sensors/fixed_point.h"
+#include "../src/sensors/imu_filter.h"
 #include <math.h>
 
 // Test IMU constants and configuration
@@ -19,6 +24,11 @@ void test_imu_constants() {
     TEST_ASSERT_EQUAL_HEX8_MESSAGE(0x36, QMI8658_AX_H, "Accel X High register should be 0x36");
     TEST_ASSERT_EQUAL_HEX8_MESSAGE(0x3B, QMI8658_GX_L, "Gyro X Low register should be 0x3B");
     TEST_ASSERT_EQUAL_HEX8_MESSAGE(0x3C, QMI8658_GX_H, "Gyro X High register should be 0x3C");
+    
+    // Burst block: timestamp (3) + temperature (2) + accel (6) + gyro (6)
+    TEST_ASSERT_EQUAL_HEX8_MESSAGE(0x30, QMI8658_DATA_START, "Burst should start at the timestamp");
+    TEST_ASSERT_EQUAL_INT_MESSAGE(17, QMI8658_DATA_LEN, "Burst should cover 0x30-0x40");
+    TEST_ASSERT_FALSE_MESSAGE(QMI8658_CTRL1_ADDR_AI & QMI8658_CTRL1_BE, "Auto-increment and big-endian are separate bits");
 }
 
 // Test IMU data structure
@@ -221,7 +231,866 @@ void test_integration_timing() {
     TEST_ASSERT_FLOAT_WITHIN_MESSAGE(0.01, 0.45, rotationChange, "Rotation integration should be correct");
 }
 
+// Test that one sample costs a single I2C transaction (needs the sensor)
+void test_imu_burst_read() {
+    IMUHandler imu;
+    if (!imu.init()) {
+        TEST_IGNORE_MESSAGE("QMI8658 not detected");
+        return;
+    }
+    
+    const int SAMPLES = 100;
+    uint32_t before = imu.getI2CTransactions();
+    unsigned long start = micros();
+    for (int i = 0; i < SAMPLES; i++) {
+        TEST_ASSERT_TRUE_MESSAGE(imu.readData(), "Burst read should succeed");
+    }
+    unsigned long elapsed = micros() - start;
+    
+    TEST_ASSERT_EQUAL_INT_MESSAGE(SAMPLES, imu.getI2CTransactions() - before, "Each sample should be one transaction");
+    
+    IMUData data = imu.getData();
+    TEST_ASSERT_TRUE_MESSAGE(data.isValid, "Sample should be valid");
+    TEST_ASSERT_TRUE_MESSAGE(data.temperature > -40.0 && data.temperature < 85.0, "Temperature should be in the sensor range");
+    
+    char report[64];
+    snprintf(report, sizeof(report), "readData: %.1f us/sample, 1 transaction", (float)elapsed / SAMPLES);
+    TEST_MESSAGE(report);
+}
+
+// Test FIFO batching: a long frame loses no samples and bus cost is per batch
+void test_imu_fifo_batches() {
+    IMUHandler imu;
+    if (!imu.init()) {
+        TEST_IGNORE_MESSAGE("QMI8658 not detected");
+        return;
+    }
+    TEST_ASSERT_TRUE_MESSAGE(imu.enableFifo(), "FIFO should be configured");
+    
+    // A 300 ms render stall: ~67 samples wait in the 128-sample FIFO
+    delay(300);
+    uint32_t samplesBefore = imu.getSampleCount();
+    uint32_t transactionsBefore = imu.getI2CTransactions();
+    imu.update();
+    uint32_t samples = imu.getSampleCount() - samplesBefore;
+    uint32_t transactions = imu.getI2CTransactions() - transactionsBefore;
+    
+    const IMUFifoStats& stats = imu.getFifoStats();
+    TEST_ASSERT_TRUE_MESSAGE(samples >= IMU_FIFO_WATERMARK, "A whole batch should be drained at once");
+    TEST_ASSERT_EQUAL_INT_MESSAGE(0, stats.overflows, "No sample should be lost during the stall");
+    TEST_ASSERT_EQUAL_INT_MESSAGE(samples, stats.lastBatch, "Fusion should consume the whole batch");
+    TEST_ASSERT_TRUE_MESSAGE(imu.hasNewData(), "Batch should produce a new orientation");
+    TEST_ASSERT_TRUE_MESSAGE(transactions * 2 < samples, "Bus cost should scale with batches, not samples");
+    
+    char report[80];
+    snprintf(report, sizeof(report), "FIFO batch: %u samples in %u I2C transactions", samples, transactions);
+    TEST_MESSAGE(report);
+}
+
 // Main test runner for IMU module
+// Test the latest-value slot: readers see whole records, and only new ones
+void test_latest_value_slot() {
+    LatestValue<IMUOrientation> slot;
+    IMUOrientation out;
+    uint32_t version = 0;
+    
+    TEST_ASSERT_FALSE_MESSAGE(slot.read(out), "Empty slot should have nothing to read");
+    TEST_ASSERT_FALSE_MESSAGE(slot.readIfNewer(out, version), "Empty slot should have nothing new");
+    
+    IMUOrientation value = {45.0f, 30.0f, 1000, 10};
+    slot.publish(value);
+    TEST_ASSERT_TRUE_MESSAGE(slot.readIfNewer(out, version), "Published value should be new");
+    TEST_ASSERT_EQUAL_FLOAT(45.0f, out.rotation);
+    TEST_ASSERT_EQUAL_INT(10, out.sampleCount);
+    TEST_ASSERT_FALSE_MESSAGE(slot.readIfNewer(out, version), "Same value should not be new twice");
+    
+    // Only the newest of several publishes is kept
+    for (uint32_t i = 11; i <= 20; i++) {
+        value.sampleCount = i;
+        value.rotation = i * 2.0f;
+        slot.publish(value);
+    }
+    TEST_ASSERT_TRUE(slot.readIfNewer(out, version));
+    TEST_ASSERT_EQUAL_INT(20, out.sampleCount);
+    TEST_ASSERT_EQUAL_FLOAT(40.0f, out.rotation);
+    TEST_ASSERT_EQUAL_INT(11, slot.publishCount());
+}
+
+// Test rate and jitter statistics on a synthetic wake-up trace
+void test_imu_rate_meter() {
+    IMURateMeter meter;
+    IMURateStats stats;
+    const uint32_t PERIOD = 4000;
+    
+    meter.begin(PERIOD, 0);
+    
+    // 250 wake-ups alternating 100 us late and on time, 0.9 samples each
+    // (a 224 Hz sensor polled at 250 Hz), one iteration overrunning
+    uint32_t now = 0;
+    bool done = false;
+    for (int i = 1; i <= 250 && !done; i++) {
+        now = i * PERIOD + (i % 2 ? 100 : 0);
+        uint32_t samples = (i % 10 == 0) ? 0 : 1;
+        uint32_t busy = (i == 100) ? PERIOD + 1 : 200;
+        done = meter.record(now, busy, samples, stats);
+    }
+    
+    TEST_ASSERT_TRUE_MESSAGE(done, "A window should close after one second");
+    TEST_ASSERT_EQUAL_INT(PERIOD, stats.periodUs);
+    TEST_ASSERT_EQUAL_INT(250, stats.wakeups);
+    TEST_ASSERT_FLOAT_WITHIN_MESSAGE(1.0, 225.0, stats.sampleRateHz, "Rate should count samples, not wake-ups");
+    TEST_ASSERT_EQUAL_INT_MESSAGE(100, stats.jitterMaxUs, "Worst interval deviation");
+    TEST_ASSERT_FLOAT_WITHIN_MESSAGE(1.0, 100.0, stats.jitterRmsUs, "Every interval is 100 us off");
+    TEST_ASSERT_EQUAL_INT(1, stats.overruns);
+    
+    // The next window starts clean
+    TEST_ASSERT_FALSE(meter.record(now + PERIOD, 200, 1, stats));
+}
+
+// Test the sampling task keeps the sensor rate while the caller is busy
+void test_imu_task_rate() {
+    IMUHandler imu;
+    if (!imu.init()) {
+        TEST_IGNORE_MESSAGE("QMI8658 not detected");
+        return;
+    }
+    imu.enableFifo();
+    imu.setAdaptiveRate(false);   // A bench is still: hold the full rate
+    TEST_ASSERT_TRUE_MESSAGE(imu.startTask(), "Task should start");
+    TEST_ASSERT_FALSE_MESSAGE(imu.startTask(), "Task should only start once");
+    
+    // Stand in for slow frames: the task must keep up on its own
+    delay(IMU_STATS_WINDOW_US / 1000 * 2 + 100);
+    
+    IMURateStats stats;
+    IMUOrientation orientation;
+    uint32_t version = 0;
+    TEST_ASSERT_TRUE_MESSAGE(imu.getRateStats(stats), "A stats window should have closed");
+    TEST_ASSERT_TRUE_MESSAGE(imu.readOrientation(orientation, version), "Orientation should be published");
+    // A one-second window splits FIFO batches, so allow one batch either way
+    TEST_ASSERT_FLOAT_WITHIN_MESSAGE(IMU_FIFO_WATERMARK * 1.5f, IMU_ODR_HZ, stats.sampleRateHz, "Achieved rate should match the ODR");
+    TEST_ASSERT_TRUE_MESSAGE(stats.jitterMaxUs < stats.periodUs, "Wake-ups should never slip a whole period");
+    TEST_ASSERT_EQUAL_INT_MESSAGE(0, stats.overruns, "Processing should fit in the period");
+    
+    char report[96];
+    snprintf(report, sizeof(report), "IMU task: %.1f Hz, jitter max %u us rms %.1f us",
+             stats.sampleRateHz, stats.jitterMaxUs, stats.jitterRmsUs);
+    TEST_MESSAGE(report);
+}
+
+// --- Sensor fusion (synthetic traces at the sensor ODR) ---
+
+static uint32_t noiseState = 1;
+
+// Deterministic uniform noise in [-amplitude, amplitude]
+static float noise(float amplitude) {
+    noiseState = noiseState * 1664525 + 1013904223;
+    return ((noiseState >> 8) / 8388608.0f - 1.0f) * amplitude;
+}
+
+static float angleError(float a, float b) {
+    float d = fmodf(a - b + 540.0f, 360.0f) - 180.0f;
+    return fabsf(d);
+}
+
+// Test a still device: orientation holds and the gyro bias is learned
+void test_fusion_static_bias() {
+    SensorFusion fusion;
+    const float dt = 1.0f / IMU_ODR_HZ;
+    const float biasX = 0.8f, biasY = -0.6f, biasZ = 0.5f;
+    noiseState = 1;
+    
+    // Upright HUD: gravity along +X; two minutes at the ODR
+    float maxError = 0;
+    for (int i = 0; i < 120 * IMU_ODR_HZ; i++) {
+        fusion.update(biasX + noise(0.05f), biasY + noise(0.05f), biasZ + noise(0.05f),
+                      1.0f + noise(0.005f), noise(0.005f), noise(0.005f), dt);
+        maxError = max(maxError, angleError(fusion.getScreenRotation(), 0.0f));
+    }
+    
+    float bx, by, bz;
+    fusion.getGyroBias(bx, by, bz);
+    TEST_ASSERT_TRUE_MESSAGE(maxError < 1.0f, "Screen rotation should not drift with a biased gyro");
+    // Rotation about gravity (X here) is unobservable without a magnetometer
+    TEST_ASSERT_FLOAT_WITHIN_MESSAGE(0.1f, biasY, by, "Y bias should be estimated");
+    TEST_ASSERT_FLOAT_WITHIN_MESSAGE(0.1f, biasZ, bz, "Z bias should be estimated");
+    
+    EulerAngles e = fusion.getEuler();
+    TEST_ASSERT_FLOAT_WITHIN_MESSAGE(1.0f, -90.0f, e.pitch, "Gravity along +X is -90° pitch");
+}
+
+// Test turning the display in its own plane: rotation follows the gyro
+void test_fusion_rotation_tracking() {
+    SensorFusion fusion;
+    const float dt = 1.0f / IMU_ODR_HZ;
+    noiseState = 7;
+    
+    // Hold, quarter turn at 90°/s, hold, half turn back at 180°/s, hold
+    struct { float seconds; float rateDps; } segments[] = {
+        {1.0f, 0.0f}, {1.0f, 90.0f}, {1.0f, 0.0f}, {1.0f, -180.0f}, {2.0f, 0.0f}
+    };
+    
+    float theta = 0;   // Truth: gravity in the body frame is (cos, -sin, 0)
+    float maxError = 0;
+    for (auto& seg : segments) {
+        for (int i = 0; i < seg.seconds * IMU_ODR_HZ; i++) {
+            theta += seg.rateDps * dt;
+            float rad = theta * PI / 180.0f;
+            fusion.update(noise(0.05f), noise(0.05f), seg.rateDps + noise(0.05f),
+                          cosf(rad) + noise(0.005f), -sinf(rad) + noise(0.005f), noise(0.005f), dt);
+            float truth = fmodf(-theta + 720.0f, 360.0f);
+            maxError = max(maxError, angleError(fusion.getScreenRotation(), truth));
+        }
+    }
+    
+    TEST_ASSERT_TRUE_MESSAGE(maxError < 2.0f, "Rotation should track within 2° during turns");
+    TEST_ASSERT_FLOAT_WITHIN_MESSAGE(1.0f, 90.0f, fusion.getScreenRotation(), "Net turn of -90° leaves gravity at 90°");
+}
+
+// Test tilting the display back does not change its rotation, and a
+// pothole-sized vertical spike is rejected instead of read as tilt
+void test_fusion_tilt_and_shock() {
+    SensorFusion fusion;
+    const float dt = 1.0f / IMU_ODR_HZ;
+    noiseState = 11;
+    
+    // Tilt back 30° about Y at 30°/s: gravity goes from +X to (cos, 0, sin)
+    float phi = 0;
+    float maxError = 0;
+    for (int i = 0; i < 2 * IMU_ODR_HZ; i++) {
+        float rate = i < IMU_ODR_HZ ? 30.0f : 0.0f;
+        phi += rate * dt;
+        float rad = phi * PI / 180.0f;
+        fusion.update(noise(0.05f), rate + noise(0.05f), noise(0.05f),
+                      cosf(rad), noise(0.005f), sinf(rad), dt);
+        maxError = max(maxError, angleError(fusion.getScreenRotation(), 0.0f));
+    }
+    TEST_ASSERT_TRUE_MESSAGE(maxError < 1.0f, "Tilt should not leak into the display rotation");
+    
+    // 0.5 s of +1.5 g along Z on top of gravity
+    float rad = phi * PI / 180.0f;
+    float gx, gy, gz;
+    for (int i = 0; i < IMU_ODR_HZ / 2; i++) {
+        fusion.update(noise(0.05f), noise(0.05f), noise(0.05f),
+                      cosf(rad), noise(0.005f), sinf(rad) + 1.5f, dt);
+    }
+    fusion.getGravity(gx, gy, gz);
+    TEST_ASSERT_FLOAT_WITHIN_MESSAGE(0.02f, sinf(rad), gz, "Shock should not be taken as gravity");
+    TEST_ASSERT_TRUE_MESSAGE(angleError(fusion.getScreenRotation(), 0.0f) < 1.0f, "Shock should not rotate the display");
+}
+
+// Benchmark: fusion cost per sample against the stated budget
+void test_fusion_benchmark() {
+    SensorFusion fusion;
+    const int ITERATIONS = 20000;
+    float dt = 1.0f / IMU_ODR_HZ;
+    
+    unsigned long start = micros();
+    for (int i = 0; i < ITERATIONS; i++) {
+        fusion.update(0.5f, -0.2f, 10.0f, 0.99f, 0.05f, 0.1f, dt);
+    }
+    unsigned long elapsed = micros() - start;
+    float perUpdate = (float)elapsed / ITERATIONS;
+    
+    // Keep the result alive
+    TEST_ASSERT_TRUE(fusion.getQuaternion().w == fusion.getQuaternion().w);
+    TEST_ASSERT_TRUE_MESSAGE(perUpdate < FUSION_CPU_BUDGET_US, "Fusion should fit the per-sample budget");
+    
+    char report[96];
+    snprintf(report, sizeof(report), "Fusion: %.2f us/update, %.2f%% of a core at %.0f Hz",
+             perUpdate, perUpdate * IMU_ODR_HZ / 10000.0f, IMU_ODR_HZ);
+    TEST_MESSAGE(report);
+}
+
+// --- Fixed-point path ---
+
+// Test CORDIC atan2 over the full circle and a wide range of magnitudes
+void test_cordic_atan2() {
+    float maxError = 0;
+    const float magnitudes[] = {Q28_ONE * 2.0f, (float)Q28_ONE, Q28_ONE / 1024.0f};
+    
+    for (float magnitude : magnitudes) {
+        for (float deg = 0; deg < 360.0f; deg += 1.3f) {
+            float rad = deg * PI / 180.0f;
+            uint32_t angle = cordicAtan2((int32_t)(magnitude * sinf(rad)), (int32_t)(magnitude * cosf(rad)));
+            maxError = max(maxError, angleError(binaryAngleToDegrees(angle), deg));
+        }
+    }
+    TEST_ASSERT_TRUE_MESSAGE(maxError < 0.01f, "CORDIC atan2 should be within 0.01°");
+    
+    // Wrapping is integer overflow: 350° + 20° = 10°
+    uint32_t a = (uint32_t)(350.0f / BINARY_ANGLE_DEG);
+    uint32_t b = (uint32_t)(20.0f / BINARY_ANGLE_DEG);
+    TEST_ASSERT_FLOAT_WITHIN(0.001f, 10.0f, binaryAngleToDegrees(a + b));
+}
+
+// Test that accelerometer readings beyond the Q28 range clamp instead of wrapping
+void test_fixed_accel_range_limit() {
+    FixedGravityFilter fixed;
+    // ±16 g full scale, with a tolerance that accepts a 16 g reading
+    fixed.configure(1.0f / 64.0f, 1.0f / 2048.0f, IMU_ODR_HZ, FUSION_KP, 16.0f);
+    
+    // Unclamped, 32767 LSB would wrap to a negative Q28 value and flip the display
+    const int16_t accel[3] = {32767, 0, 0};
+    const int16_t gyro[3] = {0, 0, 0};
+    fixed.update(accel, gyro);
+    TEST_ASSERT_EQUAL_INT_MESSAGE(Q28_ACCEL_LIMIT, fixed.getGravity()[0], "16 g should clamp to the limit");
+    
+    for (int i = 0; i < 100; i++) fixed.update(accel, gyro);
+    TEST_ASSERT_EQUAL_INT_MESSAGE(Q28_ACCEL_LIMIT, fixed.getGravity()[0], "Blending at the limit should not wrap");
+    TEST_ASSERT_TRUE_MESSAGE(angleError(fixed.getRotationDegrees(), 0.0f) < 0.01f, "Rotation should stay at 0°");
+}
+
+// Raw QMI8658 sample of the turning trace (see test_fusion_rotation_tracking)
+// at index i; returns the true display rotation
+static float turnTraceSample(int i, int16_t accel[3], int16_t gyro[3]) {
+    const float odr = IMU_ODR_HZ;
+    float t = i / odr;
+    float rate = 0, theta = 0;
+    if (t < 1.0f)      { rate = 0;      theta = 0; }
+    else if (t < 2.0f) { rate = 90.0f;  theta = 90.0f * (t - 1.0f); }
+    else if (t < 3.0f) { rate = 0;      theta = 90.0f; }
+    else if (t < 4.0f) { rate = -180.0f; theta = 90.0f - 180.0f * (t - 3.0f); }
+    else               { rate = 0;      theta = -90.0f; }
+    
+    float rad = theta * PI / 180.0f;
+    accel[0] = (int16_t)lroundf((cosf(rad) + noise(0.005f)) * 16384.0f);
+    accel[1] = (int16_t)lroundf((-sinf(rad) + noise(0.005f)) * 16384.0f);
+    accel[2] = (int16_t)lroundf(noise(0.005f) * 16384.0f);
+    gyro[0] = (int16_t)lroundf(noise(0.05f) * 64.0f);
+    gyro[1] = (int16_t)lroundf(noise(0.05f) * 64.0f);
+    gyro[2] = (int16_t)lroundf((rate + noise(0.05f)) * 64.0f);
+    return fmodf(-theta + 720.0f, 360.0f);
+}
+
+// Benchmark: cycles per sample and accuracy of the float and integer paths
+// on the same raw trace, to pick one per build
+void test_fixed_vs_float_benchmark() {
+    const int SAMPLES = 6 * IMU_ODR_HZ;
+    const float accelScale = 1.0f / 16384.0f, gyroScale = 1.0f / 64.0f;
+    
+    SensorFusion fusion;
+    FixedGravityFilter fixed;
+    fixed.configure(gyroScale, accelScale, IMU_ODR_HZ, FUSION_KP, FUSION_ACCEL_TOLERANCE);
+    
+    float floatMax = 0, fixedMax = 0, floatSq = 0, fixedSq = 0;
+    uint32_t floatCycles = 0, fixedCycles = 0;
+    noiseState = 13;
+    
+    for (int i = 0; i < SAMPLES; i++) {
+        int16_t accel[3], gyro[3];
+        float truth = turnTraceSample(i, accel, gyro);
+        
+        uint32_t start = ESP.getCycleCount();
+        fusion.update(gyro[0] * gyroScale, gyro[1] * gyroScale, gyro[2] * gyroScale,
+                      accel[0] * accelScale, accel[1] * accelScale, accel[2] * accelScale,
+                      1.0f / IMU_ODR_HZ);
+        float floatRotation = fusion.getScreenRotation();
+        uint32_t mid = ESP.getCycleCount();
+        fixed.update(accel, gyro);
+        float fixedRotation = fixed.getRotationDegrees();
+        uint32_t end = ESP.getCycleCount();
+        
+        floatCycles += mid - start;
+        fixedCycles += end - mid;
+        
+        float floatError = angleError(floatRotation, truth);
+        float fixedError = angleError(fixedRotation, truth);
+        floatMax = max(floatMax, floatError);
+        fixedMax = max(fixedMax, fixedError);
+        floatSq += floatError * floatError;
+        fixedSq += fixedError * fixedError;
+    }
+    
+    TEST_ASSERT_TRUE_MESSAGE(floatMax < 2.0f, "Float path should track within 2°");
+    TEST_ASSERT_TRUE_MESSAGE(fixedMax < 2.0f, "Fixed-point path should track within 2°");
+    
+    char report[160];
+    snprintf(report, sizeof(report),
+             "float: %u cycles/sample, max %.2f° rms %.2f° | fixed: %u cycles/sample, max %.2f° rms %.2f°",
+             floatCycles / SAMPLES, floatMax, sqrtf(floatSq / SAMPLES),
+             fixedCycles / SAMPLES, fixedMax, sqrtf(fixedSq / SAMPLES));
+    TEST_MESSAGE(report);
+}
+
+// --- Background gyro calibration ---
+
+// Feeds seconds of samples at the ODR: bias + noise, optionally moving
+static void feedCalibrator(GyroCalibrator& cal, float seconds, const float bias[3],
+                           float motionDps, float accelNorm = 1.0f) {
+    for (int i = 0; i < seconds * IMU_ODR_HZ; i++) {
+        float wave = motionDps * sinf(i * 0.05f);
+        cal.feed(bias[0] + wave + noise(0.1f), bias[1] + noise(0.1f), bias[2] + noise(0.1f),
+                 noise(0.005f), noise(0.005f), accelNorm + noise(0.005f));
+    }
+}
+
+// Test the calibrator only learns while still, and ignores driving
+void test_gyro_calibrator_stillness() {
+    GyroCalibrator cal;
+    const float bias[3] = {0.7f, -0.4f, 0.3f};
+    noiseState = 3;
+    
+    // Turning, then braking hard with no rotation: neither is a still moment
+    feedCalibrator(cal, 2.0f, bias, 20.0f);
+    feedCalibrator(cal, 2.0f, bias, 0.0f, 1.2f);
+    GyroCalibration snap = cal.snapshot();
+    TEST_ASSERT_EQUAL_INT_MESSAGE(GYRO_CAL_UNCALIBRATED, cal.getState(), "Motion should never calibrate");
+    TEST_ASSERT_EQUAL_INT(0, snap.stillWindows);
+    TEST_ASSERT_TRUE(snap.movingWindows >= 7);
+    
+    // Stopped at a light (engine vibration within the noise): one whole
+    // still window is enough, wherever the window boundary falls
+    feedCalibrator(cal, 2.0f * GYRO_CAL_WINDOW / IMU_ODR_HZ, bias, 0.0f);
+    TEST_ASSERT_EQUAL_INT_MESSAGE(GYRO_CAL_CALIBRATED, cal.getState(), "A still window should calibrate");
+    for (int i = 0; i < 3; i++) {
+        TEST_ASSERT_FLOAT_WITHIN_MESSAGE(0.02f, bias[i], cal.getBias()[i], "Bias should match the still mean");
+    }
+}
+
+// Test a saved bias is used at once and later windows follow drift
+void test_gyro_calibrator_seed_and_drift() {
+    GyroCalibrator cal;
+    noiseState = 5;
+    
+    cal.seed(0.5f, 0.5f, 0.5f);
+    TEST_ASSERT_EQUAL_INT_MESSAGE(GYRO_CAL_SEEDED, cal.getState(), "Seeded bias should be usable before any still window");
+    TEST_ASSERT_TRUE(cal.isCalibrated());
+    
+    // The first measurement replaces the seed outright
+    const float warm[3] = {0.2f, 0.2f, 0.2f};
+    feedCalibrator(cal, 0.5f, warm, 0.0f);
+    TEST_ASSERT_FLOAT_WITHIN(0.02f, 0.2f, cal.getBias()[0]);
+    
+    // Temperature drift: the estimate converges over several still windows
+    const float hot[3] = {0.6f, 0.2f, 0.2f};
+    feedCalibrator(cal, 0.5f, hot, 0.0f);
+    TEST_ASSERT_TRUE_MESSAGE(cal.getBias()[0] < 0.4f, "A single window should not jump the estimate");
+    feedCalibrator(cal, 10.0f, hot, 0.0f);
+    TEST_ASSERT_FLOAT_WITHIN_MESSAGE(0.02f, 0.6f, cal.getBias()[0], "Estimate should follow drift");
+}
+
+// Test init no longer waits for a calibration
+void test_imu_init_nonblocking() {
+    IMUHandler imu;
+    unsigned long start = millis();
+    bool ok = imu.init();
+    unsigned long elapsed = millis() - start;
+    if (!ok) {
+        TEST_IGNORE_MESSAGE("QMI8658 not detected");
+        return;
+    }
+    
+    // Only the sensor's own reset and power-up delays remain
+    TEST_ASSERT_TRUE_MESSAGE(elapsed < 150, "init() should not block on calibration");
+    
+    GyroCalibration cal;
+    uint32_t version = 0;
+    imu.seedGyroBias(0.1f, 0.2f, 0.3f);
+    TEST_ASSERT_TRUE_MESSAGE(imu.readCalibration(cal, version), "Seed should be published");
+    TEST_ASSERT_EQUAL_INT(GYRO_CAL_SEEDED, cal.state);
+    TEST_ASSERT_EQUAL_FLOAT(0.3f, cal.bias[2]);
+}
+
+// --- Temperature-compensated bias ---
+
+// Synthetic die: bias per axis as a quadratic in temperature (deg/s)
+static void dieBias(float celsius, float bias[3]) {
+    float x = celsius - 25.0f;
+    bias[0] = 0.3f + 0.02f * x + 0.0004f * x * x;
+    bias[1] = -0.1f - 0.01f * x;
+    bias[2] = 0.05f + 0.005f * x - 0.0002f * x * x;
+}
+
+// Test the model only fits once the temperature span supports it, and
+// then tracks the curve across the span
+void test_gyro_temp_model_fit() {
+    GyroTempModel model;
+    float truth[3], bias[3];
+    noiseState = 23;
+    
+    // A stop at one temperature says nothing about the slope
+    for (int i = 0; i < 20; i++) {
+        dieBias(20.0f, truth);
+        model.addObservation(20.0f + noise(0.3f), truth);
+    }
+    TEST_ASSERT_FALSE_MESSAGE(model.isFitted(), "One temperature should not produce a fit");
+    
+    // Cabin warming from 20 to 30 °C: linear
+    for (float t = 20.0f; t <= 30.0f; t += 0.25f) {
+        dieBias(t, truth);
+        const float measured[3] = {truth[0] + noise(0.01f), truth[1] + noise(0.01f), truth[2] + noise(0.01f)};
+        model.addObservation(t, measured);
+    }
+    TEST_ASSERT_TRUE_MESSAGE(model.isFitted(), "A 10 °C span should produce a fit");
+    TEST_ASSERT_EQUAL_FLOAT_MESSAGE(0.0f, model.getCoeffs().coeff[0][2], "Short span should fit a line");
+    
+    // ... and on to 55 °C in the sun: curvature
+    for (float t = 30.0f; t <= 55.0f; t += 0.25f) {
+        dieBias(t, truth);
+        const float measured[3] = {truth[0] + noise(0.01f), truth[1] + noise(0.01f), truth[2] + noise(0.01f)};
+        model.addObservation(t, measured);
+    }
+    float maxError = 0;
+    for (float t = 20.0f; t <= 55.0f; t += 0.5f) {
+        dieBias(t, truth);
+        model.lookup(t, bias);
+        for (int axis = 0; axis < 3; axis++) {
+            maxError = max(maxError, fabsf(bias[axis] - truth[axis]));
+        }
+    }
+    TEST_ASSERT_TRUE_MESSAGE(maxError < 0.03f, "Bias should follow the curve within 0.03 deg/s");
+    TEST_ASSERT_EQUAL_INT(20, model.getCoeffs().minC);
+    TEST_ASSERT_EQUAL_INT(56, model.getCoeffs().maxC);
+    
+    // Outside the learned span the edge value holds
+    float edge[3];
+    model.lookup(56.0f, edge);
+    model.lookup(75.0f, bias);
+    TEST_ASSERT_FLOAT_WITHIN_MESSAGE(0.0001f, edge[0], bias[0], "No extrapolation beyond the span");
+}
+
+// Test a saved fit is usable at boot and new temperatures are persisted
+void test_gyro_temp_model_seed() {
+    GyroTempModel learned, restored;
+    float truth[3], bias[3];
+    for (float t = 10.0f; t <= 40.0f; t += 1.0f) {
+        dieBias(t, truth);
+        learned.addObservation(t, truth);
+    }
+    
+    restored.seed(learned.getCoeffs());
+    TEST_ASSERT_TRUE_MESSAGE(restored.isFitted(), "Seeded model should be fitted before any stop");
+    restored.lookup(33.0f, bias);
+    dieBias(33.0f, truth);
+    TEST_ASSERT_FLOAT_WITHIN(0.01f, truth[0], bias[0]);
+    TEST_ASSERT_FALSE_MESSAGE(GyroTempModel::differs(learned.getCoeffs(), restored.getCoeffs(), GYRO_CAL_SAVE_DELTA),
+                              "Restored fit should match the saved one");
+    
+    // A stop at a new temperature extends the span: worth saving
+    dieBias(46.0f, truth);
+    restored.addObservation(46.0f, truth);
+    TEST_ASSERT_TRUE(GyroTempModel::differs(learned.getCoeffs(), restored.getCoeffs(), GYRO_CAL_SAVE_DELTA));
+    
+    GyroTempCoeffs none;
+    memset(&none, 0, sizeof(none));
+    restored.seed(none);
+    TEST_ASSERT_FALSE_MESSAGE(restored.isFitted(), "An invalid record should not seed a fit");
+}
+
+// Test driving while the cabin warms: between stops the model keeps the
+// bias right where a constant calibration drifts off
+void test_gyro_temp_model_drive() {
+    GyroCalibrator cal;
+    GyroTempModel model;
+    float truth[3], bias[3];
+    noiseState = 29;
+    
+    // A few stops on earlier drives taught the model 15-45 °C
+    for (float t = 15.0f; t <= 45.0f; t += 2.0f) {
+        dieBias(t, truth);
+        feedCalibrator(cal, 1.0f, truth, 0.0f);
+        model.addObservation(t, cal.getLastMean());
+    }
+    
+    // Last stop at 22 °C, then 20 minutes of driving up to 42 °C
+    dieBias(22.0f, truth);
+    feedCalibrator(cal, 2.0f, truth, 0.0f);
+    float constantError = 0, modelError = 0;
+    for (float t = 22.0f; t <= 42.0f; t += 0.5f) {
+        dieBias(t, truth);
+        model.lookup(t, bias);
+        for (int axis = 0; axis < 3; axis++) {
+            constantError = max(constantError, fabsf(cal.getBias()[axis] - truth[axis]));
+            modelError = max(modelError, fabsf(bias[axis] - truth[axis]));
+        }
+    }
+    TEST_ASSERT_TRUE_MESSAGE(modelError < 0.05f, "Model should hold the bias within 0.05 deg/s");
+    TEST_ASSERT_TRUE_MESSAGE(modelError < constantError / 4, "Model should beat the last calibration");
+    
+    char report[96];
+    snprintf(report, sizeof(report), "Bias error over a 20 °C warm-up: %.3f deg/s constant, %.3f deg/s model",
+             constantError, modelError);
+    TEST_MESSAGE(report);
+}
+
+// --- Adaptive data rate ---
+
+// Test rest must persist before the rate drops, and motion restores it at once
+void test_imu_motion_tracker() {
+    IMUMotionTracker tracker;
+    TEST_ASSERT_EQUAL_INT(IMU_MOTION_ACTIVE, tracker.getState());
+    
+    // Stopped at a light: no-motion fires once, the hold runs on without events
+    TEST_ASSERT_FALSE(tracker.update(QMI8658_STATUS1_NO_MOTION, 1000));
+    TEST_ASSERT_FALSE(tracker.update(0, 1000 + IMU_STILL_HOLD_MS / 2));
+    TEST_ASSERT_EQUAL_INT_MESSAGE(IMU_MOTION_ACTIVE, tracker.getState(), "Rest should be held before switching");
+    TEST_ASSERT_TRUE(tracker.update(0, 1000 + IMU_STILL_HOLD_MS));
+    TEST_ASSERT_EQUAL_INT(IMU_MOTION_STILL, tracker.getState());
+    
+    // Pulling away
+    TEST_ASSERT_TRUE_MESSAGE(tracker.update(QMI8658_STATUS1_ANY_MOTION, 5000), "Motion should switch at once");
+    TEST_ASSERT_EQUAL_INT(IMU_MOTION_ACTIVE, tracker.getState());
+    
+    // Creeping in traffic: motion during the hold cancels it
+    tracker.update(QMI8658_STATUS1_NO_MOTION, 6000);
+    tracker.update(QMI8658_STATUS1_ANY_MOTION, 6500);
+    TEST_ASSERT_FALSE(tracker.update(0, 6000 + IMU_STILL_HOLD_MS));
+    TEST_ASSERT_EQUAL_INT(IMU_MOTION_ACTIVE, tracker.getState());
+    
+    // Both flags in one read: motion wins
+    TEST_ASSERT_FALSE(tracker.update(QMI8658_STATUS1_ANY_MOTION | QMI8658_STATUS1_NO_MOTION, 9000));
+    TEST_ASSERT_FALSE(tracker.update(0, 9000 + IMU_STILL_HOLD_MS));
+    TEST_ASSERT_EQUAL_INT(2, tracker.getTransitions());
+}
+
+// Closes one statistics window at the current rate and returns it
+static IMURateStats measureRate(IMUHandler& imu) {
+    delay(IMU_STATS_WINDOW_US / 1000 * 2 + 100);
+    IMURateStats stats;
+    memset(&stats, 0, sizeof(stats));
+    imu.getRateStats(stats);
+    return stats;
+}
+
+// Measurement: sampling task CPU and bus utilization moving vs parked
+void test_imu_adaptive_rate() {
+    IMUHandler imu;
+    if (!imu.init()) {
+        TEST_IGNORE_MESSAGE("QMI8658 not detected");
+        return;
+    }
+    imu.enableFifo();
+    imu.requestRate(IMU_RATE_HIGH);
+    TEST_ASSERT_TRUE(imu.startTask());
+    IMURateStats moving = measureRate(imu);
+    
+    imu.requestRate(IMU_RATE_LOW);
+    IMURateStats parked = measureRate(imu);
+    TEST_ASSERT_EQUAL_INT_MESSAGE(IMU_RATE_LOW, imu.getRate(), "Requested rate should be applied");
+    TEST_ASSERT_EQUAL_FLOAT(IMU_LOW_ODR_HZ, imu.getOdrHz());
+    
+    TEST_ASSERT_EQUAL_INT(IMU_RATE_HIGH, moving.rate);
+    TEST_ASSERT_EQUAL_INT(IMU_RATE_LOW, parked.rate);
+    TEST_ASSERT_FLOAT_WITHIN_MESSAGE(IMU_FIFO_WATERMARK * 1.5f, IMU_ODR_HZ, moving.sampleRateHz, "Moving should sample at the full rate");
+    TEST_ASSERT_FLOAT_WITHIN_MESSAGE(IMU_FIFO_WATERMARK, IMU_LOW_ODR_HZ, parked.sampleRateHz, "Parked should sample at the low rate");
+    TEST_ASSERT_TRUE_MESSAGE(parked.periodUs > moving.periodUs * 4, "The task should wake less often when parked");
+    TEST_ASSERT_TRUE_MESSAGE(parked.busRate < moving.busRate / 4, "Bus traffic should drop when parked");
+    TEST_ASSERT_TRUE_MESSAGE(parked.cpuLoad < moving.cpuLoad, "CPU load should drop when parked");
+    
+    imu.requestRate(IMU_RATE_HIGH);
+    delay(parked.periodUs / 1000 * 2);
+    TEST_ASSERT_EQUAL_INT_MESSAGE(IMU_RATE_HIGH, imu.getRate(), "Full rate should come back within a wake-up");
+    
+    char report[160];
+    snprintf(report, sizeof(report),
+             "moving: %.0f Hz, %.3f%% CPU, %.0f I2C/s | parked: %.0f Hz, %.3f%% CPU, %.0f I2C/s",
+             moving.sampleRateHz, moving.cpuLoad * 100, moving.busRate,
+             parked.sampleRateHz, parked.cpuLoad * 100, parked.busRate);
+    TEST_MESSAGE(report);
+}
+
+// --- Vibration filtering ---
+
+// Runs a sine of the given amplitude (raw LSB) and frequency on every
+// channel, around offset, through the filter bank in FIFO-sized batches.
+// Returns the peak output deviation from offset once the filter settled.
+static float filterSineAmplitude(IMUFilterBank& filter, float hz, float amplitude,
+                                 int16_t offset = 0) {
+    const int SAMPLES = 4 * IMU_ODR_HZ;
+    const int SETTLE = 2 * IMU_FILTER_TAPS;
+    int16_t data[IMU_FILTER_CHANNELS][IMU_FIFO_WATERMARK];
+    int16_t* const channels[IMU_FILTER_CHANNELS] = {
+        data[0], data[1], data[2], data[3], data[4], data[5]
+    };
+    
+    float peak = 0;
+    for (int start = 0; start < SAMPLES; start += IMU_FIFO_WATERMARK) {
+        for (int i = 0; i < IMU_FIFO_WATERMARK; i++) {
+            float x = amplitude * sinf(2.0f * PI * hz * (start + i) / IMU_ODR_HZ);
+            for (int c = 0; c < IMU_FILTER_CHANNELS; c++) {
+                data[c][i] = offset + (int16_t)lroundf(x);
+            }
+        }
+        filter.process(channels, IMU_FIFO_WATERMARK);
+        for (int i = 0; i < IMU_FIFO_WATERMARK; i++) {
+            if (start + i < SETTLE) continue;
+            for (int c = 0; c < IMU_FILTER_CHANNELS; c++) {
+                peak = max(peak, fabsf((float)(data[c][i] - offset)));
+            }
+        }
+    }
+    return peak;
+}
+
+// Test gravity and slow motion pass: DC exactly, 1 Hz nearly untouched
+void test_imu_filter_passband() {
+    IMUFilterBank filter;
+    
+    // Primed on the first sample: a steady 1 g reads 1 g from the start
+    int16_t samples[IMU_FILTER_CHANNELS][8];
+    int16_t* const channels[IMU_FILTER_CHANNELS] = {
+        samples[0], samples[1], samples[2], samples[3], samples[4], samples[5]
+    };
+    for (int c = 0; c < IMU_FILTER_CHANNELS; c++) {
+        for (int i = 0; i < 8; i++) samples[c][i] = 16384;
+    }
+    filter.process(channels, 8);
+    for (int c = 0; c < IMU_FILTER_CHANNELS; c++) {
+        TEST_ASSERT_INT_WITHIN_MESSAGE(1, 16384, samples[c][7], "DC gain should be 1");
+    }
+    
+    filter.reset();
+    float amplitude = filterSineAmplitude(filter, 1.0f, 8000.0f);
+    TEST_ASSERT_TRUE_MESSAGE(amplitude > 0.95f * 8000.0f, "1 Hz motion should pass");
+    TEST_ASSERT_TRUE_MESSAGE(amplitude < 1.02f * 8000.0f, "1 Hz motion should not be amplified");
+}
+
+// Test engine and road vibration is rejected on both sensors
+void test_imu_filter_vibration_rejection() {
+#if IMU_FILTER_PROFILE == IMU_FILTER_OFF
+    TEST_IGNORE_MESSAGE("IMU_FILTER_OFF build");
+#else
+    IMUFilterBank filter;
+    float accel = filterSineAmplitude(filter, 35.0f, 4000.0f, 16384) / 4000.0f;
+    filter.reset();
+    float gyro = filterSineAmplitude(filter, 60.0f, 4000.0f) / 4000.0f;
+    
+    TEST_ASSERT_TRUE_MESSAGE(accel < 0.03f, "35 Hz should be attenuated by 30 dB");
+    TEST_ASSERT_TRUE_MESSAGE(gyro < 0.03f, "60 Hz should be attenuated by 30 dB");
+    
+    char report[96];
+    snprintf(report, sizeof(report), "Vibration gain: 35 Hz %.1f dB, 60 Hz %.1f dB",
+             20.0f * log10f(max(accel, 1e-5f)), 20.0f * log10f(max(gyro, 1e-5f)));
+    TEST_MESSAGE(report);
+#endif
+}
+
+// Test the notch removes a vibration the low-pass lets through, and that
+// batch size does not change the output
+void test_imu_filter_notch() {
+    IMUFilterBank filter;
+    float open = filterSineAmplitude(filter, 12.0f, 4000.0f);
+    
+    filter.reset();
+    filter.setNotch(12.0f, IMU_ODR_HZ);
+    float notched = filterSineAmplitude(filter, 12.0f, 4000.0f);
+    TEST_ASSERT_TRUE_MESSAGE(notched < 0.1f * 4000.0f, "Notch should reject its frequency");
+    TEST_ASSERT_TRUE_MESSAGE(notched < open / 4, "Notch should cut below the low-pass alone");
+    
+    filter.reset();
+    float slow = filterSineAmplitude(filter, 1.0f, 4000.0f);
+    TEST_ASSERT_TRUE_MESSAGE(slow > 0.9f * 4000.0f, "Notch should leave slow motion alone");
+    
+    // Same input, one sample at a time vs one block
+    IMUFilterBank single, batched;
+    int16_t a[IMU_FILTER_CHANNELS][40], b[IMU_FILTER_CHANNELS][40];
+    for (int c = 0; c < IMU_FILTER_CHANNELS; c++) {
+        for (int i = 0; i < 40; i++) {
+            a[c][i] = b[c][i] = (int16_t)((i * 2654435761u + c * 40503u) >> 20);
+        }
+    }
+    int16_t* const batch[IMU_FILTER_CHANNELS] = {b[0], b[1], b[2], b[3], b[4], b[5]};
+    batched.process(batch, 40);
+    for (int i = 0; i < 40; i++) {
+        int16_t* const one[IMU_FILTER_CHANNELS] = {&a[0][i], &a[1][i], &a[2][i], &a[3][i], &a[4][i], &a[5][i]};
+        single.process(one, 1);
+    }
+    TEST_ASSERT_EQUAL_MEMORY_MESSAGE(b, a, sizeof(a), "Output should not depend on batch size");
+}
+
+// Test a still display in a running car: the rotation stops flickering
+void test_imu_filter_car_vibration() {
+#if IMU_FILTER_PROFILE == IMU_FILTER_OFF
+    TEST_IGNORE_MESSAGE("IMU_FILTER_OFF build");
+#else
+    const int SAMPLES = 6 * IMU_ODR_HZ;
+    const float dt = 1.0f / IMU_ODR_HZ;
+    SensorFusion raw, filtered;
+    IMUFilterBank filter;
+    noiseState = 17;
+    
+    // Mounted upright; engine at 28 Hz and road at 43 Hz shake the mount
+    float rawMin = 360, rawMax = 0, filteredMin = 360, filteredMax = 0;
+    for (int i = 0; i < SAMPLES; i++) {
+        float t = i * dt;
+        float engine = sinf(2.0f * PI * 28.0f * t);
+        float road = sinf(2.0f * PI * 43.0f * t);
+        int16_t accel[3] = {
+            (int16_t)lroundf((1.0f + 0.15f * engine + noise(0.01f)) * 16384.0f),
+            (int16_t)lroundf((0.25f * engine + 0.1f * road + noise(0.01f)) * 16384.0f),
+            (int16_t)lroundf((0.1f * road + noise(0.01f)) * 16384.0f)
+        };
+        int16_t gyro[3] = {
+            (int16_t)lroundf((15.0f * road + noise(0.1f)) * 64.0f),
+            (int16_t)lroundf((10.0f * engine + noise(0.1f)) * 64.0f),
+            (int16_t)lroundf((40.0f * engine + 20.0f * road + noise(0.1f)) * 64.0f)
+        };
+        raw.update(gyro[0] / 64.0f, gyro[1] / 64.0f, gyro[2] / 64.0f,
+                   accel[0] / 16384.0f, accel[1] / 16384.0f, accel[2] / 16384.0f, dt);
+        
+        int16_t* const channels[IMU_FILTER_CHANNELS] = {
+            &accel[0], &accel[1], &accel[2], &gyro[0], &gyro[1], &gyro[2]
+        };
+        filter.process(channels, 1);
+        filtered.update(gyro[0] / 64.0f, gyro[1] / 64.0f, gyro[2] / 64.0f,
+                        accel[0] / 16384.0f, accel[1] / 16384.0f, accel[2] / 16384.0f, dt);
+        
+        if (i < 2 * IMU_ODR_HZ) continue;   // Let both settle
+        float r = fmodf(raw.getScreenRotation() + 180.0f, 360.0f);
+        float f = fmodf(filtered.getScreenRotation() + 180.0f, 360.0f);
+        rawMin = min(rawMin, r);
+        rawMax = max(rawMax, r);
+        filteredMin = min(filteredMin, f);
+        filteredMax = max(filteredMax, f);
+    }
+    
+    float rawFlicker = rawMax - rawMin;
+    float filteredFlicker = filteredMax - filteredMin;
+    TEST_ASSERT_TRUE_MESSAGE(filteredFlicker < rawFlicker / 4, "Filtering should cut the rotation flicker");
+    TEST_ASSERT_TRUE_MESSAGE(filteredFlicker < 0.2f, "Filtered rotation should hold within 0.2°");
+    
+    char report[96];
+    snprintf(report, sizeof(report), "Rotation flicker: %.3f° raw, %.3f° filtered",
+             rawFlicker, filteredFlicker);
+    TEST_MESSAGE(report);
+#endif
+}
+
+// Benchmark: six-axis samples per second through the filter bank
+void test_imu_filter_benchmark() {
+    const int BATCHES = 2000;
+    IMUFilterBank filter;
+    filter.setNotch(25.0f, IMU_ODR_HZ);
+    int16_t data[IMU_FILTER_CHANNELS][IMU_FIFO_WATERMARK];
+    int16_t* const channels[IMU_FILTER_CHANNELS] = {
+        data[0], data[1], data[2], data[3], data[4], data[5]
+    };
+    noiseState = 19;
+    for (int c = 0; c < IMU_FILTER_CHANNELS; c++) {
+        for (int i = 0; i < IMU_FIFO_WATERMARK; i++) {
+            data[c][i] = (int16_t)noise(8000.0f);
+        }
+    }
+    
+    int32_t checksum = 0;
+    unsigned long start = micros();
+    for (int n = 0; n < BATCHES; n++) {
+        filter.process(channels, IMU_FIFO_WATERMARK);
+        checksum += data[n % IMU_FILTER_CHANNELS][n % IMU_FIFO_WATERMARK];
+    }
+    unsigned long elapsed = micros() - start;
+    float perSample = (float)elapsed / (BATCHES * IMU_FIFO_WATERMARK);
+    
+    TEST_ASSERT_TRUE(checksum == checksum);
+    TEST_ASSERT_TRUE_MESSAGE(perSample < IMU_FILTER_CPU_BUDGET_US, "Filtering should fit the per-sample budget");
+    
+    char report[96];
+    snprintf(report, sizeof(report), "Filter bank: %.0f samples/s (%.2f us per 6-axis sample)",
+             perSample > 0 ? 1.0f / perSample * 1000000.0f : 0.0f, perSample);
+    TEST_MESSAGE(report);
+}
+
 void run_imu_tests() {
     RUN_TEST(test_imu_constants);
     RUN_TEST(test_imu_data_structure);
@@ -235,4 +1104,29 @@ void run_imu_tests() {
     RUN_TEST(test_i2c_pins);
     RUN_TEST(test_calibration);
     RUN_TEST(test_integration_timing);
+    RUN_TEST(test_imu_burst_read);
+    RUN_TEST(test_imu_fifo_batches);
+    RUN_TEST(test_latest_value_slot);
+    RUN_TEST(test_imu_rate_meter);
+    RUN_TEST(test_imu_task_rate);
+    RUN_TEST(test_fusion_static_bias);
+    RUN_TEST(test_fusion_rotation_tracking);
+    RUN_TEST(test_fusion_tilt_and_shock);
+    RUN_TEST(test_fusion_benchmark);
+    RUN_TEST(test_cordic_atan2);
+    RUN_TEST(test_fixed_accel_range_limit);
+    RUN_TEST(test_fixed_vs_float_benchmark);
+    RUN_TEST(test_gyro_calibrator_stillness);
+    RUN_TEST(test_gyro_calibrator_seed_and_drift);
+    RUN_TEST(test_imu_init_nonblocking);
+    RUN_TEST(test_gyro_temp_model_fit);
+    RUN_TEST(test_gyro_temp_model_seed);
+    RUN_TEST(test_gyro_temp_model_drive);
+    RUN_TEST(test_imu_motion_tracker);
+    RUN_TEST(test_imu_adaptive_rate);
+    RUN_TEST(test_imu_filter_passband);
+    RUN_TEST(test_imu_filter_vibration_rejection);
+    RUN_TEST(test_imu_filter_notch);
+    RUN_TEST(test_imu_filter_car_vibration);
+    RUN_TEST(test_imu_filter_benchmark);
 }
\ No newline at end of file
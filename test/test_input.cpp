@@ -0,0 +1,278 @@
+#include <unity.h>
+#include <Arduino.h>
+#include "../src/input/gesture_recognizer.h"
+#include "../src/input/touch_driver.h"
+#include "fakes/fake_i2c_driver.h"
+
+// --- Scripted touch traces ---
+
+#define TRACE_MAX_POINTS     160     // Longest trace: a 1.5 s hold, 152 reports
+#define TRACE_REPORT_MS      10      // FT3168 report interval while touched
+// INT edge to report read: task wake-up plus the touch client's worst-case
+// bus latency behind an IMU drain (test_bus_worst_case_latency)
+#define TRACE_READ_DELAY_MS  6
+
+struct TouchTrace {
+    TouchPoint points[TRACE_MAX_POINTS];
+    int count;
+};
+
+static void traceAdd(TouchTrace& trace, uint32_t timeMs, bool down, int16_t x, int16_t y) {
+    if (trace.count >= TRACE_MAX_POINTS) {
+        TEST_FAIL_MESSAGE("Trace longer than TRACE_MAX_POINTS");
+        return;
+    }
+    TouchPoint& p = trace.points[trace.count++];
+    p.timeMs = timeMs;
+    p.down = down;
+    p.x = x;
+    p.y = y;
+}
+
+// Straight stroke from (x, y) by (dx, dy) over durationMs, then release
+static void traceStroke(TouchTrace& trace, uint32_t startMs, int16_t x, int16_t y,
+                        int16_t dx, int16_t dy, uint32_t durationMs) {
+    for (uint32_t t = 0; t <= durationMs; t += TRACE_REPORT_MS) {
+        traceAdd(trace, startMs + t, true, x + dx * (int32_t)t / (int32_t)max(durationMs, 1u),
+                 y + dy * (int32_t)t / (int32_t)max(durationMs, 1u));
+    }
+    traceAdd(trace, startMs + durationMs + TRACE_REPORT_MS, false, x + dx, y + dy);
+}
+
+static void traceTap(TouchTrace& trace, uint32_t startMs, int16_t x, int16_t y, uint32_t durationMs = 70) {
+    traceStroke(trace, startMs, x, y, 0, 0, durationMs);
+}
+
+// Time of the release report of the stroke starting at startMs
+static uint32_t releaseTime(const TouchTrace& trace, uint32_t startMs) {
+    for (int i = 0; i < trace.count; i++) {
+        if (trace.points[i].timeMs >= startMs && !trace.points[i].down) return trace.points[i].timeMs;
+    }
+    return 0;
+}
+
+// First report at which the stroke starting at startMs has travelled a swipe
+static uint32_t swipeTime(const TouchTrace& trace, uint32_t startMs) {
+    const TouchPoint* first = nullptr;
+    for (int i = 0; i < trace.count; i++) {
+        const TouchPoint& p = trace.points[i];
+        if (p.timeMs < startMs) continue;
+        if (!first) first = &p;
+        int32_t dx = p.x - first->x, dy = p.y - first->y;
+        if (dx * dx + dy * dy >= GESTURE_SWIPE_MIN_PX * GESTURE_SWIPE_MIN_PX) return p.timeMs;
+    }
+    return 0;
+}
+
+// Plays the trace in 1 ms steps the way TouchDriver's task does: each
+// report is read TRACE_READ_DELAY_MS after it was taken, and the task
+// wakes at the recognizer's deadlines
+static int playTrace(GestureRecognizer& recognizer, const TouchTrace& trace,
+                     GestureEvent* events, int maxEvents, uint32_t tailMs = 1000) {
+    int next = 0, count = 0;
+    uint32_t endMs = trace.points[trace.count - 1].timeMs + tailMs;
+    for (uint32_t now = 0; now <= endMs; now++) {
+        while (next < trace.count && trace.points[next].timeMs + TRACE_READ_DELAY_MS <= now) {
+            recognizer.update(trace.points[next++], now);
+        }
+        if (now >= recognizer.nextDeadline()) {
+            recognizer.poll(now);
+        }
+        GestureEvent event;
+        while (recognizer.next(event)) {
+            if (count < maxEvents) events[count] = event;
+            count++;
+        }
+    }
+    return count;
+}
+
+static void assertGesture(const GestureEvent& event, GestureType type, uint32_t decisiveMs, const char* what) {
+    char message[96];
+    snprintf(message, sizeof(message), "%s: type", what);
+    TEST_ASSERT_EQUAL_INT_MESSAGE(type, event.type, message);
+    snprintf(message, sizeof(message), "%s: %u ms touch-to-event", what, event.timeMs - decisiveMs);
+    TEST_ASSERT_TRUE_MESSAGE(event.timeMs >= decisiveMs, message);
+    TEST_ASSERT_TRUE_MESSAGE(event.timeMs - decisiveMs < GESTURE_LATENCY_BUDGET_MS, message);
+}
+
+// Test a short touch becomes one tap once the double-tap window closed
+void test_gesture_tap() {
+    GestureRecognizer recognizer;
+    TouchTrace trace = {};
+    traceTap(trace, 100, 233, 233);
+
+    GestureEvent events[4];
+    int count = playTrace(recognizer, trace, events, 4);
+    TEST_ASSERT_EQUAL_INT_MESSAGE(1, count, "One tap expected");
+    assertGesture(events[0], GESTURE_TAP, releaseTime(trace, 100) + GESTURE_DOUBLE_TAP_MS, "tap");
+    TEST_ASSERT_EQUAL_INT(233, events[0].x);
+}
+
+// Test two quick taps are one double tap, with no single taps
+void test_gesture_double_tap() {
+    GestureRecognizer recognizer;
+    TouchTrace trace = {};
+    traceTap(trace, 100, 200, 240);
+    traceTap(trace, 330, 210, 235);
+
+    GestureEvent events[4];
+    int count = playTrace(recognizer, trace, events, 4);
+    TEST_ASSERT_EQUAL_INT_MESSAGE(1, count, "A double tap should not also report taps");
+    assertGesture(events[0], GESTURE_DOUBLE_TAP, releaseTime(trace, 330), "double tap");
+
+    // Second touch too far from the first: two separate taps
+    recognizer.reset();
+    trace.count = 0;
+    traceTap(trace, 100, 100, 233);
+    traceTap(trace, 330, 360, 233);
+    count = playTrace(recognizer, trace, events, 4);
+    TEST_ASSERT_EQUAL_INT(2, count);
+    TEST_ASSERT_EQUAL_INT(GESTURE_TAP, events[0].type);
+    TEST_ASSERT_EQUAL_INT(GESTURE_TAP, events[1].type);
+    TEST_ASSERT_EQUAL_INT(360, events[1].x);
+}
+
+// Test a held touch is a long press at the hold time, not at release
+void test_gesture_long_press() {
+    GestureRecognizer recognizer;
+    TouchTrace trace = {};
+    traceStroke(trace, 100, 233, 233, 5, -5, 1500);   // Resting finger drifts a little
+
+    GestureEvent events[4];
+    int count = playTrace(recognizer, trace, events, 4);
+    TEST_ASSERT_EQUAL_INT_MESSAGE(1, count, "Release after a long press should add nothing");
+    assertGesture(events[0], GESTURE_LONG_PRESS, 100 + GESTURE_LONG_PRESS_MS, "long press");
+
+    // Between a tap and a long press: nothing
+    recognizer.reset();
+    trace.count = 0;
+    traceTap(trace, 100, 233, 233, 400);
+    TEST_ASSERT_EQUAL_INT(0, playTrace(recognizer, trace, events, 4));
+}
+
+// Test the four swipe directions, reported before the finger lifts
+void test_gesture_swipes() {
+    const struct {
+        int16_t dx, dy;
+        GestureType type;
+        const char* name;
+    } strokes[] = {
+        {0, -200, GESTURE_SWIPE_UP, "swipe up"},
+        {0, 200, GESTURE_SWIPE_DOWN, "swipe down"},
+        {-200, 20, GESTURE_SWIPE_LEFT, "swipe left"},
+        {200, -30, GESTURE_SWIPE_RIGHT, "swipe right"},
+    };
+
+    for (const auto& stroke : strokes) {
+        GestureRecognizer recognizer;
+        TouchTrace trace = {};
+        traceStroke(trace, 100, 233, 233, stroke.dx, stroke.dy, 150);
+
+        GestureEvent events[4];
+        int count = playTrace(recognizer, trace, events, 4);
+        TEST_ASSERT_EQUAL_INT_MESSAGE(1, count, stroke.name);
+        assertGesture(events[0], stroke.type, swipeTime(trace, 100), stroke.name);
+        TEST_ASSERT_TRUE_MESSAGE(events[0].timeMs < releaseTime(trace, 100), "Swipe should not wait for the release");
+    }
+
+    // Content turned a quarter clockwise: panel-right is the user's up
+    GestureRecognizer recognizer;
+    recognizer.setRotation(1);
+    TouchTrace trace = {};
+    traceStroke(trace, 100, 233, 233, 200, 0, 150);
+    GestureEvent events[4];
+    TEST_ASSERT_EQUAL_INT(1, playTrace(recognizer, trace, events, 4));
+    TEST_ASSERT_EQUAL_INT(GESTURE_SWIPE_UP, events[0].type);
+
+    // A slow drag is not a swipe (nor a tap or long press)
+    recognizer.reset();
+    trace.count = 0;
+    traceStroke(trace, 100, 100, 233, 100, 0, 1500);
+    TEST_ASSERT_EQUAL_INT(0, playTrace(recognizer, trace, events, 4));
+}
+
+// Test a tap followed by a swipe inside the window keeps both
+void test_gesture_tap_then_swipe() {
+    GestureRecognizer recognizer;
+    TouchTrace trace = {};
+    traceTap(trace, 100, 233, 233);
+    traceStroke(trace, 300, 233, 233, 0, 200, 150);
+
+    GestureEvent events[4];
+    int count = playTrace(recognizer, trace, events, 4);
+    TEST_ASSERT_EQUAL_INT(2, count);
+    TEST_ASSERT_EQUAL_INT(GESTURE_TAP, events[0].type);
+    assertGesture(events[1], GESTURE_SWIPE_DOWN, swipeTime(trace, 300), "swipe after tap");
+}
+
+// --- FT3168 driver ---
+
+struct FakeFT3168 {
+    uint8_t regs[256];
+};
+
+static bool ft3168Device(void* context, const uint8_t* tx, size_t txLen, uint8_t* rx, size_t rxLen) {
+    FakeFT3168* dev = static_cast<FakeFT3168*>(context);
+    uint8_t reg = tx[0];
+    for (size_t i = 1; i < txLen; i++) dev->regs[reg++] = tx[i];
+    for (size_t i = 0; i < rxLen; i++) rx[i] = dev->regs[reg++];
+    return true;
+}
+
+static void ft3168Report(FakeFT3168& dev, bool down, uint16_t x, uint16_t y) {
+    dev.regs[FT3168_TD_STATUS] = down ? 1 : 0;
+    dev.regs[FT3168_P1_XH] = (down ? 0x80 : 0x40) | (x >> 8);   // Contact / up
+    dev.regs[FT3168_P1_XH + 1] = x & 0xFF;
+    dev.regs[FT3168_P1_XH + 2] = y >> 8;
+    dev.regs[FT3168_P1_XH + 3] = y & 0xFF;
+}
+
+// Test the driver configures trigger INT mode and turns reports into gestures
+void test_touch_driver_ft3168() {
+    FakeI2CDriver fake;
+    FakeFT3168 panel = {};
+    fake.addDevice(FT3168_I2C_ADDR, ft3168Device, &panel);
+    I2CBus bus(&fake);
+
+    EventQueue<GestureEvent> events;
+    EventBus<GestureEvent>::subscribe(events);
+
+    TouchDriver touch;
+    TEST_ASSERT_TRUE(touch.init(&bus));
+    TEST_ASSERT_EQUAL_HEX8_MESSAGE(FT3168_G_MODE_TRIGGER, panel.regs[FT3168_ID_G_MODE], "INT should pulse per report");
+
+    ft3168Report(panel, true, 300, 260);
+    touch.service(true, 1000);
+    TEST_ASSERT_TRUE(touch.getLastPoint().down);
+    TEST_ASSERT_EQUAL_INT(300, touch.getLastPoint().x);
+    TEST_ASSERT_EQUAL_INT(260, touch.getLastPoint().y);
+
+    ft3168Report(panel, false, 300, 260);
+    touch.service(true, 1060);
+    GestureEvent event;
+    TEST_ASSERT_FALSE_MESSAGE(events.pop(event), "The tap is held for the double-tap window");
+
+    touch.service(false, 1060 + GESTURE_DOUBLE_TAP_MS);
+    TEST_ASSERT_TRUE_MESSAGE(events.pop(event), "The tap should be published on the event bus");
+    TEST_ASSERT_EQUAL_INT(GESTURE_TAP, event.type);
+    TEST_ASSERT_EQUAL_INT(300, event.x);
+    TEST_ASSERT_EQUAL_INT(2, touch.getReportCount());
+    TEST_ASSERT_EQUAL_UINT32(1, touch.getGestureCount());
+    EventBus<GestureEvent>::unsubscribe(events);
+
+    // No controller on the bus
+    FakeI2CDriver empty;
+    I2CBus emptyBus(&empty);
+    TouchDriver missing;
+    TEST_ASSERT_FALSE(missing.init(&emptyBus));
+}
+
+void run_input_tests() {
+    RUN_TEST(test_gesture_tap);
+    RUN_TEST(test_gesture_double_tap);
+    RUN_TEST(test_gesture_long_press);
+    RUN_TEST(test_gesture_swipes);
+    RUN_TEST(test_gesture_tap_then_swipe);
+    RUN_TEST(test_touch_driver_ft3168);
+}
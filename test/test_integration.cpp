@@ -5,6 +5,9 @@
 #include "../src/display/ui_manager.h"
 #include "../src/sensors/imu_handler.h"
 #include "../src/config/settings.h"
+#include "../src/core/event_bus.h"
+#include "../src/core/events.h"
+#include "../src/core/task_monitor.h"
 
 // Test complete system initialization
 void test_system_initialization() {
@@ -297,7 +300,126 @@ void test_realtime_updates() {
     TEST_ASSERT_TRUE_MESSAGE(true, "UI update should be safe to call frequently");
 }
 
+// Test per-task CPU load windows and stack high-water marks
+void test_task_monitor_report() {
+    TaskMonitor monitor;
+    TaskLoad load;
+    TEST_ASSERT_EQUAL_INT(0, monitor.add("test", xTaskGetCurrentTaskHandle(), 1, 2, 8192, &load));
+    TEST_ASSERT_EQUAL_INT(1, monitor.add("stopped", nullptr, 0, 1, 3072));
+    
+    uint32_t startUs = micros();
+    TEST_ASSERT_FALSE_MESSAGE(monitor.sample(startUs), "Window should not close early");
+    
+    // 250 ms busy in two wake-ups
+    load.add(100000);
+    load.add(150000);
+    uint32_t endUs = startUs + TASK_MONITOR_WINDOW_MS * 1000UL;
+    TEST_ASSERT_TRUE(monitor.sample(endUs));
+    const TaskReport& task = monitor.getReport(0);
+    TEST_ASSERT_TRUE(task.running);
+    TEST_ASSERT_FLOAT_WITHIN(0.01f, 0.25f, task.cpuLoad);
+    TEST_ASSERT_EQUAL_UINT32(2, task.wakeups);
+    TEST_ASSERT_EQUAL_UINT32(150000, task.maxBusyUs);
+    TEST_ASSERT_TRUE_MESSAGE(task.stackFree > 0 && task.stackFree <= 8192, "High-water mark should be within the budget");
+    
+    const TaskReport& stopped = monitor.getReport(1);
+    TEST_ASSERT_FALSE(stopped.running);
+    TEST_ASSERT_TRUE_MESSAGE(stopped.cpuLoad < 0, "Stack-only rows have no load");
+    
+    // An idle window: load drops, the peak stays
+    TEST_ASSERT_TRUE(monitor.sample(endUs + TASK_MONITOR_WINDOW_MS * 1000UL));
+    TEST_ASSERT_FLOAT_WITHIN(0.001f, 0.0f, task.cpuLoad);
+    TEST_ASSERT_FLOAT_WITHIN(0.01f, 0.25f, task.peakLoad);
+    TEST_ASSERT_EQUAL_UINT32(2, monitor.getWindows());
+    TEST_ASSERT_EQUAL_INT(0, monitor.countTightStacks());
+    
+    while (monitor.getCount() < TASK_MONITOR_MAX_TASKS) {
+        monitor.add("filler", nullptr, 0, 1, 1024);
+    }
+    TEST_ASSERT_EQUAL_INT_MESSAGE(-1, monitor.add("extra", nullptr, 0, 1, 1024), "Full table should refuse");
+}
+
 // Main test runner for integration tests
+// Test typed dispatch: per-type channels, per-subscriber queues, overflow
+void test_event_bus_dispatch() {
+    EventQueue<NavUpdateEvent> first, second;
+    EventQueue<OrientationEvent> other;
+    EventBus<NavUpdateEvent>::subscribe(first);
+    EventBus<NavUpdateEvent>::subscribe(second);
+    EventBus<OrientationEvent>::subscribe(other);
+    
+    NavUpdateEvent event = {1000, 0, true, 250};
+    TEST_ASSERT_EQUAL_INT_MESSAGE(2, EventBus<NavUpdateEvent>::publish(event), "Both subscribers should get it");
+    TEST_ASSERT_EQUAL_UINT32_MESSAGE(0, other.pending(), "Other event types should not see it");
+    
+    NavUpdateEvent received;
+    TEST_ASSERT_TRUE(first.pop(received));
+    TEST_ASSERT_EQUAL_INT(250, received.distance);
+    TEST_ASSERT_FALSE(first.pop(received));
+    
+    // second never drains: it overflows alone, first keeps receiving in order
+    for (int i = 0; i < EVENT_QUEUE_DEPTH + 3; i++) {
+        event.distance = i;
+        EventBus<NavUpdateEvent>::publish(event);
+        TEST_ASSERT_TRUE(first.pop(received));
+        TEST_ASSERT_EQUAL_INT(i, received.distance);
+    }
+    TEST_ASSERT_EQUAL_UINT32(EVENT_QUEUE_DEPTH, second.pending());
+    TEST_ASSERT_EQUAL_UINT32(4, second.getDropped());
+    TEST_ASSERT_TRUE_MESSAGE(second.takeOverflow(), "Overflow should be reported once");
+    TEST_ASSERT_FALSE(second.takeOverflow());
+    TEST_ASSERT_EQUAL_UINT32(0, first.getDropped());
+    
+    EventBus<NavUpdateEvent>::unsubscribe(first);
+    EventBus<NavUpdateEvent>::unsubscribe(second);
+    EventBus<OrientationEvent>::unsubscribe(other);
+    TEST_ASSERT_EQUAL_INT(0, EventBus<NavUpdateEvent>::getSubscriberCount());
+    TEST_ASSERT_EQUAL_INT(0, EventBus<NavUpdateEvent>::publish(event));
+}
+
+// Test settings and BLE publish what changed, and only when it changed
+void test_event_publishers() {
+    EventQueue<SettingsChangedEvent> settingsEvents;
+    EventQueue<NavUpdateEvent> navEvents;
+    EventBus<SettingsChangedEvent>::subscribe(settingsEvents);
+    EventBus<NavUpdateEvent>::subscribe(navEvents);
+    
+    Settings config;
+    config.init();
+    config.setShowSpeedLimit(true);
+    config.setShowSpeedLimit(false);
+    config.setShowSpeedLimit(false);
+    
+    SettingsChangedEvent change;
+    uint16_t fields = 0;
+    int count = 0;
+    while (settingsEvents.pop(change)) {
+        fields |= change.fields;
+        count++;
+    }
+    TEST_ASSERT_EQUAL_HEX16(SETTING_SHOW_SPEED_LIMIT, fields & SETTING_SHOW_SPEED_LIMIT);
+    TEST_ASSERT_TRUE_MESSAGE(count <= 2, "Unchanged values should not publish");
+    
+    UIManager ui;
+    ui.applySettings(config.getSettings(), fields);
+    
+    BLEServer bleServer;
+    uint8_t packet[7] = {0x01, 0x00, 50, 0x02, '2', '0', '0'};   // Right turn, 50 km/h
+    bleServer.injectPacket(packet, sizeof(packet), NAV_SOURCE_SYGIC);
+    NavUpdateEvent update;
+    TEST_ASSERT_TRUE_MESSAGE(navEvents.pop(update), "Decoded data should publish a NavUpdateEvent");
+    TEST_ASSERT_EQUAL_INT(NAV_SOURCE_SYGIC, update.source);
+    TEST_ASSERT_TRUE(update.valid);
+    TEST_ASSERT_EQUAL_INT(bleServer.getNavigationData().distance, update.distance);
+    
+    bleServer.injectPacket(packet, 3, NAV_SOURCE_SYGIC);   // Too short
+    TEST_ASSERT_FALSE_MESSAGE(navEvents.pop(update), "Rejected packets should not publish");
+    
+    EventBus<SettingsChangedEvent>::unsubscribe(settingsEvents);
+    EventBus<NavUpdateEvent>::unsubscribe(navEvents);
+    config.reset();
+}
+
 void run_integration_tests() {
     RUN_TEST(test_system_initialization);
     RUN_TEST(test_data_flow);
@@ -310,4 +432,7 @@ void run_integration_tests() {
     RUN_TEST(test_system_state_transitions);
     RUN_TEST(test_persistence_integration);
     RUN_TEST(test_realtime_updates);
+    RUN_TEST(test_event_bus_dispatch);
+    RUN_TEST(test_event_publishers);
+    RUN_TEST(test_task_monitor_report);
 }
\ No newline at end of file
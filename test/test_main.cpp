@@ -1,6 +1,10 @@
 #include <unity.h>
 #include <Arduino.h>
 
+// Unity runs inside setup() on the loop task. The default 8 KB is too small
+// for tests that build an IMUHandler (~7 KB) or a BLEServer on the stack.
+SET_LOOP_TASK_STACK_SIZE(32 * 1024);
+
 // Test runner function
 void setUp(void) {
     // Set up code before each test
@@ -16,6 +20,8 @@ void run_display_tests();
 void run_ui_tests();
 void run_imu_tests();
 void run_settings_tests();
+void run_bus_tests();
+void run_input_tests();
 void run_integration_tests();
 
 void setup() {
@@ -29,6 +35,8 @@ void setup() {
     run_ui_tests(); 
     run_imu_tests();
     run_settings_tests();
+    run_bus_tests();
+    run_input_tests();
     run_integration_tests();
     
     UNITY_END();
@@ -1,6 +1,7 @@
 #include <unity.h>
 #include <Arduino.h>
 #include "../src/config/settings.h"
+#include "fakes/fake_settings_store.h"
 
 // Test settings initialization
 void test_settings_initialization() {
@@ -254,6 +255,386 @@ void test_settings_namespace() {
     TEST_ASSERT_EQUAL_STRING_MESSAGE("hud_settings", namespace_name, "Namespace should match expected value");
 }
 
+// Test the learned gyro bias survives a reload and small changes skip the write
+void test_settings_gyro_bias() {
+    Settings config;
+    config.init();
+    config.reset();
+    
+    TEST_ASSERT_FALSE_MESSAGE(config.hasGyroBias(), "No bias should be stored by default");
+    TEST_ASSERT_TRUE_MESSAGE(config.setGyroBias(0.5f, -0.25f, 0.125f, 0.05f), "First bias should always be saved");
+    TEST_ASSERT_FALSE_MESSAGE(config.setGyroBias(0.52f, -0.25f, 0.125f, 0.05f), "Change below threshold should not write flash");
+    TEST_ASSERT_TRUE_MESSAGE(config.setGyroBias(0.6f, -0.25f, 0.125f, 0.05f), "Larger change should be saved");
+    TEST_ASSERT_TRUE(config.commit());
+    
+    Settings reloaded;
+    reloaded.init();
+    const HUDSettings& s = reloaded.getSettings();
+    TEST_ASSERT_TRUE_MESSAGE(reloaded.hasGyroBias(), "Bias should persist");
+    TEST_ASSERT_FLOAT_WITHIN(0.0001f, 0.6f, s.gyroBiasX);
+    TEST_ASSERT_FLOAT_WITHIN(0.0001f, -0.25f, s.gyroBiasY);
+    TEST_ASSERT_FLOAT_WITHIN(0.0001f, 0.125f, s.gyroBiasZ);
+    
+    reloaded.reset();
+}
+
+// Test the gyro temperature model round-trips through flash
+void test_settings_gyro_temp_model() {
+    Settings config;
+    config.init();
+    config.reset();
+    
+    TEST_ASSERT_FALSE_MESSAGE(config.hasGyroTempModel(), "No temperature model should be stored by default");
+    const float coeffs[3][3] = {{0.3f, 0.02f, 0.0004f}, {-0.1f, -0.01f, 0.0f}, {0.05f, 0.005f, -0.0002f}};
+    TEST_ASSERT_TRUE(config.setGyroTempModel(coeffs, 12, 48));
+    TEST_ASSERT_TRUE(config.commit());
+    
+    Settings reloaded;
+    reloaded.init();
+    const HUDSettings& s = reloaded.getSettings();
+    TEST_ASSERT_TRUE_MESSAGE(reloaded.hasGyroTempModel(), "Model should persist");
+    TEST_ASSERT_EQUAL_INT(12, s.gyroTempMinC);
+    TEST_ASSERT_EQUAL_INT(48, s.gyroTempMaxC);
+    TEST_ASSERT_EQUAL_MEMORY_MESSAGE(coeffs, s.gyroTempCoeffs, sizeof(coeffs), "Coefficients should persist");
+    
+    reloaded.reset();
+}
+
+// Test a burst of setter calls ends in one commit
+void test_settings_deferred_commit() {
+    Settings config;
+    config.init();
+    config.reset();
+    SettingsStats before = config.getStats();
+    
+    // A brightness swipe plus a few toggles, faster than the quiet period
+    for (int i = 0; i < 100; i++) {
+        config.setBrightness(100 + i);
+        if (i % 10 == 0) config.toggleNightMode();
+    }
+    config.setRotation(1);
+    config.setShowDistance(true);   // Unchanged default, stays clean
+    
+    TEST_ASSERT_EQUAL_UINT32_MESSAGE(before.commits, config.getStats().commits, "Setters should not write flash");
+    TEST_ASSERT_EQUAL_HEX16(SETTING_BRIGHTNESS | SETTING_NIGHT_MODE | SETTING_ROTATION, config.getDirtyFields());
+    
+    uint32_t now = millis();
+    TEST_ASSERT_FALSE_MESSAGE(config.flushIfQuiet(now), "Should wait for the quiet period");
+    TEST_ASSERT_TRUE(config.flushIfQuiet(now + SETTINGS_COMMIT_QUIET_MS));
+    
+    const SettingsStats& after = config.getStats();
+    TEST_ASSERT_EQUAL_UINT32_MESSAGE(before.commits + 1, after.commits, "Burst should be one commit");
+    TEST_ASSERT_EQUAL_UINT32_MESSAGE(before.keyWrites + 1, after.keyWrites, "A commit should be one blob write");
+    TEST_ASSERT_EQUAL_HEX16(0, config.getDirtyFields());
+    TEST_ASSERT_FALSE_MESSAGE(config.commit(), "Nothing left to write");
+    
+    Settings reloaded;
+    reloaded.init();
+    TEST_ASSERT_EQUAL_INT(199, reloaded.getBrightness());
+    TEST_ASSERT_EQUAL_INT(1, reloaded.getRotation());
+    TEST_ASSERT_EQUAL_INT(config.getNightMode(), reloaded.getNightMode());
+    
+    reloaded.reset();
+}
+
+// Test a failed write is counted apart and keeps the fields for the next commit
+void test_settings_failed_commit() {
+    FakeSettingsStore store;
+    Settings config(&store);
+    config.init();
+    config.setBrightness(90);
+    SettingsStats before = config.getStats();
+    
+    store.cutPowerAfter(0);
+    TEST_ASSERT_FALSE(config.commit());
+    TEST_ASSERT_EQUAL_UINT32_MESSAGE(before.commits, config.getStats().commits, "A failed write is not a commit");
+    TEST_ASSERT_EQUAL_UINT32(before.keyWrites, config.getStats().keyWrites);
+    TEST_ASSERT_EQUAL_UINT32(before.failures + 1, config.getStats().failures);
+    TEST_ASSERT_EQUAL_HEX16_MESSAGE(SETTING_BRIGHTNESS, config.getDirtyFields() & SETTING_BRIGHTNESS,
+                                    "Fields should stay dirty after a failed write");
+    
+    store.restorePower();
+    TEST_ASSERT_TRUE(config.commit());
+    TEST_ASSERT_EQUAL_UINT32(before.commits + 1, config.getStats().commits);
+    TEST_ASSERT_EQUAL_UINT32(before.failures + 1, config.getStats().failures);
+}
+
+// Stores a blob with a valid header for the given payload
+static void writeTestBlob(uint8_t version, const void* payload, uint16_t length) {
+    uint8_t blob[sizeof(SettingsBlobHeader) + SETTINGS_BLOB_MAX_PAYLOAD];
+    SettingsBlobHeader header = {version, 0, length, 1, 0};
+    header.crc = Settings::crc32(Settings::crc32(0, &header, sizeof(header)), payload, length);
+    memcpy(blob, &header, sizeof(header));
+    memcpy(blob + sizeof(header), payload, length);
+    
+    Preferences prefs;
+    prefs.begin("hud_settings", false);
+    prefs.clear();
+    prefs.putBytes("settings_a", blob, sizeof(header) + length);
+    prefs.end();
+}
+
+// Flips one payload bit of a stored slot, or truncates it
+static void damageSlot(Preferences& prefs, const char* key, bool truncate = false) {
+    uint8_t blob[SETTINGS_BLOB_MAX];
+    size_t size = prefs.getBytes(key, blob, sizeof(blob));
+    TEST_ASSERT_EQUAL_UINT32(sizeof(SettingsBlobHeader) + sizeof(SettingsRecord), size);
+    blob[sizeof(SettingsBlobHeader)] ^= 0x04;
+    prefs.putBytes(key, blob, truncate ? size - 1 : size);
+}
+
+// Test the blob round-trips and a damaged slot falls back to the other one
+void test_settings_blob_crc() {
+    Settings config;
+    config.init();
+    config.reset();                  // Defaults in slot A
+    config.setBrightness(90);
+    config.setSleepTimeout(600);
+    TEST_ASSERT_TRUE(config.commit()); // Slot B
+    TEST_ASSERT_EQUAL_INT(1, config.getActiveSlot());
+    
+    Settings reloaded;
+    reloaded.init();
+    TEST_ASSERT_EQUAL_INT(SETTINGS_FROM_BLOB, reloaded.getLoadSource());
+    TEST_ASSERT_EQUAL_INT(1, reloaded.getActiveSlot());
+    TEST_ASSERT_EQUAL_INT(90, reloaded.getBrightness());
+    TEST_ASSERT_EQUAL_INT(600, reloaded.getSleepTimeout());
+    
+    Preferences prefs;
+    prefs.begin("hud_settings", false);
+    damageSlot(prefs, "settings_b");
+    TEST_ASSERT_TRUE(reloaded.load());
+    TEST_ASSERT_EQUAL_INT_MESSAGE(SETTINGS_FROM_BLOB, reloaded.getLoadSource(), "Older slot should still load");
+    TEST_ASSERT_EQUAL_INT(0, reloaded.getActiveSlot());
+    TEST_ASSERT_EQUAL_INT(200, reloaded.getBrightness());
+    
+    damageSlot(prefs, "settings_a", true);
+    TEST_ASSERT_TRUE(reloaded.load());
+    TEST_ASSERT_EQUAL_INT(SETTINGS_FROM_CORRUPT, reloaded.getLoadSource());
+    TEST_ASSERT_EQUAL_INT_MESSAGE(200, reloaded.getBrightness(), "No valid slot should load defaults");
+    TEST_ASSERT_EQUAL_INT(300, reloaded.getSleepTimeout());
+    prefs.end();
+    
+    reloaded.reset();
+}
+
+// Version 0 is a pre-release layout that only held brightness and rotation
+struct __attribute__((packed)) TestRecordV0 {
+    uint8_t brightness;
+    uint8_t rotation;
+};
+
+static uint16_t migrateTestV0(uint8_t* payload, uint16_t length) {
+    if (length != sizeof(TestRecordV0)) return 0;
+    TestRecordV0 old;
+    memcpy(&old, payload, sizeof(old));
+    
+    HUDSettings upgraded;
+    upgraded.brightness = old.brightness;
+    upgraded.rotation = old.rotation;
+    SettingsRecord record;
+    Settings::toRecord(upgraded, record);
+    memcpy(payload, &record, sizeof(record));
+    return sizeof(record);
+}
+
+// Test an older blob goes through the registered migration and is rewritten
+void test_settings_migration() {
+    TestRecordV0 old = {120, 3};
+    writeTestBlob(0, &old, sizeof(old));
+    
+    {
+        // No upgrade path: treated as corrupt
+        Settings config;
+        config.init();
+        TEST_ASSERT_EQUAL_INT(SETTINGS_FROM_CORRUPT, config.getLoadSource());
+    }
+    
+    writeTestBlob(0, &old, sizeof(old));
+    TEST_ASSERT_FALSE_MESSAGE(Settings::registerMigration(SETTINGS_BLOB_VERSION, migrateTestV0),
+                              "Only older versions can be migrated");
+    TEST_ASSERT_TRUE(Settings::registerMigration(0, migrateTestV0));
+    
+    Settings config;
+    config.init();
+    TEST_ASSERT_EQUAL_INT(SETTINGS_FROM_MIGRATION, config.getLoadSource());
+    TEST_ASSERT_EQUAL_INT(120, config.getBrightness());
+    TEST_ASSERT_EQUAL_INT(3, config.getRotation());
+    TEST_ASSERT_TRUE_MESSAGE(config.getAutoRotation(), "New fields should get defaults");
+    TEST_ASSERT_TRUE_MESSAGE(config.commit(), "Migrated settings should be rewritten");
+    Settings::registerMigration(0, nullptr);
+    
+    Settings reloaded;
+    reloaded.init();
+    TEST_ASSERT_EQUAL_INT(SETTINGS_FROM_BLOB, reloaded.getLoadSource());
+    TEST_ASSERT_EQUAL_INT(120, reloaded.getBrightness());
+    
+    reloaded.reset();
+}
+
+// Test the per-key layout is imported, and compare its load time with the blob
+void test_settings_legacy_import() {
+    const int LOADS = 50;
+    Preferences prefs;
+    prefs.begin("hud_settings", false);
+    prefs.clear();
+    prefs.putUChar("brightness", 77);
+    prefs.putUChar("rotation", 2);
+    prefs.putBool("auto_rot", false);
+    prefs.putBool("night_mode", true);
+    prefs.putBool("show_speed", true);
+    prefs.putBool("show_dist", true);
+    prefs.putBool("show_instr", false);
+    prefs.putUChar("dist_unit", 1);
+    prefs.putUShort("reconnect", 2000);
+    prefs.putBool("auto_conn", true);
+    prefs.putUShort("sleep_time", 120);
+    prefs.putBool("wake_data", true);
+    prefs.putFloat("gyro_bx", 0.25f);
+    
+    Settings config;
+    config.init();
+    TEST_ASSERT_EQUAL_INT(SETTINGS_FROM_LEGACY, config.getLoadSource());
+    TEST_ASSERT_EQUAL_INT(77, config.getBrightness());
+    TEST_ASSERT_EQUAL_INT(2, config.getRotation());
+    TEST_ASSERT_FALSE(config.getShowInstruction());
+    TEST_ASSERT_EQUAL_INT(2000, config.getReconnectDelay());
+    TEST_ASSERT_FLOAT_WITHIN(0.0001f, 0.25f, config.getSettings().gyroBiasX);
+    
+    unsigned long start = micros();
+    for (int i = 0; i < LOADS; i++) config.load();
+    unsigned long legacyUs = micros() - start;
+    
+    TEST_ASSERT_TRUE(config.commit());
+    TEST_ASSERT_FALSE_MESSAGE(prefs.isKey("brightness"), "Old keys should be removed once the blob is written");
+    TEST_ASSERT_TRUE(prefs.isKey("settings_a"));
+    prefs.end();
+    
+    start = micros();
+    for (int i = 0; i < LOADS; i++) config.load();
+    unsigned long blobUs = micros() - start;
+    TEST_ASSERT_EQUAL_INT(SETTINGS_FROM_BLOB, config.getLoadSource());
+    TEST_ASSERT_EQUAL_INT(77, config.getBrightness());
+    TEST_ASSERT_TRUE(config.getNightMode());
+    
+    char report[96];
+    snprintf(report, sizeof(report), "Settings load: per-key %.1f us, blob %.1f us",
+             (float)legacyUs / LOADS, (float)blobUs / LOADS);
+    TEST_MESSAGE(report);
+    TEST_ASSERT_TRUE_MESSAGE(blobUs <= legacyUs, "One blob read should load faster than 20 key lookups");
+    
+    config.reset();
+}
+
+// Test the old layout is imported and removed through an injected store,
+// without touching NVS
+void test_settings_legacy_import_store() {
+    Preferences prefs;
+    prefs.begin("hud_settings", false);
+    prefs.clear();
+    prefs.putUChar("brightness", 33);   // Must be neither read nor erased
+    
+    FakeSettingsStore store;
+    uint8_t brightness = 140;
+    uint16_t reconnect = 3000;
+    bool night = true;
+    store.write("brightness", &brightness, sizeof(brightness));
+    store.write("reconnect", &reconnect, sizeof(reconnect));
+    store.write("night_mode", &night, sizeof(night));
+    
+    {
+        Settings config(&store);
+        config.init();
+        TEST_ASSERT_EQUAL_INT(SETTINGS_FROM_LEGACY, config.getLoadSource());
+        TEST_ASSERT_EQUAL_INT(140, config.getBrightness());
+        TEST_ASSERT_EQUAL_INT(3000, config.getReconnectDelay());
+        TEST_ASSERT_TRUE(config.getNightMode());
+        TEST_ASSERT_TRUE_MESSAGE(config.getShowDistance(), "Missing keys keep their defaults");
+        
+        TEST_ASSERT_TRUE(config.commit());
+        uint8_t probe;
+        TEST_ASSERT_FALSE_MESSAGE(store.readLegacy("brightness", SETTINGS_LEGACY_U8, &probe, 1),
+                                  "Old keys should be erased from the store");
+    }
+    
+    TEST_ASSERT_EQUAL_INT_MESSAGE(33, prefs.getUChar("brightness", 0), "NVS should be left alone");
+    TEST_ASSERT_FALSE(prefs.isKey("settings_a"));
+    prefs.clear();
+    prefs.end();
+}
+
+// Applies test state n; every field differs between consecutive states
+static void applyTestState(Settings& config, uint8_t n) {
+    config.setBrightness(50 + 10 * n);
+    config.setRotation(n);
+    config.setNightMode(n % 2);
+    config.setSleepTimeout(100 + n);
+    config.setGyroBias(0.1f * n, -0.1f * n, 0.0f);
+}
+
+static void assertTestState(const Settings& config, uint8_t n) {
+    TEST_ASSERT_EQUAL_INT(50 + 10 * n, config.getBrightness());
+    TEST_ASSERT_EQUAL_INT(n % 4, config.getRotation());
+    TEST_ASSERT_EQUAL_INT(n % 2, config.getNightMode());
+    TEST_ASSERT_EQUAL_INT(100 + n, config.getSleepTimeout());
+    TEST_ASSERT_FLOAT_WITHIN(0.0001f, 0.1f * n, config.getSettings().gyroBiasX);
+    TEST_ASSERT_FLOAT_WITHIN(0.0001f, -0.1f * n, config.getSettings().gyroBiasY);
+}
+
+// Test a power cut at any write point of a commit sequence leaves a
+// consistent set: the last finished commit, never a mix
+void test_settings_power_loss() {
+    const uint8_t COMMITS = 3;
+    
+    // Count the write points of the sequence
+    uint32_t total;
+    {
+        FakeSettingsStore store;
+        Settings config(&store);
+        config.init();
+        applyTestState(config, 0);
+        TEST_ASSERT_TRUE(config.commit());
+        uint32_t start = store.getWritePoints();
+        for (uint8_t n = 1; n <= COMMITS; n++) {
+            applyTestState(config, n);
+            TEST_ASSERT_TRUE(config.commit());
+        }
+        total = store.getWritePoints() - start;
+    }
+    TEST_ASSERT_TRUE(total >= COMMITS * (sizeof(SettingsBlobHeader) + sizeof(SettingsRecord)) / FAKE_SETTINGS_WORD);
+    
+    for (uint32_t cut = 0; cut <= total; cut++) {
+        FakeSettingsStore store;
+        uint8_t committed = 0;
+        {
+            Settings config(&store);
+            config.init();
+            applyTestState(config, 0);
+            TEST_ASSERT_TRUE(config.commit());
+            
+            store.cutPowerAfter(cut);
+            for (uint8_t n = 1; n <= COMMITS; n++) {
+                applyTestState(config, n);
+                if (!config.commit()) break;
+                committed = n;
+            }
+        }
+        TEST_ASSERT_EQUAL_INT(cut < total ? false : true, store.isPowered());
+        
+        // Ignition back on
+        store.restorePower();
+        Settings booted(&store);
+        booted.init();
+        TEST_ASSERT_EQUAL_INT(SETTINGS_FROM_BLOB, booted.getLoadSource());
+        TEST_ASSERT_EQUAL_UINT32(1 + committed, booted.getSequence());
+        assertTestState(booted, committed);
+    }
+    
+    char report[64];
+    snprintf(report, sizeof(report), "Power cut at %lu write points, all recovered", (unsigned long)total + 1);
+    TEST_MESSAGE(report);
+}
+
 // Main test runner for settings module
 void run_settings_tests() {
     RUN_TEST(test_settings_initialization);
@@ -268,4 +649,13 @@ void run_settings_tests() {
     RUN_TEST(test_preference_keys);
     RUN_TEST(test_settings_validation);
     RUN_TEST(test_settings_namespace);
+    RUN_TEST(test_settings_gyro_bias);
+    RUN_TEST(test_settings_gyro_temp_model);
+    RUN_TEST(test_settings_deferred_commit);
+    RUN_TEST(test_settings_failed_commit);
+    RUN_TEST(test_settings_blob_crc);
+    RUN_TEST(test_settings_migration);
+    RUN_TEST(test_settings_legacy_import);
+    RUN_TEST(test_settings_legacy_import_store);
+    RUN_TEST(test_settings_power_loss);
 }
\ No newline at end of file
@@ -1,6 +1,7 @@
 #include <unity.h>
 #include <Arduino.h>
 #include "../src/display/ui_manager.h"
+#include "../src/display/frame_scheduler.h"
 #include "../src/ble/ble_server.h"
 
 // Test UI state management
@@ -214,6 +215,124 @@ void test_turn_direction_arrows() {
     TEST_ASSERT_TRUE_MESSAGE(rightArrowEnd < AMOLED_WIDTH, "Right arrow should be within bounds");
 }
 
+// Test frame pacing: ~1 FPS idle, on demand for changes, 30 FPS animating
+void test_frame_scheduler_pacing() {
+    FrameScheduler frames;
+    TEST_ASSERT_EQUAL_UINT32_MESSAGE(0, frames.msUntilNextFrame(0), "First frame should be due at once");
+    TEST_ASSERT_TRUE(frames.beginFrame(0));
+    frames.endFrame(5000, 0);
+    
+    TEST_ASSERT_EQUAL_INT(FRAME_MODE_IDLE, frames.getMode());
+    TEST_ASSERT_EQUAL_UINT32_MESSAGE(FRAME_IDLE_MS - 400, frames.msUntilNextFrame(400), "Idle should wait for the 1 FPS tick");
+    TEST_ASSERT_FALSE(frames.beginFrame(400));
+    
+    // A change is drawn on the next pass
+    frames.requestFrame();
+    TEST_ASSERT_EQUAL_UINT32(0, frames.msUntilNextFrame(400));
+    TEST_ASSERT_TRUE(frames.beginFrame(400));
+    frames.endFrame(5000, 0);
+    TEST_ASSERT_EQUAL_UINT32(1, frames.getStats().demandFrames);
+    
+    // Animations run at 30 FPS or more
+    frames.setAnimating(true);
+    TEST_ASSERT_EQUAL_INT(FRAME_MODE_ANIMATION, frames.getMode());
+    TEST_ASSERT_TRUE_MESSAGE(1000 / frames.getPeriodMs() >= 30, "Animation rate should be 30 FPS or more");
+    TEST_ASSERT_EQUAL_UINT32(FRAME_ANIMATION_MS - 10, frames.msUntilNextFrame(410));
+    TEST_ASSERT_TRUE(frames.beginFrame(400 + FRAME_ANIMATION_MS));
+    TEST_ASSERT_EQUAL_UINT32(1, frames.getStats().animationFrames);
+    
+    // Over budget: counted, with the widgets left for the next frame
+    frames.endFrame(FRAME_BUDGET_US + 1, WIDGET_SPEED_LIMIT | WIDGET_APPROACH);
+    const FrameStats& stats = frames.getStats();
+    TEST_ASSERT_EQUAL_UINT32(3, stats.frames);
+    TEST_ASSERT_EQUAL_UINT32(1, stats.overruns);
+    TEST_ASSERT_EQUAL_UINT32(1, stats.deferredFrames);
+    TEST_ASSERT_EQUAL_UINT32(2, stats.deferredWidgets);
+    TEST_ASSERT_EQUAL_UINT32(FRAME_BUDGET_US + 1, stats.maxFrameUs);
+    TEST_ASSERT_FLOAT_WITHIN(0.001f, 1.0f / 3.0f, frames.getOverrunRate());
+    
+    frames.setAnimating(false);
+    TEST_ASSERT_EQUAL_UINT32_MESSAGE(FRAME_IDLE_MS, frames.msUntilNextFrame(400 + FRAME_ANIMATION_MS), "Back to 1 FPS after the animation");
+}
+
+// Test that navigation updates only mark the widgets that changed
+void test_navigation_widget_invalidation() {
+    UIManager ui;
+    NavigationData nav;
+    nav.isValid = true;
+    nav.distance = 800;
+    nav.speedLimit = 50;
+    nav.turnDirection = 0x01;
+    nav.instruction = "Turn left";
+    
+    ui.setNavigation(nav);
+    TEST_ASSERT_EQUAL_INT(UI_NAVIGATION, ui.getState());
+    TEST_ASSERT_EQUAL_HEX8_MESSAGE(WIDGET_ALL, ui.getDirtyWidgets(), "Entering navigation should draw everything");
+    TEST_ASSERT_FALSE_MESSAGE(ui.isAnimating(), "Far from the turn the ring is empty");
+    ui.drawFrame(UI_NO_BUDGET);    // No display: only clears the dirty set
+    
+    // Counting down: only the distance, and the ring starts easing in
+    nav.distance = 150;
+    ui.setNavigation(nav);
+    TEST_ASSERT_EQUAL_HEX8(WIDGET_DISTANCE, ui.getDirtyWidgets());
+    TEST_ASSERT_TRUE_MESSAGE(ui.isAnimating(), "Inside the approach range the ring should animate");
+    ui.drawFrame(UI_NO_BUDGET);
+    
+    nav.speedLimit = 30;
+    nav.instruction = "Turn left now";
+    ui.setNavigation(nav);
+    TEST_ASSERT_EQUAL_HEX8(WIDGET_SPEED_LIMIT | WIDGET_INSTRUCTION, ui.getDirtyWidgets());
+    ui.drawFrame(UI_NO_BUDGET);
+    
+    ui.setNavigation(nav);
+    TEST_ASSERT_EQUAL_HEX8_MESSAGE(0, ui.getDirtyWidgets(), "Identical data should not redraw");
+    
+    // Hiding an element only touches that element; a theme change everything
+    HUDSettings settings;
+    settings.showSpeedLimit = false;
+    ui.applySettings(settings, SETTING_SHOW_SPEED_LIMIT);
+    TEST_ASSERT_EQUAL_HEX8(WIDGET_SPEED_LIMIT, ui.getDirtyWidgets());
+    ui.invalidate(WIDGET_BACKGROUND);
+    TEST_ASSERT_EQUAL_HEX8(WIDGET_ALL, ui.getDirtyWidgets());
+}
+
+// Test that an exhausted budget defers low-priority widgets, never the distance
+void test_frame_budget_defers_widgets() {
+    AmoledDriver display;
+    UIManager ui;
+    if (!display.init() || !ui.init(&display)) {
+        TEST_IGNORE_MESSAGE("AMOLED panel not detected");
+    }
+    
+    NavigationData nav;
+    nav.isValid = true;
+    nav.distance = 120;
+    nav.speedLimit = 80;
+    nav.turnDirection = 0x02;
+    nav.instruction = "Turn right";
+    ui.setNavigation(nav);
+    
+    // No budget at all: the critical widgets still go out
+    UIFrameResult result = ui.drawFrame(0);
+    TEST_ASSERT_EQUAL_HEX8(WIDGET_CRITICAL, result.drawn);
+    TEST_ASSERT_EQUAL_HEX8(WIDGET_ALL & ~WIDGET_CRITICAL, result.deferred);
+    
+    // The next frame with room catches up
+    result = ui.drawFrame(UI_NO_BUDGET);
+    TEST_ASSERT_EQUAL_HEX8(0, result.deferred);
+    
+    nav.distance = 100;
+    nav.speedLimit = 60;
+    ui.setNavigation(nav);
+    result = ui.drawFrame(0);
+    TEST_ASSERT_TRUE_MESSAGE(result.drawn & WIDGET_DISTANCE, "Distance should never be deferred");
+    TEST_ASSERT_TRUE_MESSAGE(result.deferred & WIDGET_SPEED_LIMIT, "Speed limit should wait for the next frame");
+    
+    char report[64];
+    snprintf(report, sizeof(report), "distance-only frame: %u us", result.elapsedUs);
+    TEST_MESSAGE(report);
+}
+
 // Main test runner for UI module
 void run_ui_tests() {
     RUN_TEST(test_ui_state_management);
@@ -227,4 +346,7 @@ void run_ui_tests() {
     RUN_TEST(test_speed_limit_display);
     RUN_TEST(test_distance_formatting);
     RUN_TEST(test_turn_direction_arrows);
+    RUN_TEST(test_frame_scheduler_pacing);
+    RUN_TEST(test_navigation_widget_invalidation);
+    RUN_TEST(test_frame_budget_defers_widgets);
 }
\ No newline at end of file
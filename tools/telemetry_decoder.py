@@ -0,0 +1,100 @@
+#!/usr/bin/env python3
+"""Decode HUD telemetry notifications (see src/ble/telemetry.h).
+
+Reads hex-encoded notification payloads, one per line, from stdin or the
+command line, or subscribes directly to the HUD when bleak is installed:
+
+    python3 tools/telemetry_decoder.py 01070f...
+    some_central_log | python3 tools/telemetry_decoder.py
+    python3 tools/telemetry_decoder.py --ble AA:BB:CC:DD:EE:FF > drive.csv
+
+Output is CSV with one row per notification.
+"""
+
+import argparse
+import struct
+import sys
+import time
+
+CHARACTERISTIC_UUID = "5D0360B2-2D3B-4BDC-B688-E1EC92394B8C"
+TELEMETRY_VERSION = 0x02
+
+# Mirrors TelemetryPacket (packed, little-endian)
+PACKET = struct.Struct("<BBBHHHHHBBHHB")
+
+FIELDS = [
+    "sequence", "frames", "frame_p50_ms", "frame_p95_ms", "frame_p99_ms",
+    "frame_max_ms", "spi_bytes_per_frame", "packets_dropped",
+    "packets_received", "heap_low_water", "imu_rate_hz", "frames_drawn",
+]
+
+
+def decode(payload: bytes) -> dict:
+    if len(payload) < PACKET.size:
+        raise ValueError(f"short packet: {len(payload)} bytes, need {PACKET.size}")
+    (version, seq, frames, p50, p95, p99, fmax, spi, dropped, received,
+     heap, imu, drawn) = PACKET.unpack_from(payload)
+    if version != TELEMETRY_VERSION:
+        raise ValueError(f"unknown telemetry version {version}")
+    return {
+        "sequence": seq,
+        "frames": frames,
+        "frame_p50_ms": p50 / 10.0,
+        "frame_p95_ms": p95 / 10.0,
+        "frame_p99_ms": p99 / 10.0,
+        "frame_max_ms": fmax / 10.0,
+        "spi_bytes_per_frame": spi * 8,
+        "packets_dropped": dropped,
+        "packets_received": received,
+        "heap_low_water": heap * 8,
+        "imu_rate_hz": imu / 10.0,
+        "frames_drawn": drawn,
+    }
+
+
+def emit(row: dict, timestamp: float) -> None:
+    values = [f"{timestamp:.3f}"] + [str(row[f]) for f in FIELDS]
+    print(",".join(values), flush=True)
+
+
+def decode_lines(lines) -> int:
+    errors = 0
+    for line in lines:
+        line = line.strip().replace(" ", "")
+        if not line or line.startswith("#"):
+            continue
+        try:
+            emit(decode(bytes.fromhex(line)), time.time())
+        except ValueError as exc:
+            print(f"# skipped: {exc}", file=sys.stderr)
+            errors += 1
+    return errors
+
+
+async def subscribe(address: str) -> None:
+    from bleak import BleakClient  # Optional dependency
+
+    async with BleakClient(address) as client:
+        def handler(_sender, data: bytearray) -> None:
+            try:
+                emit(decode(bytes(data)), time.time())
+            except ValueError as exc:
+                print(f"# skipped: {exc}", file=sys.stderr)
+
+        await client.start_notify(CHARACTERISTIC_UUID, handler)
+        while client.is_connected:
+            await asyncio.sleep(1.0)
+
+
+if __name__ == "__main__":
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument("hex", nargs="*", help="hex payloads to decode")
+    parser.add_argument("--ble", metavar="ADDRESS", help="subscribe to a HUD with bleak")
+    args = parser.parse_args()
+
+    print("time," + ",".join(FIELDS))
+    if args.ble:
+        import asyncio
+        asyncio.run(subscribe(args.ble))
+    else:
+        sys.exit(1 if decode_lines(args.hex or sys.stdin) else 0)